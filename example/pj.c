@@ -59,7 +59,7 @@ typedef struct tag_Context
 {
     JSON_Parser parser;
     JSON_Writer writer;
-    FILE*       input;
+    const char* inputPath; /* NULL for stdin */
     OutputMode  outputMode;
     int         inEmptyContainer;
 } Context;
@@ -68,7 +68,7 @@ static void InitContext(Context* pCtx)
 {
     pCtx->parser = NULL;
     pCtx->writer = NULL;
-    pCtx->input = NULL;
+    pCtx->inputPath = NULL;
     pCtx->outputMode = Pretty;
     pCtx->inEmptyContainer = 0;
 }
@@ -77,10 +77,6 @@ static void UninitContext(Context* pCtx)
 {
     JSON_Parser_Free(pCtx->parser);
     JSON_Writer_Free(pCtx->writer);
-    if (pCtx->input)
-    {
-        fclose(pCtx->input);
-    }
 }
 
 static JSON_Writer_HandlerResult JSON_CALL OutputHandler(JSON_Writer writer, const char* pBytes, size_t length)
@@ -257,7 +253,6 @@ static void PrintUsage(FILE* f)
 static int Configure(Context* pCtx, int argc, char* argv[])
 {
     int i;
-    pCtx->input = stdin;
     JSON_Parser_SetTrackObjectMembers(pCtx->parser, JSON_True);
     for (i = 1; i < argc; i++)
     {
@@ -333,12 +328,7 @@ static int Configure(Context* pCtx, int argc, char* argv[])
         }
         else
         {
-            pCtx->input = fopen(argv[i], "rb");
-            if (!pCtx->input)
-            {
-                fprintf(stderr, "Error: could not open file \"%s\".\n", argv[i]);
-                return 0;
-            }
+            pCtx->inputPath = argv[i];
         }
     }
     if (JSON_Parser_GetInputEncoding(pCtx->parser) == JSON_UnknownEncoding)
@@ -365,7 +355,18 @@ static int Configure(Context* pCtx, int argc, char* argv[])
 static void LogError(Context* pCtx)
 {
     fflush(stdout); /* avoid interleaving stdout and stderr */
-    if (JSON_Parser_GetError(pCtx->parser) != JSON_Error_AbortedByHandler)
+    if (JSON_Parser_GetError(pCtx->parser) == JSON_Error_CannotReadInput)
+    {
+        if (pCtx->inputPath)
+        {
+            fprintf(stderr, "Error: could not read file \"%s\".\n", pCtx->inputPath);
+        }
+        else
+        {
+            fputs("Error: could not read input.\n", stderr);
+        }
+    }
+    else if (JSON_Parser_GetError(pCtx->parser) != JSON_Error_AbortedByHandler)
     {
         JSON_Error error = JSON_Parser_GetError(pCtx->parser);
         JSON_Location errorLocation = { 0, 0, 0 };
@@ -394,23 +395,12 @@ static int Process(Context* pCtx)
     }
     else
     {
-        while (!feof(pCtx->input))
-        {
-            char chunk[1024];
-            size_t length = fread(chunk, 1, sizeof(chunk), pCtx->input);
-            if (!length && !feof(pCtx->input))
-            {
-                fflush(stdout); /* avoid interleaving stdout and stderr */
-                fputs("Error: could not read input.\n", stderr);
-                return 0;
-            }
-            if (!JSON_Parser_Parse(pCtx->parser, chunk, length, JSON_False))
-            {
-                LogError(pCtx);
-                return 0;
-            }
-        }
-        if (!JSON_Parser_Parse(pCtx->parser, NULL, 0, JSON_True) || /* finish parsing */
+        /* The file is mapped into memory if possible; stdin (descriptor 0)
+           is read in large chunks if it is a pipe or terminal. */
+        JSON_Status status = pCtx->inputPath
+            ? JSON_Parser_ParseFile(pCtx->parser, pCtx->inputPath)
+            : JSON_Parser_ParseFd(pCtx->parser, 0);
+        if (!status ||
             (pCtx->outputMode == Pretty && !JSON_Writer_WriteNewLine(pCtx->writer)))
         {
             LogError(pCtx);
@@ -22,6 +22,8 @@
 
 #include <stdlib.h>
 #include <memory.h>
+#include <float.h>  /* for DBL_DIG, DBL_MAX and DBL_MIN */
+#include <stdio.h>  /* for sprintf() */
 
 /* Ensure uint32_t type (compiler-dependent). */
 #if defined(_MSC_VER)
@@ -35,13 +37,53 @@ typedef unsigned __int32 uint32_t;
 #define SIZE_MAX ((size_t)-1)
 #endif
 
+/* Threads are only used by the parallel parsing APIs. */
+#if !defined(JSON_NO_PARSER) && !defined(JSON_NO_THREADS)
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h> /* for sysconf() */
+#endif
+#endif
+
+/* Files are only used by JSON_Parser_ParseFile() and JSON_Parser_ParseFd(). */
+#if !defined(JSON_NO_PARSER)
+#include <errno.h> /* for EINTR */
+#include <fcntl.h> /* for open() */
+#if defined(_WIN32)
+#include <io.h>    /* for _open(), _read() and _close() */
+#else
+#include <unistd.h> /* for read(), lseek() and close() */
+#if !defined(JSON_NO_MMAP)
+#include <sys/stat.h> /* for fstat() */
+#include <sys/mman.h> /* for mmap(), posix_madvise() and munmap() */
+#endif
+#endif
+#endif
+
 /* Mark APIs for export (as opposed to import) when we build this file. */
 #define JSON_BUILDING
 #include "jsonsax.h"
 
 /* Default allocation constants. */
-#define DEFAULT_TOKEN_BYTES_LENGTH 64 /* MUST be a power of 2 */
-#define DEFAULT_SYMBOL_STACK_SIZE  32 /* MUST be a power of 2 */
+#define DEFAULT_TOKEN_BYTES_LENGTH      64  /* MUST be a power of 2 */
+#define DEFAULT_SYMBOL_STACK_SIZE       32  /* MUST be a power of 2 */
+#define DEFAULT_STRUCTURAL_INDEX_LENGTH 256 /* entries, not bytes */
+#define DEFAULT_ARENA_CHUNK_SIZE        1024
+#define DEFAULT_BATCH_STRING_LENGTH     1024
+#define DEFAULT_PATH_NODES_LENGTH       16
+#define DEFAULT_PATH_NAME_BYTES_LENGTH  256
+#define DEFAULT_PATH_STACK_LENGTH       64  /* entries, not bytes */
+#define DEFAULT_TAPE_LENGTH             256 /* words, not bytes */
+#define DEFAULT_DOCUMENT_BYTES_LENGTH   1024
+#define DEFAULT_OPEN_CONTAINERS_LENGTH  32  /* entries, not bytes */
+#define FILE_READ_BUFFER_SIZE           1048576
+#define FILE_MAP_WINDOW_SIZE            67108864 /* MUST be a multiple of the page size */
+#define MAX_QUEUED_EVENTS               2
+#define MEMBER_NAME_HASH_THRESHOLD      16
+#define MIN_MEMBER_NAME_TABLE_SIZE      64  /* MUST be a power of 2 */
 
 /* Types for readability. */
 typedef unsigned char byte;
@@ -655,36 +697,46 @@ static size_t EncodeCodepoint(Codepoint c, Encoding encoding, byte* pBytes)
 
 /******************** JSON Lexer States ********************/
 
-/* Mutually-exclusive lexer states. */
+/* Mutually-exclusive lexer states. The states before LEXER_TABLE_STATES
+   are driven by the lexer's transition table; the rest are handled by
+   code. */
 #define LEXING_WHITESPACE                                     0
-#define LEXING_LITERAL                                        1
-#define LEXING_STRING                                         2
-#define LEXING_STRING_ESCAPE                                  3
-#define LEXING_STRING_HEX_ESCAPE_BYTE_1                       4
-#define LEXING_STRING_HEX_ESCAPE_BYTE_2                       5
-#define LEXING_STRING_HEX_ESCAPE_BYTE_3                       6
-#define LEXING_STRING_HEX_ESCAPE_BYTE_4                       7
-#define LEXING_STRING_HEX_ESCAPE_BYTE_5                       8
-#define LEXING_STRING_HEX_ESCAPE_BYTE_6                       9
-#define LEXING_STRING_HEX_ESCAPE_BYTE_7                       10
-#define LEXING_STRING_HEX_ESCAPE_BYTE_8                       11
-#define LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_BACKSLASH 12
-#define LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_U         13
-#define LEXING_NUMBER_AFTER_MINUS                             14
-#define LEXING_NUMBER_AFTER_LEADING_ZERO                      15
-#define LEXING_NUMBER_AFTER_LEADING_NEGATIVE_ZERO             16
-#define LEXING_NUMBER_AFTER_X                                 17
-#define LEXING_NUMBER_HEX_DIGITS                              18
-#define LEXING_NUMBER_DECIMAL_DIGITS                          19
-#define LEXING_NUMBER_AFTER_DOT                               20
-#define LEXING_NUMBER_FRACTIONAL_DIGITS                       21
-#define LEXING_NUMBER_AFTER_E                                 22
-#define LEXING_NUMBER_AFTER_EXPONENT_SIGN                     23
-#define LEXING_NUMBER_EXPONENT_DIGITS                         24
-#define LEXING_COMMENT_AFTER_SLASH                            25
-#define LEXING_SINGLE_LINE_COMMENT                            26
-#define LEXING_MULTI_LINE_COMMENT                             27
-#define LEXING_MULTI_LINE_COMMENT_AFTER_STAR                  28
+#define LEXING_NUMBER_AFTER_MINUS                             1
+#define LEXING_NUMBER_AFTER_LEADING_ZERO                      2
+#define LEXING_NUMBER_AFTER_LEADING_NEGATIVE_ZERO             3
+#define LEXING_NUMBER_AFTER_X                                 4
+#define LEXING_NUMBER_HEX_DIGITS                              5
+#define LEXING_NUMBER_DECIMAL_DIGITS                          6
+#define LEXING_NUMBER_AFTER_DOT                               7
+#define LEXING_NUMBER_FRACTIONAL_DIGITS                       8
+#define LEXING_NUMBER_AFTER_E                                 9
+#define LEXING_NUMBER_AFTER_EXPONENT_SIGN                     10
+#define LEXING_NUMBER_EXPONENT_DIGITS                         11
+#define LEXING_COMMENT_AFTER_SLASH                            12
+#define LEXING_SINGLE_LINE_COMMENT                            13
+#define LEXING_MULTI_LINE_COMMENT                             14
+#define LEXING_MULTI_LINE_COMMENT_AFTER_STAR                  15
+#define LEXER_TABLE_STATES                                    16
+#define LEXING_LITERAL                                        16
+#define LEXING_STRING                                         17
+#define LEXING_STRING_ESCAPE                                  18
+#define LEXING_STRING_HEX_ESCAPE_BYTE_1                       19
+#define LEXING_STRING_HEX_ESCAPE_BYTE_2                       20
+#define LEXING_STRING_HEX_ESCAPE_BYTE_3                       21
+#define LEXING_STRING_HEX_ESCAPE_BYTE_4                       22
+#define LEXING_STRING_HEX_ESCAPE_BYTE_5                       23
+#define LEXING_STRING_HEX_ESCAPE_BYTE_6                       24
+#define LEXING_STRING_HEX_ESCAPE_BYTE_7                       25
+#define LEXING_STRING_HEX_ESCAPE_BYTE_8                       26
+#define LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_BACKSLASH 27
+#define LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_U         28
+#define LEXING_SKIPPING_CONTAINER                             29 /* the states from here on skip a container */
+#define LEXING_SKIPPING_STRING                                30
+#define LEXING_SKIPPING_STRING_ESCAPE                         31
+#define LEXING_SKIPPING_COMMENT_AFTER_SLASH                   32
+#define LEXING_SKIPPING_SINGLE_LINE_COMMENT                   33
+#define LEXING_SKIPPING_MULTI_LINE_COMMENT                    34
+#define LEXING_SKIPPING_MULTI_LINE_COMMENT_AFTER_STAR         35
 #define LEXER_ERROR                                           255
 typedef byte LexerState;
 
@@ -953,6 +1005,138 @@ static GrammarianOutput Grammarian_ProcessToken(Grammarian grammarian, Symbol to
     return GRAMMARIAN_OUTPUT(ACCEPTED_TOKEN, emit);
 }
 
+/******************** Arena Allocator ********************/
+
+#ifndef JSON_NO_PARSER
+
+/* The arena sub-allocates memory for short-lived data whose lifetimes are
+   strictly nested, such as the member names of the objects that are
+   currently open. Allocations are carved sequentially out of a chain of
+   chunks and are never freed individually; instead, the client records a
+   mark before allocating and rewinds the arena to the mark when the data
+   is no longer needed. Chunks are retained when the arena is rewound, so
+   once the arena has grown large enough for the deepest nesting in the
+   input, it performs no further calls to the memory suite. */
+
+typedef struct tag_ArenaChunk
+{
+    struct tag_ArenaChunk* pNextChunk;
+    size_t                 size; /* bytes available after the header */
+} ArenaChunk;
+
+typedef union tag_ArenaAlignment
+{
+    void*  pointer;
+    size_t size;
+    double number;
+} ArenaAlignment;
+
+#define ARENA_ALIGNMENT          sizeof(ArenaAlignment)
+#define ARENA_ALIGN(n)           (((n) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+#define ARENA_CHUNK_HEADER_SIZE  ARENA_ALIGN(sizeof(ArenaChunk))
+#define ARENA_CHUNK_BYTES(c)     ((byte*)(c) + ARENA_CHUNK_HEADER_SIZE)
+
+typedef struct tag_ArenaData
+{
+    ArenaChunk* pFirstChunk;
+    ArenaChunk* pCurrentChunk; /* NULL if nothing has been allocated */
+    size_t      currentChunkUsed;
+} ArenaData;
+typedef ArenaData* Arena;
+
+/* A position in the arena to which it can later be rewound. */
+typedef struct tag_ArenaMark
+{
+    ArenaChunk* pChunk;
+    size_t      used;
+} ArenaMark;
+
+static void Arena_Reset(Arena arena, int isInitialized)
+{
+    /* When we reset the arena, we keep the chunks that have already been
+       allocated, if any. */
+    if (!isInitialized)
+    {
+        arena->pFirstChunk = NULL;
+    }
+    arena->pCurrentChunk = NULL;
+    arena->currentChunkUsed = 0;
+}
+
+static void Arena_FreeAllocations(Arena arena, const JSON_MemorySuite* pMemorySuite)
+{
+    while (arena->pFirstChunk)
+    {
+        ArenaChunk* pNextChunk = arena->pFirstChunk->pNextChunk;
+        pMemorySuite->free(pMemorySuite->userData, arena->pFirstChunk);
+        arena->pFirstChunk = pNextChunk;
+    }
+}
+
+static void Arena_GetMark(Arena arena, ArenaMark* pMark)
+{
+    pMark->pChunk = arena->pCurrentChunk;
+    pMark->used = arena->currentChunkUsed;
+}
+
+static void Arena_Rewind(Arena arena, const ArenaMark* pMark)
+{
+    arena->pCurrentChunk = pMark->pChunk;
+    arena->currentChunkUsed = pMark->used;
+}
+
+static void* Arena_Allocate(Arena arena, const JSON_MemorySuite* pMemorySuite, size_t size)
+{
+    ArenaChunk* pChunk = arena->pCurrentChunk;
+    void* pAllocation;
+    if (size > SIZE_MAX - ARENA_CHUNK_HEADER_SIZE - ARENA_ALIGNMENT)
+    {
+        return NULL;
+    }
+    size = ARENA_ALIGN(size);
+    if (!pChunk || pChunk->size - arena->currentChunkUsed < size)
+    {
+        /* Move on to the next chunk, replacing it if it is too small. */
+        ArenaChunk** ppNextChunk = pChunk ? &pChunk->pNextChunk : &arena->pFirstChunk;
+        ArenaChunk* pNextChunk = *ppNextChunk;
+        if (!pNextChunk || pNextChunk->size < size)
+        {
+            size_t chunkSize = DEFAULT_ARENA_CHUNK_SIZE;
+            ArenaChunk* pNewChunk;
+            if (pChunk && pChunk->size <= (SIZE_MAX - ARENA_CHUNK_HEADER_SIZE) / 2)
+            {
+                chunkSize = pChunk->size * 2;
+            }
+            if (chunkSize < size)
+            {
+                chunkSize = size;
+            }
+            pNewChunk = (ArenaChunk*)pMemorySuite->realloc(pMemorySuite->userData, NULL, ARENA_CHUNK_HEADER_SIZE + chunkSize);
+            if (!pNewChunk)
+            {
+                return NULL;
+            }
+            pNewChunk->size = chunkSize;
+            pNewChunk->pNextChunk = NULL;
+            if (pNextChunk)
+            {
+                pNewChunk->pNextChunk = pNextChunk->pNextChunk;
+                pMemorySuite->free(pMemorySuite->userData, pNextChunk);
+            }
+            *ppNextChunk = pNewChunk;
+            pNextChunk = pNewChunk;
+        }
+        arena->pCurrentChunk = pNextChunk;
+        arena->currentChunkUsed = 0;
+        pChunk = pNextChunk;
+    }
+    pAllocation = ARENA_CHUNK_BYTES(pChunk) + arena->currentChunkUsed;
+    arena->currentChunkUsed += size;
+    return pAllocation;
+}
+
+#endif /* JSON_NO_PARSER */
+
 /******************** JSON Parser ********************/
 
 #ifndef JSON_NO_PARSER
@@ -963,8 +1147,17 @@ static GrammarianOutput Grammarian_ProcessToken(Grammarian grammarian, Symbol to
 #define PARSER_FINISHED              0x02
 #define PARSER_IN_PROTECTED_API      0x04
 #define PARSER_IN_TOKEN_HANDLER      0x08
-#define PARSER_AFTER_CARRIAGE_RETURN 0x10
-typedef byte ParserState;
+#define PARSER_AFTER_CARRIAGE_RETURN 0x10 /* the most recent line break was a CR */
+#define PARSER_PULLING               0x20 /* events are pulled with JSON_Parser_NextEvent() */
+#define PARSER_SUSPENDED             0x40 /* input processing must stop so that events can be pulled */
+#define PARSER_INPUT_PENDING         0x80 /* the pulled input has not been used up */
+#define PARSER_FINAL_INPUT           0x100 /* the pulled input is the last input */
+#define PARSER_SKIPPING_VALUE        0x200 /* a handler returned JSON_Parser_SkipValue */
+#define PARSER_NEXT_VALUE_MATCHES    0x400 /* the next value matches a path filter */
+#define PARSER_IN_MEMBER_HANDLER     0x800
+#define PARSER_IN_DOCUMENT           0x1000 /* the current document has started but not finished */
+#define PARSER_SKIPPING_LINE         0x2000 /* the rest of the line after an invalid document is being skipped */
+typedef unsigned short ParserState;
 
 /* Combinable parser settings flags. */
 #define PARSER_DEFAULT_FLAGS         0x00
@@ -976,30 +1169,204 @@ typedef byte ParserState;
 #define PARSER_TRACK_OBJECT_MEMBERS  0x20
 #define PARSER_ALLOW_CONTROL_CHARS   0x40
 #define PARSER_EMBEDDED_DOCUMENT     0x80
-typedef byte ParserFlags;
+#define PARSER_ZERO_COPY_STRINGS     0x100
+#define PARSER_MULTIPLE_DOCUMENTS    0x200
+#define PARSER_SKIP_INVALID          0x400
+#define PARSER_ARRAY_ELEMENTS        0x800 /* the documents are comma-separated array elements (not exposed as a setting) */
+typedef unsigned short ParserFlags;
 
 /* Sentinel value for parser error location offset. */
 #define ERROR_LOCATION_IS_TOKEN_START 0xFF
 
 /* An object member name stored in an unordered, singly-linked-list, used for
    detecting duplicate member names. Note that the name string is not null-
-   terminated. */
+   terminated. The hash is only computed once the object has enough members
+   to be indexed by a hash table. */
 typedef struct tag_MemberName
 {
     struct tag_MemberName* pNextName;
+    uint32_t               hash;
     size_t                 length;
     byte                   pBytes[1]; /* variable-size buffer */
 } MemberName;
 
 /* An object's list of member names, and a pointer to the object's
    nearest ancestor object, if any. This is used as a stack. Because arrays
-   do not have named items, they do not need to be recorded in the stack. */
+   do not have named items, they do not need to be recorded in the stack.
+   Objects with only a few members are checked for duplicates by scanning
+   the list; once an object has more than MEMBER_NAME_HASH_THRESHOLD
+   members, its names are also indexed by an open-addressing hash table
+   whose size is a power of 2 and which is kept no more than half full.
+   The list, its names, and its hash table are allocated from the parser's
+   arena, which is rewound to the list's mark when the object ends. */
 typedef struct tag_MemberNames
 {
     struct tag_MemberNames* pAncestor;
     MemberName*             pFirstName;
+    MemberName**            pTable;    /* NULL until the object is indexed */
+    size_t                  tableSize;
+    size_t                  count;
+    ArenaMark               mark;
 } MemberNames;
 
+/* A node of the trie into which path filters are compiled. The name of a
+   named node is stored in UTF-8 in the parser's path name buffer. The index
+   is the array index named by the node, or SIZE_MAX if the name is not a
+   valid array index. */
+typedef struct tag_PathNode
+{
+    size_t firstChild;  /* 0 if none, since the root is never a child */
+    size_t nextSibling; /* 0 if none */
+    size_t nameOffset;
+    size_t nameLength;
+    size_t index;
+    byte   isWildcard;
+    byte   isMatch;
+} PathNode;
+
+/* A key dictionary seed with this bit set is the slot of the only key in
+   its bucket rather than a seed. */
+#define KEY_SEED_IS_SLOT ((uint32_t)0x80000000)
+
+/* The digits of a number token, accumulated as the token is lexed so that
+   the number can be converted to a native type without scanning its text
+   again. The number's magnitude is mantissa * base^(exponent +/- explicit
+   exponent), where base is 16 for hex numbers and 10 otherwise. Once the
+   mantissa is full, any further digits are dropped, and if any of the
+   dropped digits is non-zero the mantissa is truncated. The exponent that
+   accounts for fractional and dropped digits is exact, since it cannot
+   exceed the length of the token, but the explicit exponent saturates at
+   NUMBER_EXPONENT_LIMIT, beyond which the magnitude of any number is
+   either 0 or infinite when converted to a double. */
+typedef struct tag_NumberData
+{
+    JSON_UInt64 mantissa;
+    JSON_Int64  exponent;
+    long        explicitExponent;
+    size_t      significantDigits; /* not including leading zeros */
+    size_t      trailingZeros;
+    byte        mantissaFull;
+    byte        mantissaTruncated;
+} NumberData;
+typedef NumberData* Number;
+
+#define NUMBER_EXPONENT_LIMIT 100000L
+
+static void Number_Reset(Number number)
+{
+    number->mantissa = 0;
+    number->exponent = 0;
+    number->explicitExponent = 0;
+    number->significantDigits = 0;
+    number->trailingZeros = 0;
+    number->mantissaFull = 0;
+    number->mantissaTruncated = 0;
+}
+
+static void Number_AddDigit(Number number, unsigned int base, unsigned int digit, int isFractional)
+{
+    if (digit || number->significantDigits)
+    {
+        number->significantDigits++;
+        number->trailingZeros = digit ? 0 : number->trailingZeros + 1;
+    }
+    if (!number->mantissaFull && number->mantissa <= ((JSON_UInt64)-1 - digit) / base)
+    {
+        number->mantissa = number->mantissa * base + digit;
+        if (isFractional)
+        {
+            number->exponent--;
+        }
+    }
+    else
+    {
+        number->mantissaFull = 1;
+        if (digit)
+        {
+            number->mantissaTruncated = 1;
+        }
+        if (!isFractional)
+        {
+            number->exponent++;
+        }
+    }
+}
+
+static void Number_AddExponentDigit(Number number, unsigned int digit)
+{
+    if (number->explicitExponent < NUMBER_EXPONENT_LIMIT)
+    {
+        number->explicitExponent = number->explicitExponent * 10 + (long)digit;
+    }
+}
+
+/* A document's tape holds one 64-bit word for each value, in document
+   order, with the value's type in the top 8 bits and a payload in the
+   other 56 bits:
+
+     TAPE_NULL, TAPE_TRUE, TAPE_FALSE      no payload
+     TAPE_STRING, TAPE_MEMBER_NAME         offset of the string's entry in the
+                                           document's bytes
+     TAPE_INT64, TAPE_UINT64, TAPE_DOUBLE  offset of the number's entry in the
+                                           document's bytes
+     TAPE_SPECIAL_NUMBER                   the JSON_SpecialNumber value
+     TAPE_START_OBJECT, TAPE_START_ARRAY   index of the word that follows the
+                                           matching end word
+     TAPE_END_OBJECT, TAPE_END_ARRAY       number of items in the container
+
+   The name of an object member immediately precedes its value. An entry in
+   the document's bytes is a DocumentEntry header, followed for a number by
+   the 8 bytes of its converted value, followed by the text and a null
+   terminator. Entries are aligned to DOCUMENT_ENTRY_ALIGNMENT bytes, so the
+   text is suitably aligned for UTF-16 and UTF-32 code units. */
+#define TAPE_NULL            0x01
+#define TAPE_TRUE            0x02
+#define TAPE_FALSE           0x03
+#define TAPE_STRING          0x04
+#define TAPE_MEMBER_NAME     0x05
+#define TAPE_INT64           0x06
+#define TAPE_UINT64          0x07
+#define TAPE_DOUBLE          0x08
+#define TAPE_SPECIAL_NUMBER  0x09
+#define TAPE_START_OBJECT    0x0A
+#define TAPE_END_OBJECT      0x0B
+#define TAPE_START_ARRAY     0x0C
+#define TAPE_END_ARRAY       0x0D
+
+#define TAPE_WORD(type, payload) (((JSON_UInt64)(type) << 56) | (JSON_UInt64)(payload))
+#define TAPE_TYPE(word)          ((byte)((word) >> 56))
+#define TAPE_PAYLOAD(word)       ((size_t)((word) & (((JSON_UInt64)1 << 56) - 1)))
+
+typedef struct tag_DocumentEntry
+{
+    size_t       length;
+    unsigned int attributes;
+} DocumentEntry;
+
+#define DOCUMENT_ENTRY_ALIGNMENT   8 /* MUST be a power of 2 */
+#define DOCUMENT_ENTRY_ALIGN(n)    (((n) + (DOCUMENT_ENTRY_ALIGNMENT - 1)) & ~(size_t)(DOCUMENT_ENTRY_ALIGNMENT - 1))
+#define DOCUMENT_ENTRY_HEADER_SIZE DOCUMENT_ENTRY_ALIGN(sizeof(DocumentEntry))
+#define DOCUMENT_NUMBER_VALUE_SIZE 8
+
+/* A document instance. The containers that have started but not ended
+   while the document is being recorded are kept on a stack of pairs: the
+   index of the container's start word, and the number of items recorded
+   in it so far. */
+struct JSON_Document_Data
+{
+    JSON_MemorySuite memorySuite;
+    JSON_UInt64*     pTape;
+    size_t           tapeLength;
+    size_t           tapeUsed;
+    byte*            pBytes;
+    size_t           bytesLength;
+    size_t           bytesUsed;
+    size_t*          pOpenContainers;
+    size_t           openContainersLength;
+    size_t           openContainersUsed;
+    byte             isComplete;
+};
+
 /* A parser instance. */
 struct JSON_Parser_Data
 {
@@ -1016,26 +1383,72 @@ struct JSON_Parser_Data
     byte                                errorOffset;
     LexerState                          lexerState;
     uint32_t                            lexerBits;
+    byte                                lexerClasses[128];
     size_t                              codepointLocationByte;
     size_t                              codepointLocationLine;
-    size_t                              codepointLocationColumn;
+    size_t                              lineStartByte;
+    size_t                              lineExtraBytes;
     size_t                              tokenLocationByte;
     size_t                              tokenLocationLine;
     size_t                              tokenLocationColumn;
     size_t                              depth;
+    size_t                              skipDepth;
     byte*                               pTokenBytes;
+    const byte*                         pInputTokenBytes;
     size_t                              tokenBytesLength;
     size_t                              tokenBytesUsed;
     size_t                              maxStringLength;
     size_t                              maxNumberLength;
     MemberNames*                        pMemberNames;
+    ArenaData                           arenaData;
+    size_t*                             pStructuralIndex;
+    size_t                              structuralIndexLength;
+    size_t                              structuralIndexUsed;
+    size_t                              structuralIndexNext;
+    const byte*                         pPullInputBytes;
+    size_t                              pullInputLength;
+    size_t                              pullInputUsed;
+    byte                                replayBytes[LONGEST_ENCODING_SEQUENCE];
+    size_t                              replayLength;
+    size_t                              replayUsed;
+    JSON_Event                          events[MAX_QUEUED_EVENTS];
+    byte                                eventsQueued;
+    byte                                eventsReturned;
+    JSON_BatchedEvent*                  pBatchEvents;
+    size_t                              batchEventsLength;
+    size_t                              batchEventsUsed;
+    byte*                               pBatchStringBytes;
+    size_t                              batchStringBytesLength;
+    size_t                              batchStringBytesUsed;
+    JSON_Document                       pDocument;
+    PathNode*                           pPathNodes;
+    size_t                              pathNodesLength;
+    size_t                              pathNodesUsed;
+    byte*                               pPathNameBytes;
+    size_t                              pathNameBytesLength;
+    size_t                              pathNameBytesUsed;
+    size_t*                             pPathStack;
+    size_t                              pathStackLength;
+    size_t                              pathStackUsed;
+    size_t                              pathNextCount;
+    size_t                              pathMatchedDepth;
+    byte*                               pKeyNames;
+    size_t*                             pKeyNameOffsets; /* keyCount + 1 entries */
+    size_t*                             pKeySlots;       /* keyCount entries, after the offsets */
+    uint32_t*                           pKeySeeds;       /* keyCount entries */
+    size_t                              keyCount;
+    size_t                              memberKeyIndex;
+    size_t                              arrayElementIndex;
+    byte                                keyEncoding;
     DecoderData                         decoderData;
     GrammarianData                      grammarianData;
+    NumberData                          numberData;
     JSON_Parser_EncodingDetectedHandler encodingDetectedHandler;
     JSON_Parser_NullHandler             nullHandler;
     JSON_Parser_BooleanHandler          booleanHandler;
     JSON_Parser_StringHandler           stringHandler;
     JSON_Parser_NumberHandler           numberHandler;
+    JSON_Parser_TypedNumberHandler      typedNumberHandler;
     JSON_Parser_SpecialNumberHandler    specialNumberHandler;
     JSON_Parser_StartObjectHandler      startObjectHandler;
     JSON_Parser_EndObjectHandler        endObjectHandler;
@@ -1043,6 +1456,9 @@ struct JSON_Parser_Data
     JSON_Parser_StartArrayHandler       startArrayHandler;
     JSON_Parser_EndArrayHandler         endArrayHandler;
     JSON_Parser_ArrayItemHandler        arrayItemHandler;
+    JSON_Parser_StartDocumentHandler    startDocumentHandler;
+    JSON_Parser_EndDocumentHandler      endDocumentHandler;
+    JSON_Parser_EventBatchHandler       eventBatchHandler;
     byte                                defaultTokenBytes[DEFAULT_TOKEN_BYTES_LENGTH];
 };
 
@@ -1081,7 +1497,10 @@ static void JSON_Parser_SetErrorAtToken(JSON_Parser parser, Error error)
 
 static JSON_Status JSON_Parser_PushMemberNameList(JSON_Parser parser)
 {
-    MemberNames* pNames = (MemberNames*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, sizeof(MemberNames));
+    ArenaMark mark;
+    MemberNames* pNames;
+    Arena_GetMark(&parser->arenaData, &mark);
+    pNames = (MemberNames*)Arena_Allocate(&parser->arenaData, &parser->memorySuite, sizeof(MemberNames));
     if (!pNames)
     {
         JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
@@ -1089,21 +1508,19 @@ static JSON_Status JSON_Parser_PushMemberNameList(JSON_Parser parser)
     }
     pNames->pAncestor = parser->pMemberNames;
     pNames->pFirstName = NULL;
+    pNames->pTable = NULL;
+    pNames->tableSize = 0;
+    pNames->count = 0;
+    pNames->mark = mark;
     parser->pMemberNames = pNames;
     return JSON_Success;
 }
 
 static void JSON_Parser_PopMemberNameList(JSON_Parser parser)
 {
-    MemberNames* pAncestor = parser->pMemberNames->pAncestor;
-    while (parser->pMemberNames->pFirstName)
-    {
-        MemberName* pNextName = parser->pMemberNames->pFirstName->pNextName;
-        parser->memorySuite.free(parser->memorySuite.userData, parser->pMemberNames->pFirstName);
-        parser->pMemberNames->pFirstName = pNextName;
-    }
-    parser->memorySuite.free(parser->memorySuite.userData, parser->pMemberNames);
-    parser->pMemberNames = pAncestor;
+    MemberNames* pNames = parser->pMemberNames;
+    parser->pMemberNames = pNames->pAncestor;
+    Arena_Rewind(&parser->arenaData, &pNames->mark);
 }
 
 static JSON_Status JSON_Parser_StartContainer(JSON_Parser parser, int isObject)
@@ -1126,40 +1543,179 @@ static void JSON_Parser_EndContainer(JSON_Parser parser, int isObject)
     }
 }
 
+static const byte* JSON_Parser_GetTokenBytes(JSON_Parser parser)
+{
+    /* A string token's bytes may still be in the client's input buffer
+       if the parser is delivering zero-copy strings. */
+    return parser->pInputTokenBytes ? parser->pInputTokenBytes : parser->pTokenBytes;
+}
+
+static JSON_Status JSON_Parser_CopyInputTokenBytes(JSON_Parser parser)
+{
+    /* Copy the bytes of a string token that were deferred in the hope of
+       delivering the string directly from the client's input buffer, since
+       that is no longer possible. */
+    while (parser->tokenBytesUsed > parser->tokenBytesLength - LONGEST_ENCODING_SEQUENCE)
+    {
+        byte* pBiggerBuffer = DoubleBuffer(&parser->memorySuite, parser->defaultTokenBytes, parser->pTokenBytes, parser->tokenBytesLength);
+        if (!pBiggerBuffer)
+        {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+            return JSON_Failure;
+        }
+        parser->pTokenBytes = pBiggerBuffer;
+        parser->tokenBytesLength *= 2;
+    }
+    memcpy(parser->pTokenBytes, parser->pInputTokenBytes, parser->tokenBytesUsed);
+    parser->pInputTokenBytes = NULL;
+    return JSON_Success;
+}
+
+static uint32_t HashMemberName(const byte* pBytes, size_t length)
+{
+    /* 32-bit FNV-1a. */
+    uint32_t hash = 0x811C9DC5;
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ pBytes[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+static void MemberNames_InsertIntoTable(MemberNames* pNames, MemberName* pName)
+{
+    size_t mask = pNames->tableSize - 1;
+    size_t index = pName->hash & mask;
+    while (pNames->pTable[index])
+    {
+        index = (index + 1) & mask;
+    }
+    pNames->pTable[index] = pName;
+}
+
+static JSON_Status JSON_Parser_GrowMemberNameTable(JSON_Parser parser)
+{
+    /* The previous table, if any, is abandoned in the arena; since each
+       table is twice the size of the one before it, the abandoned tables
+       never take up more space than the current one. */
+    MemberNames* pNames = parser->pMemberNames;
+    size_t tableSize = pNames->tableSize ? pNames->tableSize * 2 : MIN_MEMBER_NAME_TABLE_SIZE;
+    MemberName** pTable = NULL;
+    MemberName* pName;
+    if (tableSize <= SIZE_MAX / sizeof(MemberName*))
+    {
+        pTable = (MemberName**)Arena_Allocate(&parser->arenaData, &parser->memorySuite, tableSize * sizeof(MemberName*));
+    }
+    if (!pTable)
+    {
+        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+        return JSON_Failure;
+    }
+    memset(pTable, 0, tableSize * sizeof(MemberName*));
+    pNames->pTable = pTable;
+    pNames->tableSize = tableSize;
+    for (pName = pNames->pFirstName; pName; pName = pName->pNextName)
+    {
+        MemberNames_InsertIntoTable(pNames, pName);
+    }
+    return JSON_Success;
+}
+
 static JSON_Status JSON_Parser_AddMemberNameToList(JSON_Parser parser)
 {
     if (GET_FLAGS(parser->flags, PARSER_TRACK_OBJECT_MEMBERS))
     {
+        MemberNames* pNames = parser->pMemberNames;
+        const byte* pTokenBytes = JSON_Parser_GetTokenBytes(parser);
+        size_t length = parser->tokenBytesUsed;
+        uint32_t hash = 0;
         MemberName* pName;
-        for (pName = parser->pMemberNames->pFirstName; pName; pName = pName->pNextName)
+        if (pNames->count < MEMBER_NAME_HASH_THRESHOLD)
+        {
+            for (pName = pNames->pFirstName; pName; pName = pName->pNextName)
+            {
+                if (pName->length == length && !memcmp(pName->pBytes, pTokenBytes, length))
+                {
+                    JSON_Parser_SetErrorAtToken(parser, JSON_Error_DuplicateObjectMember);
+                    return JSON_Failure;
+                }
+            }
+        }
+        else
         {
-            if (pName->length == parser->tokenBytesUsed && !memcmp(pName->pBytes, parser->pTokenBytes, pName->length))
+            size_t mask;
+            size_t index;
+            if (!pNames->pTable)
+            {
+                /* The object has just outgrown the list, so hash the names
+                   that are already in it and index them. */
+                for (pName = pNames->pFirstName; pName; pName = pName->pNextName)
+                {
+                    pName->hash = HashMemberName(pName->pBytes, pName->length);
+                }
+            }
+            if (pNames->count + 1 > pNames->tableSize / 2 && !JSON_Parser_GrowMemberNameTable(parser))
             {
-                JSON_Parser_SetErrorAtToken(parser, JSON_Error_DuplicateObjectMember);
                 return JSON_Failure;
             }
+            hash = HashMemberName(pTokenBytes, length);
+            mask = pNames->tableSize - 1;
+            for (index = hash & mask; (pName = pNames->pTable[index]) != NULL; index = (index + 1) & mask)
+            {
+                if (pName->hash == hash && pName->length == length && !memcmp(pName->pBytes, pTokenBytes, length))
+                {
+                    JSON_Parser_SetErrorAtToken(parser, JSON_Error_DuplicateObjectMember);
+                    return JSON_Failure;
+                }
+            }
         }
-        pName = (MemberName*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, sizeof(MemberName) + parser->tokenBytesUsed - 1);
+        pName = (MemberName*)Arena_Allocate(&parser->arenaData, &parser->memorySuite, sizeof(MemberName) + length - 1);
         if (!pName)
         {
             JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
             return JSON_Failure;
         }
-        pName->pNextName = parser->pMemberNames->pFirstName;
-        pName->length = parser->tokenBytesUsed;
-        memcpy(pName->pBytes, parser->pTokenBytes, parser->tokenBytesUsed);
-        parser->pMemberNames->pFirstName = pName;
+        pName->pNextName = pNames->pFirstName;
+        pName->hash = hash;
+        pName->length = length;
+        memcpy(pName->pBytes, pTokenBytes, length);
+        pNames->pFirstName = pName;
+        pNames->count++;
+        if (pNames->pTable)
+        {
+            MemberNames_InsertIntoTable(pNames, pName);
+        }
     }
     return JSON_Success;
 }
 
-static void JSON_Parser_ResetData(JSON_Parser parser, int isInitialized)
+static void JSON_Parser_FreeKeyDictionary(JSON_Parser parser)
+{
+    if (parser->pKeyNames)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pKeyNames);
+        parser->pKeyNames = NULL;
+    }
+    if (parser->pKeyNameOffsets)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pKeyNameOffsets);
+        parser->pKeyNameOffsets = NULL;
+    }
+    if (parser->pKeySeeds)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pKeySeeds);
+        parser->pKeySeeds = NULL;
+    }
+    parser->pKeySlots = NULL;
+    parser->keyCount = 0;
+    parser->keyEncoding = JSON_UTF8;
+}
+
+/* Reset the state of the parse in progress, but keep the parser's settings,
+   handlers, path filters and key dictionary. */
+static void JSON_Parser_ResetParseState(JSON_Parser parser, int isInitialized)
 {
-    parser->userData = NULL;
-    parser->flags = PARSER_DEFAULT_FLAGS;
-    parser->inputEncoding = JSON_UnknownEncoding;
-    parser->stringEncoding = JSON_UTF8;
-    parser->numberEncoding = JSON_UTF8;
     parser->token = T_NONE;
     parser->tokenAttributes = 0;
     parser->error = JSON_Error_None;
@@ -1168,44 +1724,87 @@ static void JSON_Parser_ResetData(JSON_Parser parser, int isInitialized)
     parser->lexerBits = 0;
     parser->codepointLocationByte = 0;
     parser->codepointLocationLine = 0;
-    parser->codepointLocationColumn = 0;
+    parser->lineStartByte = 0;
+    parser->lineExtraBytes = 0;
     parser->tokenLocationByte = 0;
     parser->tokenLocationLine = 0;
     parser->tokenLocationColumn = 0;
     parser->depth = 0;
+    parser->skipDepth = 0;
+    parser->pInputTokenBytes = NULL;
+    parser->tokenBytesUsed = 0;
+    parser->pMemberNames = NULL;
+    Arena_Reset(&parser->arenaData, isInitialized);
+    parser->structuralIndexUsed = 0;
+    parser->structuralIndexNext = 0;
+    parser->pPullInputBytes = NULL;
+    parser->pullInputLength = 0;
+    parser->pullInputUsed = 0;
+    parser->replayLength = 0;
+    parser->replayUsed = 0;
+    parser->eventsQueued = 0;
+    parser->eventsReturned = 0;
+    parser->batchEventsUsed = 0;
+    parser->batchStringBytesUsed = 0;
+    parser->pathStackUsed = 0;
+    parser->pathNextCount = 0;
+    parser->pathMatchedDepth = 0;
+    parser->memberKeyIndex = 0;
+    parser->arrayElementIndex = 0;
+    Decoder_Reset(&parser->decoderData);
+    Grammarian_Reset(&parser->grammarianData, isInitialized);
+    Number_Reset(&parser->numberData);
+    parser->state = PARSER_RESET; /* do this last! */
+}
+
+static void JSON_Parser_ResetData(JSON_Parser parser, int isInitialized)
+{
+    parser->userData = NULL;
+    parser->flags = PARSER_DEFAULT_FLAGS;
+    parser->inputEncoding = JSON_UnknownEncoding;
+    parser->stringEncoding = JSON_UTF8;
+    parser->numberEncoding = JSON_UTF8;
     if (!isInitialized)
     {
         parser->pTokenBytes = parser->defaultTokenBytes;
         parser->tokenBytesLength = sizeof(parser->defaultTokenBytes);
+        parser->pStructuralIndex = NULL;
+        parser->structuralIndexLength = 0;
+        parser->pBatchStringBytes = NULL;
+        parser->batchStringBytesLength = 0;
+        parser->pPathNodes = NULL;
+        parser->pathNodesLength = 0;
+        parser->pPathNameBytes = NULL;
+        parser->pathNameBytesLength = 0;
+        parser->pPathStack = NULL;
+        parser->pathStackLength = 0;
+        parser->pKeyNames = NULL;
+        parser->pKeyNameOffsets = NULL;
+        parser->pKeySeeds = NULL;
     }
     else
     {
-        /* When we reset the parser, we keep the output buffer and the symbol
-           stack that have already been allocated, if any. If the client wants
-           to reclaim the memory used by the those buffers, he needs to free
-           the parser and create a new one. */
+        /* When we reset the parser, we keep the output buffer, the symbol
+           stack, the arena, the structural index buffer, the batch string
+           bytes, and the path filter buffers that have already been
+           allocated, if any. If the client wants to reclaim the memory used
+           by the those buffers, he needs to free the parser and create a
+           new one. */
     }
-    parser->tokenBytesUsed = 0;
     parser->maxStringLength = SIZE_MAX;
     parser->maxNumberLength = SIZE_MAX;
-    if (!isInitialized)
-    {
-        parser->pMemberNames = NULL;
-    }
-    else
-    {
-        while (parser->pMemberNames)
-        {
-            JSON_Parser_PopMemberNameList(parser);
-        }
-    }
-    Decoder_Reset(&parser->decoderData);
-    Grammarian_Reset(&parser->grammarianData, isInitialized);
+    parser->pBatchEvents = NULL;
+    parser->batchEventsLength = 0;
+    parser->pDocument = NULL;
+    parser->pathNodesUsed = 0;
+    parser->pathNameBytesUsed = 0;
+    JSON_Parser_FreeKeyDictionary(parser);
     parser->encodingDetectedHandler = NULL;
     parser->nullHandler = NULL;
     parser->booleanHandler = NULL;
     parser->stringHandler = NULL;
     parser->numberHandler = NULL;
+    parser->typedNumberHandler = NULL;
     parser->specialNumberHandler = NULL;
     parser->startObjectHandler = NULL;
     parser->endObjectHandler = NULL;
@@ -1213,7 +1812,10 @@ static void JSON_Parser_ResetData(JSON_Parser parser, int isInitialized)
     parser->startArrayHandler = NULL;
     parser->endArrayHandler = NULL;
     parser->arrayItemHandler = NULL;
-    parser->state = PARSER_RESET; /* do this last! */
+    parser->startDocumentHandler = NULL;
+    parser->endDocumentHandler = NULL;
+    parser->eventBatchHandler = NULL;
+    JSON_Parser_ResetParseState(parser, isInitialized); /* do this last! */
 }
 
 static void JSON_Parser_NullTerminateToken(JSON_Parser parser)
@@ -1228,8 +1830,11 @@ static void JSON_Parser_NullTerminateToken(JSON_Parser parser)
 
 static JSON_Status JSON_Parser_FlushParser(JSON_Parser parser)
 {
-    /* The symbol stack should be empty when parsing finishes. */
-    if (!Grammarian_FinishedDocument(&parser->grammarianData))
+    /* The symbol stack should be empty when parsing finishes. A stream of
+       documents can also end between documents, including before the
+       first one, but a stream of array elements cannot end with a comma. */
+    if (!Grammarian_FinishedDocument(&parser->grammarianData) &&
+        (GET_FLAGS(parser->state, PARSER_IN_DOCUMENT) || GET_FLAGS(parser->flags, PARSER_ARRAY_ELEMENTS) || !GET_FLAGS(parser->flags, PARSER_MULTIPLE_DOCUMENTS)))
     {
         JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_ExpectedMoreTokens);
         return JSON_Failure;
@@ -1238,7 +1843,7 @@ static JSON_Status JSON_Parser_FlushParser(JSON_Parser parser)
 }
 
 typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_SimpleTokenHandler)(JSON_Parser parser);
-static JSON_Status JSON_Parser_CallSimpleTokenHandler(JSON_Parser parser, JSON_Parser_SimpleTokenHandler handler)
+static JSON_Status JSON_Parser_CallSimpleTokenHandler(JSON_Parser parser, JSON_Parser_SimpleTokenHandler handler, int canSkipValue)
 {
     if (handler)
     {
@@ -1246,7 +1851,11 @@ static JSON_Status JSON_Parser_CallSimpleTokenHandler(JSON_Parser parser, JSON_P
         SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
         result = handler(parser);
         SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        if (result != JSON_Parser_Continue)
+        if (canSkipValue && result == JSON_Parser_SkipValue)
+        {
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_SKIPPING_VALUE);
+        }
+        else if (result != JSON_Parser_Continue)
         {
             JSON_Parser_SetErrorAtToken(parser, JSON_Error_AbortedByHandler);
             return JSON_Failure;
@@ -1278,11 +1887,23 @@ static JSON_Status JSON_Parser_CallStringHandler(JSON_Parser parser, int isObjec
     if (handler)
     {
         JSON_Parser_HandlerResult result;
-        JSON_Parser_NullTerminateToken(parser);
-        SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        result = handler(parser, (char*)parser->pTokenBytes, parser->tokenBytesUsed, parser->tokenAttributes);
-        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        if (result != JSON_Parser_Continue)
+        JSON_StringAttributes attributes = parser->tokenAttributes;
+        if (parser->pInputTokenBytes)
+        {
+            attributes |= JSON_PointsIntoInput;
+        }
+        else
+        {
+            JSON_Parser_NullTerminateToken(parser);
+        }
+        SET_FLAGS_ON(ParserState, parser->state, isObjectMember ? (PARSER_IN_TOKEN_HANDLER | PARSER_IN_MEMBER_HANDLER) : PARSER_IN_TOKEN_HANDLER);
+        result = handler(parser, (char*)JSON_Parser_GetTokenBytes(parser), parser->tokenBytesUsed, attributes);
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER | PARSER_IN_MEMBER_HANDLER);
+        if (isObjectMember && result == JSON_Parser_SkipValue)
+        {
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_SKIPPING_VALUE);
+        }
+        else if (result != JSON_Parser_Continue)
         {
             JSON_Parser_SetErrorAtToken(parser, (isObjectMember && result == JSON_Parser_TreatAsDuplicateObjectMember)
                                         ? JSON_Error_DuplicateObjectMember : JSON_Error_AbortedByHandler);
@@ -1292,1355 +1913,6017 @@ static JSON_Status JSON_Parser_CallStringHandler(JSON_Parser parser, int isObjec
     return JSON_Success;
 }
 
-static JSON_Status JSON_Parser_CallNumberHandler(JSON_Parser parser)
+/* Powers of 10 that are exactly representable as doubles. */
+static const double exactPowersOf10[] =
 {
-    if (parser->numberHandler)
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+#define MAX_EXACT_POWER_OF_10    22
+#define MAX_EXACT_DOUBLE_INTEGER ((JSON_UInt64)1 << 53)
+
+static int Number_ConvertExactly(Number number, long exponent, double* pValue)
+{
+    /* If the mantissa and 10^|exponent| are both exactly representable as
+       doubles, a single multiplication or division yields the correctly-
+       rounded result (Clinger's fast path). This covers the overwhelming
+       majority of numbers found in practice. */
+    JSON_UInt64 mantissa = number->mantissa;
+    if (number->mantissaTruncated || mantissa > MAX_EXACT_DOUBLE_INTEGER ||
+        exponent < -MAX_EXACT_POWER_OF_10)
     {
-        JSON_Parser_HandlerResult result;
-        JSON_Parser_NullTerminateToken(parser);
-        SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        result = parser->numberHandler(parser, (char*)parser->pTokenBytes, parser->tokenBytesUsed, parser->tokenAttributes);
-        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        if (result != JSON_Parser_Continue)
-        {
-            JSON_Parser_SetErrorAtToken(parser, JSON_Error_AbortedByHandler);
-            return JSON_Failure;
-        }
+        return 0;
+    }
+    if (exponent < 0)
+    {
+        *pValue = (double)mantissa / exactPowersOf10[-exponent];
+        return 1;
     }
-    return JSON_Success;
-}
 
-static JSON_Status JSON_Parser_CallSpecialNumberHandler(JSON_Parser parser)
-{
-    if (parser->specialNumberHandler)
+    /* When the exponent is too large, we can still take the fast path if
+       moving some of it into the mantissa leaves the mantissa exact, as
+       with 123e25 = 123000e22. */
+    while (exponent > MAX_EXACT_POWER_OF_10)
     {
-        JSON_Parser_HandlerResult result;
-        SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        result = parser->specialNumberHandler(parser, parser->token == T_NAN ? JSON_NaN :
-                                              (parser->token == T_INFINITY ? JSON_Infinity : JSON_NegativeInfinity));
-        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
-        if (result != JSON_Parser_Continue)
+        if (mantissa > MAX_EXACT_DOUBLE_INTEGER / 10)
         {
-            JSON_Parser_SetErrorAtToken(parser, JSON_Error_AbortedByHandler);
-            return JSON_Failure;
+            return 0;
         }
+        mantissa *= 10;
+        exponent--;
     }
-    return JSON_Success;
+    *pValue = (double)mantissa * exactPowersOf10[exponent];
+    return 1;
 }
 
-static JSON_Status JSON_Parser_HandleGrammarEvents(JSON_Parser parser, byte emit)
+/* The longest text of an exponent written by JSON_Parser_ConvertNumberText(),
+   "e" and a sign followed by the digits of a long, and the largest
+   magnitude of exponent that it writes, beyond which any number overflows
+   to infinity or, once its digits are accounted for, underflows to 0. */
+#define MAX_EXPONENT_TEXT_LENGTH 24
+#define MAX_PARSED_EXPONENT      100000000L
+
+static JSON_Status JSON_Parser_ConvertNumberText(JSON_Parser parser, double* pValue)
 {
-    if (GET_FLAGS(emit, EMIT_ARRAY_ITEM))
+    /* The number is not eligible for the fast path, so we convert its text
+       to ASCII and let strtod() do the hard work of computing its magnitude.
+       Since strtod() is locale-sensitive, the text is written without a
+       decimal point, as the digits followed by an exponent that accounts
+       for the fractional digits. Leading zeros are left out, since they
+       do not affect the value. */
+    char defaultText[64];
+    char* pText = defaultText;
+    size_t charLength = SHORTEST_ENCODING_SEQUENCE(parser->numberEncoding);
+    size_t charOffset = (parser->numberEncoding == JSON_UTF16BE || parser->numberEncoding == JSON_UTF32BE) ? charLength - 1 : 0;
+    size_t length = parser->tokenBytesUsed / charLength;
+    size_t digitCount = 0;
+    size_t fractionDigitCount = 0;
+    JSON_Int64 exponent = 0;
+    JSON_Int64 maxExponent = MAX_PARSED_EXPONENT + (JSON_Int64)length;
+    int inFraction = 0;
+    int isExponentNegative = 0;
+    size_t i = 0;
+    if (length + MAX_EXPONENT_TEXT_LENGTH >= sizeof(defaultText))
     {
-        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->arrayItemHandler))
+        pText = (char*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, length + MAX_EXPONENT_TEXT_LENGTH + 1);
+        if (!pText)
         {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
             return JSON_Failure;
         }
-        SET_FLAGS_OFF(byte, emit, EMIT_ARRAY_ITEM);
     }
-    switch (emit)
+    for (; i < length; i++)
     {
-    case EMIT_NULL:
-        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->nullHandler))
+        char c = (char)parser->pTokenBytes[i * charLength + charOffset];
+        if (c == '.')
         {
-            return JSON_Failure;
+            inFraction = 1;
         }
-        break;
+        else if (c == 'e' || c == 'E')
+        {
+            break;
+        }
+        else if (c != '-')
+        {
+            if (c != '0' || digitCount)
+            {
+                pText[digitCount++] = c;
+            }
+            if (inFraction)
+            {
+                fractionDigitCount++;
+            }
+        }
+    }
+    for (i++; i < length; i++)
+    {
+        char c = (char)parser->pTokenBytes[i * charLength + charOffset];
+        if (c == '-')
+        {
+            isExponentNegative = 1;
+        }
+        else if (c != '+' && exponent < maxExponent)
+        {
+            /* An exponent this large still exceeds MAX_PARSED_EXPONENT once
+               the fractional digits are accounted for, so it does not
+               need to be exact. */
+            exponent = exponent * 10 + (c - '0');
+        }
+    }
+    if (isExponentNegative)
+    {
+        exponent = -exponent;
+    }
+    exponent -= (JSON_Int64)fractionDigitCount;
+    if (exponent > MAX_PARSED_EXPONENT)
+    {
+        exponent = MAX_PARSED_EXPONENT;
+    }
+    else if (exponent < -MAX_PARSED_EXPONENT - (JSON_Int64)digitCount)
+    {
+        exponent = -MAX_PARSED_EXPONENT - (JSON_Int64)digitCount;
+    }
+    sprintf(pText + digitCount, "e%ld", (long)exponent);
+    *pValue = strtod(pText, NULL);
+    if (pText != defaultText)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, pText);
+    }
+    return JSON_Success;
+}
 
-    case EMIT_BOOLEAN:
-        if (!JSON_Parser_CallBooleanHandler(parser))
+static JSON_Status JSON_Parser_ConvertNumber(JSON_Parser parser, JSON_NumberValue* pValue, JSON_NumberAttributes* pAttributes)
+{
+    Number number = &parser->numberData;
+    int isNegative = GET_FLAGS(parser->tokenAttributes, JSON_IsNegative);
+    double value = 0.0;
+    pValue->type = JSON_DoubleNumber;
+    pValue->int64Value = 0;
+    pValue->uint64Value = 0;
+    pValue->doubleValue = 0.0;
+    *pAttributes = parser->tokenAttributes;
+
+    /* Integers whose digits all fit in the mantissa are delivered exactly,
+       except for -0, which only a double can represent. */
+    if (!GET_FLAGS(parser->tokenAttributes, JSON_ContainsDecimalPoint | JSON_ContainsExponent) &&
+        !number->exponent)
+    {
+        if (!isNegative)
+        {
+            if (number->mantissa <= (((JSON_UInt64)1 << 63) - 1))
+            {
+                pValue->type = JSON_Int64Number;
+                pValue->int64Value = (JSON_Int64)number->mantissa;
+            }
+            else
+            {
+                pValue->type = JSON_UInt64Number;
+                pValue->uint64Value = number->mantissa;
+            }
+            return JSON_Success;
+        }
+        if (number->mantissa && number->mantissa <= ((JSON_UInt64)1 << 63))
+        {
+            /* Avoid overflow when negating -2^63. */
+            pValue->type = JSON_Int64Number;
+            pValue->int64Value = -(JSON_Int64)(number->mantissa - 1) - 1;
+            return JSON_Success;
+        }
+    }
+
+    if (GET_FLAGS(parser->tokenAttributes, JSON_IsHex))
+    {
+        /* Scaling by a power of 2 is exact, so only the conversion of the
+           mantissa can round. The mantissa is full when digits have been
+           dropped, so its lowest bit lies well below the bits that a
+           double keeps; setting it when a dropped digit is non-zero makes
+           the conversion round as if the dropped digits were present. */
+        JSON_Int64 exponent = number->exponent;
+        value = (double)(number->mantissaTruncated ? (number->mantissa | 1) : number->mantissa);
+        while (exponent-- > 0 && value <= DBL_MAX)
+        {
+            value *= 16.0;
+        }
+    }
+    else
+    {
+        /* The combined exponent is inexact once the explicit exponent has
+           saturated, so such numbers always take the slow path. */
+        JSON_Int64 exponent = number->exponent +
+            (GET_FLAGS(parser->tokenAttributes, JSON_ContainsNegativeExponent) ? -number->explicitExponent : number->explicitExponent);
+        if (!number->mantissa)
+        {
+            value = 0.0;
+        }
+        else if (number->explicitExponent >= NUMBER_EXPONENT_LIMIT ||
+                 exponent > NUMBER_EXPONENT_LIMIT || exponent < -NUMBER_EXPONENT_LIMIT ||
+                 !Number_ConvertExactly(number, (long)exponent, &value))
+        {
+            if (!JSON_Parser_ConvertNumberText(parser, &value))
+            {
+                return JSON_Failure;
+            }
+        }
+    }
+    if (isNegative)
+    {
+        value = -value;
+    }
+    pValue->doubleValue = value;
+    if (number->significantDigits - number->trailingZeros > DBL_DIG ||
+        value > DBL_MAX || value < -DBL_MAX ||
+        (number->mantissa && value < DBL_MIN && value > -DBL_MIN))
+    {
+        SET_FLAGS_ON(JSON_NumberAttributes, *pAttributes, JSON_LosesPrecision);
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_CallNumberHandler(JSON_Parser parser)
+{
+    JSON_Parser_HandlerResult result;
+    if (parser->typedNumberHandler)
+    {
+        JSON_NumberValue value;
+        JSON_NumberAttributes attributes;
+        if (!JSON_Parser_ConvertNumber(parser, &value, &attributes))
         {
             return JSON_Failure;
         }
-        break;
 
-    case EMIT_STRING:
-        if (!JSON_Parser_CallStringHandler(parser, 0/* isObjectMember */))
+        /* Numbers that would lose precision go to the number handler
+           instead, if there is one. */
+        if (!parser->numberHandler || !GET_FLAGS(attributes, JSON_LosesPrecision))
+        {
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
+            result = parser->typedNumberHandler(parser, &value, attributes);
+            SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
+            if (result != JSON_Parser_Continue)
+            {
+                JSON_Parser_SetErrorAtToken(parser, JSON_Error_AbortedByHandler);
+                return JSON_Failure;
+            }
+            return JSON_Success;
+        }
+    }
+    if (parser->numberHandler)
+    {
+        JSON_Parser_NullTerminateToken(parser);
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
+        result = parser->numberHandler(parser, (char*)parser->pTokenBytes, parser->tokenBytesUsed, parser->tokenAttributes);
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
+        if (result != JSON_Parser_Continue)
         {
+            JSON_Parser_SetErrorAtToken(parser, JSON_Error_AbortedByHandler);
             return JSON_Failure;
         }
-        break;
+    }
+    return JSON_Success;
+}
 
-    case EMIT_NUMBER:
-        if (!JSON_Parser_CallNumberHandler(parser))
+static JSON_Status JSON_Parser_CallSpecialNumberHandler(JSON_Parser parser)
+{
+    if (parser->specialNumberHandler)
+    {
+        JSON_Parser_HandlerResult result;
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
+        result = parser->specialNumberHandler(parser, parser->token == T_NAN ? JSON_NaN :
+                                              (parser->token == T_INFINITY ? JSON_Infinity : JSON_NegativeInfinity));
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_TOKEN_HANDLER);
+        if (result != JSON_Parser_Continue)
         {
+            JSON_Parser_SetErrorAtToken(parser, JSON_Error_AbortedByHandler);
             return JSON_Failure;
         }
+    }
+    return JSON_Success;
+}
+
+static void InitEvent(JSON_Event* pEvent, JSON_EventType type)
+{
+    pEvent->type = type;
+    pEvent->pValue = NULL;
+    pEvent->length = 0;
+    pEvent->attributes = 0;
+    pEvent->booleanValue = JSON_False;
+    pEvent->specialNumberValue = JSON_NaN;
+    pEvent->keyIndex = 0;
+}
+
+static JSON_Status JSON_Parser_QueueGrammarEvents(JSON_Parser parser, byte emit)
+{
+    /* This is the equivalent of JSON_Parser_HandleGrammarEvents() for a
+       parser that is used to pull events. Array items are implied by the
+       events that follow them, so they are not queued. A single codepoint
+       can finish at most two tokens (for example, the ] in "[1]" finishes
+       both the number and the array), and input processing is suspended as
+       soon as an event has been queued, so the queue never overflows.
+       Note that the token buffer is not touched between the two events,
+       so the first event's value remains valid. */
+    JSON_Event* pEvent = &parser->events[parser->eventsQueued];
+    SET_FLAGS_OFF(byte, emit, EMIT_ARRAY_ITEM);
+    switch (emit)
+    {
+    case EMIT_NULL:
+        InitEvent(pEvent, JSON_NullEvent);
         break;
 
-    case EMIT_SPECIAL_NUMBER:
-        if (!JSON_Parser_CallSpecialNumberHandler(parser))
+    case EMIT_BOOLEAN:
+        InitEvent(pEvent, JSON_BooleanEvent);
+        pEvent->booleanValue = (parser->token == T_TRUE) ? JSON_True : JSON_False;
+        break;
+
+    case EMIT_OBJECT_MEMBER:
+        if (!JSON_Parser_AddMemberNameToList(parser)) /* will fail if member is duplicate */
         {
             return JSON_Failure;
         }
+        /* fall through */
+
+    case EMIT_STRING:
+        InitEvent(pEvent, (emit == EMIT_OBJECT_MEMBER) ? JSON_ObjectMemberEvent : JSON_StringEvent);
+        pEvent->attributes = parser->tokenAttributes;
+        if (parser->pInputTokenBytes)
+        {
+            pEvent->attributes |= JSON_PointsIntoInput;
+        }
+        else
+        {
+            JSON_Parser_NullTerminateToken(parser);
+        }
+        pEvent->pValue = (char*)JSON_Parser_GetTokenBytes(parser);
+        pEvent->length = parser->tokenBytesUsed;
+        if (emit == EMIT_OBJECT_MEMBER)
+        {
+            pEvent->keyIndex = parser->memberKeyIndex;
+        }
+        break;
+
+    case EMIT_NUMBER:
+        InitEvent(pEvent, JSON_NumberEvent);
+        JSON_Parser_NullTerminateToken(parser);
+        pEvent->pValue = (char*)parser->pTokenBytes;
+        pEvent->length = parser->tokenBytesUsed;
+        pEvent->attributes = parser->tokenAttributes;
+        break;
+
+    case EMIT_SPECIAL_NUMBER:
+        InitEvent(pEvent, JSON_SpecialNumberEvent);
+        pEvent->specialNumberValue = (parser->token == T_NAN) ? JSON_NaN :
+                                     ((parser->token == T_INFINITY) ? JSON_Infinity : JSON_NegativeInfinity);
         break;
 
     case EMIT_START_OBJECT:
-        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->startObjectHandler) ||
-            !JSON_Parser_StartContainer(parser, 1/*isObject*/))
+        if (!JSON_Parser_StartContainer(parser, 1/*isObject*/))
         {
             return JSON_Failure;
         }
+        InitEvent(pEvent, JSON_StartObjectEvent);
         break;
 
     case EMIT_END_OBJECT:
         JSON_Parser_EndContainer(parser, 1/*isObject*/);
-        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->endObjectHandler))
+        InitEvent(pEvent, JSON_EndObjectEvent);
+        break;
+
+    case EMIT_START_ARRAY:
+        if (!JSON_Parser_StartContainer(parser, 0/*isObject*/))
+        {
+            return JSON_Failure;
+        }
+        InitEvent(pEvent, JSON_StartArrayEvent);
+        break;
+
+    case EMIT_END_ARRAY:
+        JSON_Parser_EndContainer(parser, 0/*isObject*/);
+        InitEvent(pEvent, JSON_EndArrayEvent);
+        break;
+
+    default: /* EMIT_NOTHING */
+        return JSON_Success;
+    }
+    parser->eventsQueued++;
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_SUSPENDED);
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_DeliverEventBatch(JSON_Parser parser)
+{
+    JSON_Parser_HandlerResult result = JSON_Parser_Continue;
+    if (parser->eventBatchHandler)
+    {
+        result = parser->eventBatchHandler(parser, parser->pBatchEvents, parser->batchEventsUsed, (const char*)parser->pBatchStringBytes);
+    }
+    parser->batchEventsUsed = 0;
+    parser->batchStringBytesUsed = 0;
+    if (result != JSON_Parser_Continue)
+    {
+        /* An error in the input that follows the batch takes precedence. */
+        if (parser->error == JSON_Error_None)
+        {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_AbortedByHandler);
+        }
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_AddBatchStringBytes(JSON_Parser parser, const byte* pBytes, size_t length, Encoding encoding)
+{
+    /* Each value is followed by a null terminator in the string bytes. */
+    size_t terminatorLength = SHORTEST_ENCODING_SEQUENCE(encoding);
+    size_t neededLength = parser->batchStringBytesUsed + length + terminatorLength;
+    if (neededLength < length)
+    {
+        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+        return JSON_Failure;
+    }
+    if (neededLength > parser->batchStringBytesLength)
+    {
+        size_t newLength = parser->batchStringBytesLength ? parser->batchStringBytesLength : DEFAULT_BATCH_STRING_LENGTH;
+        byte* pNewBytes;
+        while (newLength < neededLength)
+        {
+            if (newLength * 2 < newLength)
+            {
+                JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+                return JSON_Failure;
+            }
+            newLength *= 2;
+        }
+        pNewBytes = (byte*)parser->memorySuite.realloc(parser->memorySuite.userData, parser->pBatchStringBytes, newLength);
+        if (!pNewBytes)
         {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
             return JSON_Failure;
         }
+        parser->pBatchStringBytes = pNewBytes;
+        parser->batchStringBytesLength = newLength;
+    }
+    memcpy(parser->pBatchStringBytes + parser->batchStringBytesUsed, pBytes, length);
+    memset(parser->pBatchStringBytes + parser->batchStringBytesUsed + length, 0, terminatorLength);
+    parser->batchStringBytesUsed = neededLength;
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_BatchGrammarEvents(JSON_Parser parser, byte emit)
+{
+    /* This is the equivalent of JSON_Parser_HandleGrammarEvents() for a
+       parser that delivers event batches. Array items are implied by the
+       events that follow them, so they are not recorded. */
+    JSON_BatchedEvent* pEvent = &parser->pBatchEvents[parser->batchEventsUsed];
+    pEvent->attributes = 0;
+    pEvent->depth = parser->depth;
+    pEvent->offset = 0;
+    pEvent->length = 0;
+    pEvent->keyIndex = 0;
+    SET_FLAGS_OFF(byte, emit, EMIT_ARRAY_ITEM);
+    switch (emit)
+    {
+    case EMIT_NULL:
+        pEvent->type = JSON_NullEvent;
+        break;
+
+    case EMIT_BOOLEAN:
+        pEvent->type = JSON_BooleanEvent;
+        pEvent->attributes = (parser->token == T_TRUE) ? JSON_True : JSON_False;
         break;
 
     case EMIT_OBJECT_MEMBER:
-        if (!JSON_Parser_AddMemberNameToList(parser) || /* will fail if member is duplicate */
-            !JSON_Parser_CallStringHandler(parser, 1 /* isObjectMember */))
+        if (!JSON_Parser_AddMemberNameToList(parser)) /* will fail if member is duplicate */
+        {
+            return JSON_Failure;
+        }
+        /* fall through */
+
+    case EMIT_STRING:
+        pEvent->type = (emit == EMIT_OBJECT_MEMBER) ? JSON_ObjectMemberEvent : JSON_StringEvent;
+        pEvent->attributes = parser->tokenAttributes;
+        pEvent->offset = parser->batchStringBytesUsed;
+        pEvent->length = parser->tokenBytesUsed;
+        if (emit == EMIT_OBJECT_MEMBER)
+        {
+            pEvent->keyIndex = parser->memberKeyIndex;
+        }
+        if (!JSON_Parser_AddBatchStringBytes(parser, JSON_Parser_GetTokenBytes(parser), parser->tokenBytesUsed, (Encoding)parser->stringEncoding))
         {
             return JSON_Failure;
         }
         break;
 
-    case EMIT_START_ARRAY:
-        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->startArrayHandler) ||
-            !JSON_Parser_StartContainer(parser, 0/*isObject*/))
+    case EMIT_NUMBER:
+        pEvent->type = JSON_NumberEvent;
+        pEvent->attributes = parser->tokenAttributes;
+        pEvent->offset = parser->batchStringBytesUsed;
+        pEvent->length = parser->tokenBytesUsed;
+        if (!JSON_Parser_AddBatchStringBytes(parser, parser->pTokenBytes, parser->tokenBytesUsed, (Encoding)parser->numberEncoding))
         {
             return JSON_Failure;
         }
         break;
 
-    case EMIT_END_ARRAY:
-        JSON_Parser_EndContainer(parser, 0/*isObject*/);
-        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->endArrayHandler))
+    case EMIT_SPECIAL_NUMBER:
+        pEvent->type = JSON_SpecialNumberEvent;
+        pEvent->attributes = (parser->token == T_NAN) ? JSON_NaN :
+                             ((parser->token == T_INFINITY) ? JSON_Infinity : JSON_NegativeInfinity);
+        break;
+
+    /* The depth of a container is that of its start and end tokens, which
+       are not themselves enclosed by it. */
+    case EMIT_START_OBJECT:
+        if (!JSON_Parser_StartContainer(parser, 1/*isObject*/))
+        {
+            return JSON_Failure;
+        }
+        pEvent->type = JSON_StartObjectEvent;
+        break;
+
+    case EMIT_END_OBJECT:
+        JSON_Parser_EndContainer(parser, 1/*isObject*/);
+        pEvent->type = JSON_EndObjectEvent;
+        pEvent->depth--;
+        break;
+
+    case EMIT_START_ARRAY:
+        if (!JSON_Parser_StartContainer(parser, 0/*isObject*/))
         {
             return JSON_Failure;
         }
+        pEvent->type = JSON_StartArrayEvent;
         break;
+
+    case EMIT_END_ARRAY:
+        JSON_Parser_EndContainer(parser, 0/*isObject*/);
+        pEvent->type = JSON_EndArrayEvent;
+        pEvent->depth--;
+        break;
+
+    default: /* EMIT_NOTHING */
+        return JSON_Success;
     }
-    if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT))
+    parser->batchEventsUsed++;
+    if (parser->batchEventsUsed == parser->batchEventsLength)
     {
-        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_StoppedAfterEmbeddedDocument);
-        return JSON_Failure;
+        return JSON_Parser_DeliverEventBatch(parser);
     }
     return JSON_Success;
 }
 
-static JSON_Status JSON_Parser_ProcessToken(JSON_Parser parser)
+static JSON_Status JSON_Parser_SkipGrammarEvents(JSON_Parser parser, byte emit)
 {
-    GrammarianOutput output;
-    output = Grammarian_ProcessToken(&parser->grammarianData, parser->token, &parser->memorySuite);
-    switch (GRAMMARIAN_RESULT_CODE(output))
+    /* No events are emitted for a value that is being skipped. The lexer
+       skips the contents of a skipped container and then produces the
+       token that ends it, which ends the skip. */
+    switch (emit)
     {
-    case ACCEPTED_TOKEN:
-        if (!JSON_Parser_HandleGrammarEvents(parser, GRAMMARIAN_EVENT(output)))
+    case EMIT_NOTHING:
+        break;
+
+    case EMIT_START_OBJECT:
+    case EMIT_START_ARRAY:
+        if (!JSON_Parser_StartContainer(parser, emit == EMIT_START_OBJECT))
         {
             return JSON_Failure;
         }
+        parser->skipDepth = 1;
         break;
 
-    case REJECTED_TOKEN:
-        JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnexpectedToken);
-        return JSON_Failure;
+    case EMIT_END_OBJECT:
+    case EMIT_END_ARRAY:
+        JSON_Parser_EndContainer(parser, emit == EMIT_END_OBJECT);
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_SKIPPING_VALUE);
+        break;
 
-    case SYMBOL_STACK_FULL:
-        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
-        return JSON_Failure;
+    default:
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_SKIPPING_VALUE);
+        break;
     }
-
-    /* Reset the lexer to prepare for the next token. */
-    parser->lexerState = LEXING_WHITESPACE;
-    parser->lexerBits = 0;
-    parser->token = T_NONE;
-    parser->tokenAttributes = 0;
-    parser->tokenBytesUsed = 0;
     return JSON_Success;
 }
 
-/* Lexer functions. */
-
-static const byte expectedLiteralChars[] = { 'u', 'l', 'l', 0, 'r', 'u', 'e', 0, 'a', 'l', 's', 'e', 0, 'a', 'N', 0, 'n', 'f', 'i', 'n', 'i', 't', 'y', 0  };
+/* Path filters are compiled into a trie whose root, node 0, corresponds to
+   the whole document. The children of a node correspond to the reference
+   tokens that can follow the node's path in a filter, and a node is marked
+   as a match if its path is a filter. Since a wildcard child and a named
+   child of the same node can both apply to a value, a value corresponds to
+   a SET of nodes. The sets that correspond to the containers whose
+   contents might match are kept on a stack, each followed by its size and
+   by the number of items seen so far if the container is an array. The set
+   that corresponds to the next value is computed just above the top of
+   the stack, and is pushed if the value turns out to be such a container.
+   Once a value matches, everything inside it matches too, so no further
+   sets are needed until it ends. */
 
-#define NULL_LITERAL_EXPECTED_CHARS_START_INDEX     0
-#define TRUE_LITERAL_EXPECTED_CHARS_START_INDEX     4
-#define FALSE_LITERAL_EXPECTED_CHARS_START_INDEX    8
-#define NAN_LITERAL_EXPECTED_CHARS_START_INDEX      13
-#define INFINITY_LITERAL_EXPECTED_CHARS_START_INDEX 16
-
-/* Forward declaration. */
-static JSON_Status JSON_Parser_FlushLexer(JSON_Parser parser);
-static JSON_Status JSON_Parser_ProcessCodepoint(JSON_Parser parser, Codepoint c, size_t encodedLength);
-
-static JSON_Status JSON_Parser_HandleInvalidEncodingSequence(JSON_Parser parser, size_t encodedLength) {
-    if (parser->token == T_STRING && GET_FLAGS(parser->flags, PARSER_REPLACE_INVALID))
+static void* GrowArray(const JSON_MemorySuite* pMemorySuite, void* pArray, size_t* pLength, size_t elementSize, size_t defaultLength)
+{
+    /* Double the length of a growable array, or allocate it with the
+       default length if it has not been allocated yet. */
+    size_t newLength = *pLength ? *pLength * 2 : defaultLength;
+    if (newLength < *pLength || newLength > SIZE_MAX / elementSize)
     {
-        /* Since we're inside a string token, replacing the invalid sequence
-           with the Unicode replacement character as requested by the client
-           is a viable way to avoid a parse failure. Outside a string token,
-           such a replacement would simply trigger JSON_Error_UnknownToken
-           when we tried to process the replacement character, so it's less
-           confusing to stick with JSON_Error_InvalidEncodingSequence in that
-           case. */
-        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsReplacedCharacter);
-        return JSON_Parser_ProcessCodepoint(parser, REPLACEMENT_CHARACTER_CODEPOINT, encodedLength);
+        return NULL;
     }
-    else if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT))
+    pArray = pMemorySuite->realloc(pMemorySuite->userData, pArray, newLength * elementSize);
+    if (pArray)
     {
-        /* Since we're parsing the top-level value of an embedded
-           document, assume that the invalid encoding sequence we've
-           encountered does not actually belong to the document, and
-           finish parsing by pretending that we've encountered EOF
-           instead of an invalid sequence. If the content is valid,
-           this will fail with JSON_Error_StoppedAfterEmbeddedDocument;
-           otherwise, it will fail with an appropriate error. */
-        return JSON_Parser_FlushLexer(parser) && JSON_Parser_FlushParser(parser);
+        *pLength = newLength;
     }
-    JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_InvalidEncodingSequence);
-    return JSON_Failure;
+    return pArray;
 }
 
-static JSON_Status JSON_Parser_HandleInvalidNumber(JSON_Parser parser, Codepoint c, int codepointsSinceValidNumber, TokenAttributes attributesToRemove)
+static int JSON_Parser_PathNodeMatchesName(JSON_Parser parser, const PathNode* pNode)
 {
-    SET_FLAGS_OFF(TokenAttributes, parser->tokenAttributes, attributesToRemove);
-    if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT))
+    /* The node's name is stored in UTF-8, but the member name is encoded
+       according to the string encoding setting. */
+    const byte* pName;
+    const byte* pMemberName = JSON_Parser_GetTokenBytes(parser);
+    size_t memberNameLength = parser->tokenBytesUsed;
+    size_t i;
+    DecoderData decoderData;
+    if (!pNode->nameLength)
     {
-        /* The invalid number is the top-level value of an embedded document,
-           and it has a prefix that can be interpreted as a valid number.
-           We want to backtrack so that we are at the end of that prefix,
-           and then process the valid token.
-
-           Note that backtracking requires us to make three assumptions, which
-           are always valid in the context of a number token:
-
-           1. The input encoding is not JSON_UnknownEncoding.
-
-           2 The codepoints we are backing up across are all in the range
-           U+0000 - U+007F, aka ASCII, so we can assume the number of
-           bytes comprising them based on the input encoding.
-
-           3. The codepoints we are backing up across do not include any
-           line breaks, so we can assume that the line number stays the
-           same and the column number can simply be decremented.
-
-           For example:
-
-               "01"     => "0"
-               "123.!"  => "123"
-               "123e!"  => "123"
-               "123e+!" => "123"
-               "123e-!" => "123"
-               "1.2e!"  => "1.2"
-               "1.2e+!" => "1.2"
-               "1.2e-!" => "1.2"
-        */
-        parser->codepointLocationByte -= (size_t)codepointsSinceValidNumber * SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding);
-        parser->codepointLocationColumn -= (size_t)codepointsSinceValidNumber;
-        parser->tokenBytesUsed -= (size_t)codepointsSinceValidNumber * SHORTEST_ENCODING_SEQUENCE(parser->numberEncoding);
-        return JSON_Parser_ProcessToken(parser); /* always fails */
+        /* The name buffer may not have been allocated. */
+        return !memberNameLength;
     }
-    else if (c == EOF_CODEPOINT)
+    pName = parser->pPathNameBytes + pNode->nameOffset;
+    if (parser->stringEncoding == JSON_UTF8)
     {
-        /* Allow JSON_Parser_FlushLexer() to fail. */
-        return JSON_Success;
+        return pNode->nameLength == memberNameLength && !memcmp(pName, pMemberName, memberNameLength);
     }
-    JSON_Parser_SetErrorAtToken(parser, JSON_Error_InvalidNumber);
-    return JSON_Failure;
-}
-
-static void JSON_Parser_StartToken(JSON_Parser parser, Symbol token)
-{
-    parser->token = token;
-    parser->tokenLocationByte = parser->codepointLocationByte;
-    parser->tokenLocationLine = parser->codepointLocationLine;
-    parser->tokenLocationColumn = parser->codepointLocationColumn;
+    Decoder_Reset(&decoderData);
+    for (i = 0; i < pNode->nameLength; i++)
+    {
+        DecoderOutput output = Decoder_ProcessByte(&decoderData, JSON_UTF8, pName[i]);
+        if (DECODER_RESULT_CODE(output) == SEQUENCE_COMPLETE)
+        {
+            byte encodedBytes[LONGEST_ENCODING_SEQUENCE];
+            size_t encodedLength = EncodeCodepoint(DECODER_CODEPOINT(output), parser->stringEncoding, encodedBytes);
+            if (encodedLength > memberNameLength || memcmp(encodedBytes, pMemberName, encodedLength))
+            {
+                return 0;
+            }
+            pMemberName += encodedLength;
+            memberNameLength -= encodedLength;
+        }
+    }
+    return !memberNameLength;
 }
 
-static JSON_Status JSON_Parser_ProcessCodepoint(JSON_Parser parser, Codepoint c, size_t encodedLength)
+static JSON_Status JSON_Parser_PushPathNode(JSON_Parser parser, size_t node)
 {
-    Codepoint codepointToRecord = EOF_CODEPOINT;
-    Encoding tokenEncoding;
-    size_t maxTokenLength;
-    int tokenFinished = 0;
-
-    /* If the previous codepoint was U+000D (CARRIAGE RETURN), and the current
-       codepoint is U+000A (LINE FEED), then treat the 2 codepoints as a single
-       line break. */
-    if (GET_FLAGS(parser->state, PARSER_AFTER_CARRIAGE_RETURN))
+    if (parser->pathStackUsed == parser->pathStackLength)
     {
-        if (c == LINE_FEED_CODEPOINT)
+        size_t* pNewStack = (size_t*)GrowArray(&parser->memorySuite, parser->pPathStack, &parser->pathStackLength, sizeof(size_t), DEFAULT_PATH_STACK_LENGTH);
+        if (!pNewStack)
         {
-            parser->codepointLocationLine--;
+            JSON_Parser_SetErrorAtToken(parser, JSON_Error_OutOfMemory);
+            return JSON_Failure;
         }
-        SET_FLAGS_OFF(ParserState, parser->state, PARSER_AFTER_CARRIAGE_RETURN);
+        parser->pPathStack = pNewStack;
     }
+    parser->pPathStack[parser->pathStackUsed] = node;
+    parser->pathStackUsed++;
+    return JSON_Success;
+}
 
-reprocess:
-
-    switch (parser->lexerState)
+static JSON_Status JSON_Parser_FindNextPathNodes(JSON_Parser parser, int isArrayItem, int* pIsMatch)
+{
+    /* Compute the set of nodes that corresponds to the next value, given
+       the set that corresponds to the current container (if any) and the
+       member name or item index, and record its size in pathNextCount. */
+    size_t entry = parser->pathStackUsed;
+    *pIsMatch = 0;
+    if (!parser->depth)
     {
-    case LEXING_WHITESPACE:
-        if (c == '{')
+        if (!JSON_Parser_PushPathNode(parser, 0))
         {
-            JSON_Parser_StartToken(parser, T_LEFT_CURLY);
-            tokenFinished = 1;
-        }
-        else if (c == '}')
-        {
-            JSON_Parser_StartToken(parser, T_RIGHT_CURLY);
-            tokenFinished = 1;
+            return JSON_Failure;
         }
-        else if (c == '[')
+        *pIsMatch = parser->pPathNodes[0].isMatch;
+    }
+    else
+    {
+        size_t count = parser->pPathStack[entry - 2];
+        size_t itemIndex = isArrayItem ? parser->pPathStack[entry - 1]++ : 0;
+        size_t i;
+        for (i = entry - 2 - count; i < entry - 2; i++)
         {
-            JSON_Parser_StartToken(parser, T_LEFT_SQUARE);
-            tokenFinished = 1;
+            size_t child;
+            for (child = parser->pPathNodes[parser->pPathStack[i]].firstChild; child; child = parser->pPathNodes[child].nextSibling)
+            {
+                const PathNode* pChild = &parser->pPathNodes[child];
+                if (pChild->isWildcard ||
+                    (isArrayItem ? pChild->index == itemIndex : JSON_Parser_PathNodeMatchesName(parser, pChild)))
+                {
+                    if (pChild->isMatch)
+                    {
+                        *pIsMatch = 1;
+                    }
+                    if (!JSON_Parser_PushPathNode(parser, child))
+                    {
+                        return JSON_Failure;
+                    }
+                }
+            }
         }
-        else if (c == ']')
+    }
+    parser->pathNextCount = parser->pathStackUsed - entry;
+    parser->pathStackUsed = entry;
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_FilterGrammarEvents(JSON_Parser parser, byte* pEmit)
+{
+    /* Suppress the events for values that neither match a path filter nor
+       are inside a matching value, and skip the values that cannot contain
+       a matching value. */
+    byte emit = *pEmit;
+    byte valueEmit = (byte)(emit & ~EMIT_ARRAY_ITEM);
+    int isMatch;
+    if (emit == EMIT_NOTHING)
+    {
+        return JSON_Success;
+    }
+    if (parser->pathMatchedDepth)
+    {
+        if (parser->depth >= parser->pathMatchedDepth)
         {
-            JSON_Parser_StartToken(parser, T_RIGHT_SQUARE);
-            tokenFinished = 1;
+            return JSON_Success;
         }
-        else if (c == ':')
+        parser->pathMatchedDepth = 0;
+    }
+    switch (valueEmit)
+    {
+    case EMIT_END_OBJECT:
+    case EMIT_END_ARRAY:
+        parser->pathStackUsed -= parser->pPathStack[parser->pathStackUsed - 2] + 2;
+        JSON_Parser_EndContainer(parser, valueEmit == EMIT_END_OBJECT);
+        *pEmit = EMIT_NOTHING;
+        return JSON_Success;
+
+    case EMIT_OBJECT_MEMBER:
+        if (!JSON_Parser_FindNextPathNodes(parser, 0/*isArrayItem*/, &isMatch))
         {
-            JSON_Parser_StartToken(parser, T_COLON);
-            tokenFinished = 1;
+            return JSON_Failure;
         }
-        else if (c == ',')
+        if (isMatch)
         {
-            JSON_Parser_StartToken(parser, T_COMMA);
-            tokenFinished = 1;
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_NEXT_VALUE_MATCHES);
+            return JSON_Success;
         }
-        else if (c == 'n')
+        if (!JSON_Parser_AddMemberNameToList(parser))
         {
-            JSON_Parser_StartToken(parser, T_NULL);
-            parser->lexerBits = NULL_LITERAL_EXPECTED_CHARS_START_INDEX;
-            parser->lexerState = LEXING_LITERAL;
+            return JSON_Failure;
         }
-        else if (c == 't')
+        if (!parser->pathNextCount)
         {
-            JSON_Parser_StartToken(parser, T_TRUE);
-            parser->lexerBits = TRUE_LITERAL_EXPECTED_CHARS_START_INDEX;
-            parser->lexerState = LEXING_LITERAL;
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_SKIPPING_VALUE);
         }
-        else if (c == 'f')
+        *pEmit = EMIT_NOTHING;
+        return JSON_Success;
+    }
+
+    /* The event is for a value. The value of an object member has already
+       been looked up when the member name was seen. */
+    if (GET_FLAGS(emit, EMIT_ARRAY_ITEM) || !parser->depth)
+    {
+        if (!JSON_Parser_FindNextPathNodes(parser, parser->depth != 0/*isArrayItem*/, &isMatch))
         {
-            JSON_Parser_StartToken(parser, T_FALSE);
-            parser->lexerBits = FALSE_LITERAL_EXPECTED_CHARS_START_INDEX;
-            parser->lexerState = LEXING_LITERAL;
+            return JSON_Failure;
         }
-        else if (c == '"')
+        if (isMatch)
         {
-            JSON_Parser_StartToken(parser, T_STRING);
-            parser->lexerState = LEXING_STRING;
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_NEXT_VALUE_MATCHES);
         }
-        else if (c == '-')
+        else if (!parser->pathNextCount)
         {
-            JSON_Parser_StartToken(parser, T_NUMBER);
-            parser->tokenAttributes = JSON_IsNegative;
-            codepointToRecord = '-';
-            parser->lexerState = LEXING_NUMBER_AFTER_MINUS;
-            goto recordNumberCodepointAndAdvance;
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_SKIPPING_VALUE);
+            *pEmit = EMIT_NOTHING;
+            return JSON_Parser_SkipGrammarEvents(parser, valueEmit);
         }
-        else if (c == '0')
+    }
+    if (GET_FLAGS(parser->state, PARSER_NEXT_VALUE_MATCHES))
+    {
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_NEXT_VALUE_MATCHES);
+        if (valueEmit == EMIT_START_OBJECT || valueEmit == EMIT_START_ARRAY)
         {
-            JSON_Parser_StartToken(parser, T_NUMBER);
-            codepointToRecord = '0';
-            parser->lexerState = LEXING_NUMBER_AFTER_LEADING_ZERO;
-            goto recordNumberCodepointAndAdvance;
+            parser->pathMatchedDepth = parser->depth + 1;
         }
-        else if (c >= '1' && c <= '9')
+        return JSON_Success;
+    }
+    *pEmit = EMIT_NOTHING;
+    if (valueEmit == EMIT_START_OBJECT || valueEmit == EMIT_START_ARRAY)
+    {
+        /* Push the container's set, followed by its size and item count. */
+        size_t count = parser->pathNextCount;
+        parser->pathStackUsed += count;
+        if (!JSON_Parser_PushPathNode(parser, count) ||
+            !JSON_Parser_PushPathNode(parser, 0) ||
+            !JSON_Parser_StartContainer(parser, valueEmit == EMIT_START_OBJECT))
         {
-            JSON_Parser_StartToken(parser, T_NUMBER);
-            codepointToRecord = c;
-            parser->lexerState = LEXING_NUMBER_DECIMAL_DIGITS;
-            goto recordNumberCodepointAndAdvance;
+            return JSON_Failure;
         }
-        else if (c == ' ' || c == TAB_CODEPOINT || c == LINE_FEED_CODEPOINT ||
-                 c == CARRIAGE_RETURN_CODEPOINT || c == EOF_CODEPOINT)
+    }
+    return JSON_Success;
+}
+
+/* A key dictionary is compiled into a minimal perfect hash, using the
+   "hash, displace, and compress" scheme: the keys are divided into as many
+   buckets as there are keys by one hash, and then each bucket, largest
+   first, is given a seed for a second hash that sends each of its keys to
+   a different free slot. A bucket that has a single key records the slot
+   itself instead of a seed. Looking up a member name therefore takes at
+   most two hashes and a single comparison with the name in the slot,
+   which is what tells known names from unknown ones. The key names are
+   stored in the string encoding, so that member names can be compared
+   without being converted. */
+
+static uint32_t HashKeyName(uint32_t seed, const byte* pBytes, size_t length)
+{
+    /* FNV-1a, starting from a basis that depends on the seed, followed by
+       a final mix so that the low bits depend on every byte. */
+    uint32_t hash = 0x811C9DC5 ^ (seed * 0x9E3779B9);
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ pBytes[i]) * 0x01000193;
+    }
+    hash ^= hash >> 15;
+    hash *= 0x2C1B3C6D;
+    hash ^= hash >> 12;
+    return hash;
+}
+
+static int JSON_Parser_KeyNamesAreEqual(JSON_Parser parser, size_t key1, size_t key2)
+{
+    size_t offset1 = parser->pKeyNameOffsets[key1];
+    size_t offset2 = parser->pKeyNameOffsets[key2];
+    size_t length = parser->pKeyNameOffsets[key1 + 1] - offset1;
+    return parser->pKeyNameOffsets[key2 + 1] - offset2 == length &&
+           !memcmp(parser->pKeyNames + offset1, parser->pKeyNames + offset2, length);
+}
+
+static size_t JSON_Parser_GetKeySlot(JSON_Parser parser, uint32_t seed, size_t key)
+{
+    size_t offset = parser->pKeyNameOffsets[key];
+    return (size_t)(HashKeyName(seed, parser->pKeyNames + offset, parser->pKeyNameOffsets[key + 1] - offset) % (uint32_t)parser->keyCount);
+}
+
+static JSON_Status JSON_Parser_PlaceKeys(JSON_Parser parser)
+{
+    /* Fill in the slots and the seeds, failing if two keys are the same or
+       if memory cannot be allocated for the bucket lists. */
+    size_t keyCount = parser->keyCount;
+    size_t* pBucketStarts; /* keyCount + 1 entries */
+    size_t* pBucketKeys;   /* keyCount entries, grouped by bucket */
+    size_t bucketSize;
+    size_t maxBucketSize = 0;
+    size_t freeSlot = 0;
+    size_t bucket;
+    size_t key;
+    size_t i;
+    if (keyCount > (SIZE_MAX - 1) / 2 / sizeof(size_t))
+    {
+        return JSON_Failure;
+    }
+    pBucketStarts = (size_t*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, (keyCount * 2 + 1) * sizeof(size_t));
+    if (!pBucketStarts)
+    {
+        return JSON_Failure;
+    }
+    pBucketKeys = pBucketStarts + keyCount + 1;
+
+    /* Sort the keys into buckets. */
+    memset(pBucketStarts, 0, (keyCount + 1) * sizeof(size_t));
+    for (key = 0; key < keyCount; key++)
+    {
+        pBucketStarts[JSON_Parser_GetKeySlot(parser, 0, key) + 1]++;
+    }
+    for (bucket = 0; bucket < keyCount; bucket++)
+    {
+        if (pBucketStarts[bucket + 1] > maxBucketSize)
         {
-            /* Ignore whitespace between tokens. */
+            maxBucketSize = pBucketStarts[bucket + 1];
         }
-        else if (c == BOM_CODEPOINT && parser->codepointLocationByte == 0)
+        pBucketStarts[bucket + 1] += pBucketStarts[bucket];
+    }
+    for (key = 0; key < keyCount; key++)
+    {
+        bucket = JSON_Parser_GetKeySlot(parser, 0, key);
+        pBucketKeys[pBucketStarts[bucket]++] = key;
+    }
+    for (bucket = keyCount; bucket; bucket--)
+    {
+        pBucketStarts[bucket] = pBucketStarts[bucket - 1];
+    }
+    pBucketStarts[0] = 0;
+
+    /* Duplicate keys always share a bucket. */
+    for (i = 1; i < keyCount; i++)
+    {
+        size_t j;
+        bucket = JSON_Parser_GetKeySlot(parser, 0, pBucketKeys[i]);
+        for (j = pBucketStarts[bucket]; j < i; j++)
         {
-            if (GET_FLAGS(parser->flags, PARSER_ALLOW_BOM))
-            {
-                /* OK, we'll allow the BOM. */
-            }
-            else
+            if (JSON_Parser_KeyNamesAreEqual(parser, pBucketKeys[i], pBucketKeys[j]))
             {
-                JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_BOMNotAllowed);
+                parser->memorySuite.free(parser->memorySuite.userData, pBucketStarts);
                 return JSON_Failure;
             }
         }
-        else if (c == '/' && GET_FLAGS(parser->flags, PARSER_ALLOW_COMMENTS))
-        {
-            /* Comments are not real tokens, but we save the location
-               of the comment as the token location in case of an error. */
-            parser->tokenLocationByte = parser->codepointLocationByte;
-            parser->tokenLocationLine = parser->codepointLocationLine;
-            parser->tokenLocationColumn = parser->codepointLocationColumn;
-            parser->lexerState = LEXING_COMMENT_AFTER_SLASH;
-        }
-        else if (c == 'N' && GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS))
+    }
+
+    /* A slot is free while it holds keyCount. */
+    for (i = 0; i < keyCount; i++)
+    {
+        parser->pKeySlots[i] = keyCount;
+        parser->pKeySeeds[i] = 0;
+    }
+    for (bucketSize = maxBucketSize; bucketSize > 1; bucketSize--)
+    {
+        for (bucket = 0; bucket < keyCount; bucket++)
         {
-            JSON_Parser_StartToken(parser, T_NAN);
-            parser->lexerBits = NAN_LITERAL_EXPECTED_CHARS_START_INDEX;
-            parser->lexerState = LEXING_LITERAL;
+            size_t start = pBucketStarts[bucket];
+            uint32_t seed = 0;
+            if (pBucketStarts[bucket + 1] - start != bucketSize)
+            {
+                continue;
+            }
+            do
+            {
+                /* Distinct keys whose hashes collide for every seed are
+                   astronomically unlikely, so the search is not bounded. */
+                seed++;
+                for (i = 0; i < bucketSize; i++)
+                {
+                    size_t slot = JSON_Parser_GetKeySlot(parser, seed, pBucketKeys[start + i]);
+                    if (parser->pKeySlots[slot] != keyCount)
+                    {
+                        break;
+                    }
+                    parser->pKeySlots[slot] = pBucketKeys[start + i];
+                }
+                if (i < bucketSize)
+                {
+                    while (i)
+                    {
+                        i--;
+                        parser->pKeySlots[JSON_Parser_GetKeySlot(parser, seed, pBucketKeys[start + i])] = keyCount;
+                    }
+                }
+            } while (i < bucketSize);
+            parser->pKeySeeds[bucket] = seed;
         }
-        else if (c == 'I' && GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS))
+    }
+    for (bucket = 0; bucket < keyCount; bucket++)
+    {
+        if (pBucketStarts[bucket + 1] - pBucketStarts[bucket] == 1)
         {
-            JSON_Parser_StartToken(parser, T_INFINITY);
-            parser->lexerBits = INFINITY_LITERAL_EXPECTED_CHARS_START_INDEX;
-            parser->lexerState = LEXING_LITERAL;
+            while (parser->pKeySlots[freeSlot] != keyCount)
+            {
+                freeSlot++;
+            }
+            parser->pKeySlots[freeSlot] = pBucketKeys[pBucketStarts[bucket]];
+            parser->pKeySeeds[bucket] = KEY_SEED_IS_SLOT | (uint32_t)freeSlot;
         }
-        else
+    }
+    parser->memorySuite.free(parser->memorySuite.userData, pBucketStarts);
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_EncodeKeyNames(JSON_Parser parser, Encoding encoding)
+{
+    /* Convert the key names, which are known to be valid, from the key
+       encoding to the specified encoding. */
+    size_t namesLength = parser->pKeyNameOffsets[parser->keyCount];
+    size_t newLength = 0;
+    size_t start = 0;
+    size_t key;
+    byte* pNewNames;
+    DecoderData decoderData;
+    if (namesLength > SIZE_MAX / LONGEST_ENCODING_SEQUENCE)
+    {
+        return JSON_Failure;
+    }
+    pNewNames = (byte*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, namesLength ? namesLength * LONGEST_ENCODING_SEQUENCE : 1);
+    if (!pNewNames)
+    {
+        return JSON_Failure;
+    }
+    Decoder_Reset(&decoderData);
+    for (key = 0; key < parser->keyCount; key++)
+    {
+        size_t end = parser->pKeyNameOffsets[key + 1];
+        parser->pKeyNameOffsets[key] = newLength;
+        for (; start < end; start++)
         {
-            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_UnknownToken);
-            return JSON_Failure;
+            DecoderOutput output = Decoder_ProcessByte(&decoderData, (Encoding)parser->keyEncoding, parser->pKeyNames[start]);
+            if (DECODER_RESULT_CODE(output) == SEQUENCE_COMPLETE)
+            {
+                newLength += EncodeCodepoint(DECODER_CODEPOINT(output), encoding, pNewNames + newLength);
+            }
         }
-        goto advance;
+    }
+    parser->pKeyNameOffsets[parser->keyCount] = newLength;
+    parser->memorySuite.free(parser->memorySuite.userData, parser->pKeyNames);
+    parser->pKeyNames = pNewNames;
+    parser->keyEncoding = (byte)encoding;
+    return JSON_Success;
+}
 
-    case LEXING_LITERAL:
+static JSON_Status JSON_Parser_LookUpMemberKey(JSON_Parser parser)
+{
+    /* The key names are re-encoded the first time a member name is looked
+       up if the string encoding was changed after the dictionary was set. */
+    const byte* pName = JSON_Parser_GetTokenBytes(parser);
+    size_t length = parser->tokenBytesUsed;
+    size_t key;
+    size_t offset;
+    uint32_t seed;
+    if (parser->keyEncoding != parser->stringEncoding &&
+        (!JSON_Parser_EncodeKeyNames(parser, (Encoding)parser->stringEncoding) || !JSON_Parser_PlaceKeys(parser)))
+    {
+        JSON_Parser_SetErrorAtToken(parser, JSON_Error_OutOfMemory);
+        return JSON_Failure;
+    }
+    seed = parser->pKeySeeds[HashKeyName(0, pName, length) % (uint32_t)parser->keyCount];
+    key = parser->pKeySlots[(seed & KEY_SEED_IS_SLOT) ? (size_t)(seed & ~KEY_SEED_IS_SLOT) : (size_t)(HashKeyName(seed, pName, length) % (uint32_t)parser->keyCount)];
+    offset = parser->pKeyNameOffsets[key];
+    parser->memberKeyIndex = (parser->pKeyNameOffsets[key + 1] - offset == length && (!length || !memcmp(parser->pKeyNames + offset, pName, length)))
+                             ? key : parser->keyCount;
+    return JSON_Success;
+}
+
+static JSON_UInt64* Document_AddWords(JSON_Document document, size_t count)
+{
+    JSON_UInt64* pWords;
+    while (document->tapeLength - document->tapeUsed < count)
+    {
+        JSON_UInt64* pNewTape = (JSON_UInt64*)GrowArray(&document->memorySuite, document->pTape, &document->tapeLength, sizeof(JSON_UInt64), DEFAULT_TAPE_LENGTH);
+        if (!pNewTape)
+        {
+            return NULL;
+        }
+        document->pTape = pNewTape;
+    }
+    pWords = document->pTape + document->tapeUsed;
+    document->tapeUsed += count;
+    return pWords;
+}
+
+static int Document_AddValue(JSON_Document document, byte type, size_t payload)
+{
+    JSON_UInt64* pWord = Document_AddWords(document, 1);
+    if (!pWord)
+    {
+        return 0;
+    }
+    *pWord = TAPE_WORD(type, payload);
+    if (type != TAPE_MEMBER_NAME && document->openContainersUsed)
+    {
+        document->pOpenContainers[document->openContainersUsed - 1]++;
+    }
+    return 1;
+}
+
+static int Document_AddEntry(JSON_Document document, const byte* pBytes, size_t length, unsigned int attributes, Encoding encoding, size_t valueSize, size_t* pOffset)
+{
+    DocumentEntry entry;
+    size_t offset = DOCUMENT_ENTRY_ALIGN(document->bytesUsed);
+    size_t textOffset = offset + DOCUMENT_ENTRY_HEADER_SIZE + valueSize;
+    size_t terminatorLength = SHORTEST_ENCODING_SEQUENCE(encoding);
+    if (offset < document->bytesUsed || textOffset < offset || length > SIZE_MAX - textOffset - terminatorLength)
+    {
+        return 0;
+    }
+    while (textOffset + length + terminatorLength > document->bytesLength)
+    {
+        byte* pNewBytes = (byte*)GrowArray(&document->memorySuite, document->pBytes, &document->bytesLength, 1, DEFAULT_DOCUMENT_BYTES_LENGTH);
+        if (!pNewBytes)
+        {
+            return 0;
+        }
+        document->pBytes = pNewBytes;
+    }
+    entry.length = length;
+    entry.attributes = attributes;
+    memcpy(document->pBytes + offset, &entry, sizeof(entry));
+    memcpy(document->pBytes + textOffset, pBytes, length);
+    memset(document->pBytes + textOffset + length, 0, terminatorLength);
+    document->bytesUsed = textOffset + length + terminatorLength;
+    *pOffset = offset;
+    return 1;
+}
+
+static int Document_StartContainer(JSON_Document document, byte type)
+{
+    size_t start = document->tapeUsed;
+    if (document->openContainersLength - document->openContainersUsed < 2)
+    {
+        size_t* pNewContainers = (size_t*)GrowArray(&document->memorySuite, document->pOpenContainers, &document->openContainersLength, sizeof(size_t), DEFAULT_OPEN_CONTAINERS_LENGTH);
+        if (!pNewContainers)
+        {
+            return 0;
+        }
+        document->pOpenContainers = pNewContainers;
+    }
+    if (!Document_AddValue(document, type, 0))
+    {
+        return 0;
+    }
+    document->pOpenContainers[document->openContainersUsed] = start;
+    document->pOpenContainers[document->openContainersUsed + 1] = 0;
+    document->openContainersUsed += 2;
+    return 1;
+}
+
+static int Document_EndContainer(JSON_Document document, byte type)
+{
+    size_t start;
+    JSON_UInt64* pWord;
+    if (!document->openContainersUsed)
+    {
+        return 1;
+    }
+    start = document->pOpenContainers[document->openContainersUsed - 2];
+    pWord = Document_AddWords(document, 1);
+    if (!pWord)
+    {
+        return 0;
+    }
+    *pWord = TAPE_WORD(type, document->pOpenContainers[document->openContainersUsed - 1]);
+    document->pTape[start] = TAPE_WORD(TAPE_TYPE(document->pTape[start]), document->tapeUsed);
+    document->openContainersUsed -= 2;
+    return 1;
+}
+
+static int Document_AddNumber(JSON_Document document, const JSON_NumberValue* pValue, JSON_NumberAttributes attributes, const byte* pText, size_t length, Encoding encoding)
+{
+    /* The value is stored in the 8 bytes that follow the entry header, and
+       is read back with memcpy(), so its alignment does not matter. */
+    size_t offset;
+    byte type;
+    JSON_UInt64 bits;
+    if (!Document_AddEntry(document, pText, length, attributes, encoding, DOCUMENT_NUMBER_VALUE_SIZE, &offset))
+    {
+        return 0;
+    }
+    switch (pValue->type)
+    {
+    case JSON_Int64Number:
+        type = TAPE_INT64;
+        bits = (JSON_UInt64)pValue->int64Value;
+        break;
+
+    case JSON_UInt64Number:
+        type = TAPE_UINT64;
+        bits = pValue->uint64Value;
+        break;
+
+    default:
+        type = TAPE_DOUBLE;
+        memcpy(&bits, &pValue->doubleValue, sizeof(bits));
+        break;
+    }
+    memcpy(document->pBytes + offset + DOCUMENT_ENTRY_HEADER_SIZE, &bits, sizeof(bits));
+    return Document_AddValue(document, type, offset);
+}
+
+static JSON_Status JSON_Parser_RecordGrammarEvents(JSON_Parser parser, byte emit)
+{
+    /* This is the equivalent of JSON_Parser_HandleGrammarEvents() for a
+       parser that records values in a document. Array items are implied
+       by the values that follow them, so they are not recorded. When path
+       filters are used, the values that match them are recorded as
+       top-level values, so the names of the members that contain them are
+       not recorded. */
+    JSON_Document document = parser->pDocument;
+    int recorded = 1;
+    SET_FLAGS_OFF(byte, emit, EMIT_ARRAY_ITEM);
+    switch (emit)
+    {
+    case EMIT_NULL:
+        recorded = Document_AddValue(document, TAPE_NULL, 0);
+        break;
+
+    case EMIT_BOOLEAN:
+        recorded = Document_AddValue(document, (parser->token == T_TRUE) ? TAPE_TRUE : TAPE_FALSE, 0);
+        break;
+
+    case EMIT_OBJECT_MEMBER:
+        if (!JSON_Parser_AddMemberNameToList(parser)) /* will fail if member is duplicate */
+        {
+            return JSON_Failure;
+        }
+        if (!document->openContainersUsed)
+        {
+            break;
+        }
+        /* fall through */
+
+    case EMIT_STRING:
+        {
+            size_t offset;
+            recorded = Document_AddEntry(document, JSON_Parser_GetTokenBytes(parser), parser->tokenBytesUsed, parser->tokenAttributes,
+                                         (Encoding)parser->stringEncoding, 0, &offset) &&
+                       Document_AddValue(document, (emit == EMIT_OBJECT_MEMBER) ? TAPE_MEMBER_NAME : TAPE_STRING, offset);
+        }
+        break;
+
+    case EMIT_NUMBER:
+        {
+            JSON_NumberValue value;
+            JSON_NumberAttributes attributes;
+            if (!JSON_Parser_ConvertNumber(parser, &value, &attributes))
+            {
+                return JSON_Failure;
+            }
+            recorded = Document_AddNumber(document, &value, attributes, parser->pTokenBytes, parser->tokenBytesUsed, (Encoding)parser->numberEncoding);
+        }
+        break;
+
+    case EMIT_SPECIAL_NUMBER:
+        recorded = Document_AddValue(document, TAPE_SPECIAL_NUMBER, (parser->token == T_NAN) ? JSON_NaN :
+                                     ((parser->token == T_INFINITY) ? JSON_Infinity : JSON_NegativeInfinity));
+        break;
+
+    case EMIT_START_OBJECT:
+        if (!JSON_Parser_StartContainer(parser, 1/*isObject*/))
+        {
+            return JSON_Failure;
+        }
+        recorded = Document_StartContainer(document, TAPE_START_OBJECT);
+        break;
+
+    case EMIT_END_OBJECT:
+        JSON_Parser_EndContainer(parser, 1/*isObject*/);
+        recorded = Document_EndContainer(document, TAPE_END_OBJECT);
+        break;
+
+    case EMIT_START_ARRAY:
+        if (!JSON_Parser_StartContainer(parser, 0/*isObject*/))
+        {
+            return JSON_Failure;
+        }
+        recorded = Document_StartContainer(document, TAPE_START_ARRAY);
+        break;
+
+    case EMIT_END_ARRAY:
+        JSON_Parser_EndContainer(parser, 0/*isObject*/);
+        recorded = Document_EndContainer(document, TAPE_END_ARRAY);
+        break;
+
+    default: /* EMIT_NOTHING */
+        break;
+    }
+    if (!recorded)
+    {
+        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+static int JSON_Parser_CallsDocumentHandlers(JSON_Parser parser)
+{
+    /* The document handlers have no counterpart in pulled, batched or
+       recorded events. */
+    return !GET_FLAGS(parser->state, PARSER_PULLING) && !parser->batchEventsLength && !parser->pDocument;
+}
+
+static JSON_Status JSON_Parser_StartDocument(JSON_Parser parser)
+{
+    /* This is called before the first token of each document is processed.
+       Once a document has finished, another one can start only if the
+       parser allows multiple documents; otherwise the grammarian rejects
+       the token. */
+    if (Grammarian_FinishedDocument(&parser->grammarianData))
+    {
+        if (!GET_FLAGS(parser->flags, PARSER_MULTIPLE_DOCUMENTS))
+        {
+            return JSON_Success;
+        }
+        Grammarian_Reset(&parser->grammarianData, 1/*isInitialized*/);
+    }
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_DOCUMENT);
+    return !JSON_Parser_CallsDocumentHandlers(parser) ||
+           JSON_Parser_CallSimpleTokenHandler(parser, parser->startDocumentHandler, 0/*canSkipValue*/);
+}
+
+static JSON_Status JSON_Parser_EndDocument(JSON_Parser parser)
+{
+    SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_DOCUMENT);
+    return !JSON_Parser_CallsDocumentHandlers(parser) ||
+           JSON_Parser_CallSimpleTokenHandler(parser, parser->endDocumentHandler, 0/*canSkipValue*/);
+}
+
+static JSON_Status JSON_Parser_HandleGrammarEvents(JSON_Parser parser, byte emit)
+{
+    if (GET_FLAGS(parser->state, PARSER_SKIPPING_VALUE))
+    {
+        if (!JSON_Parser_SkipGrammarEvents(parser, emit))
+        {
+            return JSON_Failure;
+        }
+        emit = EMIT_NOTHING;
+    }
+    else if (parser->pathNodesUsed && !JSON_Parser_FilterGrammarEvents(parser, &emit))
+    {
+        return JSON_Failure;
+    }
+    if (emit == EMIT_OBJECT_MEMBER && parser->keyCount && !JSON_Parser_LookUpMemberKey(parser))
+    {
+        return JSON_Failure;
+    }
+    if (GET_FLAGS(parser->state, PARSER_PULLING))
+    {
+        if (!JSON_Parser_QueueGrammarEvents(parser, emit))
+        {
+            return JSON_Failure;
+        }
+        emit = EMIT_NOTHING;
+    }
+    else if (parser->pDocument)
+    {
+        if (!JSON_Parser_RecordGrammarEvents(parser, emit))
+        {
+            return JSON_Failure;
+        }
+        emit = EMIT_NOTHING;
+    }
+    else if (parser->batchEventsLength)
+    {
+        if (!JSON_Parser_BatchGrammarEvents(parser, emit))
+        {
+            return JSON_Failure;
+        }
+        emit = EMIT_NOTHING;
+    }
+    else if (GET_FLAGS(emit, EMIT_ARRAY_ITEM))
+    {
+        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->arrayItemHandler, 1/*canSkipValue*/))
+        {
+            return JSON_Failure;
+        }
+        SET_FLAGS_OFF(byte, emit, EMIT_ARRAY_ITEM);
+        if (GET_FLAGS(parser->state, PARSER_SKIPPING_VALUE))
+        {
+            if (!JSON_Parser_SkipGrammarEvents(parser, emit))
+            {
+                return JSON_Failure;
+            }
+            emit = EMIT_NOTHING;
+        }
+    }
+    switch (emit)
+    {
+    case EMIT_NULL:
+        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->nullHandler, 0/*canSkipValue*/))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_BOOLEAN:
+        if (!JSON_Parser_CallBooleanHandler(parser))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_STRING:
+        if (!JSON_Parser_CallStringHandler(parser, 0/* isObjectMember */))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_NUMBER:
+        if (!JSON_Parser_CallNumberHandler(parser))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_SPECIAL_NUMBER:
+        if (!JSON_Parser_CallSpecialNumberHandler(parser))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_START_OBJECT:
+        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->startObjectHandler, 1/*canSkipValue*/) ||
+            !JSON_Parser_StartContainer(parser, 1/*isObject*/))
+        {
+            return JSON_Failure;
+        }
+        if (GET_FLAGS(parser->state, PARSER_SKIPPING_VALUE))
+        {
+            parser->skipDepth = 1;
+        }
+        break;
+
+    case EMIT_END_OBJECT:
+        JSON_Parser_EndContainer(parser, 1/*isObject*/);
+        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->endObjectHandler, 0/*canSkipValue*/))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_OBJECT_MEMBER:
+        if (!JSON_Parser_AddMemberNameToList(parser) || /* will fail if member is duplicate */
+            !JSON_Parser_CallStringHandler(parser, 1 /* isObjectMember */))
+        {
+            return JSON_Failure;
+        }
+        break;
+
+    case EMIT_START_ARRAY:
+        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->startArrayHandler, 1/*canSkipValue*/) ||
+            !JSON_Parser_StartContainer(parser, 0/*isObject*/))
+        {
+            return JSON_Failure;
+        }
+        if (GET_FLAGS(parser->state, PARSER_SKIPPING_VALUE))
+        {
+            parser->skipDepth = 1;
+        }
+        break;
+
+    case EMIT_END_ARRAY:
+        JSON_Parser_EndContainer(parser, 0/*isObject*/);
+        if (!JSON_Parser_CallSimpleTokenHandler(parser, parser->endArrayHandler, 0/*canSkipValue*/))
+        {
+            return JSON_Failure;
+        }
+        break;
+    }
+    if (GET_FLAGS(parser->state, PARSER_IN_DOCUMENT) &&
+        Grammarian_FinishedDocument(&parser->grammarianData) &&
+        !JSON_Parser_EndDocument(parser))
+    {
+        return JSON_Failure;
+    }
+    if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT))
+    {
+        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_StoppedAfterEmbeddedDocument);
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_ProcessToken(JSON_Parser parser)
+{
+    GrammarianOutput output;
+    if (GET_FLAGS(parser->flags, PARSER_ARRAY_ELEMENTS) &&
+        !GET_FLAGS(parser->state, PARSER_IN_DOCUMENT) &&
+        Grammarian_FinishedDocument(&parser->grammarianData))
+    {
+        /* When the parser is parsing a run of array elements on behalf of
+           JSON_ParallelLines_ParseArray(), each element must be followed
+           by a comma or by the end of the input, and the comma clears the
+           way for the next element. */
+        if (parser->token != T_COMMA)
+        {
+            JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnexpectedToken);
+            return JSON_Failure;
+        }
+        Grammarian_Reset(&parser->grammarianData, 1/*isInitialized*/);
+        parser->arrayElementIndex++;
+    }
+    else
+    {
+        if (!GET_FLAGS(parser->state, PARSER_IN_DOCUMENT) && !JSON_Parser_StartDocument(parser))
+        {
+            return JSON_Failure;
+        }
+        output = Grammarian_ProcessToken(&parser->grammarianData, parser->token, &parser->memorySuite);
+        switch (GRAMMARIAN_RESULT_CODE(output))
+        {
+        case ACCEPTED_TOKEN:
+            if (!JSON_Parser_HandleGrammarEvents(parser, GRAMMARIAN_EVENT(output)))
+            {
+                return JSON_Failure;
+            }
+            break;
+
+        case REJECTED_TOKEN:
+            JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnexpectedToken);
+            return JSON_Failure;
+
+        case SYMBOL_STACK_FULL:
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+            return JSON_Failure;
+        }
+    }
+
+    /* Reset the lexer to prepare for the next token, unless the contents
+       of a container are to be skipped. */
+    parser->lexerState = parser->skipDepth ? LEXING_SKIPPING_CONTAINER : LEXING_WHITESPACE;
+    parser->lexerBits = 0;
+    parser->token = T_NONE;
+    parser->tokenAttributes = 0;
+    parser->pInputTokenBytes = NULL;
+    parser->tokenBytesUsed = 0;
+    return JSON_Success;
+}
+
+/* Lexer functions. */
+
+static const byte expectedLiteralChars[] = { 'u', 'l', 'l', 0, 'r', 'u', 'e', 0, 'a', 'l', 's', 'e', 0, 'a', 'N', 0, 'n', 'f', 'i', 'n', 'i', 't', 'y', 0  };
+
+#define NULL_LITERAL_EXPECTED_CHARS_START_INDEX     0
+#define TRUE_LITERAL_EXPECTED_CHARS_START_INDEX     4
+#define FALSE_LITERAL_EXPECTED_CHARS_START_INDEX    8
+#define NAN_LITERAL_EXPECTED_CHARS_START_INDEX      13
+#define INFINITY_LITERAL_EXPECTED_CHARS_START_INDEX 16
+
+/* Character classes used by the table-driven lexer states. */
+#define LC_OTHER           0
+#define LC_SPACE           1
+#define LC_LINE_BREAK      2
+#define LC_EOF             3
+#define LC_BOM             4
+#define LC_LEFT_CURLY      5
+#define LC_RIGHT_CURLY     6
+#define LC_LEFT_SQUARE     7
+#define LC_RIGHT_SQUARE    8
+#define LC_COLON           9
+#define LC_COMMA           10
+#define LC_QUOTE           11
+#define LC_MINUS           12
+#define LC_PLUS            13
+#define LC_DOT             14
+#define LC_ZERO            15
+#define LC_DIGIT           16
+#define LC_HEX_LETTER      17
+#define LC_E               18
+#define LC_F               19
+#define LC_N               20
+#define LC_T               21
+#define LC_X               22
+#define LC_UPPER_N         23
+#define LC_UPPER_I         24
+#define LC_SLASH           25
+#define LC_STAR            26
+#define LEXER_CLASSES      27
+
+/* The lexer classes of the ASCII codepoints. Codepoints outside the ASCII
+   range are all LC_OTHER, except for the BOM and EOF. Each parser makes a
+   copy of this table when it starts parsing, and maps the codepoints that
+   are only meaningful when certain settings are enabled to LC_OTHER if the
+   settings are disabled, so that the transition table does not need to
+   consult the settings. */
+static const byte asciiLexerClasses[128] =
+{
+    LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER, /* 00-07 */
+    LC_OTHER,        LC_SPACE,        LC_LINE_BREAK,   LC_OTHER,        LC_OTHER,        LC_LINE_BREAK,   LC_OTHER,        LC_OTHER, /* 08-0F */
+    LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER, /* 10-17 */
+    LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER, /* 18-1F */
+    LC_SPACE,        LC_OTHER,        LC_QUOTE,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER, /* 20-27 */
+    LC_OTHER,        LC_OTHER,        LC_STAR,         LC_PLUS,         LC_COMMA,        LC_MINUS,        LC_DOT,          LC_SLASH, /* 28-2F */
+    LC_ZERO,         LC_DIGIT,        LC_DIGIT,        LC_DIGIT,        LC_DIGIT,        LC_DIGIT,        LC_DIGIT,        LC_DIGIT, /* 30-37 */
+    LC_DIGIT,        LC_DIGIT,        LC_COLON,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER, /* 38-3F */
+    LC_OTHER,        LC_HEX_LETTER,   LC_HEX_LETTER,   LC_HEX_LETTER,   LC_HEX_LETTER,   LC_E,            LC_HEX_LETTER,   LC_OTHER, /* 40-47 */
+    LC_OTHER,        LC_UPPER_I,      LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_UPPER_N,      LC_OTHER, /* 48-4F */
+    LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER, /* 50-57 */
+    LC_X,            LC_OTHER,        LC_OTHER,        LC_LEFT_SQUARE,  LC_OTHER,        LC_RIGHT_SQUARE, LC_OTHER,        LC_OTHER, /* 58-5F */
+    LC_OTHER,        LC_HEX_LETTER,   LC_HEX_LETTER,   LC_HEX_LETTER,   LC_HEX_LETTER,   LC_E,            LC_F,            LC_OTHER, /* 60-67 */
+    LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_N,            LC_OTHER, /* 68-6F */
+    LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_OTHER,        LC_T,            LC_OTHER,        LC_OTHER,        LC_OTHER, /* 70-77 */
+    LC_X,            LC_OTHER,        LC_OTHER,        LC_LEFT_CURLY,   LC_OTHER,        LC_RIGHT_CURLY,  LC_OTHER,        LC_OTHER  /* 78-7F */
+};
+
+/* Actions taken by the table-driven lexer states. */
+#define LEX_STAY                        0 /* stay in the current state */
+#define LEX_GOTO                        1 /* go to the state in arg */
+#define LEX_UNKNOWN_TOKEN_AT_CODEPOINT  2
+#define LEX_UNKNOWN_TOKEN_AT_TOKEN      3
+#define LEX_BOM                         4
+#define LEX_PUNCTUATION                 5 /* arg is the token */
+#define LEX_START_LITERAL               6 /* arg is the token, bits is the expected chars index */
+#define LEX_CONTINUE_AS_LITERAL         7 /* arg is the token, bits is the expected chars index */
+#define LEX_START_STRING                8
+#define LEX_START_NUMBER                9 /* arg is the next state, bits are attributes to set */
+#define LEX_RECORD_NUMBER_CODEPOINT     10 /* arg is the next state, bits are attributes to set */
+#define LEX_FINISH_NUMBER               11
+#define LEX_INVALID_NUMBER              12 /* arg is the codepoints since the number was valid, bits are attributes to remove */
+#define LEX_START_COMMENT               13
+#define LEX_LINE_BREAK                  14 /* go to the state in arg after a line break */
+
+typedef struct tag_LexerTransition
+{
+    byte action;
+    byte arg;
+    byte bits;
+} LexerTransition;
+
+#define LX_STAY { LEX_STAY, 0, 0 }
+#define LX_UCP  { LEX_UNKNOWN_TOKEN_AT_CODEPOINT, 0, 0 }
+#define LX_UTK  { LEX_UNKNOWN_TOKEN_AT_TOKEN, 0, 0 }
+#define LX_BOM  { LEX_BOM, 0, 0 }
+#define LX_LCB  { LEX_PUNCTUATION, T_LEFT_CURLY, 0 }
+#define LX_RCB  { LEX_PUNCTUATION, T_RIGHT_CURLY, 0 }
+#define LX_LSB  { LEX_PUNCTUATION, T_LEFT_SQUARE, 0 }
+#define LX_RSB  { LEX_PUNCTUATION, T_RIGHT_SQUARE, 0 }
+#define LX_COL  { LEX_PUNCTUATION, T_COLON, 0 }
+#define LX_COM  { LEX_PUNCTUATION, T_COMMA, 0 }
+#define LX_NUL  { LEX_START_LITERAL, T_NULL, NULL_LITERAL_EXPECTED_CHARS_START_INDEX }
+#define LX_TRU  { LEX_START_LITERAL, T_TRUE, TRUE_LITERAL_EXPECTED_CHARS_START_INDEX }
+#define LX_FAL  { LEX_START_LITERAL, T_FALSE, FALSE_LITERAL_EXPECTED_CHARS_START_INDEX }
+#define LX_NAN  { LEX_START_LITERAL, T_NAN, NAN_LITERAL_EXPECTED_CHARS_START_INDEX }
+#define LX_INF  { LEX_START_LITERAL, T_INFINITY, INFINITY_LITERAL_EXPECTED_CHARS_START_INDEX }
+#define LX_NIN  { LEX_CONTINUE_AS_LITERAL, T_NEGATIVE_INFINITY, INFINITY_LITERAL_EXPECTED_CHARS_START_INDEX }
+#define LX_STR  { LEX_START_STRING, 0, 0 }
+#define LX_NEG  { LEX_START_NUMBER, LEXING_NUMBER_AFTER_MINUS, JSON_IsNegative }
+#define LX_LZ   { LEX_START_NUMBER, LEXING_NUMBER_AFTER_LEADING_ZERO, 0 }
+#define LX_INT  { LEX_START_NUMBER, LEXING_NUMBER_DECIMAL_DIGITS, 0 }
+#define LX_NZ   { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_AFTER_LEADING_NEGATIVE_ZERO, 0 }
+#define LX_DEC  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_DECIMAL_DIGITS, 0 }
+#define LX_DOT  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_AFTER_DOT, JSON_ContainsDecimalPoint }
+#define LX_FRA  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_FRACTIONAL_DIGITS, 0 }
+#define LX_E    { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_AFTER_E, JSON_ContainsExponent }
+#define LX_X    { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_AFTER_X, JSON_IsHex }
+#define LX_HEX  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_HEX_DIGITS, 0 }
+#define LX_POS  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_AFTER_EXPONENT_SIGN, 0 }
+#define LX_NGE  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_AFTER_EXPONENT_SIGN, JSON_ContainsNegativeExponent }
+#define LX_EXP  { LEX_RECORD_NUMBER_CODEPOINT, LEXING_NUMBER_EXPONENT_DIGITS, 0 }
+#define LX_END  { LEX_FINISH_NUMBER, 0, 0 }
+#define LX_BLZ  { LEX_INVALID_NUMBER, 0, 0 }
+#define LX_BX   { LEX_INVALID_NUMBER, 1, JSON_IsHex }
+#define LX_BDOT { LEX_INVALID_NUMBER, 1, JSON_ContainsDecimalPoint }
+#define LX_BE   { LEX_INVALID_NUMBER, 1, JSON_ContainsExponent }
+#define LX_BSGN { LEX_INVALID_NUMBER, 2, JSON_ContainsExponent | JSON_ContainsNegativeExponent }
+#define LX_CMT  { LEX_START_COMMENT, LEXING_COMMENT_AFTER_SLASH, 0 }
+#define LX_WS   { LEX_GOTO, LEXING_WHITESPACE, 0 }
+#define LX_WSLB { LEX_LINE_BREAK, LEXING_WHITESPACE, 0 }
+#define LX_MLLB { LEX_LINE_BREAK, LEXING_MULTI_LINE_COMMENT, 0 }
+#define LX_SLC  { LEX_GOTO, LEXING_SINGLE_LINE_COMMENT, 0 }
+#define LX_MLC  { LEX_GOTO, LEXING_MULTI_LINE_COMMENT, 0 }
+#define LX_AST  { LEX_GOTO, LEXING_MULTI_LINE_COMMENT_AFTER_STAR, 0 }
+
+/* The transition table, indexed by lexer state and lexer class. The
+   columns of each row are in lexer class order:
+
+   OTHER      SPACE      LINE_BREAK EOF        BOM        LEFT_CURLY RIGHT_CURLY LEFT_SQUARE RIGHT_SQUARE
+   COLON      COMMA      QUOTE      MINUS      PLUS       DOT        ZERO        DIGIT       HEX_LETTER
+   E          F          N          T          X          UPPER_N    UPPER_I     SLASH       STAR
+*/
+static const LexerTransition lexerTransitions[LEXER_TABLE_STATES][LEXER_CLASSES] =
+{
+    /* LEXING_WHITESPACE */
+    {
+        LX_UCP,  LX_STAY, LX_WSLB, LX_STAY, LX_BOM,  LX_LCB,  LX_RCB,  LX_LSB,  LX_RSB,
+        LX_COL,  LX_COM,  LX_STR,  LX_NEG,  LX_UCP,  LX_UCP,  LX_LZ,   LX_INT,  LX_UCP,
+        LX_UCP,  LX_FAL,  LX_NUL,  LX_TRU,  LX_UCP,  LX_NAN,  LX_INF,  LX_CMT,  LX_UCP
+    },
+    /* LEXING_NUMBER_AFTER_MINUS */
+    {
+        LX_UTK,  LX_UTK,  LX_UTK,  LX_STAY, LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,
+        LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_NZ,   LX_DEC,  LX_UTK,
+        LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_NIN,  LX_UTK,  LX_UTK
+    },
+    /* LEXING_NUMBER_AFTER_LEADING_ZERO */
+    {
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_DOT,  LX_BLZ,  LX_BLZ,  LX_END,
+        LX_E,    LX_END,  LX_END,  LX_END,  LX_X,    LX_END,  LX_END,  LX_END,  LX_END
+    },
+    /* LEXING_NUMBER_AFTER_LEADING_NEGATIVE_ZERO */
+    {
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_DOT,  LX_BLZ,  LX_BLZ,  LX_END,
+        LX_E,    LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END
+    },
+    /* LEXING_NUMBER_AFTER_X */
+    {
+        LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,
+        LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_HEX,  LX_HEX,  LX_HEX,
+        LX_HEX,  LX_HEX,  LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX,   LX_BX
+    },
+    /* LEXING_NUMBER_HEX_DIGITS */
+    {
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_HEX,  LX_HEX,  LX_HEX,
+        LX_HEX,  LX_HEX,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END
+    },
+    /* LEXING_NUMBER_DECIMAL_DIGITS */
+    {
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_DOT,  LX_DEC,  LX_DEC,  LX_END,
+        LX_E,    LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END
+    },
+    /* LEXING_NUMBER_AFTER_DOT */
+    {
+        LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT,
+        LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_FRA,  LX_FRA,  LX_BDOT,
+        LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT, LX_BDOT
+    },
+    /* LEXING_NUMBER_FRACTIONAL_DIGITS */
+    {
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_FRA,  LX_FRA,  LX_END,
+        LX_E,    LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END
+    },
+    /* LEXING_NUMBER_AFTER_E */
+    {
+        LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,
+        LX_BE,   LX_BE,   LX_BE,   LX_NGE,  LX_POS,  LX_BE,   LX_EXP,  LX_EXP,  LX_BE,
+        LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE,   LX_BE
+    },
+    /* LEXING_NUMBER_AFTER_EXPONENT_SIGN */
+    {
+        LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN,
+        LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_EXP,  LX_EXP,  LX_BSGN,
+        LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN, LX_BSGN
+    },
+    /* LEXING_NUMBER_EXPONENT_DIGITS */
+    {
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_EXP,  LX_EXP,  LX_END,
+        LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END,  LX_END
+    },
+    /* LEXING_COMMENT_AFTER_SLASH */
+    {
+        LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,
+        LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,
+        LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_UTK,  LX_SLC,  LX_MLC
+    },
+    /* LEXING_SINGLE_LINE_COMMENT */
+    {
+        LX_STAY, LX_STAY, LX_WSLB, LX_WS,   LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY,
+        LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY,
+        LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY
+    },
+    /* LEXING_MULTI_LINE_COMMENT */
+    {
+        LX_STAY, LX_STAY, LX_MLLB, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY,
+        LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY,
+        LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_STAY, LX_AST
+    },
+    /* LEXING_MULTI_LINE_COMMENT_AFTER_STAR */
+    {
+        LX_MLC,  LX_MLC,  LX_MLLB, LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,
+        LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,
+        LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_MLC,  LX_WS,   LX_STAY
+    }
+};
+
+static void JSON_Parser_InitLexerClasses(JSON_Parser parser)
+{
+    memcpy(parser->lexerClasses, asciiLexerClasses, sizeof(asciiLexerClasses));
+    if (!GET_FLAGS(parser->flags, PARSER_ALLOW_COMMENTS))
+    {
+        parser->lexerClasses['/'] = LC_OTHER;
+    }
+    if (!GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS))
+    {
+        parser->lexerClasses['N'] = LC_OTHER;
+        parser->lexerClasses['I'] = LC_OTHER;
+    }
+    if (!GET_FLAGS(parser->flags, PARSER_ALLOW_HEX_NUMBERS))
+    {
+        parser->lexerClasses['x'] = LC_OTHER;
+        parser->lexerClasses['X'] = LC_OTHER;
+    }
+}
+
+/* Forward declaration. */
+static JSON_Status JSON_Parser_FlushLexer(JSON_Parser parser);
+static JSON_Status JSON_Parser_ProcessCodepoint(JSON_Parser parser, Codepoint c, size_t encodedLength);
+
+static JSON_Status JSON_Parser_HandleInvalidEncodingSequence(JSON_Parser parser, size_t encodedLength) {
+    if (parser->token == T_STRING && GET_FLAGS(parser->flags, PARSER_REPLACE_INVALID))
+    {
+        /* Since we're inside a string token, replacing the invalid sequence
+           with the Unicode replacement character as requested by the client
+           is a viable way to avoid a parse failure. Outside a string token,
+           such a replacement would simply trigger JSON_Error_UnknownToken
+           when we tried to process the replacement character, so it's less
+           confusing to stick with JSON_Error_InvalidEncodingSequence in that
+           case. */
+        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsReplacedCharacter);
+        return JSON_Parser_ProcessCodepoint(parser, REPLACEMENT_CHARACTER_CODEPOINT, encodedLength);
+    }
+    else if (parser->lexerState == LEXING_SKIPPING_STRING && GET_FLAGS(parser->flags, PARSER_REPLACE_INVALID))
+    {
+        /* Likewise inside a string that is being skipped, except that there
+           is no token to which to attribute the replacement. */
+        return JSON_Parser_ProcessCodepoint(parser, REPLACEMENT_CHARACTER_CODEPOINT, encodedLength);
+    }
+    else if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT))
+    {
+        /* Since we're parsing the top-level value of an embedded
+           document, assume that the invalid encoding sequence we've
+           encountered does not actually belong to the document, and
+           finish parsing by pretending that we've encountered EOF
+           instead of an invalid sequence. If the content is valid,
+           this will fail with JSON_Error_StoppedAfterEmbeddedDocument;
+           otherwise, it will fail with an appropriate error. */
+        return JSON_Parser_FlushLexer(parser) && JSON_Parser_FlushParser(parser);
+    }
+    JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_InvalidEncodingSequence);
+    return JSON_Failure;
+}
+
+/* Only the byte offset of the current codepoint is updated as each
+   codepoint is processed. The line number is updated only when a line break
+   is processed, and the column number is derived from the byte offset when
+   it is needed, using the byte offset at which the current line started
+   and the number of bytes by which the encoding sequences of the codepoints
+   on the current line exceed the shortest sequence length of the input
+   encoding. The excess is accumulated only for codepoints that pass through
+   the decoder, since ASCII codepoints in UTF-8 never have any. */
+
+static size_t JSON_Parser_GetColumn(JSON_Parser parser, size_t location)
+{
+    /* The shortest sequence length is a power of 2. Note that the excess
+       wraps around if a truncated sequence at the end of the input is
+       shorter than the shortest sequence length, which is harmless since
+       the subtraction wraps around the same way. */
+    return (location - parser->lineStartByte - parser->lineExtraBytes) >> (parser->inputEncoding >> 1);
+}
+
+static void JSON_Parser_AddLineExtraBytes(JSON_Parser parser, size_t encodedLength)
+{
+    parser->lineExtraBytes += encodedLength - SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding);
+}
+
+static void JSON_Parser_BreakLine(JSON_Parser parser, Codepoint c, size_t encodedLength)
+{
+    /* The codepoint is U+000D (CARRIAGE RETURN) or U+000A (LINE FEED), and
+       the next codepoint will begin a new line. A CR followed immediately by
+       an LF is treated as a single line break. */
+    if (c == CARRIAGE_RETURN_CODEPOINT)
+    {
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_AFTER_CARRIAGE_RETURN);
+        parser->codepointLocationLine++;
+    }
+    else
+    {
+        if (!GET_FLAGS(parser->state, PARSER_AFTER_CARRIAGE_RETURN) ||
+            parser->lineStartByte != parser->codepointLocationByte)
+        {
+            parser->codepointLocationLine++;
+        }
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_AFTER_CARRIAGE_RETURN);
+    }
+    parser->lineStartByte = parser->codepointLocationByte + encodedLength;
+    parser->lineExtraBytes = 0;
+}
+
+static JSON_Status JSON_Parser_HandleInvalidNumber(JSON_Parser parser, Codepoint c, int codepointsSinceValidNumber, TokenAttributes attributesToRemove)
+{
+    SET_FLAGS_OFF(TokenAttributes, parser->tokenAttributes, attributesToRemove);
+    if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT))
+    {
+        /* The invalid number is the top-level value of an embedded document,
+           and it has a prefix that can be interpreted as a valid number.
+           We want to backtrack so that we are at the end of that prefix,
+           and then process the valid token.
+
+           Note that backtracking requires us to make three assumptions, which
+           are always valid in the context of a number token:
+
+           1. The input encoding is not JSON_UnknownEncoding.
+
+           2 The codepoints we are backing up across are all in the range
+           U+0000 - U+007F, aka ASCII, so we can assume the number of
+           bytes comprising them based on the input encoding.
+
+           3. The codepoints we are backing up across do not include any
+           line breaks, so we can assume that the line number stays the
+           same.
+
+           For example:
+
+               "01"     => "0"
+               "123.!"  => "123"
+               "123e!"  => "123"
+               "123e+!" => "123"
+               "123e-!" => "123"
+               "1.2e!"  => "1.2"
+               "1.2e+!" => "1.2"
+               "1.2e-!" => "1.2"
+        */
+        parser->codepointLocationByte -= (size_t)codepointsSinceValidNumber * SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding);
+        parser->tokenBytesUsed -= (size_t)codepointsSinceValidNumber * SHORTEST_ENCODING_SEQUENCE(parser->numberEncoding);
+        return JSON_Parser_ProcessToken(parser); /* always fails */
+    }
+    else if (c == EOF_CODEPOINT)
+    {
+        /* Allow JSON_Parser_FlushLexer() to fail. */
+        return JSON_Success;
+    }
+    JSON_Parser_SetErrorAtToken(parser, JSON_Error_InvalidNumber);
+    return JSON_Failure;
+}
+
+static void JSON_Parser_SetTokenLocation(JSON_Parser parser)
+{
+    parser->tokenLocationByte = parser->codepointLocationByte;
+    parser->tokenLocationLine = parser->codepointLocationLine;
+    parser->tokenLocationColumn = JSON_Parser_GetColumn(parser, parser->codepointLocationByte);
+}
+
+static void JSON_Parser_StartToken(JSON_Parser parser, Symbol token)
+{
+    if (token == T_NUMBER)
+    {
+        Number_Reset(&parser->numberData);
+    }
+    parser->token = token;
+    JSON_Parser_SetTokenLocation(parser);
+}
+
+static int JSON_Parser_SkipCodepoint(JSON_Parser parser, Codepoint c)
+{
+    /* While a container is being skipped, the lexer only keeps track of
+       whether it is inside a string or a comment, and of how deeply the
+       containers inside the skipped container are nested. Returns 1 if the
+       codepoint is the bracket that ends the skipped container. */
+    switch (parser->lexerState)
+    {
+    case LEXING_SKIPPING_COMMENT_AFTER_SLASH:
+        if (c == '/')
+        {
+            parser->lexerState = LEXING_SKIPPING_SINGLE_LINE_COMMENT;
+            break;
+        }
+        if (c == '*')
+        {
+            parser->lexerState = LEXING_SKIPPING_MULTI_LINE_COMMENT;
+            break;
+        }
+        parser->lexerState = LEXING_SKIPPING_CONTAINER;
+        /* fall through */
+
+    case LEXING_SKIPPING_CONTAINER:
+        if (c == '"')
+        {
+            parser->lexerState = LEXING_SKIPPING_STRING;
+        }
+        else if (c == '{' || c == '[')
+        {
+            parser->skipDepth++;
+        }
+        else if (c == '}' || c == ']')
+        {
+            parser->skipDepth--;
+            return !parser->skipDepth;
+        }
+        else if (c == '/' && GET_FLAGS(parser->flags, PARSER_ALLOW_COMMENTS))
+        {
+            parser->lexerState = LEXING_SKIPPING_COMMENT_AFTER_SLASH;
+        }
+        break;
+
+    case LEXING_SKIPPING_STRING:
+        if (c == '"')
+        {
+            parser->lexerState = LEXING_SKIPPING_CONTAINER;
+        }
+        else if (c == '\\')
+        {
+            parser->lexerState = LEXING_SKIPPING_STRING_ESCAPE;
+        }
+        break;
+
+    case LEXING_SKIPPING_STRING_ESCAPE:
+        parser->lexerState = LEXING_SKIPPING_STRING;
+        break;
+
+    case LEXING_SKIPPING_SINGLE_LINE_COMMENT:
+        if (c == CARRIAGE_RETURN_CODEPOINT || c == LINE_FEED_CODEPOINT)
+        {
+            parser->lexerState = LEXING_SKIPPING_CONTAINER;
+        }
+        break;
+
+    case LEXING_SKIPPING_MULTI_LINE_COMMENT:
+        if (c == '*')
+        {
+            parser->lexerState = LEXING_SKIPPING_MULTI_LINE_COMMENT_AFTER_STAR;
+        }
+        break;
+
+    default: /* LEXING_SKIPPING_MULTI_LINE_COMMENT_AFTER_STAR */
+        if (c == '/')
+        {
+            parser->lexerState = LEXING_SKIPPING_CONTAINER;
+        }
+        else if (c != '*')
+        {
+            parser->lexerState = LEXING_SKIPPING_MULTI_LINE_COMMENT;
+        }
+        break;
+    }
+    return 0;
+}
+
+static JSON_Status JSON_Parser_ProcessCodepoint(JSON_Parser parser, Codepoint c, size_t encodedLength)
+{
+    Codepoint codepointToRecord = EOF_CODEPOINT;
+    Encoding tokenEncoding;
+    size_t maxTokenLength;
+    int tokenFinished = 0;
+
+reprocess:
+
+    if (parser->lexerState < LEXER_TABLE_STATES)
+    {
+        const LexerTransition* pTransition = &lexerTransitions[parser->lexerState]
+            [(c < FIRST_NON_ASCII_CODEPOINT) ? parser->lexerClasses[c] : (c == EOF_CODEPOINT) ? LC_EOF : (c == BOM_CODEPOINT) ? LC_BOM : LC_OTHER];
+        switch (pTransition->action)
+        {
+        case LEX_STAY:
+            goto advance;
+
+        case LEX_GOTO:
+            parser->lexerState = pTransition->arg;
+            goto advance;
+
+        case LEX_LINE_BREAK:
+            JSON_Parser_BreakLine(parser, c, encodedLength);
+            parser->lexerState = pTransition->arg;
+            goto advance;
+
+        case LEX_BOM:
+            if (parser->codepointLocationByte != 0)
+            {
+                JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_UnknownToken);
+                return JSON_Failure;
+            }
+            if (!GET_FLAGS(parser->flags, PARSER_ALLOW_BOM))
+            {
+                JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_BOMNotAllowed);
+                return JSON_Failure;
+            }
+            /* OK, we'll allow the BOM. */
+            goto advance;
+
+        case LEX_PUNCTUATION:
+            JSON_Parser_StartToken(parser, pTransition->arg);
+            tokenFinished = 1;
+            goto advance;
+
+        case LEX_START_LITERAL:
+            JSON_Parser_StartToken(parser, pTransition->arg);
+            parser->lexerBits = pTransition->bits;
+            parser->lexerState = LEXING_LITERAL;
+            goto advance;
+
+        case LEX_CONTINUE_AS_LITERAL:
+            parser->token = pTransition->arg; /* changing horses mid-stream, so to speak */
+            parser->lexerBits = pTransition->bits;
+            parser->lexerState = LEXING_LITERAL;
+            goto advance;
+
+        case LEX_START_STRING:
+            JSON_Parser_StartToken(parser, T_STRING);
+            parser->lexerState = LEXING_STRING;
+            goto advance;
+
+        case LEX_START_NUMBER:
+            JSON_Parser_StartToken(parser, T_NUMBER);
+            /* fall through */
+
+        case LEX_RECORD_NUMBER_CODEPOINT:
+            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, pTransition->bits);
+            parser->lexerState = pTransition->arg;
+            codepointToRecord = c;
+            goto recordNumberCodepointAndAdvance;
+
+        case LEX_FINISH_NUMBER:
+            if (!JSON_Parser_ProcessToken(parser))
+            {
+                return JSON_Failure;
+            }
+            goto reprocess;
+
+        case LEX_INVALID_NUMBER:
+            /* Note that JSON does not allow the integer part of a number to
+               have any digits after a leading zero. We trigger an unknown
+               token error rather than an invalid number error after a minus
+               sign, so that "Foo" and "-Foo" trigger the same error. */
+            if (!JSON_Parser_HandleInvalidNumber(parser, c, pTransition->arg, pTransition->bits))
+            {
+                return JSON_Failure;
+            }
+            goto advance;
+
+        case LEX_START_COMMENT:
+            /* Comments are not real tokens, but we save the location
+               of the comment as the token location in case of an error. */
+            JSON_Parser_SetTokenLocation(parser);
+            parser->lexerState = pTransition->arg;
+            goto advance;
+
+        case LEX_UNKNOWN_TOKEN_AT_TOKEN:
+            JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
+            return JSON_Failure;
+
+        default: /* LEX_UNKNOWN_TOKEN_AT_CODEPOINT */
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_UnknownToken);
+            return JSON_Failure;
+        }
+    }
+
+    switch (parser->lexerState)
+    {
+    case LEXING_LITERAL:
         /* While lexing a literal we store an index into expectedLiteralChars
            in lexerBits. */
         if (expectedLiteralChars[parser->lexerBits])
         {
-            /* The codepoint should match the next character in the literal. */
-            if (c != expectedLiteralChars[parser->lexerBits])
+            /* The codepoint should match the next character in the literal. */
+            if (c != expectedLiteralChars[parser->lexerBits])
+            {
+                JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
+                return JSON_Failure;
+            }
+            parser->lexerBits++;
+
+            /* If the literal is the top-level value of an embedded document,
+               process it as soon as we consume its last expected codepoint.
+               Normally we defer processing until the following codepoint
+               has been examined, so that we can treat sequences like "nullx"
+               as a single, unknown token rather than a null literal followed
+               by an unknown token. */
+            if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT) &&
+                !expectedLiteralChars[parser->lexerBits])
+            {
+                tokenFinished = 1;
+            }
+        }
+        else
+        {
+            /* The literal should be finished, so the codepoint should not be
+               a plausible JSON literal character, but rather EOF, whitespace,
+               or the first character of the next token. */
+            if ((c >= 'A' && c <= 'Z') ||
+                (c >= 'a' && c <= 'z') ||
+                (c >= '0' && c <= '9') ||
+                (c == '_'))
+            {
+                JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
+                return JSON_Failure;
+            }
+            if (!JSON_Parser_ProcessToken(parser))
+            {
+                return JSON_Failure;
+            }
+            goto reprocess;
+        }
+        goto advance;
+
+    case LEXING_STRING:
+        if (c == EOF_CODEPOINT)
+        {
+            /* Allow JSON_Parser_FlushLexer() to fail. */
+        }
+        else if (c == '"')
+        {
+            tokenFinished = 1;
+        }
+        else if (c == '\\')
+        {
+            parser->lexerState = LEXING_STRING_ESCAPE;
+        }
+        else if (c < 0x20)
+        {
+            /* ASCII control characters (U+0000 - U+001F) are not allowed to
+               appear unescaped in string values unless specifically allowed. */
+            if (!GET_FLAGS(parser->flags, PARSER_ALLOW_CONTROL_CHARS))
+            {
+                JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_UnescapedControlCharacter);
+                return JSON_Failure;
+            }
+            if (c == CARRIAGE_RETURN_CODEPOINT || c == LINE_FEED_CODEPOINT)
+            {
+                JSON_Parser_BreakLine(parser, c, encodedLength);
+            }
+            codepointToRecord = c;
+            goto recordStringCodepointAndAdvance;
+        }
+        else
+        {
+            codepointToRecord = c;
+            goto recordStringCodepointAndAdvance;
+        }
+        goto advance;
+
+    case LEXING_STRING_ESCAPE:
+        if (c == EOF_CODEPOINT)
+        {
+            /* Allow JSON_Parser_FlushLexer() to fail. */
+        }
+        else
+        {
+            if (c == 'u')
+            {
+                parser->lexerState = LEXING_STRING_HEX_ESCAPE_BYTE_1;
+            }
+            else
+            {
+                if (c == '"' || c == '\\' || c == '/')
+                {
+                    codepointToRecord = c;
+                }
+                else if (c == 'b')
+                {
+                    codepointToRecord = BACKSPACE_CODEPOINT;
+                }
+                else if (c == 't')
+                {
+                    codepointToRecord = TAB_CODEPOINT;
+                }
+                else if (c == 'n')
+                {
+                    codepointToRecord = LINE_FEED_CODEPOINT;
+                }
+                else if (c == 'f')
+                {
+                    codepointToRecord = FORM_FEED_CODEPOINT;
+                }
+                else if (c == 'r')
+                {
+                    codepointToRecord = CARRIAGE_RETURN_CODEPOINT;
+                }
+                else
+                {
+                    /* The current codepoint location is the first character after
+                       the backslash that started the escape sequence. The error
+                       location should be the beginning of the escape sequence, 1
+                       character earlier. */
+                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_InvalidEscapeSequence, 1);
+                    return JSON_Failure;
+                }
+                parser->lexerState = LEXING_STRING;
+                goto recordStringCodepointAndAdvance;
+            }
+        }
+        goto advance;
+
+    case LEXING_STRING_HEX_ESCAPE_BYTE_1:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_2:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_3:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_4:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_5:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_6:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_7:
+    case LEXING_STRING_HEX_ESCAPE_BYTE_8:
+        if (c == EOF_CODEPOINT)
+        {
+            /* Allow JSON_Parser_FlushLexer() to fail. */
+        }
+        else
+        {
+            /* While lexing a string hex escape sequence we store the bytes
+               of the escaped codepoint in the low 2 bytes of lexerBits. If
+               the escape sequence represents a leading surrogate, we shift
+               the leading surrogate into the high 2 bytes and lex a second
+               hex escape sequence (which should be a trailing surrogate). */
+            int byteNumber = (parser->lexerState - LEXING_STRING_HEX_ESCAPE_BYTE_1) & 0x3;
+            uint32_t nibble;
+            if (c >= '0' && c <= '9')
+            {
+                nibble = c - '0';
+            }
+            else if (c >= 'A' && c <= 'F')
+            {
+                nibble = c - 'A' + 10;
+            }
+            else if (c >= 'a' && c <= 'f')
+            {
+                nibble = c - 'a' + 10;
+            }
+            else
+            {
+                /* The current codepoint location is one of the 4 hex digit
+                   character slots in the hex escape sequence. The error
+                   location should be the beginning of the hex escape
+                   sequence, between 2 and 5 bytes earlier. */
+                int codepointsAgo = 2 /* for "\u" */ + byteNumber;
+                JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_InvalidEscapeSequence, codepointsAgo);
+                return JSON_Failure;
+            }
+            /* Store the hex digit's bits in the appropriate byte of lexerBits. */
+            nibble <<= (3 - byteNumber) * 4 /* shift left by 12, 8, 4, 0 */ ;
+            parser->lexerBits |= nibble;
+            if (parser->lexerState == LEXING_STRING_HEX_ESCAPE_BYTE_4)
+            {
+                /* The escape sequence is complete. We need to check whether
+                   it represents a leading surrogate (which implies that it
+                   will be immediately followed by a hex-escaped trailing
+                   surrogate), a trailing surrogate (which is invalid), or a
+                   valid codepoint (which should simply be appended to the
+                   string token value). */
+                if (IS_LEADING_SURROGATE(parser->lexerBits))
+                {
+                    /* Shift the leading surrogate into the high 2 bytes of
+                       lexerBits so that the trailing surrogate can be stored
+                       in the low 2 bytes. */
+                    parser->lexerBits <<= 16;
+                    parser->lexerState = LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_BACKSLASH;
+                }
+                else if (IS_TRAILING_SURROGATE(parser->lexerBits))
+                {
+                    /* The current codepoint location is the last hex digit
+                       of the hex escape sequence. The error location should
+                       be the beginning of the hex escape sequence, 5
+                       characters earlier. */
+                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 5);
+                    return JSON_Failure;
+                }
+                else
+                {
+                    /* The escape sequence represents a BMP codepoint. */
+                    codepointToRecord = parser->lexerBits;
+                    parser->lexerBits = 0;
+                    parser->lexerState = LEXING_STRING;
+                    goto recordStringCodepointAndAdvance;
+                }
+            }
+            else if (parser->lexerState == LEXING_STRING_HEX_ESCAPE_BYTE_8)
+            {
+                /* The second hex escape sequence is complete. We need to
+                   check whether it represents a trailing surrogate as
+                   expected. If so, the surrogate pair represents a single
+                   non-BMP codepoint. */
+                if (!IS_TRAILING_SURROGATE(parser->lexerBits & 0xFFFF))
+                {
+                    /* The current codepoint location is the last hex digit of
+                       the second hex escape sequence. The error location
+                       should be the beginning of the leading surrogate
+                       hex escape sequence, 11 characters earlier. */
+                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 11);
+                    return JSON_Failure;
+                }
+                /* The escape sequence represents a non-BMP codepoint. */
+                codepointToRecord = CODEPOINT_FROM_SURROGATES(parser->lexerBits);
+                parser->lexerBits = 0;
+                parser->lexerState = LEXING_STRING;
+                goto recordStringCodepointAndAdvance;
+            }
+            else
+            {
+                parser->lexerState++;
+            }
+        }
+        goto advance;
+
+    case LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_BACKSLASH:
+        if (c == EOF_CODEPOINT)
+        {
+            /* Allow JSON_Parser_FlushLexer() to fail. */
+        }
+        else
+        {
+            if (c != '\\')
+            {
+                /* The current codepoint location is the first character after
+                   the leading surrogate hex escape sequence. The error
+                   location should be the beginning of the leading surrogate
+                   hex escape sequence, 6 characters earlier. */
+                JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 6);
+                return JSON_Failure;
+            }
+            parser->lexerState = LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_U;
+        }
+        goto advance;
+
+    case LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_U:
+        if (c == EOF_CODEPOINT)
+        {
+            /* Allow JSON_Parser_FlushLexer() to fail. */
+        }
+        else
+        {
+            if (c != 'u')
+            {
+                /* Distinguish between a totally bogus escape sequence
+                   and a valid one that just isn't the hex escape kind
+                   that we require for a trailing surrogate. The current
+                   codepoint location is the first character after the
+                   backslash that should have introduced the trailing
+                   surrogate hex escape sequence. */
+                if (c == '"' || c == '\\' || c == '/' || c == 'b' ||
+                    c == 't' || c == 'n' || c == 'f' || c == 'r')
+                {
+                    /* The error location should be at that beginning of the
+                       leading surrogate's hex escape sequence, 7 characters
+                       earlier. */
+                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 7);
+                }
+                else
+                {
+                    /* The error location should be at that backslash, 1
+                       character earlier. */
+                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_InvalidEscapeSequence, 1);
+                }
+                return JSON_Failure;
+            }
+            parser->lexerState = LEXING_STRING_HEX_ESCAPE_BYTE_5;
+        }
+        goto advance;
+
+    case LEXING_SKIPPING_CONTAINER:
+    case LEXING_SKIPPING_STRING:
+    case LEXING_SKIPPING_STRING_ESCAPE:
+    case LEXING_SKIPPING_COMMENT_AFTER_SLASH:
+    case LEXING_SKIPPING_SINGLE_LINE_COMMENT:
+    case LEXING_SKIPPING_MULTI_LINE_COMMENT:
+    case LEXING_SKIPPING_MULTI_LINE_COMMENT_AFTER_STAR:
+        if (c == EOF_CODEPOINT)
+        {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_ExpectedMoreTokens);
+            return JSON_Failure;
+        }
+        if (c == CARRIAGE_RETURN_CODEPOINT || c == LINE_FEED_CODEPOINT)
+        {
+            JSON_Parser_BreakLine(parser, c, encodedLength);
+        }
+        if (JSON_Parser_SkipCodepoint(parser, c))
+        {
+            /* Let the grammarian see the bracket that ends the skipped
+               container, so that a mismatched bracket is still rejected. */
+            JSON_Parser_StartToken(parser, (c == '}') ? T_RIGHT_CURLY : T_RIGHT_SQUARE);
+            parser->lexerState = LEXING_WHITESPACE;
+            tokenFinished = 1;
+        }
+        goto advance;
+    }
+
+recordStringCodepointAndAdvance:
+
+    if (parser->pInputTokenBytes && !JSON_Parser_CopyInputTokenBytes(parser))
+    {
+        return JSON_Failure;
+    }
+    tokenEncoding = parser->stringEncoding;
+    maxTokenLength = parser->maxStringLength;
+    if (!codepointToRecord)
+    {
+        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNullCharacter | JSON_ContainsControlCharacter);
+    }
+    else if (codepointToRecord < FIRST_NON_CONTROL_CODEPOINT)
+    {
+        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsControlCharacter);
+    }
+    else if (codepointToRecord >= FIRST_NON_BMP_CODEPOINT)
+    {
+        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNonASCIICharacter | JSON_ContainsNonBMPCharacter);
+    }
+    else if (codepointToRecord >= FIRST_NON_ASCII_CODEPOINT)
+    {
+        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNonASCIICharacter);
+    }
+    goto recordCodepointAndAdvance;
+
+recordNumberCodepointAndAdvance:
+
+    /* Accumulate the number's digits as they are lexed, so that the number
+       can be converted to a native type when it is finished. */
+    switch (parser->lexerState)
+    {
+    case LEXING_NUMBER_DECIMAL_DIGITS:
+        Number_AddDigit(&parser->numberData, 10, codepointToRecord - '0', 0/* isFractional */);
+        break;
+
+    case LEXING_NUMBER_FRACTIONAL_DIGITS:
+        Number_AddDigit(&parser->numberData, 10, codepointToRecord - '0', 1/* isFractional */);
+        break;
+
+    case LEXING_NUMBER_HEX_DIGITS:
+        Number_AddDigit(&parser->numberData, 16, (codepointToRecord <= '9') ? codepointToRecord - '0' : (codepointToRecord | 0x20) - 'a' + 10, 0/* isFractional */);
+        break;
+
+    case LEXING_NUMBER_EXPONENT_DIGITS:
+        Number_AddExponentDigit(&parser->numberData, codepointToRecord - '0');
+        break;
+    }
+    tokenEncoding = parser->numberEncoding;
+    maxTokenLength = parser->maxNumberLength;
+    goto recordCodepointAndAdvance;
+
+recordCodepointAndAdvance:
+
+    /* We always ensure that there are LONGEST_ENCODING_SEQUENCE bytes
+       available in the buffer for the next codepoint, so we don't have to
+       check whether there is room when we decode a new codepoint, and if
+       there isn't another codepoint, we have space already allocated for
+       the encoded null terminator.*/
+    parser->tokenBytesUsed += EncodeCodepoint(codepointToRecord, tokenEncoding, parser->pTokenBytes + parser->tokenBytesUsed);
+    if (parser->tokenBytesUsed > maxTokenLength)
+    {
+        JSON_Parser_SetErrorAtToken(parser, parser->token == T_NUMBER ? JSON_Error_TooLongNumber : JSON_Error_TooLongString);
+        return JSON_Failure;
+    }
+    if (parser->tokenBytesUsed > parser->tokenBytesLength - LONGEST_ENCODING_SEQUENCE)
+    {
+        byte* pBiggerBuffer = DoubleBuffer(&parser->memorySuite, parser->defaultTokenBytes, parser->pTokenBytes, parser->tokenBytesLength);
+        if (!pBiggerBuffer)
+        {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+            return JSON_Failure;
+        }
+        parser->pTokenBytes = pBiggerBuffer;
+        parser->tokenBytesLength *= 2;
+    }
+    goto advance;
+
+advance:
+
+    /* The current codepoint has been accepted, so advance the codepoint
+       location. Note that the EOF codepoint, which doesn't actually appear
+       in the input stream, has an encoded length of 0. */
+    parser->codepointLocationByte += encodedLength;
+
+    if (tokenFinished && !JSON_Parser_ProcessToken(parser))
+    {
+        return JSON_Failure;
+    }
+
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_FlushLexer(JSON_Parser parser)
+{
+    /* Push the EOF codepoint to the lexer so that it can finish the pending
+       token, if any. The EOF codepoint is never emitted by the decoder
+       itself, since it is outside the Unicode range and therefore cannot
+       be encoded in any of the possible input encodings. */
+    if (!JSON_Parser_ProcessCodepoint(parser, EOF_CODEPOINT, 0))
+    {
+        return JSON_Failure;
+    }
+
+    /* The lexer should be idle when parsing finishes. */
+    if (parser->lexerState != LEXING_WHITESPACE)
+    {
+        JSON_Parser_SetErrorAtToken(parser, JSON_Error_IncompleteToken);
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+/* Parser's decoder functions. */
+
+static JSON_Status JSON_Parser_CallEncodingDetectedHandler(JSON_Parser parser)
+{
+    if (parser->encodingDetectedHandler && parser->encodingDetectedHandler(parser) != JSON_Parser_Continue)
+    {
+        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_AbortedByHandler);
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+/* Forward declaration. */
+static JSON_Status JSON_Parser_ProcessInputBytes(JSON_Parser parser, const byte* pBytes, size_t length, size_t* pProcessedLength);
+
+static void JSON_Parser_SetReplayBytes(JSON_Parser parser, const byte* pBytes, size_t length)
+{
+    /* A parser that is used to pull events cannot process the bytes that
+       were used to detect the input encoding all at once, since it must be
+       able to stop after any event, so it saves them to be processed
+       before any more input. */
+    memcpy(parser->replayBytes, pBytes, length);
+    parser->replayLength = length;
+    parser->replayUsed = 0;
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_SUSPENDED);
+}
+
+static JSON_Status JSON_Parser_ProcessUnknownByte(JSON_Parser parser, byte b)
+{
+    /* When the input encoding is unknown, the first 4 bytes of input are
+       recorded in decoder.bits. */
+
+    byte bytes[LONGEST_ENCODING_SEQUENCE];
+    switch (parser->decoderData.state)
+    {
+    case DECODER_RESET:
+        parser->decoderData.state = DECODED_1_OF_4;
+        parser->decoderData.bits = (uint32_t)b << 24;
+        break;
+
+    case DECODED_1_OF_4:
+        parser->decoderData.state = DECODED_2_OF_4;
+        parser->decoderData.bits |= (uint32_t)b << 16;
+        break;
+
+    case DECODED_2_OF_4:
+        parser->decoderData.state = DECODED_3_OF_4;
+        parser->decoderData.bits |= (uint32_t)b << 8;
+        break;
+
+    case DECODED_3_OF_4:
+        bytes[0] = (byte)(parser->decoderData.bits >> 24);
+        bytes[1] = (byte)(parser->decoderData.bits >> 16);
+        bytes[2] = (byte)(parser->decoderData.bits >> 8);
+        bytes[3] = (byte)(b);
+
+        /* We try to match the following patterns in order, where .. is any
+           byte value and nz is any non-zero byte value:
+              EF BB BF .. => UTF-8 with BOM
+              FF FE 00 00 => UTF-32LE with BOM
+              FF FE nz 00 => UTF-16LE with BOM
+              00 00 FE FF -> UTF-32BE with BOM
+              FE FF .. .. => UTF-16BE with BOM
+              nz nz .. .. => UTF-8
+              nz 00 nz .. => UTF-16LE
+              nz 00 00 00 => UTF-32LE
+              00 nz .. .. => UTF-16BE
+              00 00 00 nz => UTF-32BE
+              .. .. .. .. => unknown encoding */
+        if (bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
+        {
+            /* EF BB BF .. */
+            parser->inputEncoding = JSON_UTF8;
+        }
+        else if (bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[3] == 0x00)
+        {
+            /* FF FE 00 00 or
+               FF FE nz 00 */
+            parser->inputEncoding = (bytes[2] == 0x00) ? JSON_UTF32LE : JSON_UTF16LE;
+        }
+        else if (bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF)
+        {
+            /* 00 00 FE FF */
+            parser->inputEncoding = JSON_UTF32BE;
+        }
+        else if (bytes[0] == 0xFE && bytes[1] == 0xFF)
+        {
+            /* FE FF .. .. */
+            parser->inputEncoding = JSON_UTF16BE;
+        }
+        else if (bytes[0] != 0x00)
+        {
+            /* nz .. .. .. */
+            if (bytes[1] != 0x00)
+            {
+                /* nz nz .. .. */
+                parser->inputEncoding = JSON_UTF8;
+            }
+            else if (bytes[2] != 0x00)
+            {
+                /* nz 00 nz .. */
+                parser->inputEncoding = JSON_UTF16LE;
+            }
+            else if (bytes[3] == 0x00)
+            {
+                /* nz 00 00 00 */
+                parser->inputEncoding = JSON_UTF32LE;
+            }
+            else
+            {
+                /* nz 00 00 nz => error */
+            }
+        }
+        else if (bytes[1] != 0x00)
+        {
+            /* 00 nz .. .. */
+            parser->inputEncoding = JSON_UTF16BE;
+        }
+        else if (bytes[2] == 0x00 && bytes[3] != 0x00)
+        {
+            /* 00 00 00 nz */
+            parser->inputEncoding = JSON_UTF32BE;
+        }
+        else
+        {
+            /* 00 00 nz .. or
+               00 00 00 00 => error */
+        }
+
+        if (parser->inputEncoding == JSON_UnknownEncoding)
+        {
+            return JSON_Parser_HandleInvalidEncodingSequence(parser, 4);
+        }
+
+        if (!JSON_Parser_CallEncodingDetectedHandler(parser))
+        {
+            return JSON_Failure;
+        }
+
+        /* Reset the decoder before reprocessing the bytes. Note that a
+           pending string cannot continue to refer to the bytes, since they
+           are about to go out of scope. */
+        Decoder_Reset(&parser->decoderData);
+        if (GET_FLAGS(parser->state, PARSER_PULLING))
+        {
+            JSON_Parser_SetReplayBytes(parser, bytes, 4);
+        }
+        else if (!JSON_Parser_ProcessInputBytes(parser, bytes, 4, NULL) ||
+                 (parser->pInputTokenBytes && !JSON_Parser_CopyInputTokenBytes(parser)))
+        {
+            return JSON_Failure;
+        }
+        return JSON_Success;
+    }
+
+    /* We don't have 4 bytes yet. */
+    return JSON_Success;
+}
+
+/* The bulk-scanning fast paths examine the input a machine word at a time
+   (SWAR, or "SIMD within a register"). Words are loaded with memcpy() so
+   that the loads are portable regardless of alignment, and the tests below
+   only ask whether ANY byte of a word is interesting; the exact position of
+   the interesting byte is then found by examining the word byte-by-byte,
+   which keeps the results independent of the platform's byte order. */
+typedef size_t ScanWord;
+#define SCAN_WORD_SIZE              sizeof(ScanWord)
+#define SCAN_WORD_REPEAT(b)         (((ScanWord)-1 / 0xFF) * (ScanWord)(b))
+#define SCAN_WORD_HIGH_BITS         SCAN_WORD_REPEAT(0x80)
+#define SCAN_WORD_HAS_LESS(w, n)    (((w) - SCAN_WORD_REPEAT(n)) & ~(w) & SCAN_WORD_HIGH_BITS) /* n <= 0x80 */
+#define SCAN_WORD_HAS_BYTE(w, b)    SCAN_WORD_HAS_LESS((w) ^ SCAN_WORD_REPEAT(b), 1)
+
+/* Unlike SCAN_WORD_HAS_LESS(), which can flag bytes that follow a matching
+   byte because of borrows, this sets the high bit of exactly those bytes of
+   the word that are zero. */
+#define SCAN_WORD_ZERO_BYTES(w)     (~((((w) & ~SCAN_WORD_HIGH_BITS) + ~SCAN_WORD_HIGH_BITS) | (w)) & SCAN_WORD_HIGH_BITS)
+#define SCAN_WORD_MATCH_BYTES(w, b) SCAN_WORD_ZERO_BYTES((w) ^ SCAN_WORD_REPEAT(b))
+
+/* A plain string byte is a printable ASCII character other than quotation
+   mark and reverse solidus. In UTF-8, each plain string byte is a complete
+   encoding sequence that is recorded verbatim, does not affect the token
+   attributes, and does not start a new line. */
+#define IS_PLAIN_STRING_BYTE(b)     ((b) >= 0x20 && (b) < 0x80 && (b) != '"' && (b) != '\\')
+
+/* A structural byte is a UTF-8 structural character. */
+#define IS_STRUCTURAL_BYTE(b)       ((b) == '{' || (b) == '}' || (b) == '[' || (b) == ']' || (b) == ':' || (b) == ',')
+
+/* Returns the length of the well-formed UTF-8 encoding sequence that begins
+   with a non-ASCII byte at pBytes, or 0 if the sequence is invalid or is not
+   entirely contained in the length bytes available. The ranges of valid
+   second bytes exclude exactly the overlong encodings, the surrogates, and
+   the codepoints above U+10FFFF that Decoder_ProcessByte() rejects. */
+static size_t GetValidUTF8SequenceLength(const byte* pBytes, size_t length)
+{
+    byte b = pBytes[0];
+    byte min = 0x80;
+    byte max = 0xBF;
+    if (b >= 0xC2 && b <= 0xDF)
+    {
+        return (length >= 2 && IS_UTF8_CONTINUATION_BYTE(pBytes[1])) ? 2 : 0;
+    }
+    if (b >= 0xE0 && b <= 0xEF)
+    {
+        if (b == 0xE0)
+        {
+            min = 0xA0;
+        }
+        else if (b == 0xED)
+        {
+            max = 0x9F;
+        }
+        return (length >= 3 && pBytes[1] >= min && pBytes[1] <= max &&
+                IS_UTF8_CONTINUATION_BYTE(pBytes[2])) ? 3 : 0;
+    }
+    if (b >= 0xF0 && b <= 0xF4)
+    {
+        if (b == 0xF0)
+        {
+            min = 0x90;
+        }
+        else if (b == 0xF4)
+        {
+            max = 0x8F;
+        }
+        return (length >= 4 && pBytes[1] >= min && pBytes[1] <= max &&
+                IS_UTF8_CONTINUATION_BYTE(pBytes[2]) &&
+                IS_UTF8_CONTINUATION_BYTE(pBytes[3])) ? 4 : 0;
+    }
+    return 0;
+}
+
+/* Returns the number of leading bytes that consist entirely of plain string
+   bytes and well-formed non-ASCII UTF-8 encoding sequences, and reports the
+   number of codepoints they encode and the token attributes they imply. The
+   scan stops before anything that needs the attention of the lexer or the
+   decoder: a quotation mark, reverse solidus, control character, invalid
+   encoding sequence, or sequence that is truncated by the end of the bytes. */
+static size_t ScanStringBytes(const byte* pBytes, size_t length, size_t* pCodepoints, TokenAttributes* pAttributes)
+{
+    size_t i = 0;
+    size_t codepoints = 0;
+    TokenAttributes attributes = 0;
+    while (i < length)
+    {
+        byte b;
+        size_t sequenceLength;
+        if (length - i >= SCAN_WORD_SIZE)
+        {
+            ScanWord w;
+            memcpy(&w, pBytes + i, SCAN_WORD_SIZE);
+            if (!((w & SCAN_WORD_HIGH_BITS) |
+                  SCAN_WORD_HAS_LESS(w, 0x20) |
+                  SCAN_WORD_HAS_BYTE(w, '"') |
+                  SCAN_WORD_HAS_BYTE(w, '\\')))
+            {
+                i += SCAN_WORD_SIZE;
+                codepoints += SCAN_WORD_SIZE;
+                continue;
+            }
+        }
+        b = pBytes[i];
+        if (IS_UTF8_SINGLE_BYTE(b))
+        {
+            if (!IS_PLAIN_STRING_BYTE(b))
+            {
+                break;
+            }
+            sequenceLength = 1;
+        }
+        else
+        {
+            sequenceLength = GetValidUTF8SequenceLength(pBytes + i, length - i);
+            if (!sequenceLength)
+            {
+                break;
+            }
+            attributes |= (sequenceLength == 4)
+                ? (JSON_ContainsNonASCIICharacter | JSON_ContainsNonBMPCharacter)
+                : JSON_ContainsNonASCIICharacter;
+        }
+        i += sequenceLength;
+        codepoints++;
+    }
+    *pCodepoints = codepoints;
+    *pAttributes = attributes;
+    return i;
+}
+
+static JSON_Status JSON_Parser_ProcessStringBytes(JSON_Parser parser, const byte* pBytes, size_t length, size_t codepoints, TokenAttributes attributes)
+{
+    /* This is equivalent to passing each codepoint to
+       JSON_Parser_ProcessCodepoint() individually, but copies the bytes into
+       the token buffer in bulk. The caller is responsible for ensuring that
+       the bytes were accepted by ScanStringBytes(), that the input and
+       string encodings are both UTF-8, and that the bytes do not exceed the
+       maximum string length. The only observable difference is that if the
+       buffer cannot be grown, the error is reported at the first codepoint
+       of the bytes rather than at the codepoint that did not fit. */
+    SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, attributes);
+    if (GET_FLAGS(parser->flags, PARSER_ZERO_COPY_STRINGS))
+    {
+        /* If the bytes are the first bytes of the string, or immediately
+           follow the string's other bytes in the input, we defer copying
+           them, in the hope that the string ends before the input does. */
+        if (!parser->tokenBytesUsed)
+        {
+            parser->pInputTokenBytes = pBytes;
+        }
+        if (parser->pInputTokenBytes && parser->pInputTokenBytes + parser->tokenBytesUsed == pBytes)
+        {
+            parser->tokenBytesUsed += length;
+            parser->codepointLocationByte += length;
+            parser->lineExtraBytes += length - codepoints;
+            return JSON_Success;
+        }
+        if (parser->pInputTokenBytes && !JSON_Parser_CopyInputTokenBytes(parser))
+        {
+            return JSON_Failure;
+        }
+    }
+
+    /* Keep LONGEST_ENCODING_SEQUENCE bytes available after the copy, as
+       recording the codepoints individually would have. */
+    while (parser->tokenBytesUsed + length > parser->tokenBytesLength - LONGEST_ENCODING_SEQUENCE)
+    {
+        byte* pBiggerBuffer = DoubleBuffer(&parser->memorySuite, parser->defaultTokenBytes, parser->pTokenBytes, parser->tokenBytesLength);
+        if (!pBiggerBuffer)
+        {
+            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+            return JSON_Failure;
+        }
+        parser->pTokenBytes = pBiggerBuffer;
+        parser->tokenBytesLength *= 2;
+    }
+    memcpy(parser->pTokenBytes + parser->tokenBytesUsed, pBytes, length);
+    parser->tokenBytesUsed += length;
+    parser->codepointLocationByte += length;
+    parser->lineExtraBytes += length - codepoints;
+    return JSON_Success;
+}
+
+static Codepoint ReadCodeUnit(const byte* pBytes, Encoding encoding)
+{
+    /* Read a single UTF-16 or UTF-32 code unit, which might not be a valid
+       codepoint by itself. */
+    switch (encoding)
+    {
+    case JSON_UTF16LE:
+        return ((Codepoint)pBytes[1] << 8) | pBytes[0];
+    case JSON_UTF16BE:
+        return ((Codepoint)pBytes[0] << 8) | pBytes[1];
+    case JSON_UTF32LE:
+        return ((Codepoint)pBytes[3] << 24) | ((Codepoint)pBytes[2] << 16) | ((Codepoint)pBytes[1] << 8) | pBytes[0];
+    default: /* JSON_UTF32BE */
+        return ((Codepoint)pBytes[0] << 24) | ((Codepoint)pBytes[1] << 16) | ((Codepoint)pBytes[2] << 8) | pBytes[3];
+    }
+}
+
+static JSON_Status JSON_Parser_TranscodeStringBytes(JSON_Parser parser, const byte* pBytes, size_t length, size_t* pProcessedLength)
+{
+    /* This is equivalent to passing each codepoint of a run of string
+       characters to JSON_Parser_ProcessCodepoint() individually, for input
+       and string encodings that are not both UTF-8. The codepoints are
+       decoded and re-encoded directly into the token buffer rather than
+       one byte at a time by the decoder, and runs of ASCII characters in
+       UTF-16 or UTF-32 input are narrowed to UTF-8 a word at a time. The
+       caller is responsible for ensuring that the lexer is in a string and
+       that the decoder is reset. The run ends before anything that needs
+       the attention of the lexer or the decoder, just as it does in
+       ScanStringBytes(), and before a codepoint that would make the string
+       too long, so that the error is reported normally. */
+    Encoding inputEncoding = (Encoding)parser->inputEncoding;
+    Encoding stringEncoding = (Encoding)parser->stringEncoding;
+    size_t unitLength = SHORTEST_ENCODING_SEQUENCE(inputEncoding);
+    size_t lowByteOffset = (inputEncoding == JSON_UTF16BE || inputEncoding == JSON_UTF32BE) ? unitLength - 1 : 0;
+    size_t used = parser->tokenBytesUsed;
+    size_t extraBytes = 0;
+    size_t i = 0;
+    TokenAttributes attributes = 0;
+    int outOfMemory = 0;
+    ScanWord asciiMask = 0;
+    ScanWord asciiFill = 0;
+    if (unitLength > 1 && stringEncoding == JSON_UTF8)
+    {
+        /* A word of ASCII code units has a zero in every byte but the low
+           byte of each unit. The masks are built in memory so that they
+           match the words regardless of the platform's byte order. */
+        byte maskBytes[sizeof(ScanWord)];
+        size_t j;
+        for (j = 0; j < SCAN_WORD_SIZE; j++)
+        {
+            maskBytes[j] = (byte)((j % unitLength == lowByteOffset) ? 0x00 : 0x80);
+        }
+        memcpy(&asciiMask, maskBytes, SCAN_WORD_SIZE);
+        asciiFill = (asciiMask >> 7) * (ScanWord)'A';
+    }
+    while (i < length)
+    {
+        Codepoint c;
+        size_t sequenceLength;
+        size_t encodedLength;
+        if (asciiMask && length - i >= SCAN_WORD_SIZE &&
+            used + SCAN_WORD_SIZE / unitLength <= parser->maxStringLength &&
+            used + SCAN_WORD_SIZE / unitLength <= parser->tokenBytesLength - LONGEST_ENCODING_SEQUENCE)
+        {
+            ScanWord w;
+            memcpy(&w, pBytes + i, SCAN_WORD_SIZE);
+            if ((SCAN_WORD_ZERO_BYTES(w) & asciiMask) == asciiMask)
+            {
+                w |= asciiFill;
+                if (!((w & SCAN_WORD_HIGH_BITS) |
+                      SCAN_WORD_HAS_LESS(w, 0x20) |
+                      SCAN_WORD_HAS_BYTE(w, '"') |
+                      SCAN_WORD_HAS_BYTE(w, '\\')))
+                {
+                    size_t j;
+                    for (j = lowByteOffset; j < SCAN_WORD_SIZE; j += unitLength)
+                    {
+                        parser->pTokenBytes[used++] = pBytes[i + j];
+                    }
+                    i += SCAN_WORD_SIZE;
+                    continue;
+                }
+            }
+        }
+        if (length - i < unitLength)
+        {
+            break;
+        }
+        switch (inputEncoding)
+        {
+        case JSON_UTF8:
+            c = pBytes[i];
+            sequenceLength = IS_UTF8_SINGLE_BYTE(c) ? 1 : GetValidUTF8SequenceLength(pBytes + i, length - i);
+            switch (sequenceLength)
+            {
+            case 2:
+                c = ((c & 0x1F) << 6) | BOTTOM_6_BITS(pBytes[i + 1]);
+                break;
+            case 3:
+                c = ((c & 0x0F) << 12) | (BOTTOM_6_BITS(pBytes[i + 1]) << 6) | BOTTOM_6_BITS(pBytes[i + 2]);
+                break;
+            case 4:
+                c = ((c & 0x07) << 18) | (BOTTOM_6_BITS(pBytes[i + 1]) << 12) | (BOTTOM_6_BITS(pBytes[i + 2]) << 6) | BOTTOM_6_BITS(pBytes[i + 3]);
+                break;
+            }
+            break;
+
+        case JSON_UTF16LE:
+        case JSON_UTF16BE:
+            c = ReadCodeUnit(pBytes + i, inputEncoding);
+            sequenceLength = 2;
+            if (IS_SURROGATE(c))
+            {
+                Codepoint trailing;
+                if (!IS_LEADING_SURROGATE(c) || length - i < 4)
+                {
+                    sequenceLength = 0;
+                    break;
+                }
+                trailing = ReadCodeUnit(pBytes + i + 2, inputEncoding);
+                if (!IS_TRAILING_SURROGATE(trailing))
+                {
+                    sequenceLength = 0;
+                    break;
+                }
+                c = CODEPOINT_FROM_SURROGATES((c << 16) | trailing);
+                sequenceLength = 4;
+            }
+            break;
+
+        default: /* JSON_UTF32LE or JSON_UTF32BE */
+            c = ReadCodeUnit(pBytes + i, inputEncoding);
+            sequenceLength = (IS_SURROGATE(c) || c > MAX_CODEPOINT) ? 0 : 4;
+            break;
+        }
+        if (!sequenceLength || c < FIRST_NON_CONTROL_CODEPOINT || c == '"' || c == '\\')
+        {
+            break;
+        }
+
+        /* There are always LONGEST_ENCODING_SEQUENCE bytes available in the
+           token buffer, as in JSON_Parser_ProcessCodepoint(). */
+        encodedLength = EncodeCodepoint(c, stringEncoding, parser->pTokenBytes + used);
+        if (used + encodedLength > parser->maxStringLength)
+        {
+            break;
+        }
+        if (c >= FIRST_NON_ASCII_CODEPOINT)
+        {
+            attributes |= (c >= FIRST_NON_BMP_CODEPOINT)
+                ? (JSON_ContainsNonASCIICharacter | JSON_ContainsNonBMPCharacter)
+                : JSON_ContainsNonASCIICharacter;
+        }
+        used += encodedLength;
+        i += sequenceLength;
+        extraBytes += sequenceLength - unitLength;
+        if (used > parser->tokenBytesLength - LONGEST_ENCODING_SEQUENCE)
+        {
+            byte* pBiggerBuffer = DoubleBuffer(&parser->memorySuite, parser->defaultTokenBytes, parser->pTokenBytes, parser->tokenBytesLength);
+            if (!pBiggerBuffer)
+            {
+                /* Report the error at the codepoint that did not fit. */
+                i -= sequenceLength;
+                extraBytes -= sequenceLength - unitLength;
+                used -= encodedLength;
+                outOfMemory = 1;
+                break;
+            }
+            parser->pTokenBytes = pBiggerBuffer;
+            parser->tokenBytesLength *= 2;
+        }
+    }
+    SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, attributes);
+    parser->tokenBytesUsed = used;
+    parser->codepointLocationByte += i;
+    parser->lineExtraBytes += extraBytes;
+    *pProcessedLength = i;
+    if (outOfMemory)
+    {
+        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+static size_t JSON_Parser_SkipWhitespaceBytes(JSON_Parser parser, const byte* pBytes, size_t length)
+{
+    /* This is equivalent to passing each UTF-8 whitespace byte to
+       JSON_Parser_ProcessCodepoint() individually while the lexer is between
+       tokens, and returns the number of bytes skipped. Runs of spaces and
+       tabs, such as indentation, are skipped a word at a time. */
+    size_t i = 0;
+    while (i < length)
+    {
+        byte b;
+        if (length - i >= SCAN_WORD_SIZE)
+        {
+            ScanWord w;
+            memcpy(&w, pBytes + i, SCAN_WORD_SIZE);
+            if ((SCAN_WORD_MATCH_BYTES(w, ' ') | SCAN_WORD_MATCH_BYTES(w, TAB_CODEPOINT)) == SCAN_WORD_HIGH_BITS)
+            {
+                parser->codepointLocationByte += SCAN_WORD_SIZE;
+                i += SCAN_WORD_SIZE;
+                continue;
+            }
+        }
+        b = pBytes[i];
+        if (b == LINE_FEED_CODEPOINT || b == CARRIAGE_RETURN_CODEPOINT)
+        {
+            JSON_Parser_BreakLine(parser, b, 1);
+        }
+        else if (b != ' ' && b != TAB_CODEPOINT)
+        {
+            break;
+        }
+        parser->codepointLocationByte++;
+        i++;
+    }
+    return i;
+}
+
+static size_t JSON_Parser_MatchLiteralBytes(JSON_Parser parser, const byte* pBytes, size_t length, Symbol* pToken)
+{
+    /* This returns the length of the UTF-8 literal at the start of pBytes,
+       or 0 if pBytes does not start with a complete literal followed by the
+       codepoint that ends it, in which case the literal must be lexed one
+       codepoint at a time. Each literal is compared with a fixed-length
+       memcmp(), which compilers reduce to a single word compare. */
+    size_t literalLength;
+    byte b;
+    switch (pBytes[0])
+    {
+    case 'n':
+        if (length <= 4 || memcmp(pBytes, "null", 4))
+        {
+            return 0;
+        }
+        *pToken = T_NULL;
+        literalLength = 4;
+        break;
+
+    case 't':
+        if (length <= 4 || memcmp(pBytes, "true", 4))
+        {
+            return 0;
+        }
+        *pToken = T_TRUE;
+        literalLength = 4;
+        break;
+
+    case 'f':
+        if (length <= 5 || memcmp(pBytes + 1, "alse", 4))
+        {
+            return 0;
+        }
+        *pToken = T_FALSE;
+        literalLength = 5;
+        break;
+
+    case 'N':
+        if (!GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS) || length <= 3 || memcmp(pBytes + 1, "aN", 2))
+        {
+            return 0;
+        }
+        *pToken = T_NAN;
+        literalLength = 3;
+        break;
+
+    case 'I':
+        if (!GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS) || length <= 8 || memcmp(pBytes, "Infinity", 8))
+        {
+            return 0;
+        }
+        *pToken = T_INFINITY;
+        literalLength = 8;
+        break;
+
+    default:
+        return 0;
+    }
+
+    /* As in JSON_Parser_ProcessCodepoint(), a literal followed by a
+       plausible JSON literal character is an unknown token, so leave it
+       for the lexer to report. */
+    b = pBytes[literalLength];
+    if ((b >= 'A' && b <= 'Z') ||
+        (b >= 'a' && b <= 'z') ||
+        (b >= '0' && b <= '9') ||
+        (b == '_'))
+    {
+        return 0;
+    }
+    return literalLength;
+}
+
+static JSON_Status JSON_Parser_ProcessLiteralBytes(JSON_Parser parser, Symbol token, size_t literalLength)
+{
+    /* This is equivalent to passing each codepoint of a UTF-8 literal to
+       JSON_Parser_ProcessCodepoint() while the lexer is between tokens,
+       followed by the codepoint that ends the literal. */
+    JSON_Parser_StartToken(parser, token);
+    parser->codepointLocationByte += literalLength;
+    return JSON_Parser_ProcessToken(parser);
+}
+
+static size_t JSON_Parser_SkipContainerBytes(JSON_Parser parser, const byte* pBytes, size_t length)
+{
+    /* This is equivalent to passing each UTF-8 encoding sequence to
+       JSON_Parser_ProcessCodepoint() while a container is being skipped, up
+       to but not including the bracket that ends the skipped container or
+       an invalid encoding sequence, and returns the number of bytes
+       skipped. Only a few ASCII characters are significant while skipping,
+       so words that contain none of them are skipped whole, unless the
+       lexer is in a state that any codepoint would change. */
+    size_t i = 0;
+    while (i < length)
+    {
+        byte b;
+        if (length - i >= SCAN_WORD_SIZE &&
+            parser->lexerState != LEXING_SKIPPING_STRING_ESCAPE &&
+            parser->lexerState != LEXING_SKIPPING_COMMENT_AFTER_SLASH &&
+            parser->lexerState != LEXING_SKIPPING_MULTI_LINE_COMMENT_AFTER_STAR)
+        {
+            ScanWord w;
+            ScanWord folded;
+            memcpy(&w, pBytes + i, SCAN_WORD_SIZE);
+
+            /* Setting bit 0x20 of each byte folds '[', '\', and ']' onto
+               '{', '|', and '}', so that 3 tests cover 5 characters. */
+            folded = w | SCAN_WORD_REPEAT(0x20);
+            if (!((w & SCAN_WORD_HIGH_BITS) |
+                  SCAN_WORD_HAS_LESS(w, CARRIAGE_RETURN_CODEPOINT + 1) |
+                  SCAN_WORD_HAS_BYTE(w, '"') |
+                  SCAN_WORD_HAS_BYTE(w, '/') |
+                  SCAN_WORD_HAS_BYTE(w, '*') |
+                  SCAN_WORD_HAS_BYTE(folded, '{') |
+                  SCAN_WORD_HAS_BYTE(folded, '|') |
+                  SCAN_WORD_HAS_BYTE(folded, '}')))
+            {
+                parser->codepointLocationByte += SCAN_WORD_SIZE;
+                i += SCAN_WORD_SIZE;
+                continue;
+            }
+        }
+        b = pBytes[i];
+        if (IS_UTF8_SINGLE_BYTE(b))
+        {
+            if ((b == '}' || b == ']') && parser->skipDepth == 1 && parser->lexerState == LEXING_SKIPPING_CONTAINER)
+            {
+                break;
+            }
+            if (b == LINE_FEED_CODEPOINT || b == CARRIAGE_RETURN_CODEPOINT)
+            {
+                JSON_Parser_BreakLine(parser, b, 1);
+            }
+            JSON_Parser_SkipCodepoint(parser, b);
+            parser->codepointLocationByte++;
+            i++;
+        }
+        else
+        {
+            /* Non-ASCII codepoints are never significant, so the lead byte
+               can stand in for the codepoint. */
+            size_t sequenceLength = GetValidUTF8SequenceLength(pBytes + i, length - i);
+            if (!sequenceLength)
+            {
+                break;
+            }
+            JSON_Parser_SkipCodepoint(parser, b);
+            parser->codepointLocationByte += sequenceLength;
+            parser->lineExtraBytes += sequenceLength - 1;
+            i += sequenceLength;
+        }
+    }
+    return i;
+}
+
+static JSON_Status JSON_Parser_CallDocumentHandler(JSON_Parser parser, JSON_Parser_SimpleTokenHandler handler)
+{
+    /* Unlike JSON_Parser_CallSimpleTokenHandler(), this is used when there
+       is no token, so JSON_Parser_GetTokenLocation() fails in the handler. */
+    if (handler && handler(parser) != JSON_Parser_Continue)
+    {
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_SkipInvalidDocument(JSON_Parser parser)
+{
+    /* This is called after an error has been set, to abandon the current
+       document and skip the rest of the line on which the error occurred,
+       if the client has asked for that and the error is one that parsing
+       can recover from. The codepoint that caused the error may or may not
+       have been consumed; the caller is responsible for skipping it if it
+       was not. */
+    if (!GET_FLAGS(parser->flags, PARSER_SKIP_INVALID) ||
+        !GET_FLAGS(parser->flags, PARSER_MULTIPLE_DOCUMENTS) ||
+        !JSON_Parser_CallsDocumentHandlers(parser) ||
+        parser->error == JSON_Error_OutOfMemory ||
+        parser->error == JSON_Error_AbortedByHandler ||
+        parser->error == JSON_Error_StoppedAfterEmbeddedDocument)
+    {
+        return JSON_Failure;
+    }
+    /* An invalid encoding sequence at the end of a line that is already
+       being skipped does not belong to any document. */
+    if (!GET_FLAGS(parser->state, PARSER_SKIPPING_LINE) &&
+        ((!GET_FLAGS(parser->state, PARSER_IN_DOCUMENT) &&
+          !JSON_Parser_CallDocumentHandler(parser, parser->startDocumentHandler)) ||
+         !JSON_Parser_CallDocumentHandler(parser, parser->endDocumentHandler)))
+    {
+        parser->error = JSON_Error_AbortedByHandler;
+        parser->errorOffset = 0;
+        return JSON_Failure;
+    }
+
+    /* Discard everything that belongs to the abandoned document, but keep
+       the buffers that have been allocated. */
+    parser->error = JSON_Error_None;
+    parser->errorOffset = 0;
+    parser->token = T_NONE;
+    parser->tokenAttributes = 0;
+    parser->lexerState = LEXING_WHITESPACE;
+    parser->lexerBits = 0;
+    parser->pInputTokenBytes = NULL;
+    parser->tokenBytesUsed = 0;
+    parser->depth = 0;
+    parser->skipDepth = 0;
+    parser->pMemberNames = NULL;
+    Arena_Reset(&parser->arenaData, 1/*isInitialized*/);
+    parser->pathStackUsed = 0;
+    parser->pathNextCount = 0;
+    parser->pathMatchedDepth = 0;
+    parser->memberKeyIndex = 0;
+    Number_Reset(&parser->numberData);
+    Grammarian_Reset(&parser->grammarianData, 1/*isInitialized*/);
+    SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_DOCUMENT | PARSER_SKIPPING_VALUE | PARSER_NEXT_VALUE_MATCHES);
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_SKIPPING_LINE);
+    return JSON_Success;
+}
+
+static void JSON_Parser_SkipLineCodepoint(JSON_Parser parser, Codepoint c, size_t encodedLength)
+{
+    if (c == CARRIAGE_RETURN_CODEPOINT || c == LINE_FEED_CODEPOINT)
+    {
+        JSON_Parser_BreakLine(parser, c, encodedLength);
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_SKIPPING_LINE);
+    }
+    parser->codepointLocationByte += encodedLength;
+}
+
+static JSON_Status JSON_Parser_ProcessInputCodepoint(JSON_Parser parser, Codepoint c, size_t encodedLength)
+{
+    /* This wraps JSON_Parser_ProcessCodepoint() for codepoints of input,
+       so that the rest of a line can be skipped after an invalid document.
+       A codepoint that causes an error is consumed only if it finishes a
+       punctuation token, which cannot be a line break. */
+    size_t location = parser->codepointLocationByte;
+    if (GET_FLAGS(parser->state, PARSER_SKIPPING_LINE))
+    {
+        JSON_Parser_SkipLineCodepoint(parser, c, encodedLength);
+        return JSON_Success;
+    }
+    if (JSON_Parser_ProcessCodepoint(parser, c, encodedLength))
+    {
+        return JSON_Success;
+    }
+    if (!JSON_Parser_SkipInvalidDocument(parser))
+    {
+        return JSON_Failure;
+    }
+    if (parser->codepointLocationByte == location)
+    {
+        JSON_Parser_SkipLineCodepoint(parser, c, encodedLength);
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_ProcessInvalidInputSequence(JSON_Parser parser, size_t encodedLength)
+{
+    /* Likewise for JSON_Parser_HandleInvalidEncodingSequence(). */
+    size_t location = parser->codepointLocationByte;
+    if (!GET_FLAGS(parser->state, PARSER_SKIPPING_LINE))
+    {
+        if (JSON_Parser_HandleInvalidEncodingSequence(parser, encodedLength))
+        {
+            return JSON_Success;
+        }
+        if (!JSON_Parser_SkipInvalidDocument(parser))
+        {
+            return JSON_Failure;
+        }
+        if (parser->codepointLocationByte != location)
+        {
+            return JSON_Success;
+        }
+    }
+    parser->codepointLocationByte += encodedLength;
+    return JSON_Success;
+}
+
+static size_t JSON_Parser_SkipLineBytes(JSON_Parser parser, const byte* pBytes, size_t length)
+{
+    /* This is equivalent to passing each UTF-8 encoding sequence to
+       JSON_Parser_ProcessInputCodepoint() while the rest of a line is being
+       skipped, up to and including the line break that ends the line, and
+       returns the number of bytes skipped. It stops early only at an
+       invalid or incomplete encoding sequence, which it leaves for the
+       decoder. */
+    size_t i = 0;
+    while (i < length)
+    {
+        byte b;
+        if (length - i >= SCAN_WORD_SIZE)
+        {
+            ScanWord w;
+            memcpy(&w, pBytes + i, SCAN_WORD_SIZE);
+            if (!((w & SCAN_WORD_HIGH_BITS) | SCAN_WORD_HAS_LESS(w, CARRIAGE_RETURN_CODEPOINT + 1)))
+            {
+                parser->codepointLocationByte += SCAN_WORD_SIZE;
+                i += SCAN_WORD_SIZE;
+                continue;
+            }
+        }
+        b = pBytes[i];
+        if (IS_UTF8_SINGLE_BYTE(b))
+        {
+            JSON_Parser_SkipLineCodepoint(parser, b, 1);
+            i++;
+            if (!GET_FLAGS(parser->state, PARSER_SKIPPING_LINE))
+            {
+                break;
+            }
+        }
+        else
+        {
+            size_t sequenceLength = GetValidUTF8SequenceLength(pBytes + i, length - i);
+            if (!sequenceLength)
+            {
+                break;
+            }
+            parser->codepointLocationByte += sequenceLength;
+            parser->lineExtraBytes += sequenceLength - 1;
+            i += sequenceLength;
+        }
+    }
+    return i;
+}
+
+JSON_Status JSON_Parser_ProcessInputBytes(JSON_Parser parser, const byte* pBytes, size_t length, size_t* pProcessedLength)
+{
+    /* Note that if length is 0, pBytes is allowed to be NULL. Processing
+       stops early only if the parser is suspended, which only happens when
+       it is used to pull events; in that case the number of bytes that
+       were processed is stored in pProcessedLength. */
+    size_t i = 0;
+    while (parser->inputEncoding == JSON_UnknownEncoding && i < length)
+    {
+        if (!JSON_Parser_ProcessUnknownByte(parser, pBytes[i]))
+        {
+            return JSON_Failure;
+        }
+        i++;
+    }
+    while (i < length && !GET_FLAGS(parser->state, PARSER_SUSPENDED))
+    {
+        DecoderOutput output;
+        DecoderResultCode result;
+
+        /* The rest of a line that contained an invalid document is scanned
+           for the line break without being decoded. If the scan stops
+           immediately, the next byte starts an invalid or incomplete
+           encoding sequence, which none of the fast paths below accept. */
+        if (GET_FLAGS(parser->state, PARSER_SKIPPING_LINE) &&
+            parser->inputEncoding == JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET)
+        {
+            size_t skippedLength = JSON_Parser_SkipLineBytes(parser, pBytes + i, length - i);
+            if (skippedLength)
+            {
+                i += skippedLength;
+                continue;
+            }
+        }
+
+        /* The contents of a container that a handler has asked to skip are
+           scanned without being tokenized. */
+        if (parser->lexerState >= LEXING_SKIPPING_CONTAINER &&
+            parser->inputEncoding == JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET)
+        {
+            size_t skippedLength = JSON_Parser_SkipContainerBytes(parser, pBytes + i, length - i);
+            if (skippedLength)
+            {
+                i += skippedLength;
+                continue;
+            }
+        }
+
+        /* Runs of characters in UTF-8 string values are by far the most
+           common input, and they need no re-encoding, so we validate them
+           and copy them into the token buffer in bulk. Anything that the
+           scan does not accept (including invalid encoding sequences) is
+           left for the decoder, so errors and replacements are unaffected. */
+        if (parser->lexerState == LEXING_STRING &&
+            parser->inputEncoding == JSON_UTF8 &&
+            parser->stringEncoding == JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET)
+        {
+            size_t codepoints;
+            TokenAttributes attributes;
+            size_t scanLength = length - i;
+            if (scanLength > parser->maxStringLength - parser->tokenBytesUsed)
+            {
+                /* Let the codepoint that makes the string too long be
+                   processed individually so that the error is reported
+                   normally. */
+                scanLength = parser->maxStringLength - parser->tokenBytesUsed;
+            }
+            scanLength = ScanStringBytes(pBytes + i, scanLength, &codepoints, &attributes);
+            if (scanLength)
+            {
+                if (!JSON_Parser_ProcessStringBytes(parser, pBytes + i, scanLength, codepoints, attributes))
+                {
+                    return JSON_Failure;
+                }
+                i += scanLength;
+                continue;
+            }
+        }
+
+        /* Strings in the other encodings are decoded and re-encoded in
+           bulk, which is much faster than passing them through the
+           decoder a byte at a time. */
+        if (parser->lexerState == LEXING_STRING &&
+            (parser->inputEncoding != JSON_UTF8 || parser->stringEncoding != JSON_UTF8) &&
+            parser->decoderData.state == DECODER_RESET)
+        {
+            size_t transcodedLength;
+            if (!JSON_Parser_TranscodeStringBytes(parser, pBytes + i, length - i, &transcodedLength))
+            {
+                return JSON_Failure;
+            }
+            if (transcodedLength)
+            {
+                i += transcodedLength;
+                continue;
+            }
+        }
+
+        /* Likewise, whitespace between tokens (which can make up a large
+           fraction of pretty-printed input) needs no decoding at all. */
+        if (parser->lexerState == LEXING_WHITESPACE &&
+            parser->inputEncoding == JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET)
+        {
+            size_t whitespaceLength = JSON_Parser_SkipWhitespaceBytes(parser, pBytes + i, length - i);
+            if (whitespaceLength)
+            {
+                i += whitespaceLength;
+                continue;
+            }
+        }
+
+        /* Literals are short sequences of ASCII characters, so when a
+           whole literal is available it can be matched in one step rather
+           than one codepoint at a time. Literals that are split across
+           calls are lexed normally. */
+        if (parser->lexerState == LEXING_WHITESPACE &&
+            parser->inputEncoding == JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET)
+        {
+            Symbol token;
+            size_t literalLength = JSON_Parser_MatchLiteralBytes(parser, pBytes + i, length - i, &token);
+            if (literalLength)
+            {
+                if (!JSON_Parser_ProcessLiteralBytes(parser, token, literalLength) &&
+                    !JSON_Parser_SkipInvalidDocument(parser))
+                {
+                    return JSON_Failure;
+                }
+                i += literalLength;
+                continue;
+            }
+        }
+
+        /* An ASCII byte is always a complete UTF-8 encoding sequence by
+           itself, so it need not pass through the decoder. */
+        if (parser->inputEncoding == JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET &&
+            IS_UTF8_SINGLE_BYTE(pBytes[i]))
+        {
+            if (!JSON_Parser_ProcessInputCodepoint(parser, pBytes[i], 1))
+            {
+                return JSON_Failure;
+            }
+            i++;
+            continue;
+        }
+
+        /* Similarly, a UTF-16 code unit that is not a surrogate, or a UTF-32
+           code unit that is a valid codepoint, is a complete encoding
+           sequence by itself. */
+        if (parser->inputEncoding > JSON_UTF8 &&
+            parser->decoderData.state == DECODER_RESET &&
+            length - i >= SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding))
+        {
+            Codepoint c = ReadCodeUnit(pBytes + i, (Encoding)parser->inputEncoding);
+            if (!IS_SURROGATE(c) && c <= MAX_CODEPOINT)
+            {
+                if (!JSON_Parser_ProcessInputCodepoint(parser, c, SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding)))
+                {
+                    return JSON_Failure;
+                }
+                i += SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding);
+                continue;
+            }
+        }
+
+        output = Decoder_ProcessByte(&parser->decoderData, parser->inputEncoding, pBytes[i]);
+        result = DECODER_RESULT_CODE(output);
+        switch (result)
+        {
+        case SEQUENCE_PENDING:
+            i++;
+            break;
+
+        case SEQUENCE_COMPLETE:
+            if (!JSON_Parser_ProcessInputCodepoint(parser, DECODER_CODEPOINT(output), DECODER_SEQUENCE_LENGTH(output)))
+            {
+                return JSON_Failure;
+            }
+            JSON_Parser_AddLineExtraBytes(parser, DECODER_SEQUENCE_LENGTH(output));
+            i++;
+            break;
+
+        case SEQUENCE_INVALID_INCLUSIVE:
+            i++;
+            /* fallthrough */
+        case SEQUENCE_INVALID_EXCLUSIVE:
+            if (!JSON_Parser_ProcessInvalidInputSequence(parser, DECODER_SEQUENCE_LENGTH(output)))
+            {
+                return JSON_Failure;
+            }
+            JSON_Parser_AddLineExtraBytes(parser, DECODER_SEQUENCE_LENGTH(output));
+            break;
+        }
+    }
+    if (pProcessedLength)
+    {
+        *pProcessedLength = i;
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_ProcessStructuralByte(JSON_Parser parser, byte b)
+{
+    /* This is equivalent to passing a UTF-8 structural character to
+       JSON_Parser_ProcessCodepoint() while the lexer is between tokens. */
+    Symbol token;
+    switch (b)
+    {
+    case '{':
+        token = T_LEFT_CURLY;
+        break;
+    case '}':
+        token = T_RIGHT_CURLY;
+        break;
+    case '[':
+        token = T_LEFT_SQUARE;
+        break;
+    case ']':
+        token = T_RIGHT_SQUARE;
+        break;
+    case ':':
+        token = T_COLON;
+        break;
+    default: /* ',' */
+        token = T_COMMA;
+        break;
+    }
+    JSON_Parser_StartToken(parser, token);
+    parser->codepointLocationByte++;
+    return JSON_Parser_ProcessToken(parser);
+}
+
+static JSON_Status JSON_Parser_ProcessIndexedInputBytes(JSON_Parser parser, const byte* pBytes, size_t length)
+{
+    /* The structural index tells us where the structural characters are
+       without our having to lex the input that precedes them. We pass the
+       input between structural characters through the normal processing
+       path, and pass the structural characters themselves directly to the
+       grammarian. Note that we never trust the index blindly: a structural
+       character is only handled directly if the lexer is between tokens
+       and the indexed byte really is a structural character, so a stale or
+       incorrect index can only make parsing slower, never incorrect. */
+    size_t i = 0;
+    while (i < length)
+    {
+        size_t spanLength = length - i;
+        if (parser->inputEncoding == JSON_UnknownEncoding)
+        {
+            /* Feed the bytes that are used to detect the encoding one at a
+               time, so that we can start using the index immediately. */
+            spanLength = 1;
+        }
+        else if (parser->inputEncoding == JSON_UTF8 && parser->decoderData.state == DECODER_RESET)
+        {
+            while (parser->structuralIndexNext < parser->structuralIndexUsed &&
+                   parser->pStructuralIndex[parser->structuralIndexNext] < parser->codepointLocationByte)
+            {
+                parser->structuralIndexNext++;
+            }
+            if (parser->structuralIndexNext < parser->structuralIndexUsed &&
+                parser->pStructuralIndex[parser->structuralIndexNext] - parser->codepointLocationByte < length - i)
+            {
+                spanLength = parser->pStructuralIndex[parser->structuralIndexNext] - parser->codepointLocationByte;
+                if (!spanLength)
+                {
+                    parser->structuralIndexNext++;
+                    if (parser->lexerState == LEXING_WHITESPACE &&
+                        !GET_FLAGS(parser->state, PARSER_SKIPPING_LINE) &&
+                        IS_STRUCTURAL_BYTE(pBytes[i]))
+                    {
+                        if (!JSON_Parser_ProcessStructuralByte(parser, pBytes[i]) &&
+                            !JSON_Parser_SkipInvalidDocument(parser))
+                        {
+                            return JSON_Failure;
+                        }
+                        i++;
+                        continue;
+                    }
+                    spanLength = 1;
+                }
+            }
+        }
+        if (!JSON_Parser_ProcessInputBytes(parser, pBytes + i, spanLength, NULL))
+        {
+            return JSON_Failure;
+        }
+        i += spanLength;
+    }
+    return JSON_Success;
+}
+
+static JSON_Status JSON_Parser_FlushDecoder(JSON_Parser parser)
+{
+    /* If the input was 1, 2, or 3 bytes long, and the input encoding was not
+       explicitly specified by the client, we can sometimes make a reasonable
+       guess. If the input was 1 or 3 bytes long, the only encoding that could
+       possibly be valid JSON is UF-8. If the input was 2 bytes long, we try
+       to match the following patterns in order, where .. is any byte value
+       and nz is any non-zero byte value:
+         FF FE => UTF-16LE with BOM
+         FE FF => UTF-16BE with BOM
+         nz nz => UTF-8
+         nz 00 => UTF-16LE
+         00 nz => UTF-16BE
+         .. .. => unknown encoding
+    */
+    if (parser->inputEncoding == JSON_UnknownEncoding &&
+        parser->decoderData.state != DECODER_RESET)
+    {
+        byte bytes[3];
+        size_t length = 0;
+        bytes[0] = (byte)(parser->decoderData.bits >> 24);
+        bytes[1] = (byte)(parser->decoderData.bits >> 16);
+        bytes[2] = (byte)(parser->decoderData.bits >> 8);
+        switch (parser->decoderData.state)
+        {
+        case DECODED_1_OF_4:
+            parser->inputEncoding = JSON_UTF8;
+            length = 1;
+            break;
+
+        case DECODED_2_OF_4:
+            if (bytes[0] == 0xFF && bytes[1] == 0xFE)
+            {
+                /* FF FE */
+                parser->inputEncoding = JSON_UTF16LE;
+            }
+            else if (bytes[0] == 0xFE && bytes[1] == 0xFF)
+            {
+                /* FE FF */
+                parser->inputEncoding = JSON_UTF16BE;
+            }
+            else if (bytes[0] != 0x00)
+            {
+                /* nz nz or
+                   nz 00 */
+                parser->inputEncoding = bytes[1] ? JSON_UTF8 : JSON_UTF16LE;
+            }
+            else if (bytes[1] != 0x00)
+            {
+                /* 00 nz */
+                parser->inputEncoding = JSON_UTF16BE;
+            }
+            else
+            {
+                /* 00 00 */
+                return JSON_Parser_HandleInvalidEncodingSequence(parser, 2);
+            }
+            length = 2;
+            break;
+
+        case DECODED_3_OF_4:
+            parser->inputEncoding = JSON_UTF8;
+            length = 3;
+            break;
+        }
+
+        if (!JSON_Parser_CallEncodingDetectedHandler(parser))
+        {
+            return JSON_Failure;
+        }
+
+        /* Reset the decoder before reprocessing the bytes. */
+        parser->decoderData.state = DECODER_RESET;
+        parser->decoderData.bits = 0;
+        if (GET_FLAGS(parser->state, PARSER_PULLING))
+        {
+            JSON_Parser_SetReplayBytes(parser, bytes, length);
+            return JSON_Success;
+        }
+        if (!JSON_Parser_ProcessInputBytes(parser, bytes, length, NULL))
+        {
+            return JSON_Failure;
+        }
+    }
+
+    /* The decoder should be idle when parsing finishes. */
+    if (Decoder_SequencePending(&parser->decoderData))
+    {
+        return JSON_Parser_HandleInvalidEncodingSequence(parser, DECODER_STATE_BYTES(parser->decoderData.state));
+    }
+    return JSON_Success;
+}
+
+/* Parser API functions. */
+
+JSON_Parser JSON_CALL JSON_Parser_Create(const JSON_MemorySuite* pMemorySuite)
+{
+    JSON_Parser parser;
+    JSON_MemorySuite memorySuite;
+    if (pMemorySuite)
+    {
+        memorySuite = *pMemorySuite;
+        if (!memorySuite.realloc || !memorySuite.free)
+        {
+            /* The full memory suite must be specified. */
+            return NULL;
+        }
+    }
+    else
+    {
+        memorySuite = defaultMemorySuite;
+    }
+    parser = (JSON_Parser)memorySuite.realloc(memorySuite.userData, NULL, sizeof(struct JSON_Parser_Data));
+    if (!parser)
+    {
+        return NULL;
+    }
+    parser->memorySuite = memorySuite;
+    JSON_Parser_ResetData(parser, 0/* isInitialized */);
+    return parser;
+}
+
+JSON_Status JSON_CALL JSON_Parser_Free(JSON_Parser parser)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_IN_PROTECTED_API))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_PROTECTED_API);
+    if (parser->pTokenBytes != parser->defaultTokenBytes)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pTokenBytes);
+    }
+    Arena_FreeAllocations(&parser->arenaData, &parser->memorySuite);
+    if (parser->pStructuralIndex)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pStructuralIndex);
+    }
+    if (parser->pBatchStringBytes)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pBatchStringBytes);
+    }
+    if (parser->pPathNodes)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pPathNodes);
+    }
+    if (parser->pPathNameBytes)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pPathNameBytes);
+    }
+    if (parser->pPathStack)
+    {
+        parser->memorySuite.free(parser->memorySuite.userData, parser->pPathStack);
+    }
+    JSON_Parser_FreeKeyDictionary(parser);
+    Grammarian_FreeAllocations(&parser->grammarianData, &parser->memorySuite);
+    parser->memorySuite.free(parser->memorySuite.userData, parser);
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_Reset(JSON_Parser parser)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_IN_PROTECTED_API))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_PROTECTED_API);
+    JSON_Parser_ResetData(parser, 1/* isInitialized */);
+    /* Note that JSON_Parser_ResetData() unset PARSER_IN_PROTECTED_API for us. */
+    return JSON_Success;
+}
+
+void* JSON_CALL JSON_Parser_GetUserData(JSON_Parser parser)
+{
+    return parser ? parser->userData : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetUserData(JSON_Parser parser, void* userData)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->userData = userData;
+    return JSON_Success;
+}
+
+JSON_Encoding JSON_CALL JSON_Parser_GetInputEncoding(JSON_Parser parser)
+{
+    return parser ? (JSON_Encoding)parser->inputEncoding : JSON_UnknownEncoding;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetInputEncoding(JSON_Parser parser, JSON_Encoding encoding)
+{
+    if (!parser || encoding < JSON_UnknownEncoding || encoding > JSON_UTF32BE || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->inputEncoding = (Encoding)encoding;
+    return JSON_Success;
+}
+
+JSON_Encoding JSON_CALL JSON_Parser_GetStringEncoding(JSON_Parser parser)
+{
+    return parser ? (JSON_Encoding)parser->stringEncoding : JSON_UTF8;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetStringEncoding(JSON_Parser parser, JSON_Encoding encoding)
+{
+    if (!parser || encoding <= JSON_UnknownEncoding || encoding > JSON_UTF32BE || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->stringEncoding = (Encoding)encoding;
+    return JSON_Success;
+}
+
+size_t JSON_CALL JSON_Parser_GetMaxStringLength(JSON_Parser parser)
+{
+    return parser ? parser->maxStringLength : SIZE_MAX;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetMaxStringLength(JSON_Parser parser, size_t maxLength)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->maxStringLength = maxLength;
+    return JSON_Success;
+}
+
+JSON_Encoding JSON_CALL JSON_Parser_GetNumberEncoding(JSON_Parser parser)
+{
+    return parser ? (JSON_Encoding)parser->numberEncoding : JSON_UTF8;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetNumberEncoding(JSON_Parser parser, JSON_Encoding encoding)
+{
+    if (!parser || encoding <= JSON_UnknownEncoding || encoding > JSON_UTF32BE || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->numberEncoding = (Encoding)encoding;
+    return JSON_Success;
+}
+
+size_t JSON_CALL JSON_Parser_GetMaxNumberLength(JSON_Parser parser)
+{
+    return parser ? parser->maxNumberLength : SIZE_MAX;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetMaxNumberLength(JSON_Parser parser, size_t maxLength)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->maxNumberLength = maxLength;
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetAllowBOM(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_BOM)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetAllowBOM(JSON_Parser parser, JSON_Boolean allowBOM)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_BOM, allowBOM);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetAllowComments(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_COMMENTS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetAllowComments(JSON_Parser parser, JSON_Boolean allowComments)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_COMMENTS, allowComments);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetAllowSpecialNumbers(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetAllowSpecialNumbers(JSON_Parser parser, JSON_Boolean allowSpecialNumbers)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS, allowSpecialNumbers);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetAllowHexNumbers(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_HEX_NUMBERS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetAllowHexNumbers(JSON_Parser parser, JSON_Boolean allowHexNumbers)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_HEX_NUMBERS, allowHexNumbers);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetAllowUnescapedControlCharacters(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_CONTROL_CHARS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetAllowUnescapedControlCharacters(JSON_Parser parser, JSON_Boolean allowUnescapedControlCharacters)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_CONTROL_CHARS, allowUnescapedControlCharacters);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetReplaceInvalidEncodingSequences(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_REPLACE_INVALID)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetReplaceInvalidEncodingSequences(JSON_Parser parser, JSON_Boolean replaceInvalidEncodingSequences)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_REPLACE_INVALID, replaceInvalidEncodingSequences);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetTrackObjectMembers(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_TRACK_OBJECT_MEMBERS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetTrackObjectMembers(JSON_Parser parser, JSON_Boolean trackObjectMembers)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_TRACK_OBJECT_MEMBERS, trackObjectMembers);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetStopAfterEmbeddedDocument(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetStopAfterEmbeddedDocument(JSON_Parser parser, JSON_Boolean stopAfterEmbeddedDocument)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_EMBEDDED_DOCUMENT, stopAfterEmbeddedDocument);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetZeroCopyStrings(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_ZERO_COPY_STRINGS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetZeroCopyStrings(JSON_Parser parser, JSON_Boolean zeroCopyStrings)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_ZERO_COPY_STRINGS, zeroCopyStrings);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetAllowMultipleDocuments(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_MULTIPLE_DOCUMENTS)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetAllowMultipleDocuments(JSON_Parser parser, JSON_Boolean allowMultipleDocuments)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_MULTIPLE_DOCUMENTS, allowMultipleDocuments);
+    return JSON_Success;
+}
+
+JSON_Boolean JSON_CALL JSON_Parser_GetSkipInvalidDocuments(JSON_Parser parser)
+{
+    return (parser && GET_FLAGS(parser->flags, PARSER_SKIP_INVALID)) ? JSON_True : JSON_False;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetSkipInvalidDocuments(JSON_Parser parser, JSON_Boolean skipInvalidDocuments)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    SET_FLAGS(ParserFlags, parser->flags, PARSER_SKIP_INVALID, skipInvalidDocuments);
+    return JSON_Success;
+}
+
+JSON_Error JSON_CALL JSON_Parser_GetError(JSON_Parser parser)
+{
+    return parser ? (JSON_Error)parser->error : JSON_Error_None;
+}
+
+JSON_Status JSON_CALL JSON_Parser_GetErrorLocation(JSON_Parser parser, JSON_Location* pLocation)
+{
+    if (!pLocation || !parser || parser->error == JSON_Error_None)
+    {
+        return JSON_Failure;
+    }
+    if (parser->errorOffset == ERROR_LOCATION_IS_TOKEN_START)
+    {
+        pLocation->byte = parser->tokenLocationByte;
+        pLocation->line = parser->tokenLocationLine;
+        pLocation->column = parser->tokenLocationColumn;
+    }
+    else
+    {
+        pLocation->byte = parser->codepointLocationByte - (SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding) * parser->errorOffset);
+        pLocation->line = parser->codepointLocationLine;
+        pLocation->column = JSON_Parser_GetColumn(parser, parser->codepointLocationByte) - parser->errorOffset;
+    }
+    pLocation->depth = parser->depth;
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_GetTokenLocation(JSON_Parser parser, JSON_Location* pLocation)
+{
+    if (!parser || !pLocation || !GET_FLAGS(parser->state, PARSER_IN_TOKEN_HANDLER))
+    {
+        return JSON_Failure;
+    }
+    pLocation->byte = parser->tokenLocationByte;
+    pLocation->line = parser->tokenLocationLine;
+    pLocation->column = parser->tokenLocationColumn;
+    pLocation->depth = parser->depth;
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_GetAfterTokenLocation(JSON_Parser parser, JSON_Location* pLocation)
+{
+    if (!parser || !pLocation || !GET_FLAGS(parser->state, PARSER_IN_TOKEN_HANDLER))
+    {
+        return JSON_Failure;
+    }
+    pLocation->byte = parser->codepointLocationByte;
+    pLocation->line = parser->codepointLocationLine;
+    pLocation->column = JSON_Parser_GetColumn(parser, parser->codepointLocationByte);
+    pLocation->depth = parser->depth;
+    return JSON_Success;
+}
+
+JSON_Parser_NullHandler JSON_CALL JSON_Parser_GetEncodingDetectedHandler(JSON_Parser parser)
+{
+    return parser ? parser->encodingDetectedHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetEncodingDetectedHandler(JSON_Parser parser, JSON_Parser_EncodingDetectedHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->encodingDetectedHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_NullHandler JSON_CALL JSON_Parser_GetNullHandler(JSON_Parser parser)
+{
+    return parser ? parser->nullHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetNullHandler(JSON_Parser parser, JSON_Parser_NullHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->nullHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_BooleanHandler JSON_CALL JSON_Parser_GetBooleanHandler(JSON_Parser parser)
+{
+    return parser ? parser->booleanHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetBooleanHandler(JSON_Parser parser, JSON_Parser_BooleanHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->booleanHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_StringHandler JSON_CALL JSON_Parser_GetStringHandler(JSON_Parser parser)
+{
+    return parser ? parser->stringHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetStringHandler(JSON_Parser parser, JSON_Parser_StringHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->stringHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_NumberHandler JSON_CALL JSON_Parser_GetNumberHandler(JSON_Parser parser)
+{
+    return parser ? parser->numberHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetNumberHandler(JSON_Parser parser, JSON_Parser_NumberHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->numberHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_TypedNumberHandler JSON_CALL JSON_Parser_GetTypedNumberHandler(JSON_Parser parser)
+{
+    return parser ? parser->typedNumberHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetTypedNumberHandler(JSON_Parser parser, JSON_Parser_TypedNumberHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->typedNumberHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_SpecialNumberHandler JSON_CALL JSON_Parser_GetSpecialNumberHandler(JSON_Parser parser)
+{
+    return parser ? parser->specialNumberHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetSpecialNumberHandler(JSON_Parser parser, JSON_Parser_SpecialNumberHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->specialNumberHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_StartObjectHandler JSON_CALL JSON_Parser_GetStartObjectHandler(JSON_Parser parser)
+{
+    return parser ? parser->startObjectHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetStartObjectHandler(JSON_Parser parser, JSON_Parser_StartObjectHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->startObjectHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_EndObjectHandler JSON_CALL JSON_Parser_GetEndObjectHandler(JSON_Parser parser)
+{
+    return parser ? parser->endObjectHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetEndObjectHandler(JSON_Parser parser, JSON_Parser_EndObjectHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->endObjectHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_ObjectMemberHandler JSON_CALL JSON_Parser_GetObjectMemberHandler(JSON_Parser parser)
+{
+    return parser ? parser->objectMemberHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetObjectMemberHandler(JSON_Parser parser, JSON_Parser_ObjectMemberHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->objectMemberHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_StartArrayHandler JSON_CALL JSON_Parser_GetStartArrayHandler(JSON_Parser parser)
+{
+    return parser ? parser->startArrayHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetStartArrayHandler(JSON_Parser parser, JSON_Parser_StartArrayHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->startArrayHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_EndArrayHandler JSON_CALL JSON_Parser_GetEndArrayHandler(JSON_Parser parser)
+{
+    return parser ? parser->endArrayHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetEndArrayHandler(JSON_Parser parser, JSON_Parser_EndArrayHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->endArrayHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_ArrayItemHandler JSON_CALL JSON_Parser_GetArrayItemHandler(JSON_Parser parser)
+{
+    return parser ? parser->arrayItemHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetArrayItemHandler(JSON_Parser parser, JSON_Parser_ArrayItemHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->arrayItemHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_StartDocumentHandler JSON_CALL JSON_Parser_GetStartDocumentHandler(JSON_Parser parser)
+{
+    return parser ? parser->startDocumentHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetStartDocumentHandler(JSON_Parser parser, JSON_Parser_StartDocumentHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->startDocumentHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Parser_EndDocumentHandler JSON_CALL JSON_Parser_GetEndDocumentHandler(JSON_Parser parser)
+{
+    return parser ? parser->endDocumentHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetEndDocumentHandler(JSON_Parser parser, JSON_Parser_EndDocumentHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->endDocumentHandler = handler;
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_Parse(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal)
+{
+    JSON_Status status = JSON_Failure;
+    if (parser && (pBytes || !length) && !GET_FLAGS(parser->state, PARSER_FINISHED | PARSER_IN_PROTECTED_API | PARSER_PULLING))
+    {
+        int finishedParsing = 0;
+        if (!GET_FLAGS(parser->state, PARSER_STARTED))
+        {
+            /* The settings cannot change once parsing has started. */
+            JSON_Parser_InitLexerClasses(parser);
+        }
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_STARTED | PARSER_IN_PROTECTED_API);
+        /* Note that a pending string cannot continue to refer to the input
+           after this call returns. */
+        if ((parser->structuralIndexUsed
+             ? JSON_Parser_ProcessIndexedInputBytes(parser, (const byte*)pBytes, length)
+             : JSON_Parser_ProcessInputBytes(parser, (const byte*)pBytes, length, NULL)) &&
+            (!parser->pInputTokenBytes || JSON_Parser_CopyInputTokenBytes(parser)))
+        {
+            /* New input was parsed successfully. */
+            if (isFinal)
+            {
+                /* Make sure there is nothing pending in the decoder, lexer,
+                   or parser. */
+                if ((JSON_Parser_FlushDecoder(parser) &&
+                     JSON_Parser_FlushLexer(parser) &&
+                     JSON_Parser_FlushParser(parser)) ||
+                    JSON_Parser_SkipInvalidDocument(parser))
+                {
+                    status = JSON_Success;
+                    if (parser->pDocument)
+                    {
+                        parser->pDocument->isComplete = 1;
+                    }
+                }
+                finishedParsing = 1;
+            }
+            else
             {
-                JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
-                return JSON_Failure;
+                status = JSON_Success;
             }
-            parser->lexerBits++;
+        }
+        else
+        {
+            /* New input failed to parse. */
+            finishedParsing = 1;
+        }
+        /* Batched events are delivered before this call returns, even if
+           an error follows them. */
+        if (parser->batchEventsUsed && !JSON_Parser_DeliverEventBatch(parser))
+        {
+            status = JSON_Failure;
+            finishedParsing = 1;
+        }
+        if (finishedParsing)
+        {
+            SET_FLAGS_ON(ParserState, parser->state, PARSER_FINISHED);
+        }
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_PROTECTED_API);
+    }
+    return status;
+}
 
-            /* If the literal is the top-level value of an embedded document,
-               process it as soon as we consume its last expected codepoint.
-               Normally we defer processing until the following codepoint
-               has been examined, so that we can treat sequences like "nullx"
-               as a single, unknown token rather than a null literal followed
-               by an unknown token. */
-            if (!parser->depth && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT) &&
-                !expectedLiteralChars[parser->lexerBits])
+/* Minimal wrappers around the platform's file descriptor functions. */
+#if defined(_WIN32)
+#define File_Open(path)                _open((path), _O_RDONLY | _O_BINARY)
+#define File_Read(fd, pBuffer, length) _read((fd), (pBuffer), (unsigned int)(length))
+#define File_Close(fd)                 _close(fd)
+#else
+#define File_Open(path)                open((path), O_RDONLY)
+#define File_Read(fd, pBuffer, length) read((fd), (pBuffer), (length))
+#define File_Close(fd)                 close(fd)
+#endif
+
+static JSON_Status JSON_Parser_StopParsingFile(JSON_Parser parser, Error error)
+{
+    JSON_Parser_SetErrorAtCodepoint(parser, error);
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_FINISHED);
+    return JSON_Failure;
+}
+
+static JSON_Status JSON_Parser_ReadFile(JSON_Parser parser, int fd)
+{
+    JSON_Status status = JSON_Failure;
+    char* pBuffer = (char*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, FILE_READ_BUFFER_SIZE);
+    if (!pBuffer)
+    {
+        return JSON_Parser_StopParsingFile(parser, JSON_Error_OutOfMemory);
+    }
+    for (;;)
+    {
+        long length = (long)File_Read(fd, pBuffer, FILE_READ_BUFFER_SIZE);
+        if (length < 0)
+        {
+            if (errno != EINTR)
             {
-                tokenFinished = 1;
+                JSON_Parser_StopParsingFile(parser, JSON_Error_CannotReadInput);
+                break;
             }
         }
+        else if (!JSON_Parser_Parse(parser, pBuffer, (size_t)length, length ? JSON_False : JSON_True))
+        {
+            break;
+        }
+        else if (!length)
+        {
+            status = JSON_Success;
+            break;
+        }
+    }
+    parser->memorySuite.free(parser->memorySuite.userData, pBuffer);
+    return status;
+}
+
+#if !defined(_WIN32) && !defined(JSON_NO_MMAP)
+
+/* Parse the rest of a regular file by mapping it into memory. The mapping
+   is passed to the parser a window at a time, and each window is unmapped
+   once it has been parsed, which keeps the resident size of the mapping
+   bounded however large the file is. The next window is prefetched while
+   the current one is parsed. This function returns 0, without touching
+   the parser, if the file cannot be mapped. */
+static int JSON_Parser_ParseMappedFile(JSON_Parser parser, int fd, JSON_Status* pStatus)
+{
+    struct stat info;
+    long pageSize = sysconf(_SC_PAGESIZE);
+    off_t position;
+    off_t mapStart;
+    size_t mapLength;
+    size_t used;
+    size_t unmapped;
+    byte* pMapping;
+    JSON_Status status = JSON_Success;
+    if (pageSize <= 0 || fstat(fd, &info) != 0 || !S_ISREG(info.st_mode))
+    {
+        return 0;
+    }
+    position = lseek(fd, 0, SEEK_CUR);
+    if (position < 0 || position >= info.st_size)
+    {
+        return 0;
+    }
+    mapStart = position - position % (off_t)pageSize;
+    if ((JSON_UInt64)(info.st_size - mapStart) > (JSON_UInt64)SIZE_MAX)
+    {
+        return 0;
+    }
+    mapLength = (size_t)(info.st_size - mapStart);
+    pMapping = (byte*)mmap(NULL, mapLength, PROT_READ, MAP_PRIVATE, fd, mapStart);
+    if (pMapping == (byte*)MAP_FAILED)
+    {
+        return 0;
+    }
+#if defined(POSIX_MADV_SEQUENTIAL)
+    (void)posix_madvise(pMapping, mapLength, POSIX_MADV_SEQUENTIAL);
+#endif
+    used = (size_t)(position - mapStart);
+    unmapped = 0;
+    while (status == JSON_Success && used < mapLength)
+    {
+        size_t end = used - used % FILE_MAP_WINDOW_SIZE + FILE_MAP_WINDOW_SIZE;
+        if (end > mapLength || end < used)
+        {
+            end = mapLength;
+        }
+#if defined(POSIX_MADV_WILLNEED)
         else
         {
-            /* The literal should be finished, so the codepoint should not be
-               a plausible JSON literal character, but rather EOF, whitespace,
-               or the first character of the next token. */
-            if ((c >= 'A' && c <= 'Z') ||
-                (c >= 'a' && c <= 'z') ||
-                (c >= '0' && c <= '9') ||
-                (c == '_'))
+            (void)posix_madvise(pMapping + end, (mapLength - end < FILE_MAP_WINDOW_SIZE) ? mapLength - end : FILE_MAP_WINDOW_SIZE, POSIX_MADV_WILLNEED);
+        }
+#endif
+        status = JSON_Parser_Parse(parser, (const char*)pMapping + used, end - used, (end == mapLength) ? JSON_True : JSON_False);
+        used = end;
+        if (used < mapLength)
+        {
+            munmap(pMapping + unmapped, used - unmapped);
+            unmapped = used;
+        }
+    }
+    munmap(pMapping + unmapped, mapLength - unmapped);
+    (void)lseek(fd, mapStart + (off_t)used, SEEK_SET);
+    *pStatus = status;
+    return 1;
+}
+
+#endif
+
+JSON_Status JSON_CALL JSON_Parser_ParseFd(JSON_Parser parser, int fd)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_FINISHED | PARSER_IN_PROTECTED_API | PARSER_PULLING))
+    {
+        return JSON_Failure;
+    }
+    if (fd < 0)
+    {
+        return JSON_Parser_StopParsingFile(parser, JSON_Error_CannotReadInput);
+    }
+#if !defined(_WIN32) && !defined(JSON_NO_MMAP)
+    {
+        JSON_Status status;
+        if (JSON_Parser_ParseMappedFile(parser, fd, &status))
+        {
+            return status;
+        }
+    }
+#endif
+    return JSON_Parser_ReadFile(parser, fd);
+}
+
+JSON_Status JSON_CALL JSON_Parser_ParseFile(JSON_Parser parser, const char* path)
+{
+    JSON_Status status;
+    int fd;
+    if (!parser || !path || GET_FLAGS(parser->state, PARSER_FINISHED | PARSER_IN_PROTECTED_API | PARSER_PULLING))
+    {
+        return JSON_Failure;
+    }
+    fd = File_Open(path);
+    status = JSON_Parser_ParseFd(parser, fd);
+    if (fd >= 0)
+    {
+        File_Close(fd);
+    }
+    return status;
+}
+
+/* Returns the offset of the first byte at or after offset i that belongs
+   in a structural index, or length if there is none. The value pointed to
+   by pInString tracks whether the scan is inside a string. */
+static size_t FindStructuralByte(const byte* pInput, size_t i, size_t length, int* pInString)
+{
+    while (i < length)
+    {
+        byte b;
+
+        /* Skip whole words that cannot contain an index entry. Inside a
+           string, only quotation marks and reverse solidi matter; outside
+           a string, OR-ing each byte with 0x20 maps [ and ] onto { and },
+           so that we can test for all the brackets with two comparisons. */
+        if (length - i >= SCAN_WORD_SIZE)
+        {
+            ScanWord w;
+            memcpy(&w, pInput + i, SCAN_WORD_SIZE);
+            if (*pInString
+                ? !(SCAN_WORD_HAS_BYTE(w, '"') | SCAN_WORD_HAS_BYTE(w, '\\'))
+                : !(SCAN_WORD_HAS_BYTE(w | SCAN_WORD_REPEAT(0x20), '{') |
+                    SCAN_WORD_HAS_BYTE(w | SCAN_WORD_REPEAT(0x20), '}') |
+                    SCAN_WORD_HAS_BYTE(w, ':') |
+                    SCAN_WORD_HAS_BYTE(w, ',') |
+                    SCAN_WORD_HAS_BYTE(w, '"')))
             {
-                JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
-                return JSON_Failure;
+                i += SCAN_WORD_SIZE;
+                continue;
             }
-            if (!JSON_Parser_ProcessToken(parser))
+        }
+        b = pInput[i];
+        if (*pInString)
+        {
+            if (b == '\\')
             {
-                return JSON_Failure;
+                /* Skip the escaped character, which may be a quotation mark. */
+                i++;
+            }
+            else if (b == '"')
+            {
+                *pInString = 0;
+                return i;
             }
-            goto reprocess;
         }
-        goto advance;
-
-    case LEXING_STRING:
-        if (c == EOF_CODEPOINT)
+        else if (b == '"' || IS_STRUCTURAL_BYTE(b))
         {
-            /* Allow JSON_Parser_FlushLexer() to fail. */
+            *pInString = (b == '"');
+            return i;
         }
-        else if (c == '"')
+        i++;
+    }
+    return length;
+}
+
+static JSON_Status JSON_Parser_AddStructuralIndexEntry(JSON_Parser parser, size_t offset)
+{
+    if (parser->structuralIndexUsed == parser->structuralIndexLength)
+    {
+        size_t newLength = parser->structuralIndexLength ? parser->structuralIndexLength * 2 : DEFAULT_STRUCTURAL_INDEX_LENGTH;
+        size_t* pNewIndex;
+        if (newLength < parser->structuralIndexLength || newLength > SIZE_MAX / sizeof(size_t))
         {
-            tokenFinished = 1;
+            return JSON_Failure;
         }
-        else if (c == '\\')
+        pNewIndex = (size_t*)parser->memorySuite.realloc(parser->memorySuite.userData, parser->pStructuralIndex, newLength * sizeof(size_t));
+        if (!pNewIndex)
         {
-            parser->lexerState = LEXING_STRING_ESCAPE;
+            return JSON_Failure;
         }
-        else if (c < 0x20 && !GET_FLAGS(parser->flags, PARSER_ALLOW_CONTROL_CHARS))
+        parser->pStructuralIndex = pNewIndex;
+        parser->structuralIndexLength = newLength;
+    }
+    parser->pStructuralIndex[parser->structuralIndexUsed] = offset;
+    parser->structuralIndexUsed++;
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_BuildStructuralIndex(JSON_Parser parser, const char* pBytes, size_t length)
+{
+    const byte* pInput = (const byte*)pBytes;
+    int inString = 0;
+    size_t i = 0;
+    if (!parser || (!pBytes && length) || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->structuralIndexUsed = 0;
+    parser->structuralIndexNext = 0;
+    while ((i = FindStructuralByte(pInput, i, length, &inString)) < length)
+    {
+        if (!JSON_Parser_AddStructuralIndexEntry(parser, i))
         {
-            /* ASCII control characters (U+0000 - U+001F) are not allowed to
-               appear unescaped in string values unless specifically allowed. */
-            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_UnescapedControlCharacter);
+            /* We ran out of memory, so discard the partial index. */
+            parser->structuralIndexUsed = 0;
             return JSON_Failure;
         }
-        else
+        i++;
+    }
+    return JSON_Success;
+}
+
+const size_t* JSON_CALL JSON_Parser_GetStructuralIndex(JSON_Parser parser, size_t* pLength)
+{
+    if (pLength)
+    {
+        *pLength = parser ? parser->structuralIndexUsed : 0;
+    }
+    return (parser && parser->structuralIndexUsed) ? parser->pStructuralIndex : NULL;
+}
+
+static JSON_Status JSON_Parser_AddPathNameByte(JSON_Parser parser, byte b)
+{
+    if (parser->pathNameBytesUsed == parser->pathNameBytesLength)
+    {
+        byte* pNewBytes = (byte*)GrowArray(&parser->memorySuite, parser->pPathNameBytes, &parser->pathNameBytesLength, 1, DEFAULT_PATH_NAME_BYTES_LENGTH);
+        if (!pNewBytes)
         {
-            codepointToRecord = c;
-            goto recordStringCodepointAndAdvance;
+            return JSON_Failure;
         }
-        goto advance;
+        parser->pPathNameBytes = pNewBytes;
+    }
+    parser->pPathNameBytes[parser->pathNameBytesUsed] = b;
+    parser->pathNameBytesUsed++;
+    return JSON_Success;
+}
 
-    case LEXING_STRING_ESCAPE:
-        if (c == EOF_CODEPOINT)
+static JSON_Status JSON_Parser_AddPathNode(JSON_Parser parser, size_t* pNode, size_t nameOffset, int isWildcard)
+{
+    /* Find or add the child of the node that has the name most recently
+       added to the path name buffer, and make it the current node. */
+    size_t nameLength = parser->pathNameBytesUsed - nameOffset;
+    const byte* pName = nameLength ? parser->pPathNameBytes + nameOffset : NULL;
+    size_t child;
+    PathNode* pChild;
+    for (child = parser->pathNodesUsed ? parser->pPathNodes[*pNode].firstChild : 0; child; child = parser->pPathNodes[child].nextSibling)
+    {
+        pChild = &parser->pPathNodes[child];
+        if (pChild->isWildcard == isWildcard && pChild->nameLength == nameLength &&
+            (!nameLength || !memcmp(parser->pPathNameBytes + pChild->nameOffset, pName, nameLength)))
         {
-            /* Allow JSON_Parser_FlushLexer() to fail. */
+            parser->pathNameBytesUsed = nameOffset;
+            *pNode = child;
+            return JSON_Success;
         }
-        else
+    }
+    if (parser->pathNodesUsed == parser->pathNodesLength)
+    {
+        PathNode* pNewNodes = (PathNode*)GrowArray(&parser->memorySuite, parser->pPathNodes, &parser->pathNodesLength, sizeof(PathNode), DEFAULT_PATH_NODES_LENGTH);
+        if (!pNewNodes)
         {
-            if (c == 'u')
+            return JSON_Failure;
+        }
+        parser->pPathNodes = pNewNodes;
+    }
+    child = parser->pathNodesUsed;
+    pChild = &parser->pPathNodes[child];
+    pChild->firstChild = 0;
+    pChild->nextSibling = 0;
+    pChild->nameOffset = nameOffset;
+    pChild->nameLength = nameLength;
+    pChild->index = SIZE_MAX;
+    pChild->isWildcard = (byte)isWildcard;
+    pChild->isMatch = 0;
+    if (nameLength && (pName[0] != '0' || nameLength == 1))
+    {
+        /* The name is an array index if it is a decimal number without
+           leading zeros that fits in a size_t. */
+        size_t i;
+        pChild->index = 0;
+        for (i = 0; i < nameLength && pChild->index != SIZE_MAX; i++)
+        {
+            if (pName[i] < '0' || pName[i] > '9' || pChild->index > (SIZE_MAX - 1 - (pName[i] - '0')) / 10)
             {
-                parser->lexerState = LEXING_STRING_HEX_ESCAPE_BYTE_1;
+                pChild->index = SIZE_MAX;
             }
             else
             {
-                if (c == '"' || c == '\\' || c == '/')
-                {
-                    codepointToRecord = c;
-                }
-                else if (c == 'b')
-                {
-                    codepointToRecord = BACKSPACE_CODEPOINT;
-                }
-                else if (c == 't')
-                {
-                    codepointToRecord = TAB_CODEPOINT;
-                }
-                else if (c == 'n')
-                {
-                    codepointToRecord = LINE_FEED_CODEPOINT;
-                }
-                else if (c == 'f')
-                {
-                    codepointToRecord = FORM_FEED_CODEPOINT;
-                }
-                else if (c == 'r')
-                {
-                    codepointToRecord = CARRIAGE_RETURN_CODEPOINT;
-                }
-                else
-                {
-                    /* The current codepoint location is the first character after
-                       the backslash that started the escape sequence. The error
-                       location should be the beginning of the escape sequence, 1
-                       character earlier. */
-                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_InvalidEscapeSequence, 1);
-                    return JSON_Failure;
-                }
-                parser->lexerState = LEXING_STRING;
-                goto recordStringCodepointAndAdvance;
+                pChild->index = pChild->index * 10 + (pName[i] - '0');
             }
         }
-        goto advance;
+    }
+    if (child)
+    {
+        pChild->nextSibling = parser->pPathNodes[*pNode].firstChild;
+        parser->pPathNodes[*pNode].firstChild = child;
+    }
+    parser->pathNodesUsed++;
+    *pNode = child;
+    return JSON_Success;
+}
 
-    case LEXING_STRING_HEX_ESCAPE_BYTE_1:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_2:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_3:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_4:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_5:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_6:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_7:
-    case LEXING_STRING_HEX_ESCAPE_BYTE_8:
-        if (c == EOF_CODEPOINT)
+JSON_Status JSON_CALL JSON_Parser_AddPathFilter(JSON_Parser parser, const char* pPath)
+{
+    const byte* pBytes = (const byte*)pPath;
+    size_t length;
+    size_t node = 0;
+    size_t i;
+    DecoderData decoderData;
+    if (!parser || !pPath || GET_FLAGS(parser->state, PARSER_STARTED) || (pBytes[0] && pBytes[0] != '/'))
+    {
+        return JSON_Failure;
+    }
+
+    /* Validate the whole path before changing the trie. */
+    length = strlen(pPath);
+    Decoder_Reset(&decoderData);
+    for (i = 0; i < length; i++)
+    {
+        DecoderResultCode result = DECODER_RESULT_CODE(Decoder_ProcessByte(&decoderData, JSON_UTF8, pBytes[i]));
+        if ((result != SEQUENCE_PENDING && result != SEQUENCE_COMPLETE) ||
+            (pBytes[i] == '~' && pBytes[i + 1] != '0' && pBytes[i + 1] != '1'))
         {
-            /* Allow JSON_Parser_FlushLexer() to fail. */
+            return JSON_Failure;
         }
-        else
+    }
+    if (Decoder_SequencePending(&decoderData))
+    {
+        return JSON_Failure;
+    }
+
+    /* The root node, which has no name, is added along with the first
+       filter. */
+    if (!parser->pathNodesUsed && !JSON_Parser_AddPathNode(parser, &node, parser->pathNameBytesUsed, 0/*isWildcard*/))
+    {
+        return JSON_Failure;
+    }
+    i = 0;
+    while (i < length)
+    {
+        size_t nameOffset = parser->pathNameBytesUsed;
+        size_t tokenStart = ++i; /* skip the solidus */
+        while (i < length && pBytes[i] != '/')
         {
-            /* While lexing a string hex escape sequence we store the bytes
-               of the escaped codepoint in the low 2 bytes of lexerBits. If
-               the escape sequence represents a leading surrogate, we shift
-               the leading surrogate into the high 2 bytes and lex a second
-               hex escape sequence (which should be a trailing surrogate). */
-            int byteNumber = (parser->lexerState - LEXING_STRING_HEX_ESCAPE_BYTE_1) & 0x3;
-            uint32_t nibble;
-            if (c >= '0' && c <= '9')
-            {
-                nibble = c - '0';
-            }
-            else if (c >= 'A' && c <= 'F')
-            {
-                nibble = c - 'A' + 10;
-            }
-            else if (c >= 'a' && c <= 'f')
+            byte b = pBytes[i];
+            if (b == '~')
             {
-                nibble = c - 'a' + 10;
+                i++;
+                b = (byte)((pBytes[i] == '0') ? '~' : '/');
             }
-            else
+            if (!JSON_Parser_AddPathNameByte(parser, b))
             {
-                /* The current codepoint location is one of the 4 hex digit
-                   character slots in the hex escape sequence. The error
-                   location should be the beginning of the hex escape
-                   sequence, between 2 and 5 bytes earlier. */
-                int codepointsAgo = 2 /* for "\u" */ + byteNumber;
-                JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_InvalidEscapeSequence, codepointsAgo);
+                parser->pathNameBytesUsed = nameOffset;
                 return JSON_Failure;
             }
-            /* Store the hex digit's bits in the appropriate byte of lexerBits. */
-            nibble <<= (3 - byteNumber) * 4 /* shift left by 12, 8, 4, 0 */ ;
-            parser->lexerBits |= nibble;
-            if (parser->lexerState == LEXING_STRING_HEX_ESCAPE_BYTE_4)
-            {
-                /* The escape sequence is complete. We need to check whether
-                   it represents a leading surrogate (which implies that it
-                   will be immediately followed by a hex-escaped trailing
-                   surrogate), a trailing surrogate (which is invalid), or a
-                   valid codepoint (which should simply be appended to the
-                   string token value). */
-                if (IS_LEADING_SURROGATE(parser->lexerBits))
-                {
-                    /* Shift the leading surrogate into the high 2 bytes of
-                       lexerBits so that the trailing surrogate can be stored
-                       in the low 2 bytes. */
-                    parser->lexerBits <<= 16;
-                    parser->lexerState = LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_BACKSLASH;
-                }
-                else if (IS_TRAILING_SURROGATE(parser->lexerBits))
-                {
-                    /* The current codepoint location is the last hex digit
-                       of the hex escape sequence. The error location should
-                       be the beginning of the hex escape sequence, 5
-                       characters earlier. */
-                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 5);
-                    return JSON_Failure;
-                }
-                else
-                {
-                    /* The escape sequence represents a BMP codepoint. */
-                    codepointToRecord = parser->lexerBits;
-                    parser->lexerBits = 0;
-                    parser->lexerState = LEXING_STRING;
-                    goto recordStringCodepointAndAdvance;
-                }
-            }
-            else if (parser->lexerState == LEXING_STRING_HEX_ESCAPE_BYTE_8)
-            {
-                /* The second hex escape sequence is complete. We need to
-                   check whether it represents a trailing surrogate as
-                   expected. If so, the surrogate pair represents a single
-                   non-BMP codepoint. */
-                if (!IS_TRAILING_SURROGATE(parser->lexerBits & 0xFFFF))
-                {
-                    /* The current codepoint location is the last hex digit of
-                       the second hex escape sequence. The error location
-                       should be the beginning of the leading surrogate
-                       hex escape sequence, 11 characters earlier. */
-                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 11);
-                    return JSON_Failure;
-                }
-                /* The escape sequence represents a non-BMP codepoint. */
-                codepointToRecord = CODEPOINT_FROM_SURROGATES(parser->lexerBits);
-                parser->lexerBits = 0;
-                parser->lexerState = LEXING_STRING;
-                goto recordStringCodepointAndAdvance;
-            }
-            else
+            i++;
+        }
+        if (i - tokenStart == 1 && pBytes[tokenStart] == '*')
+        {
+            parser->pathNameBytesUsed = nameOffset;
+            if (!JSON_Parser_AddPathNode(parser, &node, nameOffset, 1/*isWildcard*/))
             {
-                parser->lexerState++;
+                return JSON_Failure;
             }
         }
-        goto advance;
+        else if (!JSON_Parser_AddPathNode(parser, &node, nameOffset, 0/*isWildcard*/))
+        {
+            parser->pathNameBytesUsed = nameOffset;
+            return JSON_Failure;
+        }
+    }
+    parser->pPathNodes[node].isMatch = 1;
+    return JSON_Success;
+}
 
-    case LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_BACKSLASH:
-        if (c == EOF_CODEPOINT)
+JSON_Status JSON_CALL JSON_Parser_SetKeyDictionary(JSON_Parser parser, const char* const* ppKeys, size_t keyCount)
+{
+    size_t namesLength = 0;
+    size_t key;
+    DecoderData decoderData;
+    if (!parser || (!ppKeys && keyCount) || GET_FLAGS(parser->state, PARSER_STARTED) ||
+        keyCount > KEY_SEED_IS_SLOT || keyCount > SIZE_MAX / sizeof(size_t) / 2 - 1)
+    {
+        return JSON_Failure;
+    }
+
+    /* Validate all of the keys before discarding the old dictionary. */
+    Decoder_Reset(&decoderData);
+    for (key = 0; key < keyCount; key++)
+    {
+        const byte* pBytes = (const byte*)ppKeys[key];
+        size_t i;
+        if (!pBytes)
         {
-            /* Allow JSON_Parser_FlushLexer() to fail. */
+            return JSON_Failure;
         }
-        else
+        for (i = 0; pBytes[i]; i++)
         {
-            if (c != '\\')
+            DecoderResultCode result = DECODER_RESULT_CODE(Decoder_ProcessByte(&decoderData, JSON_UTF8, pBytes[i]));
+            if (result != SEQUENCE_PENDING && result != SEQUENCE_COMPLETE)
             {
-                /* The current codepoint location is the first character after
-                   the leading surrogate hex escape sequence. The error
-                   location should be the beginning of the leading surrogate
-                   hex escape sequence, 6 characters earlier. */
-                JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 6);
                 return JSON_Failure;
             }
-            parser->lexerState = LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_U;
         }
-        goto advance;
-
-    case LEXING_STRING_TRAILING_SURROGATE_HEX_ESCAPE_U:
-        if (c == EOF_CODEPOINT)
+        if (Decoder_SequencePending(&decoderData) || namesLength + i < namesLength)
         {
-            /* Allow JSON_Parser_FlushLexer() to fail. */
+            return JSON_Failure;
         }
-        else
+        namesLength += i;
+    }
+    JSON_Parser_FreeKeyDictionary(parser);
+    if (!keyCount)
+    {
+        return JSON_Success;
+    }
+    parser->pKeyNames = (byte*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, namesLength ? namesLength : 1);
+    parser->pKeyNameOffsets = (size_t*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, (keyCount * 2 + 1) * sizeof(size_t));
+    parser->pKeySeeds = (uint32_t*)parser->memorySuite.realloc(parser->memorySuite.userData, NULL, keyCount * sizeof(uint32_t));
+    parser->keyCount = keyCount;
+    if (!parser->pKeyNames || !parser->pKeyNameOffsets || !parser->pKeySeeds)
+    {
+        JSON_Parser_FreeKeyDictionary(parser);
+        return JSON_Failure;
+    }
+    parser->pKeySlots = parser->pKeyNameOffsets + keyCount + 1;
+    namesLength = 0;
+    for (key = 0; key < keyCount; key++)
+    {
+        size_t length = strlen(ppKeys[key]);
+        parser->pKeyNameOffsets[key] = namesLength;
+        memcpy(parser->pKeyNames + namesLength, ppKeys[key], length);
+        namesLength += length;
+    }
+    parser->pKeyNameOffsets[keyCount] = namesLength;
+    if ((parser->stringEncoding != JSON_UTF8 && !JSON_Parser_EncodeKeyNames(parser, (Encoding)parser->stringEncoding)) ||
+        !JSON_Parser_PlaceKeys(parser))
+    {
+        JSON_Parser_FreeKeyDictionary(parser);
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_GetMemberKeyIndex(JSON_Parser parser, size_t* pIndex)
+{
+    if (!parser || !pIndex || !GET_FLAGS(parser->state, PARSER_IN_MEMBER_HANDLER))
+    {
+        return JSON_Failure;
+    }
+    *pIndex = parser->memberKeyIndex;
+    return JSON_Success;
+}
+
+static void JSON_Parser_StartPulling(JSON_Parser parser)
+{
+    if (!GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        /* The settings cannot change once parsing has started. */
+        JSON_Parser_InitLexerClasses(parser);
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_STARTED | PARSER_PULLING);
+    }
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetInput(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal)
+{
+    if (!parser || (!pBytes && length) ||
+        GET_FLAGS(parser->state, PARSER_FINISHED | PARSER_IN_PROTECTED_API | PARSER_INPUT_PENDING | PARSER_FINAL_INPUT) ||
+        (GET_FLAGS(parser->state, PARSER_STARTED) && !GET_FLAGS(parser->state, PARSER_PULLING)))
+    {
+        return JSON_Failure;
+    }
+    JSON_Parser_StartPulling(parser);
+    parser->pPullInputBytes = (const byte*)pBytes;
+    parser->pullInputLength = length;
+    parser->pullInputUsed = 0;
+    SET_FLAGS_ON(ParserState, parser->state, PARSER_INPUT_PENDING);
+    if (isFinal)
+    {
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_FINAL_INPUT);
+    }
+    return JSON_Success;
+}
+
+JSON_Status JSON_CALL JSON_Parser_NextEvent(JSON_Parser parser, JSON_Event* pEvent)
+{
+    JSON_Status status = JSON_Failure;
+    if (parser && pEvent && !GET_FLAGS(parser->state, PARSER_IN_PROTECTED_API) &&
+        (GET_FLAGS(parser->state, PARSER_PULLING) || !GET_FLAGS(parser->state, PARSER_STARTED)))
+    {
+        JSON_Parser_StartPulling(parser);
+        SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_PROTECTED_API);
+        for (;;)
         {
-            if (c != 'u')
+            size_t processedLength = 0;
+            int processed;
+
+            /* Queued events are always returned before an error is reported,
+               since they precede it in the input. */
+            if (parser->eventsReturned < parser->eventsQueued)
             {
-                /* Distinguish between a totally bogus escape sequence
-                   and a valid one that just isn't the hex escape kind
-                   that we require for a trailing surrogate. The current
-                   codepoint location is the first character after the
-                   backslash that should have introduced the trailing
-                   surrogate hex escape sequence. */
-                if (c == '"' || c == '\\' || c == '/' || c == 'b' ||
-                    c == 't' || c == 'n' || c == 'f' || c == 'r')
+                *pEvent = parser->events[parser->eventsReturned];
+                parser->eventsReturned++;
+                status = JSON_Success;
+                break;
+            }
+            parser->eventsQueued = 0;
+            parser->eventsReturned = 0;
+            if (GET_FLAGS(parser->state, PARSER_FINISHED))
+            {
+                if (parser->error == JSON_Error_None)
                 {
-                    /* The error location should be at that beginning of the
-                       leading surrogate's hex escape sequence, 7 characters
-                       earlier. */
-                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_UnpairedSurrogateEscapeSequence, 7);
+                    InitEvent(pEvent, JSON_EndOfDocumentEvent);
+                    status = JSON_Success;
                 }
-                else
+                break;
+            }
+
+            /* Process input until an event is queued or the input is used
+               up. Bytes that were saved while detecting the input encoding
+               come before any remaining input. */
+            SET_FLAGS_OFF(ParserState, parser->state, PARSER_SUSPENDED);
+            if (parser->replayUsed < parser->replayLength)
+            {
+                processed = JSON_Parser_ProcessInputBytes(parser, parser->replayBytes + parser->replayUsed,
+                                                          parser->replayLength - parser->replayUsed, &processedLength);
+                parser->replayUsed += processedLength;
+                if (processed && parser->replayUsed == parser->replayLength && parser->pInputTokenBytes)
                 {
-                    /* The error location should be at that backslash, 1
-                       character earlier. */
-                    JSON_Parser_SetErrorAtStringEscapeSequenceStart(parser, JSON_Error_InvalidEscapeSequence, 1);
+                    /* A pending string cannot continue to refer to the
+                       replayed bytes, since they do not precede the input. */
+                    processed = JSON_Parser_CopyInputTokenBytes(parser);
                 }
-                return JSON_Failure;
             }
-            parser->lexerState = LEXING_STRING_HEX_ESCAPE_BYTE_5;
+            else if (parser->pullInputUsed < parser->pullInputLength)
+            {
+                processed = JSON_Parser_ProcessInputBytes(parser, parser->pPullInputBytes + parser->pullInputUsed,
+                                                          parser->pullInputLength - parser->pullInputUsed, &processedLength);
+                parser->pullInputUsed += processedLength;
+            }
+            else if (!GET_FLAGS(parser->state, PARSER_FINAL_INPUT))
+            {
+                /* Note that a pending string cannot continue to refer to the
+                   input once the client has been asked for more. */
+                if (!parser->pInputTokenBytes || JSON_Parser_CopyInputTokenBytes(parser))
+                {
+                    SET_FLAGS_OFF(ParserState, parser->state, PARSER_INPUT_PENDING);
+                    parser->pPullInputBytes = NULL;
+                    parser->pullInputLength = 0;
+                    parser->pullInputUsed = 0;
+                    InitEvent(pEvent, JSON_NeedMoreInputEvent);
+                    status = JSON_Success;
+                    break;
+                }
+                processed = 0;
+            }
+            else
+            {
+                /* Make sure there is nothing pending in the decoder, lexer,
+                   or parser. If the decoder is holding bytes that it used to
+                   detect the input encoding, they are processed first. */
+                processed = JSON_Parser_FlushDecoder(parser);
+                if (processed && parser->replayUsed < parser->replayLength)
+                {
+                    continue;
+                }
+                processed = processed && JSON_Parser_FlushLexer(parser) && JSON_Parser_FlushParser(parser);
+                SET_FLAGS_ON(ParserState, parser->state, PARSER_FINISHED);
+            }
+            if (!processed)
+            {
+                SET_FLAGS_ON(ParserState, parser->state, PARSER_FINISHED);
+            }
         }
-        goto advance;
+        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_PROTECTED_API);
+    }
+    return status;
+}
+
+JSON_Parser_EventBatchHandler JSON_CALL JSON_Parser_GetEventBatchHandler(JSON_Parser parser)
+{
+    return parser ? parser->eventBatchHandler : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetEventBatchHandler(JSON_Parser parser, JSON_Parser_EventBatchHandler handler)
+{
+    if (!parser)
+    {
+        return JSON_Failure;
+    }
+    parser->eventBatchHandler = handler;
+    return JSON_Success;
+}
+
+size_t JSON_CALL JSON_Parser_GetEventBatchBufferSize(JSON_Parser parser)
+{
+    return parser ? parser->batchEventsLength : 0;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetEventBatchBuffer(JSON_Parser parser, JSON_BatchedEvent* pEvents, size_t size)
+{
+    if (!parser || (!pEvents && size) || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    parser->pBatchEvents = size ? pEvents : NULL;
+    parser->batchEventsLength = size;
+    return JSON_Success;
+}
+
+JSON_Document JSON_CALL JSON_Parser_GetDocument(JSON_Parser parser)
+{
+    return parser ? parser->pDocument : NULL;
+}
+
+JSON_Status JSON_CALL JSON_Parser_SetDocument(JSON_Parser parser, JSON_Document document)
+{
+    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    if (document)
+    {
+        document->tapeUsed = 0;
+        document->bytesUsed = 0;
+        document->openContainersUsed = 0;
+        document->isComplete = 0;
+    }
+    parser->pDocument = document;
+    return JSON_Success;
+}
+
+/******************** JSON Parallel Lines ********************/
+
+/* Minimal wrappers around the platform's threads and mutexes. When the
+   library is built without threads, the mutex operations do nothing and
+   all batches are parsed on the calling thread. */
+#if defined(JSON_NO_THREADS)
+
+typedef int Mutex;
+#define Mutex_Init(pMutex)    (*(pMutex) = 0, 1)
+#define Mutex_Destroy(pMutex) ((void)(pMutex))
+#define Mutex_Lock(pMutex)    ((void)(pMutex))
+#define Mutex_Unlock(pMutex)  ((void)(pMutex))
+
+#elif defined(_WIN32)
+
+typedef HANDLE Thread;
+typedef CRITICAL_SECTION Mutex;
+#define Mutex_Init(pMutex)    (InitializeCriticalSection(pMutex), 1)
+#define Mutex_Destroy(pMutex) DeleteCriticalSection(pMutex)
+#define Mutex_Lock(pMutex)    EnterCriticalSection(pMutex)
+#define Mutex_Unlock(pMutex)  LeaveCriticalSection(pMutex)
+
+#else
+
+typedef pthread_t Thread;
+typedef pthread_mutex_t Mutex;
+#define Mutex_Init(pMutex)    (pthread_mutex_init((pMutex), NULL) == 0)
+#define Mutex_Destroy(pMutex) pthread_mutex_destroy(pMutex)
+#define Mutex_Lock(pMutex)    pthread_mutex_lock(pMutex)
+#define Mutex_Unlock(pMutex)  pthread_mutex_unlock(pMutex)
 
-    case LEXING_NUMBER_AFTER_MINUS:
-        if (c == EOF_CODEPOINT)
-        {
-            /* Allow JSON_Parser_FlushLexer() to fail. */
-        }
-        else if (c == 'I' && GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS))
+#endif
+
+/* Combinable parallel lines state flags. */
+#define PARALLEL_RESET              0x0
+#define PARALLEL_IN_PROTECTED_API   0x1
+#define PARALLEL_HAS_ERROR_LOCATION 0x2 /* the array scan found an error */
+typedef byte ParallelState;
+
+#define DEFAULT_LINE_BATCH_SIZE  1048576
+#define DEFAULT_LINE_BATCH_COUNT 16
+#define NO_ELEMENT_BOUNDARY      ((size_t)-1)
+
+typedef struct tag_ParallelBatch
+{
+    JSON_LineBatch batch;
+    size_t         lineCount;    /* line breaks in the batch */
+    size_t         elementCount; /* array elements in the batch */
+    size_t         errorElement; /* relative to the batch's first element */
+    int            isFinished;   /* protected by the mutex */
+} ParallelBatch;
+
+/* The state of a scan for the boundaries between the elements of an
+   array. The depth is the number of containers that are open, and is
+   relative to the start of the scan when the scan starts at an unknown
+   depth. */
+typedef struct tag_ArrayScan
+{
+    byte      inString;
+    byte      isEscaped;
+    ptrdiff_t depth;
+    ptrdiff_t minDepth;
+} ArrayScan;
+
+/* A piece of an array's input, which is scanned independently. */
+typedef struct tag_ArrayPiece
+{
+    size_t    start;
+    size_t    end;
+    ArrayScan scans[2];       /* assuming the piece starts outside ([0]) or inside ([1]) a string */
+    byte      startsInString; /* the actual state at the start of the piece */
+    ptrdiff_t startDepth;
+    size_t    boundary;       /* the first comma in the piece that separates two elements */
+} ArrayPiece;
+
+typedef void (*ParallelTask)(JSON_ParallelLines lines, JSON_Parser* pParser, size_t index);
+
+struct JSON_ParallelLines_Data
+{
+    JSON_MemorySuite                     memorySuite;
+    void*                                userData;
+    ParallelState                        state;
+    JSON_Error                           error;
+    JSON_Location                        errorLocation;
+    size_t                               threadCount;
+    size_t                               batchSize;
+    JSON_ParallelLines_BatchStartHandler batchStartHandler;
+    JSON_ParallelLines_BatchEndHandler   batchEndHandler;
+    ParallelBatch*                       pBatches;
+    size_t                               batchesLength;
+    size_t                               batchCount;
+    ArrayPiece*                          pPieces;
+    size_t                               piecesLength;
+    size_t                               pieceCount;
+    const byte*                          pInput;
+    size_t                               arrayEnd; /* offset of the bracket that closes the array */
+    int                                  isArray;
+
+    /* The remaining members are shared by the worker threads. The mutex
+       protects the counters and flags; a task that has been claimed is
+       only touched by the thread that claimed it until it is finished, and
+       only one thread at a time delivers finished batches, so the line and
+       element counts do not need the mutex. */
+    Mutex                                mutex;
+    ParallelTask                         task;
+    size_t                               taskCount;
+    size_t                               nextTask;     /* next task to claim */
+    size_t                               nextDelivery; /* next batch to pass to the batch end handler */
+    size_t                               nextLine;
+    size_t                               nextElement;
+    int                                  isDelivering;
+    int                                  isAborted;
+};
+
+static size_t CountLineBreaks(const char* pBytes, size_t length)
+{
+    /* Line breaks are counted the same way as JSON_Parser_BreakLine()
+       counts them. */
+    size_t count = 0;
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        if (pBytes[i] == '\r' || (pBytes[i] == '\n' && (!i || pBytes[i - 1] != '\r')))
         {
-            parser->token = T_NEGATIVE_INFINITY; /* changing horses mid-stream, so to speak */
-            parser->lexerBits = INFINITY_LITERAL_EXPECTED_CHARS_START_INDEX;
-            parser->lexerState = LEXING_LITERAL;
+            count++;
         }
-        else
+    }
+    return count;
+}
+
+static int IsWhitespaceByte(byte b)
+{
+    return b == ' ' || b == '\t' || b == '\r' || b == '\n';
+}
+
+static void ArrayScan_Scan(ArrayScan* pScan, const byte* pBytes, size_t length)
+{
+    /* This only looks at the bytes that can change whether the scan is
+       inside a string or how deeply nested it is; a backslash is only an
+       escape inside a string. */
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        byte b = pBytes[i];
+        if (pScan->inString)
         {
-            if (c == '0')
-            {
-                codepointToRecord = '0';
-                parser->lexerState = LEXING_NUMBER_AFTER_LEADING_NEGATIVE_ZERO;
-                goto recordNumberCodepointAndAdvance;
-            }
-            else if (c >= '1' && c <= '9')
+            if (pScan->isEscaped)
             {
-                codepointToRecord = c;
-                parser->lexerState = LEXING_NUMBER_DECIMAL_DIGITS;
-                goto recordNumberCodepointAndAdvance;
+                pScan->isEscaped = 0;
             }
-            else
+            else if (b == '\\')
             {
-                /* We trigger an unknown token error rather than an invalid number
-                   error so that "Foo" and "-Foo" trigger the same error. */
-                JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
-                return JSON_Failure;
+                pScan->isEscaped = 1;
             }
-        }
-        goto advance;
-
-    case LEXING_NUMBER_AFTER_LEADING_ZERO:
-    case LEXING_NUMBER_AFTER_LEADING_NEGATIVE_ZERO:
-        if (c == '.')
-        {
-            codepointToRecord = '.';
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsDecimalPoint);
-            parser->lexerState = LEXING_NUMBER_AFTER_DOT;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c == 'e' || c == 'E')
-        {
-            codepointToRecord = c;
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsExponent);
-            parser->lexerState = LEXING_NUMBER_AFTER_E;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c >= '0' && c <= '9')
-        {
-            /* JSON does not allow the integer part of a number to have any
-               digits after a leading zero. */
-            if (!JSON_Parser_HandleInvalidNumber(parser, c, 0, 0))
+            else if (b == '"')
             {
-                return JSON_Failure;
+                pScan->inString = 0;
             }
         }
-        else if ((c == 'x' || c == 'X') &&
-                 parser->lexerState == LEXING_NUMBER_AFTER_LEADING_ZERO &&
-                 GET_FLAGS(parser->flags, PARSER_ALLOW_HEX_NUMBERS))
-        {
-            codepointToRecord = c;
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_IsHex);
-            parser->lexerState = LEXING_NUMBER_AFTER_X;
-            goto recordNumberCodepointAndAdvance;
-        }
         else
         {
-            /* The number is finished. */
-            if (!JSON_Parser_ProcessToken(parser))
+            switch (b)
             {
-                return JSON_Failure;
-            }
-            goto reprocess;
-        }
-        goto advance;
+            case '"':
+                pScan->inString = 1;
+                break;
 
-    case LEXING_NUMBER_AFTER_X:
-        if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
-        {
-            codepointToRecord = c;
-            parser->lexerState = LEXING_NUMBER_HEX_DIGITS;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (!JSON_Parser_HandleInvalidNumber(parser, c, 1, JSON_IsHex))
-        {
-            return JSON_Failure;
-        }
-        goto advance;
+            case '[':
+            case '{':
+                pScan->depth++;
+                break;
 
-    case LEXING_NUMBER_HEX_DIGITS:
-        if ((c >= '0' && c <= '9') || (c >= 'A' && c <= 'F') || (c >= 'a' && c <= 'f'))
-        {
-            codepointToRecord = c;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else
-        {
-            /* The number is finished. */
-            if (!JSON_Parser_ProcessToken(parser))
-            {
-                return JSON_Failure;
+            case ']':
+            case '}':
+                pScan->depth--;
+                if (pScan->depth < pScan->minDepth)
+                {
+                    pScan->minDepth = pScan->depth;
+                }
+                break;
+
+            default:
+                break;
             }
-            goto reprocess;
         }
-        goto advance;
+    }
+}
 
-    case LEXING_NUMBER_DECIMAL_DIGITS:
-        if (c >= '0' && c <= '9')
-        {
-            codepointToRecord = c;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c == '.')
-        {
-            codepointToRecord = '.';
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsDecimalPoint);
-            parser->lexerState = LEXING_NUMBER_AFTER_DOT;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c == 'e' || c == 'E')
-        {
-            codepointToRecord = c;
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsExponent);
-            parser->lexerState = LEXING_NUMBER_AFTER_E;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else
+static size_t ArrayScan_FindElementEnd(ArrayScan* pScan, const byte* pBytes, size_t length)
+{
+    /* Starting from a known state, find the first comma that separates two
+       elements of the array, or the bracket that closes the array. Return
+       its offset, or length if neither is found. */
+    size_t i;
+    for (i = 0; i < length; i++)
+    {
+        byte b = pBytes[i];
+        if (pScan->inString)
         {
-            /* The number is finished. */
-            if (!JSON_Parser_ProcessToken(parser))
+            if (pScan->isEscaped)
             {
-                return JSON_Failure;
+                pScan->isEscaped = 0;
+            }
+            else if (b == '\\')
+            {
+                pScan->isEscaped = 1;
+            }
+            else if (b == '"')
+            {
+                pScan->inString = 0;
             }
-            goto reprocess;
-        }
-        goto advance;
-
-    case LEXING_NUMBER_AFTER_DOT:
-        if (c >= '0' && c <= '9')
-        {
-            codepointToRecord = c;
-            parser->lexerState = LEXING_NUMBER_FRACTIONAL_DIGITS;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (!JSON_Parser_HandleInvalidNumber(parser, c, 1, JSON_ContainsDecimalPoint))
-        {
-            return JSON_Failure;
-        }
-        goto advance;
-
-    case LEXING_NUMBER_FRACTIONAL_DIGITS:
-        if (c >= '0' && c <= '9')
-        {
-            codepointToRecord = c;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c == 'e' || c == 'E')
-        {
-            codepointToRecord = c;
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsExponent);
-            parser->lexerState = LEXING_NUMBER_AFTER_E;
-            goto recordNumberCodepointAndAdvance;
         }
         else
         {
-            /* The number is finished. */
-            if (!JSON_Parser_ProcessToken(parser))
+            switch (b)
             {
-                return JSON_Failure;
+            case '"':
+                pScan->inString = 1;
+                break;
+
+            case '[':
+            case '{':
+                pScan->depth++;
+                break;
+
+            case ']':
+            case '}':
+                if (!--pScan->depth)
+                {
+                    return i;
+                }
+                break;
+
+            case ',':
+                if (pScan->depth == 1)
+                {
+                    return i;
+                }
+                break;
+
+            default:
+                break;
             }
-            goto reprocess;
         }
-        goto advance;
+    }
+    return length;
+}
 
-    case LEXING_NUMBER_AFTER_E:
-        if (c == '+')
-        {
-            codepointToRecord = c;
-            parser->lexerState = LEXING_NUMBER_AFTER_EXPONENT_SIGN;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c == '-')
-        {
-            codepointToRecord = c;
-            SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNegativeExponent);
-            parser->lexerState = LEXING_NUMBER_AFTER_EXPONENT_SIGN;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (c >= '0' && c <= '9')
-        {
-            codepointToRecord = c;
-            parser->lexerState = LEXING_NUMBER_EXPONENT_DIGITS;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (!JSON_Parser_HandleInvalidNumber(parser, c, 1, JSON_ContainsExponent))
-        {
-            return JSON_Failure;
-        }
-        goto advance;
+static size_t CountArrayElements(const byte* pBytes, size_t length)
+{
+    /* A batch begins outside any string, directly inside the array, and
+       never contains the bracket that closes the array. */
+    ArrayScan scan = { 0, 0, 1, 1 };
+    size_t count = 1;
+    size_t i = ArrayScan_FindElementEnd(&scan, pBytes, length);
+    while (i < length)
+    {
+        count++;
+        i++;
+        i += ArrayScan_FindElementEnd(&scan, pBytes + i, length - i);
+    }
+    return count;
+}
 
-    case LEXING_NUMBER_AFTER_EXPONENT_SIGN:
-        if (c >= '0' && c <= '9')
-        {
-            codepointToRecord = c;
-            parser->lexerState = LEXING_NUMBER_EXPONENT_DIGITS;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else if (!JSON_Parser_HandleInvalidNumber(parser, c, 2, JSON_ContainsExponent | JSON_ContainsNegativeExponent))
+static JSON_Status JSON_ParallelLines_AddBatch(JSON_ParallelLines lines, const char* pBytes, size_t start, size_t end)
+{
+    ParallelBatch* pBatch;
+    if (lines->batchCount == lines->batchesLength)
+    {
+        size_t newLength = lines->batchesLength ? lines->batchesLength * 2 : DEFAULT_LINE_BATCH_COUNT;
+        ParallelBatch* pNewBatches = (ParallelBatch*)lines->memorySuite.realloc(lines->memorySuite.userData, lines->pBatches, newLength * sizeof(ParallelBatch));
+        if (!pNewBatches)
         {
             return JSON_Failure;
         }
-        goto advance;
+        lines->pBatches = pNewBatches;
+        lines->batchesLength = newLength;
+    }
+    pBatch = &lines->pBatches[lines->batchCount];
+    pBatch->batch.index = lines->batchCount;
+    pBatch->batch.pBytes = pBytes + start;
+    pBatch->batch.length = end - start;
+    pBatch->batch.byte = start;
+    pBatch->batch.line = 0;
+    pBatch->batch.element = 0;
+    pBatch->batch.userData = NULL;
+    pBatch->batch.error = JSON_Error_None;
+    pBatch->batch.errorLocation.byte = 0;
+    pBatch->batch.errorLocation.line = 0;
+    pBatch->batch.errorLocation.column = 0;
+    pBatch->batch.errorLocation.depth = 0;
+    pBatch->batch.errorElement = 0;
+    pBatch->lineCount = 0;
+    pBatch->elementCount = 0;
+    pBatch->errorElement = 0;
+    pBatch->isFinished = 0;
+    lines->batchCount++;
+    return JSON_Success;
+}
 
-    case LEXING_NUMBER_EXPONENT_DIGITS:
-        if (c >= '0' && c <= '9')
-        {
-            codepointToRecord = c;
-            goto recordNumberCodepointAndAdvance;
-        }
-        else
+static JSON_Status JSON_ParallelLines_DivideInput(JSON_ParallelLines lines, const char* pBytes, size_t length)
+{
+    size_t offset = 0;
+    lines->batchCount = 0;
+    while (offset < length)
+    {
+        size_t end = length;
+        if (length - offset > lines->batchSize)
         {
-            /* The number is finished. */
-            if (!JSON_Parser_ProcessToken(parser))
+            /* A batch ends after a line break of any kind, but never
+               between the CR and LF of a CRLF line break, which would
+               be counted as two line breaks. */
+            size_t i = offset + lines->batchSize - 1;
+            while (i < length && pBytes[i] != '\n' && pBytes[i] != '\r')
             {
-                return JSON_Failure;
+                i++;
+            }
+            if (i < length)
+            {
+                end = (pBytes[i] == '\r' && i + 1 < length && pBytes[i + 1] == '\n') ? i + 2 : i + 1;
             }
-            goto reprocess;
-        }
-        goto advance;
-
-    case LEXING_COMMENT_AFTER_SLASH:
-        if (c == '/')
-        {
-            parser->lexerState = LEXING_SINGLE_LINE_COMMENT;
-        }
-        else if (c == '*')
-        {
-            parser->lexerState = LEXING_MULTI_LINE_COMMENT;
         }
-        else
+        if (!JSON_ParallelLines_AddBatch(lines, pBytes, offset, end))
         {
-            JSON_Parser_SetErrorAtToken(parser, JSON_Error_UnknownToken);
+            lines->error = JSON_Error_OutOfMemory;
             return JSON_Failure;
         }
-        goto advance;
-
-    case LEXING_SINGLE_LINE_COMMENT:
-        if (c == CARRIAGE_RETURN_CODEPOINT || c == LINE_FEED_CODEPOINT || c == EOF_CODEPOINT)
-        {
-            parser->lexerState = LEXING_WHITESPACE;
-        }
-        goto advance;
-
-    case LEXING_MULTI_LINE_COMMENT:
-        if (c == '*')
-        {
-            parser->lexerState = LEXING_MULTI_LINE_COMMENT_AFTER_STAR;
-        }
-        goto advance;
-
-    case LEXING_MULTI_LINE_COMMENT_AFTER_STAR:
-        if (c == '/')
-        {
-            parser->lexerState = LEXING_WHITESPACE;
-        }
-        else if (c != '*')
-        {
-            parser->lexerState = LEXING_MULTI_LINE_COMMENT;
-        }
-        goto advance;
+        offset = end;
     }
+    return JSON_Success;
+}
 
-recordStringCodepointAndAdvance:
-
-    tokenEncoding = parser->stringEncoding;
-    maxTokenLength = parser->maxStringLength;
-    if (!codepointToRecord)
-    {
-        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNullCharacter | JSON_ContainsControlCharacter);
-    }
-    else if (codepointToRecord < FIRST_NON_CONTROL_CODEPOINT)
+static void JSON_ParallelLines_ParseBatch(JSON_ParallelLines lines, JSON_Parser* pParser, ParallelBatch* pBatch)
+{
+    /* Each worker thread creates its parser the first time it claims a
+       batch, and resets it for each subsequent batch, which keeps the
+       parser's buffers. */
+    JSON_LineBatch* pLineBatch = &pBatch->batch;
+    JSON_Parser parser = *pParser;
+    if (parser)
     {
-        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsControlCharacter);
+        JSON_Parser_Reset(parser);
     }
-    else if (codepointToRecord >= FIRST_NON_BMP_CODEPOINT)
+    else
     {
-        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNonASCIICharacter | JSON_ContainsNonBMPCharacter);
+        parser = *pParser = JSON_Parser_Create(&lines->memorySuite);
+        if (!parser)
+        {
+            pLineBatch->error = JSON_Error_OutOfMemory;
+        }
     }
-    else if (codepointToRecord >= FIRST_NON_ASCII_CODEPOINT)
+    if (parser)
     {
-        SET_FLAGS_ON(TokenAttributes, parser->tokenAttributes, JSON_ContainsNonASCIICharacter);
+        JSON_Parser_SetInputEncoding(parser, JSON_UTF8);
+        JSON_Parser_SetAllowMultipleDocuments(parser, JSON_True);
+        if (lines->isArray)
+        {
+            SET_FLAGS_ON(ParserFlags, parser->flags, PARSER_ARRAY_ELEMENTS);
+        }
+        else
+        {
+            JSON_Parser_SetSkipInvalidDocuments(parser, JSON_True);
+        }
+        if (lines->batchStartHandler && lines->batchStartHandler(lines, parser, pLineBatch) != JSON_Parser_Continue)
+        {
+            pLineBatch->error = JSON_Error_AbortedByHandler;
+        }
+        else if (!JSON_Parser_Parse(parser, pLineBatch->pBytes, pLineBatch->length, JSON_True))
+        {
+            pLineBatch->error = (JSON_Error)parser->error;
+            JSON_Parser_GetErrorLocation(parser, &pLineBatch->errorLocation);
+        }
+        pLineBatch->userData = parser->userData;
     }
-    goto recordCodepointAndAdvance;
-
-recordNumberCodepointAndAdvance:
 
-    tokenEncoding = parser->numberEncoding;
-    maxTokenLength = parser->maxNumberLength;
-    goto recordCodepointAndAdvance;
-
-recordCodepointAndAdvance:
-
-    /* We always ensure that there are LONGEST_ENCODING_SEQUENCE bytes
-       available in the buffer for the next codepoint, so we don't have to
-       check whether there is room when we decode a new codepoint, and if
-       there isn't another codepoint, we have space already allocated for
-       the encoded null terminator.*/
-    parser->tokenBytesUsed += EncodeCodepoint(codepointToRecord, tokenEncoding, parser->pTokenBytes + parser->tokenBytesUsed);
-    if (parser->tokenBytesUsed > maxTokenLength)
+    /* The parser has already counted the line breaks and elements in a
+       batch that it parsed completely. */
+    if (pLineBatch->error == JSON_Error_None)
     {
-        JSON_Parser_SetErrorAtToken(parser, parser->token == T_NUMBER ? JSON_Error_TooLongNumber : JSON_Error_TooLongString);
-        return JSON_Failure;
+        pBatch->lineCount = parser->codepointLocationLine;
+        pBatch->elementCount = lines->isArray ? parser->arrayElementIndex + 1 : 0;
     }
-    if (parser->tokenBytesUsed > parser->tokenBytesLength - LONGEST_ENCODING_SEQUENCE)
+    else
     {
-        byte* pBiggerBuffer = DoubleBuffer(&parser->memorySuite, parser->defaultTokenBytes, parser->pTokenBytes, parser->tokenBytesLength);
-        if (!pBiggerBuffer)
+        pBatch->lineCount = CountLineBreaks(pLineBatch->pBytes, pLineBatch->length);
+        if (lines->isArray)
         {
-            JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_OutOfMemory);
-            return JSON_Failure;
+            pBatch->elementCount = CountArrayElements((const byte*)pLineBatch->pBytes, pLineBatch->length);
+            pBatch->errorElement = parser ? parser->arrayElementIndex : 0;
         }
-        parser->pTokenBytes = pBiggerBuffer;
-        parser->tokenBytesLength *= 2;
     }
-    goto advance;
-
-advance:
+}
 
-    /* The current codepoint has been accepted, so advance the codepoint
-       location counters accordingly. Note that the one time we don't
-       do this is when the codepoint is EOF, which doesn't actually
-       appear in the input stream. */
-    if (c == CARRIAGE_RETURN_CODEPOINT)
+static void JSON_ParallelLines_DeliverBatches(JSON_ParallelLines lines)
+{
+    /* This is called with the mutex locked by a thread that has just
+       finished a batch. If no other thread is delivering batches, it
+       passes every finished batch that is next in input order to the batch
+       end handler, releasing the mutex while the handler runs. A batch
+       that finishes while the handler runs is picked up by the loop, or,
+       if the loop has already ended, by the thread that finished it. */
+    if (lines->isDelivering)
     {
-        SET_FLAGS_ON(ParserState, parser->state, PARSER_AFTER_CARRIAGE_RETURN);
+        return;
     }
-    if (c != EOF_CODEPOINT)
+    lines->isDelivering = 1;
+    while (!lines->isAborted &&
+           lines->nextDelivery < lines->batchCount &&
+           lines->pBatches[lines->nextDelivery].isFinished)
     {
-        parser->codepointLocationByte += encodedLength;
-        if (c == CARRIAGE_RETURN_CODEPOINT || c == LINE_FEED_CODEPOINT)
+        ParallelBatch* pBatch = &lines->pBatches[lines->nextDelivery];
+        JSON_Parser_HandlerResult result = JSON_Parser_Continue;
+        Mutex_Unlock(&lines->mutex);
+        pBatch->batch.line = lines->nextLine;
+        pBatch->batch.element = lines->nextElement;
+        if (pBatch->batch.error != JSON_Error_None)
         {
-            /* The next character will begin a new line. */
-            parser->codepointLocationLine++;
-            parser->codepointLocationColumn = 0;
+            pBatch->batch.errorElement = lines->nextElement + pBatch->errorElement;
         }
-        else
+        lines->nextLine += pBatch->lineCount;
+        lines->nextElement += pBatch->elementCount;
+        if (lines->batchEndHandler)
+        {
+            result = lines->batchEndHandler(lines, &pBatch->batch);
+        }
+        Mutex_Lock(&lines->mutex);
+        lines->nextDelivery++;
+        if (result != JSON_Parser_Continue)
         {
-            /* The next character will be on the same line. */
-            parser->codepointLocationColumn++;
+            lines->isAborted = 1;
         }
     }
+    lines->isDelivering = 0;
+}
 
-    if (tokenFinished && !JSON_Parser_ProcessToken(parser))
-    {
-        return JSON_Failure;
-    }
+static void JSON_ParallelLines_ParseBatchTask(JSON_ParallelLines lines, JSON_Parser* pParser, size_t index)
+{
+    ParallelBatch* pBatch = &lines->pBatches[index];
+    JSON_ParallelLines_ParseBatch(lines, pParser, pBatch);
+    Mutex_Lock(&lines->mutex);
+    pBatch->isFinished = 1;
+    JSON_ParallelLines_DeliverBatches(lines);
+    Mutex_Unlock(&lines->mutex);
+}
 
-    return JSON_Success;
+static void JSON_ParallelLines_ScanPieceTask(JSON_ParallelLines lines, JSON_Parser* pParser, size_t index)
+{
+    /* Scan the piece both ways, since we don't yet know whether it starts
+       inside a string. */
+    ArrayPiece* pPiece = &lines->pPieces[index];
+    const byte* pBytes = lines->pInput + pPiece->start;
+    size_t length = pPiece->end - pPiece->start;
+    (void)pParser; /* unused */
+    pPiece->scans[0].inString = 0;
+    pPiece->scans[1].inString = 1;
+    pPiece->scans[0].isEscaped = pPiece->scans[1].isEscaped = 0;
+    pPiece->scans[0].depth = pPiece->scans[1].depth = 0;
+    pPiece->scans[0].minDepth = pPiece->scans[1].minDepth = 0;
+    ArrayScan_Scan(&pPiece->scans[0], pBytes, length);
+    ArrayScan_Scan(&pPiece->scans[1], pBytes, length);
 }
 
-static JSON_Status JSON_Parser_FlushLexer(JSON_Parser parser)
+static void JSON_ParallelLines_FindBoundaryTask(JSON_ParallelLines lines, JSON_Parser* pParser, size_t index)
 {
-    /* Push the EOF codepoint to the lexer so that it can finish the pending
-       token, if any. The EOF codepoint is never emitted by the decoder
-       itself, since it is outside the Unicode range and therefore cannot
-       be encoded in any of the possible input encodings. */
-    if (!JSON_Parser_ProcessCodepoint(parser, EOF_CODEPOINT, 0))
+    /* Now that the state at the start of the piece is known, find the first
+       comma in the piece that separates two elements. The first piece
+       starts the first batch, so it does not need a boundary. */
+    ArrayPiece* pPiece = &lines->pPieces[index];
+    ArrayScan scan;
+    size_t end = (pPiece->end < lines->arrayEnd) ? pPiece->end : lines->arrayEnd;
+    size_t i;
+    (void)pParser; /* unused */
+    pPiece->boundary = NO_ELEMENT_BOUNDARY;
+    if (index && pPiece->start < end)
     {
-        return JSON_Failure;
+        scan.inString = pPiece->startsInString;
+        scan.isEscaped = 0;
+        scan.depth = pPiece->startDepth;
+        scan.minDepth = pPiece->startDepth;
+        i = pPiece->start + ArrayScan_FindElementEnd(&scan, lines->pInput + pPiece->start, end - pPiece->start);
+        if (i < end && lines->pInput[i] == ',')
+        {
+            pPiece->boundary = i;
+        }
     }
+}
 
-    /* The lexer should be idle when parsing finishes. */
-    if (parser->lexerState != LEXING_WHITESPACE)
+static void JSON_ParallelLines_Work(JSON_ParallelLines lines)
+{
+    /* Each thread, including the one that called the parse function,
+       claims the next unclaimed task until there are none left, so that
+       threads that finish their tasks early take on more of them. */
+    JSON_Parser parser = NULL;
+    for (;;)
     {
-        JSON_Parser_SetErrorAtToken(parser, JSON_Error_IncompleteToken);
-        return JSON_Failure;
+        size_t index;
+        Mutex_Lock(&lines->mutex);
+        if (lines->isAborted || lines->nextTask == lines->taskCount)
+        {
+            Mutex_Unlock(&lines->mutex);
+            break;
+        }
+        index = lines->nextTask++;
+        Mutex_Unlock(&lines->mutex);
+        lines->task(lines, &parser, index);
+    }
+    if (parser)
+    {
+        JSON_Parser_Free(parser);
     }
-    return JSON_Success;
 }
 
-/* Parser's decoder functions. */
+#if !defined(JSON_NO_THREADS)
 
-static JSON_Status JSON_Parser_CallEncodingDetectedHandler(JSON_Parser parser)
+#if defined(_WIN32)
+
+static DWORD WINAPI JSON_ParallelLines_ThreadMain(LPVOID arg)
 {
-    if (parser->encodingDetectedHandler && parser->encodingDetectedHandler(parser) != JSON_Parser_Continue)
-    {
-        JSON_Parser_SetErrorAtCodepoint(parser, JSON_Error_AbortedByHandler);
-        return JSON_Failure;
-    }
-    return JSON_Success;
+    JSON_ParallelLines_Work((JSON_ParallelLines)arg);
+    return 0;
 }
 
-/* Forward declaration. */
-static JSON_Status JSON_Parser_ProcessInputBytes(JSON_Parser parser, const byte* pBytes, size_t length);
+static int Thread_Start(Thread* pThread, JSON_ParallelLines lines)
+{
+    *pThread = CreateThread(NULL, 0, &JSON_ParallelLines_ThreadMain, lines, 0, NULL);
+    return *pThread != NULL;
+}
 
-static JSON_Status JSON_Parser_ProcessUnknownByte(JSON_Parser parser, byte b)
+static void Thread_Join(Thread thread)
 {
-    /* When the input encoding is unknown, the first 4 bytes of input are
-       recorded in decoder.bits. */
+    WaitForSingleObject(thread, INFINITE);
+    CloseHandle(thread);
+}
 
-    byte bytes[LONGEST_ENCODING_SEQUENCE];
-    switch (parser->decoderData.state)
-    {
-    case DECODER_RESET:
-        parser->decoderData.state = DECODED_1_OF_4;
-        parser->decoderData.bits = (uint32_t)b << 24;
-        break;
+static size_t GetProcessorCount(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors ? (size_t)info.dwNumberOfProcessors : 1;
+}
 
-    case DECODED_1_OF_4:
-        parser->decoderData.state = DECODED_2_OF_4;
-        parser->decoderData.bits |= (uint32_t)b << 16;
-        break;
+#else
 
-    case DECODED_2_OF_4:
-        parser->decoderData.state = DECODED_3_OF_4;
-        parser->decoderData.bits |= (uint32_t)b << 8;
-        break;
+static void* JSON_ParallelLines_ThreadMain(void* arg)
+{
+    JSON_ParallelLines_Work((JSON_ParallelLines)arg);
+    return NULL;
+}
 
-    case DECODED_3_OF_4:
-        bytes[0] = (byte)(parser->decoderData.bits >> 24);
-        bytes[1] = (byte)(parser->decoderData.bits >> 16);
-        bytes[2] = (byte)(parser->decoderData.bits >> 8);
-        bytes[3] = (byte)(b);
+static int Thread_Start(Thread* pThread, JSON_ParallelLines lines)
+{
+    return pthread_create(pThread, NULL, &JSON_ParallelLines_ThreadMain, lines) == 0;
+}
 
-        /* We try to match the following patterns in order, where .. is any
-           byte value and nz is any non-zero byte value:
-              EF BB BF .. => UTF-8 with BOM
-              FF FE 00 00 => UTF-32LE with BOM
-              FF FE nz 00 => UTF-16LE with BOM
-              00 00 FE FF -> UTF-32BE with BOM
-              FE FF .. .. => UTF-16BE with BOM
-              nz nz .. .. => UTF-8
-              nz 00 nz .. => UTF-16LE
-              nz 00 00 00 => UTF-32LE
-              00 nz .. .. => UTF-16BE
-              00 00 00 nz => UTF-32BE
-              .. .. .. .. => unknown encoding */
-        if (bytes[0] == 0xEF && bytes[1] == 0xBB && bytes[2] == 0xBF)
-        {
-            /* EF BB BF .. */
-            parser->inputEncoding = JSON_UTF8;
-        }
-        else if (bytes[0] == 0xFF && bytes[1] == 0xFE && bytes[3] == 0x00)
-        {
-            /* FF FE 00 00 or
-               FF FE nz 00 */
-            parser->inputEncoding = (bytes[2] == 0x00) ? JSON_UTF32LE : JSON_UTF16LE;
-        }
-        else if (bytes[0] == 0x00 && bytes[1] == 0x00 && bytes[2] == 0xFE && bytes[3] == 0xFF)
-        {
-            /* 00 00 FE FF */
-            parser->inputEncoding = JSON_UTF32BE;
-        }
-        else if (bytes[0] == 0xFE && bytes[1] == 0xFF)
-        {
-            /* FE FF .. .. */
-            parser->inputEncoding = JSON_UTF16BE;
-        }
-        else if (bytes[0] != 0x00)
+static void Thread_Join(Thread thread)
+{
+    pthread_join(thread, NULL);
+}
+
+static size_t GetProcessorCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (size_t)count : 1;
+}
+
+#endif
+
+static void JSON_ParallelLines_Run(JSON_ParallelLines lines, ParallelTask task, size_t taskCount)
+{
+    /* The calling thread is one of the workers, so only the others need to
+       be started. If a thread cannot be started, the ones that were started
+       share its tasks. */
+    size_t threadCount = lines->threadCount ? lines->threadCount : GetProcessorCount();
+    Thread* pThreads = NULL;
+    size_t started = 0;
+    size_t i;
+    lines->task = task;
+    lines->taskCount = taskCount;
+    lines->nextTask = 0;
+    if (threadCount > taskCount)
+    {
+        threadCount = taskCount;
+    }
+    if (threadCount > 1)
+    {
+        pThreads = (Thread*)lines->memorySuite.realloc(lines->memorySuite.userData, NULL, (threadCount - 1) * sizeof(Thread));
+        if (pThreads)
         {
-            /* nz .. .. .. */
-            if (bytes[1] != 0x00)
-            {
-                /* nz nz .. .. */
-                parser->inputEncoding = JSON_UTF8;
-            }
-            else if (bytes[2] != 0x00)
-            {
-                /* nz 00 nz .. */
-                parser->inputEncoding = JSON_UTF16LE;
-            }
-            else if (bytes[3] == 0x00)
-            {
-                /* nz 00 00 00 */
-                parser->inputEncoding = JSON_UTF32LE;
-            }
-            else
+            while (started < threadCount - 1 && Thread_Start(&pThreads[started], lines))
             {
-                /* nz 00 00 nz => error */
+                started++;
             }
         }
-        else if (bytes[1] != 0x00)
-        {
-            /* 00 nz .. .. */
-            parser->inputEncoding = JSON_UTF16BE;
-        }
-        else if (bytes[2] == 0x00 && bytes[3] != 0x00)
-        {
-            /* 00 00 00 nz */
-            parser->inputEncoding = JSON_UTF32BE;
-        }
-        else
-        {
-            /* 00 00 nz .. or
-               00 00 00 00 => error */
-        }
+    }
+    JSON_ParallelLines_Work(lines);
+    for (i = 0; i < started; i++)
+    {
+        Thread_Join(pThreads[i]);
+    }
+    if (pThreads)
+    {
+        lines->memorySuite.free(lines->memorySuite.userData, pThreads);
+    }
+}
 
-        if (parser->inputEncoding == JSON_UnknownEncoding)
+#else
+
+static void JSON_ParallelLines_Run(JSON_ParallelLines lines, ParallelTask task, size_t taskCount)
+{
+    lines->task = task;
+    lines->taskCount = taskCount;
+    lines->nextTask = 0;
+    JSON_ParallelLines_Work(lines);
+}
+
+#endif
+
+static void JSON_ParallelLines_SetArrayError(JSON_ParallelLines lines, JSON_Error error, size_t offset, ptrdiff_t depth)
+{
+    /* Errors in the structure of the array are rare, so we only work out
+       the line and column when one occurs. */
+    const byte* pBytes = lines->pInput;
+    size_t lineStart = offset;
+    size_t column = 0;
+    size_t i;
+    while (lineStart && pBytes[lineStart - 1] != '\n' && pBytes[lineStart - 1] != '\r')
+    {
+        lineStart--;
+    }
+    for (i = lineStart; i < offset; i++)
+    {
+        if ((pBytes[i] & 0xC0) != 0x80)
         {
-            return JSON_Parser_HandleInvalidEncodingSequence(parser, 4);
+            column++;
         }
+    }
+    lines->error = error;
+    lines->errorLocation.byte = offset;
+    lines->errorLocation.line = CountLineBreaks((const char*)pBytes, offset);
+    lines->errorLocation.column = column;
+    lines->errorLocation.depth = (depth > 0) ? (size_t)depth : 0;
+    SET_FLAGS_ON(ParallelState, lines->state, PARALLEL_HAS_ERROR_LOCATION);
+}
 
-        if (!JSON_Parser_CallEncodingDetectedHandler(parser))
+static JSON_Status JSON_ParallelLines_AddPiece(JSON_ParallelLines lines, size_t start, size_t end)
+{
+    if (lines->pieceCount == lines->piecesLength)
+    {
+        size_t newLength = lines->piecesLength ? lines->piecesLength * 2 : DEFAULT_LINE_BATCH_COUNT;
+        ArrayPiece* pNewPieces = (ArrayPiece*)lines->memorySuite.realloc(lines->memorySuite.userData, lines->pPieces, newLength * sizeof(ArrayPiece));
+        if (!pNewPieces)
         {
             return JSON_Failure;
         }
-
-        /* Reset the decoder before reprocessing the bytes. */
-        Decoder_Reset(&parser->decoderData);
-        return JSON_Parser_ProcessInputBytes(parser, bytes, 4);
+        lines->pPieces = pNewPieces;
+        lines->piecesLength = newLength;
     }
-
-    /* We don't have 4 bytes yet. */
+    lines->pPieces[lines->pieceCount].start = start;
+    lines->pPieces[lines->pieceCount].end = end;
+    lines->pieceCount++;
     return JSON_Success;
 }
 
-JSON_Status JSON_Parser_ProcessInputBytes(JSON_Parser parser, const byte* pBytes, size_t length)
+static JSON_Status JSON_ParallelLines_DivideArray(JSON_ParallelLines lines, const char* pBytes, size_t length)
 {
-    /* Note that if length is 0, pBytes is allowed to be NULL. */
-    size_t i = 0;
-    while (parser->inputEncoding == JSON_UnknownEncoding && i < length)
+    const byte* pInput = (const byte*)pBytes;
+    size_t arrayStart = 0;
+    size_t start;
+    size_t i;
+    ArrayScan scan = { 0, 0, 1, 1 };
+    lines->batchCount = 0;
+    lines->pieceCount = 0;
+    lines->pInput = pInput;
+
+    /* Find the bracket that opens the array. */
+    while (arrayStart < length && IsWhitespaceByte(pInput[arrayStart]))
     {
-        if (!JSON_Parser_ProcessUnknownByte(parser, pBytes[i]))
+        arrayStart++;
+    }
+    if (arrayStart == length)
+    {
+        JSON_ParallelLines_SetArrayError(lines, JSON_Error_ExpectedMoreTokens, length, 0);
+        return JSON_Failure;
+    }
+    if (pInput[arrayStart] != '[')
+    {
+        JSON_ParallelLines_SetArrayError(lines, JSON_Error_UnexpectedToken, arrayStart, 0);
+        return JSON_Failure;
+    }
+    arrayStart++;
+
+    /* Divide the rest of the input into pieces. A piece never starts
+       immediately after a backslash, so the only thing that we need to
+       guess about the state at its start is whether it is inside a
+       string. */
+    start = arrayStart;
+    while (start < length)
+    {
+        size_t end = length;
+        if (length - start > lines->batchSize)
+        {
+            end = start + lines->batchSize;
+            while (end < length && pInput[end - 1] == '\\')
+            {
+                end++;
+            }
+        }
+        if (!JSON_ParallelLines_AddPiece(lines, start, end))
         {
+            lines->error = JSON_Error_OutOfMemory;
             return JSON_Failure;
         }
-        i++;
+        start = end;
     }
-    while (i < length)
+    JSON_ParallelLines_Run(lines, &JSON_ParallelLines_ScanPieceTask, lines->pieceCount);
+
+    /* Chain the pieces together, choosing the scan of each piece that
+       matches the state at the end of the previous one, until we reach the
+       piece in which the array closes. */
+    lines->arrayEnd = length;
+    for (i = 0; i < lines->pieceCount; i++)
     {
-        DecoderOutput output = Decoder_ProcessByte(&parser->decoderData, parser->inputEncoding, pBytes[i]);
-        DecoderResultCode result = DECODER_RESULT_CODE(output);
-        switch (result)
+        ArrayPiece* pPiece = &lines->pPieces[i];
+        const ArrayScan* pPieceScan = &pPiece->scans[scan.inString];
+        pPiece->startsInString = scan.inString;
+        pPiece->startDepth = scan.depth;
+        if (scan.depth + pPieceScan->minDepth <= 0)
         {
-        case SEQUENCE_PENDING:
-            i++;
-            break;
-
-        case SEQUENCE_COMPLETE:
-            if (!JSON_Parser_ProcessCodepoint(parser, DECODER_CODEPOINT(output), DECODER_SEQUENCE_LENGTH(output)))
-            {
-                return JSON_Failure;
-            }
-            i++;
-            break;
-
-        case SEQUENCE_INVALID_INCLUSIVE:
-            i++;
-            /* fallthrough */
-        case SEQUENCE_INVALID_EXCLUSIVE:
-            if (!JSON_Parser_HandleInvalidEncodingSequence(parser, DECODER_SEQUENCE_LENGTH(output)))
+            size_t end = pPiece->start + ArrayScan_FindElementEnd(&scan, pInput + pPiece->start, pPiece->end - pPiece->start);
+            while (end < pPiece->end && pInput[end] == ',')
             {
-                return JSON_Failure;
+                end++;
+                end += ArrayScan_FindElementEnd(&scan, pInput + end, pPiece->end - end);
             }
+            lines->arrayEnd = end;
+            lines->pieceCount = i + 1;
             break;
         }
+        scan.inString = pPieceScan->inString;
+        scan.depth += pPieceScan->depth;
     }
-    return JSON_Success;
-}
-
-static JSON_Status JSON_Parser_FlushDecoder(JSON_Parser parser)
-{
-    /* If the input was 1, 2, or 3 bytes long, and the input encoding was not
-       explicitly specified by the client, we can sometimes make a reasonable
-       guess. If the input was 1 or 3 bytes long, the only encoding that could
-       possibly be valid JSON is UF-8. If the input was 2 bytes long, we try
-       to match the following patterns in order, where .. is any byte value
-       and nz is any non-zero byte value:
-         FF FE => UTF-16LE with BOM
-         FE FF => UTF-16BE with BOM
-         nz nz => UTF-8
-         nz 00 => UTF-16LE
-         00 nz => UTF-16BE
-         .. .. => unknown encoding
-    */
-    if (parser->inputEncoding == JSON_UnknownEncoding &&
-        parser->decoderData.state != DECODER_RESET)
+    if (lines->arrayEnd == length)
     {
-        byte bytes[3];
-        size_t length = 0;
-        bytes[0] = (byte)(parser->decoderData.bits >> 24);
-        bytes[1] = (byte)(parser->decoderData.bits >> 16);
-        bytes[2] = (byte)(parser->decoderData.bits >> 8);
-        switch (parser->decoderData.state)
+        JSON_ParallelLines_SetArrayError(lines, JSON_Error_ExpectedMoreTokens, length, scan.depth);
+        return JSON_Failure;
+    }
+    if (pInput[lines->arrayEnd] != ']')
+    {
+        JSON_ParallelLines_SetArrayError(lines, JSON_Error_UnexpectedToken, lines->arrayEnd, 1);
+        return JSON_Failure;
+    }
+    for (i = lines->arrayEnd + 1; i < length; i++)
+    {
+        if (!IsWhitespaceByte(pInput[i]))
         {
-        case DECODED_1_OF_4:
-            parser->inputEncoding = JSON_UTF8;
-            length = 1;
-            break;
+            JSON_ParallelLines_SetArrayError(lines, JSON_Error_UnexpectedToken, i, 0);
+            return JSON_Failure;
+        }
+    }
 
-        case DECODED_2_OF_4:
-            if (bytes[0] == 0xFF && bytes[1] == 0xFE)
-            {
-                /* FF FE */
-                parser->inputEncoding = JSON_UTF16LE;
-            }
-            else if (bytes[0] == 0xFE && bytes[1] == 0xFF)
-            {
-                /* FE FF */
-                parser->inputEncoding = JSON_UTF16BE;
-            }
-            else if (bytes[0] != 0x00)
-            {
-                /* nz nz or
-                   nz 00 */
-                parser->inputEncoding = bytes[1] ? JSON_UTF8 : JSON_UTF16LE;
-            }
-            else if (bytes[1] != 0x00)
-            {
-                /* 00 nz */
-                parser->inputEncoding = JSON_UTF16BE;
-            }
-            else
+    /* Find the boundaries between batches and divide the elements. An
+       array that contains only whitespace has no elements. */
+    JSON_ParallelLines_Run(lines, &JSON_ParallelLines_FindBoundaryTask, lines->pieceCount);
+    start = arrayStart;
+    for (i = 1; i < lines->pieceCount; i++)
+    {
+        size_t boundary = lines->pPieces[i].boundary;
+        if (boundary != NO_ELEMENT_BOUNDARY)
+        {
+            if (!JSON_ParallelLines_AddBatch(lines, pBytes, start, boundary))
             {
-                /* 00 00 */
-                return JSON_Parser_HandleInvalidEncodingSequence(parser, 2);
+                lines->error = JSON_Error_OutOfMemory;
+                return JSON_Failure;
             }
-            length = 2;
-            break;
-
-        case DECODED_3_OF_4:
-            parser->inputEncoding = JSON_UTF8;
-            length = 3;
-            break;
+            start = boundary + 1;
         }
-
-        if (!JSON_Parser_CallEncodingDetectedHandler(parser))
+    }
+    if (!lines->batchCount)
+    {
+        i = start;
+        while (i < lines->arrayEnd && IsWhitespaceByte(pInput[i]))
         {
-            return JSON_Failure;
+            i++;
         }
-
-        /* Reset the decoder before reprocessing the bytes. */
-        parser->decoderData.state = DECODER_RESET;
-        parser->decoderData.bits = 0;
-        if (!JSON_Parser_ProcessInputBytes(parser, bytes, length))
+        if (i == lines->arrayEnd)
         {
-            return JSON_Failure;
+            return JSON_Success;
         }
     }
+    if (!JSON_ParallelLines_AddBatch(lines, pBytes, start, lines->arrayEnd))
+    {
+        lines->error = JSON_Error_OutOfMemory;
+        return JSON_Failure;
+    }
+    return JSON_Success;
+}
 
-    /* The decoder should be idle when parsing finishes. */
-    if (Decoder_SequencePending(&parser->decoderData))
+static JSON_Status JSON_ParallelLines_ParseBatches(JSON_ParallelLines lines)
+{
+    lines->nextDelivery = 0;
+    lines->nextLine = 0;
+    lines->nextElement = 0;
+    lines->isDelivering = 0;
+    JSON_ParallelLines_Run(lines, &JSON_ParallelLines_ParseBatchTask, lines->batchCount);
+    if (lines->isAborted)
     {
-        return JSON_Parser_HandleInvalidEncodingSequence(parser, DECODER_STATE_BYTES(parser->decoderData.state));
+        lines->error = JSON_Error_AbortedByHandler;
+        return JSON_Failure;
     }
     return JSON_Success;
 }
 
-/* Parser API functions. */
+/* Parallel lines API functions. */
 
-JSON_Parser JSON_CALL JSON_Parser_Create(const JSON_MemorySuite* pMemorySuite)
+JSON_ParallelLines JSON_CALL JSON_ParallelLines_Create(const JSON_MemorySuite* pMemorySuite)
 {
-    JSON_Parser parser;
+    JSON_ParallelLines lines;
     JSON_MemorySuite memorySuite;
     if (pMemorySuite)
     {
@@ -2655,530 +7938,965 @@ JSON_Parser JSON_CALL JSON_Parser_Create(const JSON_MemorySuite* pMemorySuite)
     {
         memorySuite = defaultMemorySuite;
     }
-    parser = (JSON_Parser)memorySuite.realloc(memorySuite.userData, NULL, sizeof(struct JSON_Parser_Data));
-    if (!parser)
+    lines = (JSON_ParallelLines)memorySuite.realloc(memorySuite.userData, NULL, sizeof(struct JSON_ParallelLines_Data));
+    if (!lines)
     {
         return NULL;
     }
-    parser->memorySuite = memorySuite;
-    JSON_Parser_ResetData(parser, 0/* isInitialized */);
-    return parser;
-}
-
-JSON_Status JSON_CALL JSON_Parser_Free(JSON_Parser parser)
-{
-    if (!parser || GET_FLAGS(parser->state, PARSER_IN_PROTECTED_API))
+    if (!Mutex_Init(&lines->mutex))
+    {
+        memorySuite.free(memorySuite.userData, lines);
+        return NULL;
+    }
+    lines->memorySuite = memorySuite;
+    lines->userData = NULL;
+    lines->state = PARALLEL_RESET;
+    lines->error = JSON_Error_None;
+    lines->threadCount = 0;
+    lines->batchSize = DEFAULT_LINE_BATCH_SIZE;
+    lines->batchStartHandler = NULL;
+    lines->batchEndHandler = NULL;
+    lines->pBatches = NULL;
+    lines->batchesLength = 0;
+    lines->batchCount = 0;
+    lines->pPieces = NULL;
+    lines->piecesLength = 0;
+    lines->pieceCount = 0;
+    lines->pInput = NULL;
+    lines->arrayEnd = 0;
+    lines->isArray = 0;
+    lines->task = NULL;
+    lines->taskCount = 0;
+    lines->nextTask = 0;
+    lines->nextDelivery = 0;
+    lines->nextLine = 0;
+    lines->nextElement = 0;
+    lines->isDelivering = 0;
+    lines->isAborted = 0;
+    return lines;
+}
+
+JSON_Status JSON_CALL JSON_ParallelLines_Free(JSON_ParallelLines lines)
+{
+    if (!lines || GET_FLAGS(lines->state, PARALLEL_IN_PROTECTED_API))
     {
         return JSON_Failure;
     }
-    SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_PROTECTED_API);
-    if (parser->pTokenBytes != parser->defaultTokenBytes)
+    if (lines->pBatches)
     {
-        parser->memorySuite.free(parser->memorySuite.userData, parser->pTokenBytes);
+        lines->memorySuite.free(lines->memorySuite.userData, lines->pBatches);
     }
-    while (parser->pMemberNames)
+    if (lines->pPieces)
     {
-        JSON_Parser_PopMemberNameList(parser);
+        lines->memorySuite.free(lines->memorySuite.userData, lines->pPieces);
     }
-    Grammarian_FreeAllocations(&parser->grammarianData, &parser->memorySuite);
-    parser->memorySuite.free(parser->memorySuite.userData, parser);
+    Mutex_Destroy(&lines->mutex);
+    lines->memorySuite.free(lines->memorySuite.userData, lines);
     return JSON_Success;
 }
 
-JSON_Status JSON_CALL JSON_Parser_Reset(JSON_Parser parser)
+void* JSON_CALL JSON_ParallelLines_GetUserData(JSON_ParallelLines lines)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_IN_PROTECTED_API))
+    return lines ? lines->userData : NULL;
+}
+
+JSON_Status JSON_CALL JSON_ParallelLines_SetUserData(JSON_ParallelLines lines, void* userData)
+{
+    if (!lines)
     {
         return JSON_Failure;
     }
-    SET_FLAGS_ON(ParserState, parser->state, PARSER_IN_PROTECTED_API);
-    JSON_Parser_ResetData(parser, 1/* isInitialized */);
-    /* Note that JSON_Parser_ResetData() unset PARSER_IN_PROTECTED_API for us. */
+    lines->userData = userData;
     return JSON_Success;
 }
 
-void* JSON_CALL JSON_Parser_GetUserData(JSON_Parser parser)
+size_t JSON_CALL JSON_ParallelLines_GetThreadCount(JSON_ParallelLines lines)
 {
-    return parser ? parser->userData : NULL;
+    return lines ? lines->threadCount : 0;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetUserData(JSON_Parser parser, void* userData)
+JSON_Status JSON_CALL JSON_ParallelLines_SetThreadCount(JSON_ParallelLines lines, size_t threadCount)
 {
-    if (!parser)
+    if (!lines || GET_FLAGS(lines->state, PARALLEL_IN_PROTECTED_API))
     {
         return JSON_Failure;
     }
-    parser->userData = userData;
+    lines->threadCount = threadCount;
     return JSON_Success;
 }
 
-JSON_Encoding JSON_CALL JSON_Parser_GetInputEncoding(JSON_Parser parser)
+size_t JSON_CALL JSON_ParallelLines_GetBatchSize(JSON_ParallelLines lines)
 {
-    return parser ? (JSON_Encoding)parser->inputEncoding : JSON_UnknownEncoding;
+    return lines ? lines->batchSize : 0;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetInputEncoding(JSON_Parser parser, JSON_Encoding encoding)
+JSON_Status JSON_CALL JSON_ParallelLines_SetBatchSize(JSON_ParallelLines lines, size_t batchSize)
 {
-    if (!parser || encoding < JSON_UnknownEncoding || encoding > JSON_UTF32BE || GET_FLAGS(parser->state, PARSER_STARTED))
+    if (!lines || !batchSize || GET_FLAGS(lines->state, PARALLEL_IN_PROTECTED_API))
     {
         return JSON_Failure;
     }
-    parser->inputEncoding = (Encoding)encoding;
+    lines->batchSize = batchSize;
     return JSON_Success;
 }
 
-JSON_Encoding JSON_CALL JSON_Parser_GetStringEncoding(JSON_Parser parser)
+JSON_ParallelLines_BatchStartHandler JSON_CALL JSON_ParallelLines_GetBatchStartHandler(JSON_ParallelLines lines)
 {
-    return parser ? (JSON_Encoding)parser->stringEncoding : JSON_UTF8;
+    return lines ? lines->batchStartHandler : NULL;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetStringEncoding(JSON_Parser parser, JSON_Encoding encoding)
+JSON_Status JSON_CALL JSON_ParallelLines_SetBatchStartHandler(JSON_ParallelLines lines, JSON_ParallelLines_BatchStartHandler handler)
 {
-    if (!parser || encoding <= JSON_UnknownEncoding || encoding > JSON_UTF32BE || GET_FLAGS(parser->state, PARSER_STARTED))
+    if (!lines)
     {
         return JSON_Failure;
     }
-    parser->stringEncoding = (Encoding)encoding;
+    lines->batchStartHandler = handler;
     return JSON_Success;
 }
 
-size_t JSON_CALL JSON_Parser_GetMaxStringLength(JSON_Parser parser)
+JSON_ParallelLines_BatchEndHandler JSON_CALL JSON_ParallelLines_GetBatchEndHandler(JSON_ParallelLines lines)
 {
-    return parser ? parser->maxStringLength : SIZE_MAX;
+    return lines ? lines->batchEndHandler : NULL;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetMaxStringLength(JSON_Parser parser, size_t maxLength)
+JSON_Status JSON_CALL JSON_ParallelLines_SetBatchEndHandler(JSON_ParallelLines lines, JSON_ParallelLines_BatchEndHandler handler)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    if (!lines)
     {
         return JSON_Failure;
     }
-    parser->maxStringLength = maxLength;
+    lines->batchEndHandler = handler;
     return JSON_Success;
 }
 
-JSON_Encoding JSON_CALL JSON_Parser_GetNumberEncoding(JSON_Parser parser)
+JSON_Error JSON_CALL JSON_ParallelLines_GetError(JSON_ParallelLines lines)
 {
-    return parser ? (JSON_Encoding)parser->numberEncoding : JSON_UTF8;
+    return lines ? lines->error : JSON_Error_None;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetNumberEncoding(JSON_Parser parser, JSON_Encoding encoding)
+JSON_Status JSON_CALL JSON_ParallelLines_GetErrorLocation(JSON_ParallelLines lines, JSON_Location* pLocation)
 {
-    if (!parser || encoding <= JSON_UnknownEncoding || encoding > JSON_UTF32BE || GET_FLAGS(parser->state, PARSER_STARTED))
+    if (!lines || !pLocation || !GET_FLAGS(lines->state, PARALLEL_HAS_ERROR_LOCATION))
     {
         return JSON_Failure;
     }
-    parser->numberEncoding = (Encoding)encoding;
+    *pLocation = lines->errorLocation;
     return JSON_Success;
 }
 
-size_t JSON_CALL JSON_Parser_GetMaxNumberLength(JSON_Parser parser)
+JSON_Status JSON_CALL JSON_ParallelLines_Parse(JSON_ParallelLines lines, const char* pBytes, size_t length)
 {
-    return parser ? parser->maxNumberLength : SIZE_MAX;
+    JSON_Status status = JSON_Failure;
+    if (lines && (pBytes || !length) && !GET_FLAGS(lines->state, PARALLEL_IN_PROTECTED_API))
+    {
+        SET_FLAGS_ON(ParallelState, lines->state, PARALLEL_IN_PROTECTED_API);
+        SET_FLAGS_OFF(ParallelState, lines->state, PARALLEL_HAS_ERROR_LOCATION);
+        lines->error = JSON_Error_None;
+        lines->isArray = 0;
+        lines->isAborted = 0;
+        status = JSON_ParallelLines_DivideInput(lines, pBytes, length) &&
+                 JSON_ParallelLines_ParseBatches(lines);
+        SET_FLAGS_OFF(ParallelState, lines->state, PARALLEL_IN_PROTECTED_API);
+    }
+    return status;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetMaxNumberLength(JSON_Parser parser, size_t maxLength)
+JSON_Status JSON_CALL JSON_ParallelLines_ParseArray(JSON_ParallelLines lines, const char* pBytes, size_t length)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
-    {
-        return JSON_Failure;
+    JSON_Status status = JSON_Failure;
+    if (lines && (pBytes || !length) && !GET_FLAGS(lines->state, PARALLEL_IN_PROTECTED_API))
+    {
+        SET_FLAGS_ON(ParallelState, lines->state, PARALLEL_IN_PROTECTED_API);
+        SET_FLAGS_OFF(ParallelState, lines->state, PARALLEL_HAS_ERROR_LOCATION);
+        lines->error = JSON_Error_None;
+        lines->isArray = 1;
+        lines->isAborted = 0;
+        status = JSON_ParallelLines_DivideArray(lines, pBytes, length) &&
+                 JSON_ParallelLines_ParseBatches(lines);
+        lines->isArray = 0;
+        SET_FLAGS_OFF(ParallelState, lines->state, PARALLEL_IN_PROTECTED_API);
     }
-    parser->maxNumberLength = maxLength;
-    return JSON_Success;
+    return status;
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetAllowBOM(JSON_Parser parser)
+/******************** JSON Document ********************/
+
+/* Get the tape word of a value in a complete document, or 0 (which has no
+   type) if there is no such value. */
+static JSON_UInt64 Document_GetWord(JSON_Document document, size_t value)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_BOM)) ? JSON_True : JSON_False;
+    if (!document || !document->isComplete || value >= document->tapeUsed)
+    {
+        return 0;
+    }
+    return document->pTape[value];
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetAllowBOM(JSON_Parser parser, JSON_Boolean allowBOM)
+static const char* Document_GetEntry(JSON_Document document, JSON_UInt64 word, size_t valueSize, size_t* pLength, unsigned int* pAttributes)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    DocumentEntry entry;
+    size_t offset = TAPE_PAYLOAD(word);
+    memcpy(&entry, document->pBytes + offset, sizeof(entry));
+    if (pLength)
     {
-        return JSON_Failure;
+        *pLength = entry.length;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_BOM, allowBOM);
-    return JSON_Success;
+    if (pAttributes)
+    {
+        *pAttributes = entry.attributes;
+    }
+    return (const char*)document->pBytes + offset + DOCUMENT_ENTRY_HEADER_SIZE + valueSize;
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetAllowComments(JSON_Parser parser)
+/* Get the index of the first word after a value and, if the value is the
+   name of an object member, after the member's value as well. */
+static size_t Document_GetItemEnd(JSON_Document document, size_t value)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_COMMENTS)) ? JSON_True : JSON_False;
+    JSON_UInt64 word = document->pTape[value];
+    byte type = TAPE_TYPE(word);
+    return (type == TAPE_START_OBJECT || type == TAPE_START_ARRAY) ? TAPE_PAYLOAD(word) : value + 1;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetAllowComments(JSON_Parser parser, JSON_Boolean allowComments)
+/* Get the item at a word that follows an item or starts a container's
+   items, or JSON_Document_NoValue if there are no more items. */
+static size_t Document_GetItemAt(JSON_Document document, size_t index)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    byte type;
+    if (index >= document->tapeUsed)
     {
-        return JSON_Failure;
+        return JSON_Document_NoValue;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_COMMENTS, allowComments);
-    return JSON_Success;
+    type = TAPE_TYPE(document->pTape[index]);
+    if (type == TAPE_END_OBJECT || type == TAPE_END_ARRAY)
+    {
+        return JSON_Document_NoValue;
+    }
+    return (type == TAPE_MEMBER_NAME) ? index + 1 : index;
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetAllowSpecialNumbers(JSON_Parser parser)
+JSON_Document JSON_CALL JSON_Document_Create(const JSON_MemorySuite* pMemorySuite)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS)) ? JSON_True : JSON_False;
+    JSON_Document document;
+    JSON_MemorySuite memorySuite;
+    if (pMemorySuite)
+    {
+        memorySuite = *pMemorySuite;
+        if (!memorySuite.realloc || !memorySuite.free)
+        {
+            /* The full memory suite must be specified. */
+            return NULL;
+        }
+    }
+    else
+    {
+        memorySuite = defaultMemorySuite;
+    }
+    document = (JSON_Document)memorySuite.realloc(memorySuite.userData, NULL, sizeof(struct JSON_Document_Data));
+    if (!document)
+    {
+        return NULL;
+    }
+    document->memorySuite = memorySuite;
+    document->pTape = NULL;
+    document->tapeLength = 0;
+    document->tapeUsed = 0;
+    document->pBytes = NULL;
+    document->bytesLength = 0;
+    document->bytesUsed = 0;
+    document->pOpenContainers = NULL;
+    document->openContainersLength = 0;
+    document->openContainersUsed = 0;
+    document->isComplete = 0;
+    return document;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetAllowSpecialNumbers(JSON_Parser parser, JSON_Boolean allowSpecialNumbers)
+JSON_Status JSON_CALL JSON_Document_Free(JSON_Document document)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    if (!document)
     {
         return JSON_Failure;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_SPECIAL_NUMBERS, allowSpecialNumbers);
+    if (document->pTape)
+    {
+        document->memorySuite.free(document->memorySuite.userData, document->pTape);
+    }
+    if (document->pBytes)
+    {
+        document->memorySuite.free(document->memorySuite.userData, document->pBytes);
+    }
+    if (document->pOpenContainers)
+    {
+        document->memorySuite.free(document->memorySuite.userData, document->pOpenContainers);
+    }
+    document->memorySuite.free(document->memorySuite.userData, document);
     return JSON_Success;
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetAllowHexNumbers(JSON_Parser parser)
+size_t JSON_CALL JSON_Document_GetRoot(JSON_Document document)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_HEX_NUMBERS)) ? JSON_True : JSON_False;
+    return (document && document->isComplete) ? Document_GetItemAt(document, 0) : JSON_Document_NoValue;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetAllowHexNumbers(JSON_Parser parser, JSON_Boolean allowHexNumbers)
+JSON_ValueType JSON_CALL JSON_Document_GetType(JSON_Document document, size_t value)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    switch (TAPE_TYPE(Document_GetWord(document, value)))
     {
-        return JSON_Failure;
+    case TAPE_NULL:
+        return JSON_NullValueType;
+
+    case TAPE_TRUE:
+    case TAPE_FALSE:
+        return JSON_BooleanValueType;
+
+    case TAPE_STRING:
+        return JSON_StringValueType;
+
+    case TAPE_INT64:
+    case TAPE_UINT64:
+    case TAPE_DOUBLE:
+        return JSON_NumberValueType;
+
+    case TAPE_SPECIAL_NUMBER:
+        return JSON_SpecialNumberValueType;
+
+    case TAPE_START_OBJECT:
+        return JSON_ObjectValueType;
+
+    case TAPE_START_ARRAY:
+        return JSON_ArrayValueType;
+
+    default: /* member names and container ends are not values */
+        return JSON_NoValueType;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_HEX_NUMBERS, allowHexNumbers);
-    return JSON_Success;
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetAllowUnescapedControlCharacters(JSON_Parser parser)
+JSON_Boolean JSON_CALL JSON_Document_GetBoolean(JSON_Document document, size_t value)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_ALLOW_CONTROL_CHARS)) ? JSON_True : JSON_False;
+    return (TAPE_TYPE(Document_GetWord(document, value)) == TAPE_TRUE) ? JSON_True : JSON_False;
+}
+
+const char* JSON_CALL JSON_Document_GetString(JSON_Document document, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes)
+{
+    JSON_UInt64 word = Document_GetWord(document, value);
+    if (TAPE_TYPE(word) != TAPE_STRING)
+    {
+        return NULL;
+    }
+    return Document_GetEntry(document, word, 0, pLength, pAttributes);
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetAllowUnescapedControlCharacters(JSON_Parser parser, JSON_Boolean allowUnescapedControlCharacters)
+JSON_Status JSON_CALL JSON_Document_GetNumber(JSON_Document document, size_t value, JSON_NumberValue* pValue, JSON_NumberAttributes* pAttributes)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    JSON_UInt64 word = Document_GetWord(document, value);
+    byte type = TAPE_TYPE(word);
+    JSON_UInt64 bits;
+    if (!pValue || (type != TAPE_INT64 && type != TAPE_UINT64 && type != TAPE_DOUBLE))
     {
         return JSON_Failure;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_ALLOW_CONTROL_CHARS, allowUnescapedControlCharacters);
-    return JSON_Success;
-}
+    memcpy(&bits, Document_GetEntry(document, word, 0, NULL, pAttributes), sizeof(bits));
+    pValue->int64Value = 0;
+    pValue->uint64Value = 0;
+    pValue->doubleValue = 0.0;
+    switch (type)
+    {
+    case TAPE_INT64:
+        pValue->type = JSON_Int64Number;
+        pValue->int64Value = (JSON_Int64)bits;
+        break;
 
-JSON_Boolean JSON_CALL JSON_Parser_GetReplaceInvalidEncodingSequences(JSON_Parser parser)
-{
-    return (parser && GET_FLAGS(parser->flags, PARSER_REPLACE_INVALID)) ? JSON_True : JSON_False;
+    case TAPE_UINT64:
+        pValue->type = JSON_UInt64Number;
+        pValue->uint64Value = bits;
+        break;
+
+    default:
+        pValue->type = JSON_DoubleNumber;
+        memcpy(&pValue->doubleValue, &bits, sizeof(bits));
+        break;
+    }
+    return JSON_Success;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetReplaceInvalidEncodingSequences(JSON_Parser parser, JSON_Boolean replaceInvalidEncodingSequences)
+const char* JSON_CALL JSON_Document_GetNumberText(JSON_Document document, size_t value, size_t* pLength)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    JSON_UInt64 word = Document_GetWord(document, value);
+    byte type = TAPE_TYPE(word);
+    if (type != TAPE_INT64 && type != TAPE_UINT64 && type != TAPE_DOUBLE)
     {
-        return JSON_Failure;
+        return NULL;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_REPLACE_INVALID, replaceInvalidEncodingSequences);
-    return JSON_Success;
+    return Document_GetEntry(document, word, DOCUMENT_NUMBER_VALUE_SIZE, pLength, NULL);
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetTrackObjectMembers(JSON_Parser parser)
+JSON_SpecialNumber JSON_CALL JSON_Document_GetSpecialNumber(JSON_Document document, size_t value)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_TRACK_OBJECT_MEMBERS)) ? JSON_True : JSON_False;
+    JSON_UInt64 word = Document_GetWord(document, value);
+    return (TAPE_TYPE(word) == TAPE_SPECIAL_NUMBER) ? (JSON_SpecialNumber)TAPE_PAYLOAD(word) : JSON_NaN;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetTrackObjectMembers(JSON_Parser parser, JSON_Boolean trackObjectMembers)
+size_t JSON_CALL JSON_Document_GetItemCount(JSON_Document document, size_t value)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    JSON_UInt64 word = Document_GetWord(document, value);
+    byte type = TAPE_TYPE(word);
+    if (type != TAPE_START_OBJECT && type != TAPE_START_ARRAY)
     {
-        return JSON_Failure;
+        return 0;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_TRACK_OBJECT_MEMBERS, trackObjectMembers);
-    return JSON_Success;
+    /* The end word follows the last word of the container. */
+    return TAPE_PAYLOAD(document->pTape[TAPE_PAYLOAD(word) - 1]);
 }
 
-JSON_Boolean JSON_CALL JSON_Parser_GetStopAfterEmbeddedDocument(JSON_Parser parser)
+size_t JSON_CALL JSON_Document_GetFirstItem(JSON_Document document, size_t value)
 {
-    return (parser && GET_FLAGS(parser->flags, PARSER_EMBEDDED_DOCUMENT)) ? JSON_True : JSON_False;
+    byte type = TAPE_TYPE(Document_GetWord(document, value));
+    if (type != TAPE_START_OBJECT && type != TAPE_START_ARRAY)
+    {
+        return JSON_Document_NoValue;
+    }
+    return Document_GetItemAt(document, value + 1);
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetStopAfterEmbeddedDocument(JSON_Parser parser, JSON_Boolean stopAfterEmbeddedDocument)
+size_t JSON_CALL JSON_Document_GetNextItem(JSON_Document document, size_t value)
 {
-    if (!parser || GET_FLAGS(parser->state, PARSER_STARTED))
+    if (JSON_Document_GetType(document, value) == JSON_NoValueType)
     {
-        return JSON_Failure;
+        return JSON_Document_NoValue;
     }
-    SET_FLAGS(ParserFlags, parser->flags, PARSER_EMBEDDED_DOCUMENT, stopAfterEmbeddedDocument);
-    return JSON_Success;
+    return Document_GetItemAt(document, Document_GetItemEnd(document, value));
 }
 
-JSON_Error JSON_CALL JSON_Parser_GetError(JSON_Parser parser)
+const char* JSON_CALL JSON_Document_GetMemberName(JSON_Document document, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes)
 {
-    return parser ? (JSON_Error)parser->error : JSON_Error_None;
+    JSON_UInt64 word;
+    if (JSON_Document_GetType(document, value) == JSON_NoValueType || !value)
+    {
+        return NULL;
+    }
+    word = document->pTape[value - 1];
+    if (TAPE_TYPE(word) != TAPE_MEMBER_NAME)
+    {
+        return NULL;
+    }
+    return Document_GetEntry(document, word, 0, pLength, pAttributes);
 }
 
-JSON_Status JSON_CALL JSON_Parser_GetErrorLocation(JSON_Parser parser, JSON_Location* pLocation)
+size_t JSON_CALL JSON_Document_FindMember(JSON_Document document, size_t value, const char* pName, size_t length)
 {
-    if (!pLocation || !parser || parser->error == JSON_Error_None)
-    {
-        return JSON_Failure;
-    }
-    if (parser->errorOffset == ERROR_LOCATION_IS_TOKEN_START)
+    size_t item;
+    if (TAPE_TYPE(Document_GetWord(document, value)) != TAPE_START_OBJECT || (!pName && length))
     {
-        pLocation->byte = parser->tokenLocationByte;
-        pLocation->line = parser->tokenLocationLine;
-        pLocation->column = parser->tokenLocationColumn;
+        return JSON_Document_NoValue;
     }
-    else
+    for (item = Document_GetItemAt(document, value + 1); item != JSON_Document_NoValue; item = Document_GetItemAt(document, Document_GetItemEnd(document, item)))
     {
-        pLocation->byte = parser->codepointLocationByte - (SHORTEST_ENCODING_SEQUENCE(parser->inputEncoding) * parser->errorOffset);
-        pLocation->line = parser->codepointLocationLine;
-        pLocation->column = parser->codepointLocationColumn - parser->errorOffset;
+        size_t nameLength;
+        const char* pItemName = Document_GetEntry(document, document->pTape[item - 1], 0, &nameLength, NULL);
+        if (nameLength == length && (!length || !memcmp(pItemName, pName, length)))
+        {
+            return item;
+        }
     }
-    pLocation->depth = parser->depth;
-    return JSON_Success;
+    return JSON_Document_NoValue;
 }
 
-JSON_Status JSON_CALL JSON_Parser_GetTokenLocation(JSON_Parser parser, JSON_Location* pLocation)
+/******************** JSON On-Demand ********************/
+
+/* An on-demand instance. The structural index of the open document is
+   built up to the byte before the scanned offset; scanning continues only
+   when a value beyond it is needed. The document holds the value that was
+   most recently decoded, which began at the decoded offset. */
+struct JSON_OnDemand_Data
 {
-    if (!parser || !pLocation || !GET_FLAGS(parser->state, PARSER_IN_TOKEN_HANDLER))
+    JSON_MemorySuite memorySuite;
+    JSON_Parser      parser;
+    JSON_Document    document;
+    const byte*      pInput;
+    size_t           length;
+    size_t*          pIndex;
+    size_t           indexLength;
+    size_t           indexUsed;
+    size_t           scanned;
+    int              inString;
+    size_t           decoded;
+    JSON_Error       error;
+};
+
+/* Get the offset of an entry in the structural index, scanning the input
+   for it if necessary, or the length of the input if there is no such
+   entry. */
+static size_t OnDemand_GetEntry(JSON_OnDemand onDemand, size_t position)
+{
+    while (position >= onDemand->indexUsed)
     {
-        return JSON_Failure;
+        size_t offset;
+        if (onDemand->scanned >= onDemand->length)
+        {
+            return onDemand->length;
+        }
+        offset = FindStructuralByte(onDemand->pInput, onDemand->scanned, onDemand->length, &onDemand->inString);
+        if (offset == onDemand->length)
+        {
+            onDemand->scanned = offset;
+            return offset;
+        }
+        if (onDemand->indexUsed == onDemand->indexLength)
+        {
+            size_t* pNewIndex = (size_t*)GrowArray(&onDemand->memorySuite, onDemand->pIndex, &onDemand->indexLength, sizeof(size_t), DEFAULT_STRUCTURAL_INDEX_LENGTH);
+            if (!pNewIndex)
+            {
+                onDemand->error = JSON_Error_OutOfMemory;
+                return onDemand->length;
+            }
+            onDemand->pIndex = pNewIndex;
+        }
+        onDemand->pIndex[onDemand->indexUsed] = offset;
+        onDemand->indexUsed++;
+        onDemand->scanned = offset + 1;
     }
-    pLocation->byte = parser->tokenLocationByte;
-    pLocation->line = parser->tokenLocationLine;
-    pLocation->column = parser->tokenLocationColumn;
-    pLocation->depth = parser->depth;
-    return JSON_Success;
+    return onDemand->pIndex[position];
 }
 
-JSON_Status JSON_CALL JSON_Parser_GetAfterTokenLocation(JSON_Parser parser, JSON_Location* pLocation)
+/* Get the position in the structural index of the first entry at or after
+   an offset. */
+static size_t OnDemand_FindEntry(JSON_OnDemand onDemand, size_t offset)
 {
-    if (!parser || !pLocation || !GET_FLAGS(parser->state, PARSER_IN_TOKEN_HANDLER))
+    size_t low = 0;
+    size_t high;
+    while ((!onDemand->indexUsed || onDemand->pIndex[onDemand->indexUsed - 1] < offset) &&
+           OnDemand_GetEntry(onDemand, onDemand->indexUsed) < onDemand->length)
     {
-        return JSON_Failure;
+        /* The index has been extended by one entry. */
     }
-    pLocation->byte = parser->codepointLocationByte;
-    pLocation->line = parser->codepointLocationLine;
-    pLocation->column = parser->codepointLocationColumn;
-    pLocation->depth = parser->depth;
-    return JSON_Success;
+    high = onDemand->indexUsed;
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+        if (onDemand->pIndex[middle] < offset)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+    return low;
 }
 
-JSON_Parser_NullHandler JSON_CALL JSON_Parser_GetEncodingDetectedHandler(JSON_Parser parser)
+static byte OnDemand_GetEntryByte(JSON_OnDemand onDemand, size_t position)
 {
-    return parser ? parser->encodingDetectedHandler : NULL;
+    size_t offset = OnDemand_GetEntry(onDemand, position);
+    return (offset < onDemand->length) ? onDemand->pInput[offset] : 0;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetEncodingDetectedHandler(JSON_Parser parser, JSON_Parser_EncodingDetectedHandler handler)
+static size_t OnDemand_SkipWhitespace(JSON_OnDemand onDemand, size_t offset)
 {
-    if (!parser)
+    while (offset < onDemand->length && IsWhitespaceByte(onDemand->pInput[offset]))
     {
-        return JSON_Failure;
+        offset++;
     }
-    parser->encodingDetectedHandler = handler;
-    return JSON_Success;
-}
-
-JSON_Parser_NullHandler JSON_CALL JSON_Parser_GetNullHandler(JSON_Parser parser)
-{
-    return parser ? parser->nullHandler : NULL;
+    return offset;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetNullHandler(JSON_Parser parser, JSON_Parser_NullHandler handler)
+/* Get the value that begins at an offset, or JSON_OnDemand_NoValue if
+   the input ends or a container, member or item ends there instead. */
+static size_t OnDemand_GetValueAt(JSON_OnDemand onDemand, size_t offset)
 {
-    if (!parser)
+    byte b;
+    if (offset >= onDemand->length)
     {
-        return JSON_Failure;
+        return JSON_OnDemand_NoValue;
     }
-    parser->nullHandler = handler;
-    return JSON_Success;
+    b = onDemand->pInput[offset];
+    return (IS_STRUCTURAL_BYTE(b) && b != '{' && b != '[') ? JSON_OnDemand_NoValue : offset;
 }
 
-JSON_Parser_BooleanHandler JSON_CALL JSON_Parser_GetBooleanHandler(JSON_Parser parser)
+static size_t OnDemand_GetRootOffset(JSON_OnDemand onDemand)
 {
-    return parser ? parser->booleanHandler : NULL;
+    size_t offset = 0;
+    if (onDemand->length >= 3 && onDemand->pInput[0] == 0xEF && onDemand->pInput[1] == 0xBB && onDemand->pInput[2] == 0xBF)
+    {
+        offset = 3;
+    }
+    return OnDemand_SkipWhitespace(onDemand, offset);
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetBooleanHandler(JSON_Parser parser, JSON_Parser_BooleanHandler handler)
+/* Get the offset just past the end of a value. The end of a container is
+   found by counting brackets in the structural index. */
+static size_t OnDemand_GetValueEnd(JSON_OnDemand onDemand, size_t value)
 {
-    if (!parser)
+    byte b = onDemand->pInput[value];
+    size_t position;
+    size_t offset;
+    if (b == '{' || b == '[')
     {
-        return JSON_Failure;
+        size_t depth = 0;
+        for (position = OnDemand_FindEntry(onDemand, value); ; position++)
+        {
+            offset = OnDemand_GetEntry(onDemand, position);
+            if (offset == onDemand->length)
+            {
+                return offset;
+            }
+            b = onDemand->pInput[offset];
+            if (b == '{' || b == '[')
+            {
+                depth++;
+            }
+            else if ((b == '}' || b == ']') && !--depth)
+            {
+                return offset + 1;
+            }
+        }
     }
-    parser->booleanHandler = handler;
-    return JSON_Success;
+    if (b == '"')
+    {
+        offset = OnDemand_GetEntry(onDemand, OnDemand_FindEntry(onDemand, value) + 1);
+        return (offset < onDemand->length) ? offset + 1 : offset;
+    }
+    offset = value;
+    while (offset < onDemand->length && !IsWhitespaceByte(onDemand->pInput[offset]) &&
+           !IS_STRUCTURAL_BYTE(onDemand->pInput[offset]) && onDemand->pInput[offset] != '"')
+    {
+        offset++;
+    }
+    return offset;
 }
 
-JSON_Parser_StringHandler JSON_CALL JSON_Parser_GetStringHandler(JSON_Parser parser)
+/* Get the value of the member whose name begins at a position in the
+   structural index. */
+static size_t OnDemand_GetMemberValue(JSON_OnDemand onDemand, size_t position)
 {
-    return parser ? parser->stringHandler : NULL;
+    if (OnDemand_GetEntryByte(onDemand, position) != '"' ||
+        OnDemand_GetEntryByte(onDemand, position + 2) != ':')
+    {
+        return JSON_OnDemand_NoValue;
+    }
+    return OnDemand_GetValueAt(onDemand, OnDemand_SkipWhitespace(onDemand, OnDemand_GetEntry(onDemand, position + 2) + 1));
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetStringHandler(JSON_Parser parser, JSON_Parser_StringHandler handler)
+/* Get the position in the structural index of the opening quotation mark
+   of the name of the member whose value is a value, or 0 if the value is
+   not the value of an object member. The entry before a value is a colon
+   only if the value is a member's value. */
+static size_t OnDemand_FindMemberName(JSON_OnDemand onDemand, size_t value)
 {
-    if (!parser)
+    size_t position = OnDemand_FindEntry(onDemand, value);
+    if (position < 3 || onDemand->pInput[onDemand->pIndex[position - 1]] != ':' ||
+        onDemand->pInput[onDemand->pIndex[position - 3]] != '"')
     {
-        return JSON_Failure;
+        return 0;
     }
-    parser->stringHandler = handler;
-    return JSON_Success;
+    return position - 3;
 }
 
-JSON_Parser_NumberHandler JSON_CALL JSON_Parser_GetNumberHandler(JSON_Parser parser)
+/* Decode the bytes of a value, or of a member name as a string value,
+   into the instance's document. Only the parse state is reset after each
+   value, so the client's settings, path filters and key dictionary all
+   apply to every value that is decoded. */
+static size_t OnDemand_Decode(JSON_OnDemand onDemand, size_t start, size_t end)
 {
-    return parser ? parser->numberHandler : NULL;
+    JSON_Parser parser = onDemand->parser;
+    Encoding inputEncoding = parser->inputEncoding;
+    JSON_Document document = parser->pDocument;
+    JSON_Status status;
+    if (onDemand->decoded == start)
+    {
+        return JSON_Document_GetRoot(onDemand->document);
+    }
+    onDemand->decoded = JSON_OnDemand_NoValue;
+    parser->inputEncoding = JSON_UTF8;
+    JSON_Parser_SetDocument(parser, onDemand->document);
+    status = JSON_Parser_Parse(parser, (const char*)onDemand->pInput + start, end - start, JSON_True);
+    if (!status)
+    {
+        onDemand->error = (JSON_Error)parser->error;
+    }
+    JSON_Parser_ResetParseState(parser, 1/* isInitialized */);
+    parser->inputEncoding = inputEncoding;
+    parser->pDocument = document;
+    if (!status)
+    {
+        return JSON_Document_NoValue;
+    }
+    onDemand->decoded = start;
+    return JSON_Document_GetRoot(onDemand->document);
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetNumberHandler(JSON_Parser parser, JSON_Parser_NumberHandler handler)
+static size_t OnDemand_DecodeValue(JSON_OnDemand onDemand, size_t value, JSON_ValueType type)
 {
-    if (!parser)
+    if (JSON_OnDemand_GetType(onDemand, value) != type)
     {
-        return JSON_Failure;
+        return JSON_Document_NoValue;
     }
-    parser->numberHandler = handler;
-    return JSON_Success;
+    return OnDemand_Decode(onDemand, value, OnDemand_GetValueEnd(onDemand, value));
 }
 
-JSON_Parser_SpecialNumberHandler JSON_CALL JSON_Parser_GetSpecialNumberHandler(JSON_Parser parser)
+JSON_OnDemand JSON_CALL JSON_OnDemand_Create(const JSON_MemorySuite* pMemorySuite)
 {
-    return parser ? parser->specialNumberHandler : NULL;
+    JSON_OnDemand onDemand;
+    JSON_MemorySuite memorySuite;
+    if (pMemorySuite)
+    {
+        memorySuite = *pMemorySuite;
+        if (!memorySuite.realloc || !memorySuite.free)
+        {
+            /* The full memory suite must be specified. */
+            return NULL;
+        }
+    }
+    else
+    {
+        memorySuite = defaultMemorySuite;
+    }
+    onDemand = (JSON_OnDemand)memorySuite.realloc(memorySuite.userData, NULL, sizeof(struct JSON_OnDemand_Data));
+    if (!onDemand)
+    {
+        return NULL;
+    }
+    onDemand->memorySuite = memorySuite;
+    onDemand->parser = JSON_Parser_Create(&memorySuite);
+    onDemand->document = JSON_Document_Create(&memorySuite);
+    if (!onDemand->parser || !onDemand->document)
+    {
+        JSON_Parser_Free(onDemand->parser);
+        JSON_Document_Free(onDemand->document);
+        memorySuite.free(memorySuite.userData, onDemand);
+        return NULL;
+    }
+    onDemand->pInput = NULL;
+    onDemand->length = 0;
+    onDemand->pIndex = NULL;
+    onDemand->indexLength = 0;
+    onDemand->indexUsed = 0;
+    onDemand->scanned = 0;
+    onDemand->inString = 0;
+    onDemand->decoded = JSON_OnDemand_NoValue;
+    onDemand->error = JSON_Error_None;
+    return onDemand;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetSpecialNumberHandler(JSON_Parser parser, JSON_Parser_SpecialNumberHandler handler)
+JSON_Status JSON_CALL JSON_OnDemand_Free(JSON_OnDemand onDemand)
 {
-    if (!parser)
+    if (!onDemand)
     {
         return JSON_Failure;
     }
-    parser->specialNumberHandler = handler;
+    JSON_Parser_Free(onDemand->parser);
+    JSON_Document_Free(onDemand->document);
+    if (onDemand->pIndex)
+    {
+        onDemand->memorySuite.free(onDemand->memorySuite.userData, onDemand->pIndex);
+    }
+    onDemand->memorySuite.free(onDemand->memorySuite.userData, onDemand);
     return JSON_Success;
 }
 
-JSON_Parser_StartObjectHandler JSON_CALL JSON_Parser_GetStartObjectHandler(JSON_Parser parser)
+JSON_Parser JSON_CALL JSON_OnDemand_GetParser(JSON_OnDemand onDemand)
 {
-    return parser ? parser->startObjectHandler : NULL;
+    return onDemand ? onDemand->parser : NULL;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetStartObjectHandler(JSON_Parser parser, JSON_Parser_StartObjectHandler handler)
+JSON_Status JSON_CALL JSON_OnDemand_Open(JSON_OnDemand onDemand, const char* pBytes, size_t length)
 {
-    if (!parser)
+    if (!onDemand || (!pBytes && length))
     {
         return JSON_Failure;
     }
-    parser->startObjectHandler = handler;
+    onDemand->pInput = (const byte*)pBytes;
+    onDemand->length = length;
+    onDemand->indexUsed = 0;
+    onDemand->scanned = 0;
+    onDemand->inString = 0;
+    onDemand->decoded = JSON_OnDemand_NoValue;
+    onDemand->error = JSON_Error_None;
     return JSON_Success;
 }
 
-JSON_Parser_EndObjectHandler JSON_CALL JSON_Parser_GetEndObjectHandler(JSON_Parser parser)
+JSON_Error JSON_CALL JSON_OnDemand_GetError(JSON_OnDemand onDemand)
 {
-    return parser ? parser->endObjectHandler : NULL;
+    return onDemand ? onDemand->error : JSON_Error_None;
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetEndObjectHandler(JSON_Parser parser, JSON_Parser_EndObjectHandler handler)
+size_t JSON_CALL JSON_OnDemand_GetRoot(JSON_OnDemand onDemand)
 {
-    if (!parser)
+    size_t root;
+    if (!onDemand)
     {
-        return JSON_Failure;
+        return JSON_OnDemand_NoValue;
     }
-    parser->endObjectHandler = handler;
-    return JSON_Success;
+    root = OnDemand_GetRootOffset(onDemand);
+    if (root && onDemand->pInput[0] == 0xEF && !GET_FLAGS(onDemand->parser->flags, PARSER_ALLOW_BOM))
+    {
+        onDemand->error = JSON_Error_BOMNotAllowed;
+        return JSON_OnDemand_NoValue;
+    }
+    return OnDemand_GetValueAt(onDemand, root);
 }
 
-JSON_Parser_ObjectMemberHandler JSON_CALL JSON_Parser_GetObjectMemberHandler(JSON_Parser parser)
+JSON_ValueType JSON_CALL JSON_OnDemand_GetType(JSON_OnDemand onDemand, size_t value)
 {
-    return parser ? parser->objectMemberHandler : NULL;
+    if (!onDemand || value >= onDemand->length)
+    {
+        return JSON_NoValueType;
+    }
+    switch (onDemand->pInput[value])
+    {
+    case 'n':
+        return JSON_NullValueType;
+
+    case 't':
+    case 'f':
+        return JSON_BooleanValueType;
+
+    case '"':
+        return JSON_StringValueType;
+
+    case '-':
+        return (value + 1 < onDemand->length && onDemand->pInput[value + 1] == 'I') ? JSON_SpecialNumberValueType : JSON_NumberValueType;
+
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        return JSON_NumberValueType;
+
+    case 'N':
+    case 'I':
+        return JSON_SpecialNumberValueType;
+
+    case '{':
+        return JSON_ObjectValueType;
+
+    case '[':
+        return JSON_ArrayValueType;
+
+    default:
+        return JSON_NoValueType;
+    }
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetObjectMemberHandler(JSON_Parser parser, JSON_Parser_ObjectMemberHandler handler)
+JSON_Boolean JSON_CALL JSON_OnDemand_GetBoolean(JSON_OnDemand onDemand, size_t value)
 {
-    if (!parser)
-    {
-        return JSON_Failure;
-    }
-    parser->objectMemberHandler = handler;
-    return JSON_Success;
+    return JSON_Document_GetBoolean(onDemand ? onDemand->document : NULL, OnDemand_DecodeValue(onDemand, value, JSON_BooleanValueType));
 }
 
-JSON_Parser_StartArrayHandler JSON_CALL JSON_Parser_GetStartArrayHandler(JSON_Parser parser)
+const char* JSON_CALL JSON_OnDemand_GetString(JSON_OnDemand onDemand, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes)
 {
-    return parser ? parser->startArrayHandler : NULL;
+    return JSON_Document_GetString(onDemand ? onDemand->document : NULL, OnDemand_DecodeValue(onDemand, value, JSON_StringValueType), pLength, pAttributes);
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetStartArrayHandler(JSON_Parser parser, JSON_Parser_StartArrayHandler handler)
+JSON_Status JSON_CALL JSON_OnDemand_GetNumber(JSON_OnDemand onDemand, size_t value, JSON_NumberValue* pValue, JSON_NumberAttributes* pAttributes)
 {
-    if (!parser)
+    if (!pValue)
     {
         return JSON_Failure;
     }
-    parser->startArrayHandler = handler;
-    return JSON_Success;
+    return JSON_Document_GetNumber(onDemand ? onDemand->document : NULL, OnDemand_DecodeValue(onDemand, value, JSON_NumberValueType), pValue, pAttributes);
 }
 
-JSON_Parser_EndArrayHandler JSON_CALL JSON_Parser_GetEndArrayHandler(JSON_Parser parser)
+const char* JSON_CALL JSON_OnDemand_GetNumberText(JSON_OnDemand onDemand, size_t value, size_t* pLength)
 {
-    return parser ? parser->endArrayHandler : NULL;
+    return JSON_Document_GetNumberText(onDemand ? onDemand->document : NULL, OnDemand_DecodeValue(onDemand, value, JSON_NumberValueType), pLength);
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetEndArrayHandler(JSON_Parser parser, JSON_Parser_EndArrayHandler handler)
+JSON_SpecialNumber JSON_CALL JSON_OnDemand_GetSpecialNumber(JSON_OnDemand onDemand, size_t value)
 {
-    if (!parser)
+    return JSON_Document_GetSpecialNumber(onDemand ? onDemand->document : NULL, OnDemand_DecodeValue(onDemand, value, JSON_SpecialNumberValueType));
+}
+
+size_t JSON_CALL JSON_OnDemand_GetFirstItem(JSON_OnDemand onDemand, size_t value)
+{
+    switch (JSON_OnDemand_GetType(onDemand, value))
     {
-        return JSON_Failure;
+    case JSON_ArrayValueType:
+        return OnDemand_GetValueAt(onDemand, OnDemand_SkipWhitespace(onDemand, value + 1));
+
+    case JSON_ObjectValueType:
+        return OnDemand_GetMemberValue(onDemand, OnDemand_FindEntry(onDemand, value) + 1);
+
+    default:
+        return JSON_OnDemand_NoValue;
     }
-    parser->endArrayHandler = handler;
-    return JSON_Success;
 }
 
-JSON_Parser_ArrayItemHandler JSON_CALL JSON_Parser_GetArrayItemHandler(JSON_Parser parser)
+size_t JSON_CALL JSON_OnDemand_GetNextItem(JSON_OnDemand onDemand, size_t value)
 {
-    return parser ? parser->arrayItemHandler : NULL;
+    size_t offset;
+    if (JSON_OnDemand_GetType(onDemand, value) == JSON_NoValueType || value == OnDemand_GetRootOffset(onDemand))
+    {
+        return JSON_OnDemand_NoValue;
+    }
+    offset = OnDemand_SkipWhitespace(onDemand, OnDemand_GetValueEnd(onDemand, value));
+    if (offset >= onDemand->length || onDemand->pInput[offset] != ',')
+    {
+        return JSON_OnDemand_NoValue;
+    }
+    if (OnDemand_FindMemberName(onDemand, value))
+    {
+        return OnDemand_GetMemberValue(onDemand, OnDemand_FindEntry(onDemand, offset) + 1);
+    }
+    return OnDemand_GetValueAt(onDemand, OnDemand_SkipWhitespace(onDemand, offset + 1));
 }
 
-JSON_Status JSON_CALL JSON_Parser_SetArrayItemHandler(JSON_Parser parser, JSON_Parser_ArrayItemHandler handler)
+const char* JSON_CALL JSON_OnDemand_GetMemberName(JSON_OnDemand onDemand, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes)
 {
-    if (!parser)
+    size_t position;
+    if (JSON_OnDemand_GetType(onDemand, value) == JSON_NoValueType)
     {
-        return JSON_Failure;
+        return NULL;
+    }
+    position = OnDemand_FindMemberName(onDemand, value);
+    if (!position)
+    {
+        return NULL;
     }
-    parser->arrayItemHandler = handler;
-    return JSON_Success;
+    return JSON_Document_GetString(onDemand->document,
+                                   OnDemand_Decode(onDemand, onDemand->pIndex[position], onDemand->pIndex[position + 1] + 1),
+                                   pLength, pAttributes);
 }
 
-JSON_Status JSON_CALL JSON_Parser_Parse(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal)
+size_t JSON_CALL JSON_OnDemand_FindMember(JSON_OnDemand onDemand, size_t value, const char* pName, size_t length)
 {
-    JSON_Status status = JSON_Failure;
-    if (parser && (pBytes || !length) && !GET_FLAGS(parser->state, PARSER_FINISHED | PARSER_IN_PROTECTED_API))
+    size_t item;
+    if (JSON_OnDemand_GetType(onDemand, value) != JSON_ObjectValueType || (!pName && length))
     {
-        int finishedParsing = 0;
-        SET_FLAGS_ON(ParserState, parser->state, PARSER_STARTED | PARSER_IN_PROTECTED_API);
-        if (JSON_Parser_ProcessInputBytes(parser, (const byte*)pBytes, length))
+        return JSON_OnDemand_NoValue;
+    }
+    for (item = JSON_OnDemand_GetFirstItem(onDemand, value); item != JSON_OnDemand_NoValue; item = JSON_OnDemand_GetNextItem(onDemand, item))
+    {
+        /* A name made only of plain string bytes decodes to itself in
+           UTF-8, so it can be compared without being decoded. */
+        size_t position = OnDemand_FindMemberName(onDemand, item);
+        size_t nameStart = onDemand->pIndex[position] + 1;
+        size_t nameEnd = onDemand->pIndex[position + 1];
+        int isPlain = (onDemand->parser->stringEncoding == JSON_UTF8 && nameEnd - nameStart <= onDemand->parser->maxStringLength);
+        const char* pItemName;
+        size_t nameLength;
+        size_t i;
+        for (i = nameStart; isPlain && i < nameEnd; i++)
         {
-            /* New input was parsed successfully. */
-            if (isFinal)
-            {
-                /* Make sure there is nothing pending in the decoder, lexer,
-                   or parser. */
-                if (JSON_Parser_FlushDecoder(parser) &&
-                    JSON_Parser_FlushLexer(parser) &&
-                    JSON_Parser_FlushParser(parser))
-                {
-                    status = JSON_Success;
-                }
-                finishedParsing = 1;
-            }
-            else
-            {
-                status = JSON_Success;
-            }
+            isPlain = IS_PLAIN_STRING_BYTE(onDemand->pInput[i]);
+        }
+        if (isPlain)
+        {
+            pItemName = (const char*)onDemand->pInput + nameStart;
+            nameLength = nameEnd - nameStart;
         }
         else
         {
-            /* New input failed to parse. */
-            finishedParsing = 1;
+            pItemName = JSON_OnDemand_GetMemberName(onDemand, item, &nameLength, NULL);
+            if (!pItemName)
+            {
+                continue;
+            }
         }
-        if (finishedParsing)
+        if (nameLength == length && (!length || !memcmp(pItemName, pName, length)))
         {
-            SET_FLAGS_ON(ParserState, parser->state, PARSER_FINISHED);
+            return item;
         }
-        SET_FLAGS_OFF(ParserState, parser->state, PARSER_IN_PROTECTED_API);
     }
-    return status;
+    return JSON_OnDemand_NoValue;
 }
 
 #endif /* JSON_NO_PARSER */
@@ -3198,6 +8916,7 @@ typedef byte WriterState;
 #define WRITER_USE_CRLF         0x1
 #define WRITER_REPLACE_INVALID  0x2
 #define WRITER_ESCAPE_NON_ASCII 0x4
+#define WRITER_OWNS_BUFFER      0x8
 typedef byte WriterFlags;
 
 /* A writer instance. */
@@ -3211,12 +8930,35 @@ struct JSON_Writer_Data
     Error                     error;
     GrammarianData            grammarianData;
     JSON_Writer_OutputHandler outputHandler;
+    byte*                     pOutputBuffer;
+    size_t                    outputBufferSize;
+    size_t                    outputBufferUsed;
 };
 
 /* Writer internal functions. */
 
+static void JSON_Writer_FreeOutputBuffer(JSON_Writer writer)
+{
+    if (GET_FLAGS(writer->flags, WRITER_OWNS_BUFFER))
+    {
+        writer->memorySuite.free(writer->memorySuite.userData, writer->pOutputBuffer);
+        SET_FLAGS_OFF(WriterFlags, writer->flags, WRITER_OWNS_BUFFER);
+    }
+    writer->pOutputBuffer = NULL;
+    writer->outputBufferSize = 0;
+    writer->outputBufferUsed = 0;
+}
+
 static void JSON_Writer_ResetData(JSON_Writer writer, int isInitialized)
 {
+    if (!isInitialized)
+    {
+        writer->flags = WRITER_DEFAULT_FLAGS;
+    }
+    /* Unlike the grammarian's symbol stack, the output buffer is a setting,
+       so when we reset the writer we release any buffer we allocated
+       rather than keeping it. */
+    JSON_Writer_FreeOutputBuffer(writer);
     writer->userData = NULL;
     writer->flags = WRITER_DEFAULT_FLAGS;
     writer->outputEncoding = JSON_UTF8;
@@ -3247,7 +8989,7 @@ static JSON_Status JSON_Writer_ProcessToken(JSON_Writer writer, Symbol token)
     return JSON_Success;
 }
 
-static JSON_Status JSON_Writer_OutputBytes(JSON_Writer writer, const byte* pBytes, size_t length)
+static JSON_Status JSON_Writer_CallOutputHandler(JSON_Writer writer, const byte* pBytes, size_t length)
 {
     if (writer->outputHandler && length)
     {
@@ -3260,6 +9002,47 @@ static JSON_Status JSON_Writer_OutputBytes(JSON_Writer writer, const byte* pByte
     return JSON_Success;
 }
 
+static JSON_Status JSON_Writer_FlushOutputBuffer(JSON_Writer writer)
+{
+    size_t used = writer->outputBufferUsed;
+    writer->outputBufferUsed = 0;
+    return JSON_Writer_CallOutputHandler(writer, writer->pOutputBuffer, used);
+}
+
+static JSON_Status JSON_Writer_OutputBytes(JSON_Writer writer, const byte* pBytes, size_t length)
+{
+    size_t available;
+    if (!writer->outputBufferSize)
+    {
+        return JSON_Writer_CallOutputHandler(writer, pBytes, length);
+    }
+    available = writer->outputBufferSize - writer->outputBufferUsed;
+    while (length > available)
+    {
+        if (!writer->outputBufferUsed)
+        {
+            /* The output won't fit in an empty buffer, so there's nothing to
+               be gained by copying it. */
+            return JSON_Writer_CallOutputHandler(writer, pBytes, length);
+        }
+
+        /* Top off the buffer so that the handler always receives full
+           buffers while the writer is producing a steady stream of output. */
+        memcpy(&writer->pOutputBuffer[writer->outputBufferUsed], pBytes, available);
+        writer->outputBufferUsed += available;
+        pBytes += available;
+        length -= available;
+        if (!JSON_Writer_FlushOutputBuffer(writer))
+        {
+            return JSON_Failure;
+        }
+        available = writer->outputBufferSize;
+    }
+    memcpy(&writer->pOutputBuffer[writer->outputBufferUsed], pBytes, length);
+    writer->outputBufferUsed += length;
+    return JSON_Success;
+}
+
 static Codepoint JSON_Writer_GetCodepointEscapeCharacter(JSON_Writer writer, Codepoint c)
 {
     switch (c)
@@ -3318,7 +9101,12 @@ static void WriteBuffer_Reset(WriteBuffer buffer)
 
 static JSON_Status WriteBuffer_Flush(WriteBuffer buffer, JSON_Writer writer)
 {
-    JSON_Status status = JSON_Writer_OutputBytes(writer, buffer->bytes, buffer->used);
+    JSON_Status status;
+    if (!buffer->used)
+    {
+        return JSON_Success;
+    }
+    status = JSON_Writer_OutputBytes(writer, buffer->bytes, buffer->used);
     buffer->used = 0;
     return status;
 }
@@ -3747,6 +9535,568 @@ static JSON_Status JSON_Writer_OutputNumber(JSON_Writer writer, const byte* pByt
     return JSON_Success;
 }
 
+/* Numbers written by JSON_Writer_WriteInt64(), JSON_Writer_WriteUInt64()
+   and JSON_Writer_WriteDouble() are formatted as ASCII into a small local
+   buffer and then output directly, without being re-lexed, since the
+   formatting routines only ever produce valid JSON numbers.
+
+   Integers are formatted two digits at a time, right to left, from a table
+   of digit pairs.
+
+   Doubles are formatted with Florian Loitsch's Grisu3 algorithm, which
+   uses only 64-bit integer arithmetic to produce the shortest digit string
+   that round-trips to the same value. For the roughly 0.5% of values where
+   Grisu3 cannot prove its result is the shortest, we fall back to a slower
+   search using sprintf() and strtod(). */
+
+#define MAX_FORMATTED_NUMBER_LENGTH 32
+#define UINT64_FROM_PARTS(hi, lo)   (((JSON_UInt64)(hi) << 32) | (JSON_UInt64)(lo))
+
+static const char digitPairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/* Formats an unsigned integer into the bytes immediately preceding pEnd
+   and returns a pointer to the first digit. */
+static byte* FormatUInt64(JSON_UInt64 value, byte* pEnd)
+{
+    unsigned long smallValue;
+    size_t pair;
+
+    /* Peel off digit pairs with 64-bit division only while the value does
+       not fit in 32 bits. */
+    while (value > 0xFFFFFFFFUL)
+    {
+        pair = (size_t)(value % 100) * 2;
+        value /= 100;
+        *--pEnd = (byte)digitPairs[pair + 1];
+        *--pEnd = (byte)digitPairs[pair];
+    }
+    smallValue = (unsigned long)value;
+    while (smallValue >= 100)
+    {
+        pair = (size_t)(smallValue % 100) * 2;
+        smallValue /= 100;
+        *--pEnd = (byte)digitPairs[pair + 1];
+        *--pEnd = (byte)digitPairs[pair];
+    }
+    if (smallValue >= 10)
+    {
+        pair = (size_t)smallValue * 2;
+        *--pEnd = (byte)digitPairs[pair + 1];
+        *--pEnd = (byte)digitPairs[pair];
+    }
+    else
+    {
+        *--pEnd = (byte)('0' + smallValue);
+    }
+    return pEnd;
+}
+
+/* Formats a signed integer into the bytes immediately preceding pEnd and
+   returns a pointer to the first character. */
+static byte* FormatInt64(JSON_Int64 value, byte* pEnd)
+{
+    byte* pStart;
+    if (value < 0)
+    {
+        /* Negate in unsigned arithmetic so that the most negative value
+           does not overflow. */
+        pStart = FormatUInt64((JSON_UInt64)0 - (JSON_UInt64)value, pEnd);
+        *--pStart = '-';
+    }
+    else
+    {
+        pStart = FormatUInt64((JSON_UInt64)value, pEnd);
+    }
+    return pStart;
+}
+
+#define DOUBLE_SIGN_MASK        UINT64_FROM_PARTS(0x80000000, 0x00000000)
+#define DOUBLE_EXPONENT_MASK    UINT64_FROM_PARTS(0x7FF00000, 0x00000000)
+#define DOUBLE_SIGNIFICAND_MASK UINT64_FROM_PARTS(0x000FFFFF, 0xFFFFFFFF)
+#define DOUBLE_HIDDEN_BIT       UINT64_FROM_PARTS(0x00100000, 0x00000000)
+#define DOUBLE_SIGNIFICAND_BITS 52
+#define DOUBLE_EXPONENT_BIAS    1075 /* 1023 + 52 */
+
+static JSON_UInt64 DoubleToBits(double value)
+{
+    JSON_UInt64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+static double BitsToDouble(JSON_UInt64 bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+/* A "do-it-yourself" floating-point value: f * 2^e. */
+typedef struct tag_DiyFp
+{
+    JSON_UInt64 f;
+    int         e;
+} DiyFp;
+
+static DiyFp DiyFp_Multiply(DiyFp x, DiyFp y)
+{
+    /* Multiply the significands as 32-bit halves, keeping the rounded
+       upper 64 bits of the 128-bit product. */
+    JSON_UInt64 a = x.f >> 32;
+    JSON_UInt64 b = x.f & 0xFFFFFFFFUL;
+    JSON_UInt64 c = y.f >> 32;
+    JSON_UInt64 d = y.f & 0xFFFFFFFFUL;
+    JSON_UInt64 ac = a * c;
+    JSON_UInt64 bc = b * c;
+    JSON_UInt64 ad = a * d;
+    JSON_UInt64 bd = b * d;
+    JSON_UInt64 middle = (bd >> 32) + (ad & 0xFFFFFFFFUL) + (bc & 0xFFFFFFFFUL) + ((JSON_UInt64)1 << 31);
+    DiyFp product;
+    product.f = ac + (ad >> 32) + (bc >> 32) + (middle >> 32);
+    product.e = x.e + y.e + 64;
+    return product;
+}
+
+static DiyFp DiyFp_Normalize(DiyFp x)
+{
+    while (!(x.f & UINT64_FROM_PARTS(0xFFC00000, 0x00000000)))
+    {
+        x.f <<= 10;
+        x.e -= 10;
+    }
+    while (!(x.f & DOUBLE_SIGN_MASK))
+    {
+        x.f <<= 1;
+        x.e--;
+    }
+    return x;
+}
+
+/* Normalized powers of ten from 10^-348 to 10^340 in steps of 10^8. */
+static const DiyFp cachedPowersOf10[87] =
+{
+    { UINT64_FROM_PARTS(0xfa8fd5a0, 0x081c0288), -1220 },
+    { UINT64_FROM_PARTS(0xbaaee17f, 0xa23ebf76), -1193 },
+    { UINT64_FROM_PARTS(0x8b16fb20, 0x3055ac76), -1166 },
+    { UINT64_FROM_PARTS(0xcf42894a, 0x5dce35ea), -1140 },
+    { UINT64_FROM_PARTS(0x9a6bb0aa, 0x55653b2d), -1113 },
+    { UINT64_FROM_PARTS(0xe61acf03, 0x3d1a45df), -1087 },
+    { UINT64_FROM_PARTS(0xab70fe17, 0xc79ac6ca), -1060 },
+    { UINT64_FROM_PARTS(0xff77b1fc, 0xbebcdc4f), -1034 },
+    { UINT64_FROM_PARTS(0xbe5691ef, 0x416bd60c), -1007 },
+    { UINT64_FROM_PARTS(0x8dd01fad, 0x907ffc3c), -980 },
+    { UINT64_FROM_PARTS(0xd3515c28, 0x31559a83), -954 },
+    { UINT64_FROM_PARTS(0x9d71ac8f, 0xada6c9b5), -927 },
+    { UINT64_FROM_PARTS(0xea9c2277, 0x23ee8bcb), -901 },
+    { UINT64_FROM_PARTS(0xaecc4991, 0x4078536d), -874 },
+    { UINT64_FROM_PARTS(0x823c1279, 0x5db6ce57), -847 },
+    { UINT64_FROM_PARTS(0xc2109436, 0x4dfb5637), -821 },
+    { UINT64_FROM_PARTS(0x9096ea6f, 0x3848984f), -794 },
+    { UINT64_FROM_PARTS(0xd77485cb, 0x25823ac7), -768 },
+    { UINT64_FROM_PARTS(0xa086cfcd, 0x97bf97f4), -741 },
+    { UINT64_FROM_PARTS(0xef340a98, 0x172aace5), -715 },
+    { UINT64_FROM_PARTS(0xb23867fb, 0x2a35b28e), -688 },
+    { UINT64_FROM_PARTS(0x84c8d4df, 0xd2c63f3b), -661 },
+    { UINT64_FROM_PARTS(0xc5dd4427, 0x1ad3cdba), -635 },
+    { UINT64_FROM_PARTS(0x936b9fce, 0xbb25c996), -608 },
+    { UINT64_FROM_PARTS(0xdbac6c24, 0x7d62a584), -582 },
+    { UINT64_FROM_PARTS(0xa3ab6658, 0x0d5fdaf6), -555 },
+    { UINT64_FROM_PARTS(0xf3e2f893, 0xdec3f126), -529 },
+    { UINT64_FROM_PARTS(0xb5b5ada8, 0xaaff80b8), -502 },
+    { UINT64_FROM_PARTS(0x87625f05, 0x6c7c4a8b), -475 },
+    { UINT64_FROM_PARTS(0xc9bcff60, 0x34c13053), -449 },
+    { UINT64_FROM_PARTS(0x964e858c, 0x91ba2655), -422 },
+    { UINT64_FROM_PARTS(0xdff97724, 0x70297ebd), -396 },
+    { UINT64_FROM_PARTS(0xa6dfbd9f, 0xb8e5b88f), -369 },
+    { UINT64_FROM_PARTS(0xf8a95fcf, 0x88747d94), -343 },
+    { UINT64_FROM_PARTS(0xb9447093, 0x8fa89bcf), -316 },
+    { UINT64_FROM_PARTS(0x8a08f0f8, 0xbf0f156b), -289 },
+    { UINT64_FROM_PARTS(0xcdb02555, 0x653131b6), -263 },
+    { UINT64_FROM_PARTS(0x993fe2c6, 0xd07b7fac), -236 },
+    { UINT64_FROM_PARTS(0xe45c10c4, 0x2a2b3b06), -210 },
+    { UINT64_FROM_PARTS(0xaa242499, 0x697392d3), -183 },
+    { UINT64_FROM_PARTS(0xfd87b5f2, 0x8300ca0e), -157 },
+    { UINT64_FROM_PARTS(0xbce50864, 0x92111aeb), -130 },
+    { UINT64_FROM_PARTS(0x8cbccc09, 0x6f5088cc), -103 },
+    { UINT64_FROM_PARTS(0xd1b71758, 0xe219652c), -77 },
+    { UINT64_FROM_PARTS(0x9c400000, 0x00000000), -50 },
+    { UINT64_FROM_PARTS(0xe8d4a510, 0x00000000), -24 },
+    { UINT64_FROM_PARTS(0xad78ebc5, 0xac620000), 3 },
+    { UINT64_FROM_PARTS(0x813f3978, 0xf8940984), 30 },
+    { UINT64_FROM_PARTS(0xc097ce7b, 0xc90715b3), 56 },
+    { UINT64_FROM_PARTS(0x8f7e32ce, 0x7bea5c70), 83 },
+    { UINT64_FROM_PARTS(0xd5d238a4, 0xabe98068), 109 },
+    { UINT64_FROM_PARTS(0x9f4f2726, 0x179a2245), 136 },
+    { UINT64_FROM_PARTS(0xed63a231, 0xd4c4fb27), 162 },
+    { UINT64_FROM_PARTS(0xb0de6538, 0x8cc8ada8), 189 },
+    { UINT64_FROM_PARTS(0x83c7088e, 0x1aab65db), 216 },
+    { UINT64_FROM_PARTS(0xc45d1df9, 0x42711d9a), 242 },
+    { UINT64_FROM_PARTS(0x924d692c, 0xa61be758), 269 },
+    { UINT64_FROM_PARTS(0xda01ee64, 0x1a708dea), 295 },
+    { UINT64_FROM_PARTS(0xa26da399, 0x9aef774a), 322 },
+    { UINT64_FROM_PARTS(0xf209787b, 0xb47d6b85), 348 },
+    { UINT64_FROM_PARTS(0xb454e4a1, 0x79dd1877), 375 },
+    { UINT64_FROM_PARTS(0x865b8692, 0x5b9bc5c2), 402 },
+    { UINT64_FROM_PARTS(0xc83553c5, 0xc8965d3d), 428 },
+    { UINT64_FROM_PARTS(0x952ab45c, 0xfa97a0b3), 455 },
+    { UINT64_FROM_PARTS(0xde469fbd, 0x99a05fe3), 481 },
+    { UINT64_FROM_PARTS(0xa59bc234, 0xdb398c25), 508 },
+    { UINT64_FROM_PARTS(0xf6c69a72, 0xa3989f5c), 534 },
+    { UINT64_FROM_PARTS(0xb7dcbf53, 0x54e9bece), 561 },
+    { UINT64_FROM_PARTS(0x88fcf317, 0xf22241e2), 588 },
+    { UINT64_FROM_PARTS(0xcc20ce9b, 0xd35c78a5), 614 },
+    { UINT64_FROM_PARTS(0x98165af3, 0x7b2153df), 641 },
+    { UINT64_FROM_PARTS(0xe2a0b5dc, 0x971f303a), 667 },
+    { UINT64_FROM_PARTS(0xa8d9d153, 0x5ce3b396), 694 },
+    { UINT64_FROM_PARTS(0xfb9b7cd9, 0xa4a7443c), 720 },
+    { UINT64_FROM_PARTS(0xbb764c4c, 0xa7a44410), 747 },
+    { UINT64_FROM_PARTS(0x8bab8eef, 0xb6409c1a), 774 },
+    { UINT64_FROM_PARTS(0xd01fef10, 0xa657842c), 800 },
+    { UINT64_FROM_PARTS(0x9b10a4e5, 0xe9913129), 827 },
+    { UINT64_FROM_PARTS(0xe7109bfb, 0xa19c0c9d), 853 },
+    { UINT64_FROM_PARTS(0xac2820d9, 0x623bf429), 880 },
+    { UINT64_FROM_PARTS(0x80444b5e, 0x7aa7cf85), 907 },
+    { UINT64_FROM_PARTS(0xbf21e440, 0x03acdd2d), 933 },
+    { UINT64_FROM_PARTS(0x8e679c2f, 0x5e44ff8f), 960 },
+    { UINT64_FROM_PARTS(0xd433179d, 0x9c8cb841), 986 },
+    { UINT64_FROM_PARTS(0x9e19db92, 0xb4e31ba9), 1013 },
+    { UINT64_FROM_PARTS(0xeb96bf6e, 0xbadf77d9), 1039 },
+    { UINT64_FROM_PARTS(0xaf87023b, 0x9bf0ee6b), 1066 }
+};
+
+static const JSON_UInt64 integerPowersOf10[20] =
+{
+    UINT64_FROM_PARTS(0x00000000, 0x00000001), UINT64_FROM_PARTS(0x00000000, 0x0000000A),
+    UINT64_FROM_PARTS(0x00000000, 0x00000064), UINT64_FROM_PARTS(0x00000000, 0x000003E8),
+    UINT64_FROM_PARTS(0x00000000, 0x00002710), UINT64_FROM_PARTS(0x00000000, 0x000186A0),
+    UINT64_FROM_PARTS(0x00000000, 0x000F4240), UINT64_FROM_PARTS(0x00000000, 0x00989680),
+    UINT64_FROM_PARTS(0x00000000, 0x05F5E100), UINT64_FROM_PARTS(0x00000000, 0x3B9ACA00),
+    UINT64_FROM_PARTS(0x00000002, 0x540BE400), UINT64_FROM_PARTS(0x00000017, 0x4876E800),
+    UINT64_FROM_PARTS(0x000000E8, 0xD4A51000), UINT64_FROM_PARTS(0x00000918, 0x4E72A000),
+    UINT64_FROM_PARTS(0x00005AF3, 0x107A4000), UINT64_FROM_PARTS(0x00038D7E, 0xA4C68000),
+    UINT64_FROM_PARTS(0x002386F2, 0x6FC10000), UINT64_FROM_PARTS(0x01634578, 0x5D8A0000),
+    UINT64_FROM_PARTS(0x0DE0B6B3, 0xA7640000), UINT64_FROM_PARTS(0x8AC72304, 0x89E80000)
+};
+
+static DiyFp GetCachedPowerOf10(int e, int* pK)
+{
+    /* Select the cached power c = 10^-k such that the exponent of the
+       product of c and a normalized value with binary exponent e lies in
+       the range [-60, -32]. */
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = (int)dk;
+    size_t index;
+    if (dk - k > 0.0)
+    {
+        k++;
+    }
+    index = (size_t)((k >> 3) + 1);
+    *pK = 348 - (int)index * 8;
+    return cachedPowersOf10[index];
+}
+
+static int CountDecimalDigits(unsigned long value)
+{
+    int count = 1;
+    while (value >= 10)
+    {
+        value /= 10;
+        count++;
+    }
+    return count;
+}
+
+/* Moves the last generated digit down while doing so brings the number
+   closer to the exact value, then reports whether the result is provably
+   the shortest and closest representation. */
+static int Grisu3_RoundWeed(byte* pDigits, int length, JSON_UInt64 distanceTooHighW, JSON_UInt64 unsafeInterval, JSON_UInt64 rest, JSON_UInt64 tenKappa, JSON_UInt64 unit)
+{
+    JSON_UInt64 smallDistance = distanceTooHighW - unit;
+    JSON_UInt64 bigDistance = distanceTooHighW + unit;
+    while (rest < smallDistance && unsafeInterval - rest >= tenKappa &&
+           (rest + tenKappa < smallDistance || smallDistance - rest >= rest + tenKappa - smallDistance))
+    {
+        pDigits[length - 1]--;
+        rest += tenKappa;
+    }
+    if (rest < bigDistance && unsafeInterval - rest >= tenKappa &&
+        (rest + tenKappa < bigDistance || bigDistance - rest > rest + tenKappa - bigDistance))
+    {
+        return 0;
+    }
+    return (2 * unit <= rest) && (rest <= unsafeInterval - 4 * unit);
+}
+
+static int Grisu3_GenerateDigits(DiyFp low, DiyFp w, DiyFp high, byte* pDigits, int* pLength, int* pKappa)
+{
+    int shift = -w.e;
+    JSON_UInt64 one = (JSON_UInt64)1 << shift;
+    JSON_UInt64 unit = 1;
+    JSON_UInt64 tooLow = low.f - unit;
+    JSON_UInt64 tooHigh = high.f + unit;
+    JSON_UInt64 unsafeInterval = tooHigh - tooLow;
+    unsigned long integral = (unsigned long)(tooHigh >> shift);
+    JSON_UInt64 fractional = tooHigh & (one - 1);
+    int kappa = CountDecimalDigits(integral);
+    int length = 0;
+
+    /* Digits of the integral part. */
+    while (kappa > 0)
+    {
+        unsigned long divisor = (unsigned long)integerPowersOf10[kappa - 1];
+        JSON_UInt64 rest;
+        pDigits[length++] = (byte)('0' + integral / divisor);
+        integral %= divisor;
+        kappa--;
+        rest = ((JSON_UInt64)integral << shift) + fractional;
+        if (rest < unsafeInterval)
+        {
+            *pLength = length;
+            *pKappa = kappa;
+            return Grisu3_RoundWeed(pDigits, length, tooHigh - w.f, unsafeInterval, rest, (JSON_UInt64)divisor << shift, unit);
+        }
+    }
+
+    /* Digits of the fractional part. */
+    for (;;)
+    {
+        fractional *= 10;
+        unit *= 10;
+        unsafeInterval *= 10;
+        pDigits[length++] = (byte)('0' + (fractional >> shift));
+        fractional &= one - 1;
+        kappa--;
+        if (fractional < unsafeInterval)
+        {
+            *pLength = length;
+            *pKappa = kappa;
+            return Grisu3_RoundWeed(pDigits, length, (tooHigh - w.f) * unit, unsafeInterval, fractional, one, unit);
+        }
+    }
+}
+
+/* Generates the shortest digits of a positive, finite, non-zero double
+   into pDigits. On success, returns non-zero and sets *pLength to the
+   number of digits and *pK such that the value is digits * 10^k. Returns
+   zero for the small fraction of values for which the result cannot be
+   guaranteed to be the shortest. */
+static int Grisu3(JSON_UInt64 bits, byte* pDigits, int* pLength, int* pK)
+{
+    int biasedExponent = (int)((bits & DOUBLE_EXPONENT_MASK) >> DOUBLE_SIGNIFICAND_BITS);
+    DiyFp v, upper, lower, cachedPower, w;
+    int kappa;
+
+    v.f = bits & DOUBLE_SIGNIFICAND_MASK;
+    if (biasedExponent)
+    {
+        v.f += DOUBLE_HIDDEN_BIT;
+        v.e = biasedExponent - DOUBLE_EXPONENT_BIAS;
+    }
+    else
+    {
+        v.e = 1 - DOUBLE_EXPONENT_BIAS;
+    }
+
+    /* The boundaries of the rounding interval are the midpoints between v
+       and its neighbours; the lower neighbour is closer when v is a power
+       of two (other than the smallest normal value). */
+    upper.f = (v.f << 1) + 1;
+    upper.e = v.e - 1;
+    upper = DiyFp_Normalize(upper);
+    if (v.f == DOUBLE_HIDDEN_BIT && biasedExponent > 1)
+    {
+        lower.f = (v.f << 2) - 1;
+        lower.e = v.e - 2;
+    }
+    else
+    {
+        lower.f = (v.f << 1) - 1;
+        lower.e = v.e - 1;
+    }
+    lower.f <<= lower.e - upper.e;
+    lower.e = upper.e;
+
+    cachedPower = GetCachedPowerOf10(upper.e, pK);
+    w = DiyFp_Multiply(DiyFp_Normalize(v), cachedPower);
+    upper = DiyFp_Multiply(upper, cachedPower);
+    lower = DiyFp_Multiply(lower, cachedPower);
+    if (!Grisu3_GenerateDigits(lower, w, upper, pDigits, pLength, &kappa))
+    {
+        return 0;
+    }
+    *pK += kappa;
+    return 1;
+}
+
+/* Generates the shortest digits of a positive, finite, non-zero double by
+   brute force, for the rare values that Grisu3 rejects. Both sprintf() and
+   strtod() round correctly, and only the digits and exponent of their text
+   are used, so the locale's decimal point does not matter. */
+static int FormatDigitsSlowly(double value, byte* pDigits, int* pK)
+{
+    char text[MAX_FORMATTED_NUMBER_LENGTH];
+    int precision;
+    int length = 0;
+    for (precision = 1; precision <= 17; precision++)
+    {
+        const char* pChar;
+        sprintf(text, "%.*e", precision - 1, value);
+        length = 0;
+        for (pChar = text; *pChar != 'e'; pChar++)
+        {
+            if (*pChar >= '0' && *pChar <= '9')
+            {
+                pDigits[length++] = (byte)*pChar;
+            }
+        }
+        *pK = atoi(pChar + 1) - (length - 1);
+        memcpy(text, pDigits, (size_t)length);
+        sprintf(text + length, "e%d", *pK);
+        if (strtod(text, NULL) == value)
+        {
+            break;
+        }
+    }
+    return length;
+}
+
+static byte* FormatExponent(int exponent, byte* pChars)
+{
+    if (exponent < 0)
+    {
+        *pChars++ = '-';
+        exponent = -exponent;
+    }
+    if (exponent >= 100)
+    {
+        *pChars++ = (byte)('0' + exponent / 100);
+        exponent %= 100;
+        *pChars++ = (byte)digitPairs[exponent * 2];
+        *pChars++ = (byte)digitPairs[exponent * 2 + 1];
+    }
+    else if (exponent >= 10)
+    {
+        *pChars++ = (byte)digitPairs[exponent * 2];
+        *pChars++ = (byte)digitPairs[exponent * 2 + 1];
+    }
+    else
+    {
+        *pChars++ = (byte)('0' + exponent);
+    }
+    return pChars;
+}
+
+/* Lays out the digits in pChars, representing the value digits * 10^k,
+   as a JSON number, and returns a pointer past the last character. Values
+   with no fractional part keep a trailing ".0" so that they are read back
+   as floating-point numbers. */
+static byte* FormatDecimal(byte* pChars, int length, int k)
+{
+    int exponent = length + k; /* 10^(exponent - 1) <= value < 10^exponent */
+    int i;
+    if (k >= 0 && exponent <= 21)
+    {
+        /* 1234e7 -> 12340000000.0 */
+        for (i = length; i < exponent; i++)
+        {
+            pChars[i] = '0';
+        }
+        pChars[exponent] = '.';
+        pChars[exponent + 1] = '0';
+        return &pChars[exponent + 2];
+    }
+    if (exponent > 0 && exponent <= 21)
+    {
+        /* 1234e-2 -> 12.34 */
+        memmove(&pChars[exponent + 1], &pChars[exponent], (size_t)(length - exponent));
+        pChars[exponent] = '.';
+        return &pChars[length + 1];
+    }
+    if (exponent > -6 && exponent <= 0)
+    {
+        /* 1234e-6 -> 0.001234 */
+        int offset = 2 - exponent;
+        memmove(&pChars[offset], &pChars[0], (size_t)length);
+        pChars[0] = '0';
+        pChars[1] = '.';
+        for (i = 2; i < offset; i++)
+        {
+            pChars[i] = '0';
+        }
+        return &pChars[length + offset];
+    }
+    if (length == 1)
+    {
+        /* 1e30 */
+        pChars[1] = 'e';
+        return FormatExponent(exponent - 1, &pChars[2]);
+    }
+    /* 1234e30 -> 1.234e33 */
+    memmove(&pChars[2], &pChars[1], (size_t)(length - 1));
+    pChars[1] = '.';
+    pChars[length + 1] = 'e';
+    return FormatExponent(exponent - 1, &pChars[length + 2]);
+}
+
+/* Formats a finite double into pChars, which must be at least
+   MAX_FORMATTED_NUMBER_LENGTH bytes long, and returns the length. */
+static size_t FormatDouble(JSON_UInt64 bits, byte* pChars)
+{
+    byte* pStart = pChars;
+    if (bits & DOUBLE_SIGN_MASK)
+    {
+        *pChars++ = '-';
+        bits &= ~DOUBLE_SIGN_MASK;
+    }
+    if (!bits)
+    {
+        pChars[0] = '0';
+        pChars[1] = '.';
+        pChars[2] = '0';
+        pChars += 3;
+    }
+    else
+    {
+        int length;
+        int k;
+        if (!Grisu3(bits, pChars, &length, &k))
+        {
+            length = FormatDigitsSlowly(BitsToDouble(bits), pChars, &k);
+        }
+        pChars = FormatDecimal(pChars, length, k);
+    }
+    return (size_t)(pChars - pStart);
+}
+
+static JSON_Status JSON_Writer_OutputFormattedNumber(JSON_Writer writer, const byte* pChars, size_t length)
+{
+    WriteBufferData bufferData;
+    size_t i;
+    if (writer->outputEncoding == JSON_UTF8)
+    {
+        return JSON_Writer_OutputBytes(writer, pChars, length);
+    }
+    WriteBuffer_Reset(&bufferData);
+    for (i = 0; i < length; i++)
+    {
+        if (!WriteBuffer_WriteCodepoint(&bufferData, writer, pChars[i]))
+        {
+            return JSON_Failure;
+        }
+    }
+    return WriteBuffer_Flush(&bufferData, writer);
+}
+
 #define SPACES_PER_CHUNK 8
 static JSON_Status JSON_Writer_OutputSpaces(JSON_Writer writer, size_t numberOfSpaces)
 {
@@ -3825,6 +10175,7 @@ JSON_Status JSON_CALL JSON_Writer_Free(JSON_Writer writer)
         return JSON_Failure;
     }
     SET_FLAGS_ON(WriterState, writer->state, WRITER_IN_PROTECTED_API);
+    JSON_Writer_FreeOutputBuffer(writer);
     Grammarian_FreeAllocations(&writer->grammarianData, &writer->memorySuite);
     writer->memorySuite.free(writer->memorySuite.userData, writer);
     return JSON_Success;
@@ -3917,6 +10268,36 @@ JSON_Status JSON_CALL JSON_Writer_SetEscapeAllNonASCIICharacters(JSON_Writer wri
     return JSON_Success;
 }
 
+size_t JSON_CALL JSON_Writer_GetOutputBufferSize(JSON_Writer writer)
+{
+    return writer ? writer->outputBufferSize : 0;
+}
+
+JSON_Status JSON_CALL JSON_Writer_SetOutputBuffer(JSON_Writer writer, char* pBuffer, size_t size)
+{
+    byte* pNewBuffer = (byte*)pBuffer;
+    if (!writer || GET_FLAGS(writer->state, WRITER_STARTED))
+    {
+        return JSON_Failure;
+    }
+    if (size && !pNewBuffer)
+    {
+        pNewBuffer = (byte*)writer->memorySuite.realloc(writer->memorySuite.userData, NULL, size);
+        if (!pNewBuffer)
+        {
+            return JSON_Failure;
+        }
+    }
+    JSON_Writer_FreeOutputBuffer(writer);
+    if (size)
+    {
+        writer->pOutputBuffer = pNewBuffer;
+        writer->outputBufferSize = size;
+        SET_FLAGS(WriterFlags, writer->flags, WRITER_OWNS_BUFFER, !pBuffer);
+    }
+    return JSON_Success;
+}
+
 JSON_Error JSON_CALL JSON_Writer_GetError(JSON_Writer writer)
 {
     return writer ? (JSON_Error)writer->error : JSON_Error_None;
@@ -3937,6 +10318,18 @@ JSON_Status JSON_CALL JSON_Writer_SetOutputHandler(JSON_Writer writer, JSON_Writ
     return JSON_Success;
 }
 
+JSON_Status JSON_CALL JSON_Writer_Flush(JSON_Writer writer)
+{
+    JSON_Status status = JSON_Failure;
+    if (writer && !GET_FLAGS(writer->state, WRITER_IN_PROTECTED_API))
+    {
+        SET_FLAGS_ON(WriterState, writer->state, WRITER_IN_PROTECTED_API);
+        status = JSON_Writer_FlushOutputBuffer(writer);
+        SET_FLAGS_OFF(WriterState, writer->state, WRITER_IN_PROTECTED_API);
+    }
+    return status;
+}
+
 JSON_Status JSON_CALL JSON_Writer_WriteNull(JSON_Writer writer)
 {
     static const byte nullUTF8[] = { 'n', 'u', 'l', 'l' };
@@ -4009,6 +10402,49 @@ JSON_Status JSON_CALL JSON_Writer_WriteNumber(JSON_Writer writer, const char* pV
     return status;
 }
 
+static JSON_Status JSON_Writer_WriteFormattedNumber(JSON_Writer writer, const byte* pChars, size_t length)
+{
+    JSON_Status status = JSON_Failure;
+    if (writer && !GET_FLAGS(writer->state, WRITER_IN_PROTECTED_API) && writer->error == JSON_Error_None)
+    {
+        SET_FLAGS_ON(WriterState, writer->state, WRITER_STARTED | WRITER_IN_PROTECTED_API);
+        if (JSON_Writer_ProcessToken(writer, T_NUMBER))
+        {
+            status = JSON_Writer_OutputFormattedNumber(writer, pChars, length);
+        }
+        SET_FLAGS_OFF(WriterState, writer->state, WRITER_IN_PROTECTED_API);
+    }
+    return status;
+}
+
+JSON_Status JSON_CALL JSON_Writer_WriteInt64(JSON_Writer writer, JSON_Int64 value)
+{
+    byte chars[MAX_FORMATTED_NUMBER_LENGTH];
+    byte* pEnd = chars + sizeof(chars);
+    byte* pStart = FormatInt64(value, pEnd);
+    return JSON_Writer_WriteFormattedNumber(writer, pStart, (size_t)(pEnd - pStart));
+}
+
+JSON_Status JSON_CALL JSON_Writer_WriteUInt64(JSON_Writer writer, JSON_UInt64 value)
+{
+    byte chars[MAX_FORMATTED_NUMBER_LENGTH];
+    byte* pEnd = chars + sizeof(chars);
+    byte* pStart = FormatUInt64(value, pEnd);
+    return JSON_Writer_WriteFormattedNumber(writer, pStart, (size_t)(pEnd - pStart));
+}
+
+JSON_Status JSON_CALL JSON_Writer_WriteDouble(JSON_Writer writer, double value)
+{
+    byte chars[MAX_FORMATTED_NUMBER_LENGTH];
+    JSON_UInt64 bits = DoubleToBits(value);
+    if ((bits & DOUBLE_EXPONENT_MASK) == DOUBLE_EXPONENT_MASK)
+    {
+        /* NaN and infinity cannot be written as JSON numbers. */
+        return JSON_Failure;
+    }
+    return JSON_Writer_WriteFormattedNumber(writer, chars, FormatDouble(bits, chars));
+}
+
 JSON_Status JSON_CALL JSON_Writer_WriteSpecialNumber(JSON_Writer writer, JSON_SpecialNumber value)
 {
     static const byte nanUTF8[] = { 'N', 'a', 'N' };
@@ -4174,7 +10610,8 @@ const char* JSON_CALL JSON_ErrorString(JSON_Error error)
     /* JSON_Error_InvalidNumber */                   "the input contains an invalid number",
     /* JSON_Error_TooLongNumber */                   "the input contains a number that is too long",
     /* JSON_Error_DuplicateObjectMember */           "the input contains an object with duplicate members",
-    /* JSON_Error_StoppedAfterEmbeddedDocument */    "the end of the embedded document was reached"
+    /* JSON_Error_StoppedAfterEmbeddedDocument */    "the end of the embedded document was reached",
+    /* JSON_Error_CannotReadInput */                 "the input could not be read"
     };
     return ((unsigned int)error < (sizeof(errorStrings) / sizeof(errorStrings[0])))
         ? errorStrings[error]
@@ -35,8 +35,27 @@
 #error JSON_NO_PARSER and JSON_NO_WRITER cannot both be defined!
 #endif
 
+/* JSON_NO_THREADS, if defined, makes the parallel parsing APIs do all of
+ * their work on the calling thread, so that the library does not depend
+ * on the platform's threads.
+ *
+ * JSON_NO_MMAP, if defined, makes JSON_Parser_ParseFile() and
+ * JSON_Parser_ParseFd() always read files in chunks rather than mapping
+ * them into memory.
+ */
+
 #include <stddef.h> /* for size_t and NULL */
 
+/* Ensure 64-bit integer types (compiler-dependent). */
+#if defined(_MSC_VER)
+typedef __int64 JSON_Int64;
+typedef unsigned __int64 JSON_UInt64;
+#else
+#include <stdint.h>
+typedef int64_t JSON_Int64;
+typedef uint64_t JSON_UInt64;
+#endif
+
 /* The library API is C and should not be subjected to C++ name mangling. */
 #ifdef __cplusplus
 extern "C" {
@@ -115,7 +134,8 @@ typedef enum tag_JSON_Error
     JSON_Error_InvalidNumber                   = 13,
     JSON_Error_TooLongNumber                   = 14,
     JSON_Error_DuplicateObjectMember           = 15,
-    JSON_Error_StoppedAfterEmbeddedDocument    = 16
+    JSON_Error_StoppedAfterEmbeddedDocument    = 16,
+    JSON_Error_CannotReadInput                 = 17
 } JSON_Error;
 
 /* Text encodings. */
@@ -137,7 +157,8 @@ typedef enum tag_JSON_StringAttribute
     JSON_ContainsControlCharacter  = 1 << 1, /* U+0000 - U+001F */
     JSON_ContainsNonASCIICharacter = 1 << 2, /* U+0080 - U+10FFFF */
     JSON_ContainsNonBMPCharacter   = 1 << 3, /* U+10000 - U+10FFFF */
-    JSON_ContainsReplacedCharacter = 1 << 4  /* an invalid encoding sequence was replaced by U+FFFD */
+    JSON_ContainsReplacedCharacter = 1 << 4, /* an invalid encoding sequence was replaced by U+FFFD */
+    JSON_PointsIntoInput           = 1 << 5  /* the value points into the input and is not null-terminated */
 } JSON_StringAttribute;
 typedef unsigned int JSON_StringAttributes;
 
@@ -149,10 +170,30 @@ typedef enum tag_JSON_NumberAttribute
     JSON_IsHex                    = 1 << 1,
     JSON_ContainsDecimalPoint     = 1 << 2,
     JSON_ContainsExponent         = 1 << 3,
-    JSON_ContainsNegativeExponent = 1 << 4
+    JSON_ContainsNegativeExponent = 1 << 4,
+    JSON_LosesPrecision           = 1 << 5  /* the typed value does not preserve the number exactly */
 } JSON_NumberAttribute;
 typedef unsigned int JSON_NumberAttributes;
 
+/* Native types to which a number value can be converted. */
+typedef enum tag_JSON_NumberType
+{
+    JSON_Int64Number  = 0,
+    JSON_UInt64Number = 1,
+    JSON_DoubleNumber = 2
+} JSON_NumberType;
+
+/* A number value converted to a native type. Only the member that
+ * corresponds to the type member is meaningful.
+ */
+typedef struct tag_JSON_NumberValue
+{
+    JSON_NumberType type;
+    JSON_Int64      int64Value;
+    JSON_UInt64     uint64Value;
+    double          doubleValue;
+} JSON_NumberValue;
+
 /* Types of "special" number. */
 typedef enum tag_JSON_SpecialNumber
 {
@@ -471,6 +512,80 @@ JSON_API(JSON_Status) JSON_Parser_SetTrackObjectMembers(JSON_Parser parser, JSON
 JSON_API(JSON_Boolean) JSON_Parser_GetStopAfterEmbeddedDocument(JSON_Parser parser);
 JSON_API(JSON_Status) JSON_Parser_SetStopAfterEmbeddedDocument(JSON_Parser parser, JSON_Boolean stopAfterEmbeddedDocument);
 
+/* Get and set whether a parser instance passes string values directly from
+ * the input buffer to the string and object member handlers, where
+ * possible, instead of copying them.
+ *
+ * If this setting is enabled, and both the input encoding and the string
+ * encoding are JSON_UTF8, a string that appears in its entirety within the
+ * buffer passed to a single call to JSON_Parser_Parse() and that contains
+ * no escape sequences, control characters or invalid encoding sequences
+ * is passed to the handlers as a pointer into that buffer, and the attributes passed to
+ * the handler include JSON_PointsIntoInput. Such a value is NOT
+ * null-terminated, and the handler must not modify it. All other strings
+ * are copied, null-terminated and passed to the handlers as usual.
+ *
+ * The default value of this setting is JSON_False.
+ *
+ * This setting cannot be changed once the parser has started parsing.
+ */
+JSON_API(JSON_Boolean) JSON_Parser_GetZeroCopyStrings(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetZeroCopyStrings(JSON_Parser parser, JSON_Boolean zeroCopyStrings);
+
+/* Get and set whether a parser instance accepts a stream of JSON documents
+ * rather than a single document.
+ *
+ * If this setting is enabled, the input may contain any number of top-level
+ * values (including none) separated by whitespace, as in newline-delimited
+ * JSON (NDJSON, also known as JSON Lines). The parse handlers are called
+ * for the values of each document in turn, and the start and end document
+ * handlers are called at the boundaries between documents, so that a
+ * client can process an entire stream with a single parser, keeping its
+ * settings, handlers, and allocated buffers from one document to the next.
+ * Note that whitespace is required between two documents only where it
+ * would be required between two tokens, as between two numbers.
+ *
+ * If StopAfterEmbeddedDocument is also enabled, the parser stops after the
+ * first document as usual.
+ *
+ * The default value of this setting is JSON_False.
+ *
+ * This setting cannot be changed once the parser has started parsing.
+ */
+JSON_API(JSON_Boolean) JSON_Parser_GetAllowMultipleDocuments(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetAllowMultipleDocuments(JSON_Parser parser, JSON_Boolean allowMultipleDocuments);
+
+/* Get and set whether a parser instance that accepts multiple documents
+ * skips the documents that are invalid rather than failing.
+ *
+ * If this setting and AllowMultipleDocuments are both enabled, and the
+ * parser encounters an error other than JSON_Error_OutOfMemory,
+ * JSON_Error_AbortedByHandler, or JSON_Error_StoppedAfterEmbeddedDocument,
+ * it abandons the document in which the error occurred, discards the rest
+ * of the line on which the error occurred (up to and including the next
+ * line break), and resumes parsing at the start of the next line. This
+ * allows a stream of newline-delimited documents to survive a malformed
+ * record.
+ *
+ * Before the document is abandoned, the end document handler is called
+ * for it (preceded by the start document handler, if the error occurred
+ * before the document's first token), and JSON_Parser_GetError() and
+ * JSON_Parser_GetErrorLocation() report the error while the handler runs.
+ * The error is cleared once the handler returns. Note that the handlers for
+ * the values that preceded the error in the abandoned document will
+ * already have been called.
+ *
+ * Invalid documents are only skipped when the input is pushed with
+ * JSON_Parser_Parse() and events are not delivered in batches; when events
+ * are pulled or batched, errors are always reported as usual.
+ *
+ * The default value of this setting is JSON_False.
+ *
+ * This setting cannot be changed once the parser has started parsing.
+ */
+JSON_API(JSON_Boolean) JSON_Parser_GetSkipInvalidDocuments(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetSkipInvalidDocuments(JSON_Parser parser, JSON_Boolean skipInvalidDocuments);
+
 /* Get the type of error, if any, encountered by a parser instance.
  *
  * If the parser encountered an error while parsing input, this function
@@ -537,12 +652,24 @@ JSON_API(JSON_Status) JSON_Parser_GetAfterTokenLocation(JSON_Parser parser, JSON
  * Note that JSON_TreatAsDuplicateObjectMember should only be returned by
  * object member handlers. Refer to JSON_Parser_SetObjectMemberHandler()
  * for details.
+ *
+ * JSON_Parser_SkipValue should only be returned by start object, start
+ * array, object member, and array item handlers; it is treated like
+ * JSON_Parser_Abort if it is returned by any other handler. It tells the
+ * parser to skip the rest of the current value (the object or array that
+ * is being started, the value of the object member, or the array item)
+ * without calling any further handlers for it, including the end object or
+ * end array handler of a skipped container. Skipped containers are
+ * scanned quickly for little more than the brackets that end them, so
+ * their contents are not validated beyond the nesting of the brackets,
+ * the boundaries of strings and comments, and the input encoding.
  */
 typedef enum tag_JSON_Parser_HandlerResult
 {
     JSON_Parser_Continue                     = 0,
     JSON_Parser_Abort                        = 1,
-    JSON_Parser_TreatAsDuplicateObjectMember = 2
+    JSON_Parser_TreatAsDuplicateObjectMember = 2,
+    JSON_Parser_SkipValue                    = 3
 } JSON_Parser_HandlerResult;
 
 /* Get and set the handler that is called when a parser instance detects the
@@ -582,7 +709,9 @@ JSON_API(JSON_Status) JSON_Parser_SetBooleanHandler(JSON_Parser parser, JSON_Par
  * buffer is null-terminated (the null terminator character is also encoded).
  * Note, however, that JSON strings may contain embedded null characters,
  * which are specifiable using the escape sequence \u0000. The client is
- * free to modify the contents of the buffer during the handler.
+ * free to modify the contents of the buffer during the handler. (If the
+ * attributes include JSON_PointsIntoInput, however, the buffer is neither
+ * null-terminated nor modifiable; see JSON_Parser_SetZeroCopyStrings().)
  *
  * The length parameter specifies the number of bytes (NOT characters) in
  * the encoded string, not including the encoded null terminator.
@@ -608,7 +737,9 @@ JSON_API(JSON_Status) JSON_Parser_SetStringHandler(JSON_Parser parser, JSON_Pars
  * and different clients may wish to interpret them differently, for
  * example, as IEEE 754 doubles, 64-bit integers, or arbitrary-precision
  * bignums. For this reason, the parser does not attempt to interpret
- * number values, but leaves this to the client.
+ * number values, but leaves this to the client. (Clients that simply want
+ * native integers and doubles can use JSON_Parser_SetTypedNumberHandler()
+ * instead.)
  *
  * The pValue parameter points to a buffer containing the number value,
  * encoded according to the parser instance's number encoding setting. The
@@ -632,6 +763,34 @@ typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_NumberHandler)(JSON_P
 JSON_API(JSON_Parser_NumberHandler) JSON_Parser_GetNumberHandler(JSON_Parser parser);
 JSON_API(JSON_Status) JSON_Parser_SetNumberHandler(JSON_Parser parser, JSON_Parser_NumberHandler handler);
 
+/* Get and set the handler that is called when a parser instance encounters
+ * a JSON number value, for clients that want the value converted to a
+ * native type rather than as text.
+ *
+ * The parser converts the number as it lexes its digits, so the client
+ * does not need to scan the text again with strtod() or strtoll(). The
+ * pValue parameter points to the converted value. An integer (a number
+ * without a decimal point or exponent, or a hex number) is converted to
+ * JSON_Int64Number if it fits in a JSON_Int64, or else to JSON_UInt64Number
+ * if it fits in a JSON_UInt64. All other numbers, including -0, are
+ * converted to JSON_DoubleNumber, using round-to-nearest.
+ *
+ * If the value is JSON_DoubleNumber and the number has more significant
+ * digits than a double is guaranteed to preserve (15), or its magnitude is
+ * too large or too small to be represented by a normal double, the
+ * attributes include JSON_LosesPrecision. If a number handler is also set,
+ * such numbers are passed to the number handler as text INSTEAD of being
+ * passed to the typed number handler, so that the client can interpret
+ * them in some other way; all other numbers are passed only to the typed
+ * number handler. If no number handler is set, all numbers are passed to
+ * the typed number handler.
+ *
+ * Note that the conversion is not affected by the number encoding setting.
+ */
+typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_TypedNumberHandler)(JSON_Parser parser, const JSON_NumberValue* pValue, JSON_NumberAttributes attributes);
+JSON_API(JSON_Parser_TypedNumberHandler) JSON_Parser_GetTypedNumberHandler(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetTypedNumberHandler(JSON_Parser parser, JSON_Parser_TypedNumberHandler handler);
+
 /* Get and set the handler that is called when a parser instance encounters
  * one of the "special" number literals NaN, Infinity, and -Inifinity.
  */
@@ -641,6 +800,8 @@ JSON_API(JSON_Status) JSON_Parser_SetSpecialNumberHandler(JSON_Parser parser, JS
 
 /* Get and set the handler that is called when a parser instance encounters
  * the left curly brace that starts an object.
+ *
+ * The handler can return JSON_Parser_SkipValue to skip the object.
  */
 typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_StartObjectHandler)(JSON_Parser parser);
 JSON_API(JSON_Parser_StartObjectHandler) JSON_Parser_GetStartObjectHandler(JSON_Parser parser);
@@ -661,7 +822,9 @@ JSON_API(JSON_Status) JSON_Parser_SetEndObjectHandler(JSON_Parser parser, JSON_P
  * buffer is null-terminated (the null terminator character is also encoded).
  * Note, however, that JSON strings may contain embedded null characters,
  * which are specifiable using the escape sequence \u0000. The client is
- * free to modify the contents of the buffer during the handler.
+ * free to modify the contents of the buffer during the handler. (If the
+ * attributes include JSON_PointsIntoInput, however, the buffer is neither
+ * null-terminated nor modifiable; see JSON_Parser_SetZeroCopyStrings().)
  *
  * The length parameter specifies the number of bytes (NOT characters) in
  * the encoded string, not including the encoded null terminator.
@@ -681,6 +844,8 @@ JSON_API(JSON_Status) JSON_Parser_SetEndObjectHandler(JSON_Parser parser, JSON_P
  * specified name. This allows clients to implement duplicate member
  * checking without incurring the additional memory overhead associated
  * with enabling the TrackObjectMembers setting.
+ *
+ * The handler can return JSON_Parser_SkipValue to skip the member's value.
  */
 typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_ObjectMemberHandler)(JSON_Parser parser, char* pValue, size_t length, JSON_StringAttributes attributes);
 JSON_API(JSON_Parser_ObjectMemberHandler) JSON_Parser_GetObjectMemberHandler(JSON_Parser parser);
@@ -688,6 +853,8 @@ JSON_API(JSON_Status) JSON_Parser_SetObjectMemberHandler(JSON_Parser parser, JSO
 
 /* Get and set the handler that is called when a parser instance encounters
  * the left square brace that starts an array.
+ *
+ * The handler can return JSON_Parser_SkipValue to skip the array.
  */
 typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_StartArrayHandler)(JSON_Parser parser);
 JSON_API(JSON_Parser_StartArrayHandler) JSON_Parser_GetStartArrayHandler(JSON_Parser parser);
@@ -704,12 +871,37 @@ JSON_API(JSON_Status) JSON_Parser_SetEndArrayHandler(JSON_Parser parser, JSON_Pa
  * an array item.
  *
  * This event is always immediately followed by a null, boolean, string,
- * number, special number, start object, or start array event.
+ * number, special number, start object, or start array event, unless the
+ * handler returns JSON_Parser_SkipValue to skip the item.
  */
 typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_ArrayItemHandler)(JSON_Parser parser);
 JSON_API(JSON_Parser_ArrayItemHandler) JSON_Parser_GetArrayItemHandler(JSON_Parser parser);
 JSON_API(JSON_Status) JSON_Parser_SetArrayItemHandler(JSON_Parser parser, JSON_Parser_ArrayItemHandler handler);
 
+/* Get and set the handlers that are called when a parser instance starts
+ * and finishes parsing a document.
+ *
+ * The start document handler is called immediately before the handler for
+ * the first token of the document, and JSON_Parser_GetTokenLocation()
+ * returns the location of that token. The end document handler is called
+ * immediately after the handler for the last token of the document, and
+ * JSON_Parser_GetTokenLocation() returns the location of that token. If
+ * the parser allows multiple documents, the handlers are called once for
+ * each document in the input; refer to JSON_Parser_SetAllowMultipleDocuments()
+ * and JSON_Parser_SetSkipInvalidDocuments() for details.
+ *
+ * These handlers are not called when events are pulled or delivered in
+ * batches. In that case, each document ends with the event at depth 0 that
+ * is not a start object or start array event.
+ */
+typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_StartDocumentHandler)(JSON_Parser parser);
+JSON_API(JSON_Parser_StartDocumentHandler) JSON_Parser_GetStartDocumentHandler(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetStartDocumentHandler(JSON_Parser parser, JSON_Parser_StartDocumentHandler handler);
+
+typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_EndDocumentHandler)(JSON_Parser parser);
+JSON_API(JSON_Parser_EndDocumentHandler) JSON_Parser_GetEndDocumentHandler(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetEndDocumentHandler(JSON_Parser parser, JSON_Parser_EndDocumentHandler handler);
+
 /* Push zero or more bytes of input to a parser instance.
  *
  * The pBytes parameter points to a buffer containing the bytes to be
@@ -734,6 +926,982 @@ JSON_API(JSON_Status) JSON_Parser_SetArrayItemHandler(JSON_Parser parser, JSON_P
  */
 JSON_API(JSON_Status) JSON_Parser_Parse(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal);
 
+/* Parse the entire contents of a file with a parser instance.
+ *
+ * JSON_Parser_ParseFile() opens the file with the specified null-terminated
+ * path, and JSON_Parser_ParseFd() reads from an open file descriptor,
+ * starting at its current position; the descriptor is not closed. Either
+ * way, the input is parsed to the end of the file, exactly as if it had
+ * been passed to JSON_Parser_Parse() with isFinal set to JSON_True.
+ *
+ * Where the platform supports it, a regular file is mapped into memory
+ * rather than read, and the mapping is passed to the parser directly, so
+ * that the input is not copied through an intermediate buffer and string
+ * runs and skipped whitespace are scanned across spans as long as
+ * possible. Very large files are passed to the parser in windows of 64 MiB
+ * of the mapping, each of which is released once it has been parsed, so
+ * that the memory used by the process does not grow with the size of the
+ * file. The file must not be truncated while it is being parsed. Input
+ * that cannot be mapped, such as a pipe or a terminal, is read in chunks
+ * of 1 MiB. If the library is built with JSON_NO_MMAP defined, files are
+ * always read.
+ *
+ * If the file cannot be opened or read, the parser stops, and
+ * JSON_Parser_GetError() returns JSON_Error_CannotReadInput; if the
+ * buffer into which input is read cannot be allocated, it returns
+ * JSON_Error_OutOfMemory. In either case, the error location is the
+ * location of the first byte that was not parsed.
+ *
+ * These functions return failure for the same reasons as
+ * JSON_Parser_Parse(), if path is null, or if the file cannot be opened
+ * or read.
+ */
+JSON_API(JSON_Status) JSON_Parser_ParseFile(JSON_Parser parser, const char* path);
+JSON_API(JSON_Status) JSON_Parser_ParseFd(JSON_Parser parser, int fd);
+
+/* Build a structural index of a complete UTF-8 JSON document in preparation
+ * for parsing it with a parser instance.
+ *
+ * The structural index is an array containing the offsets, in ascending
+ * order, of every {, }, [, ], :, and , character that appears outside of a
+ * string, and of every quotation mark that begins or ends a string. Once
+ * the index has been built, subsequent calls to JSON_Parser_Parse() use it
+ * to pass structural characters directly to the parser's grammar instead
+ * of decoding and lexing them one at a time. The handlers that are called,
+ * and the locations and errors that are reported, are exactly the same
+ * whether or not an index is used.
+ *
+ * The pBytes parameter points to the entire document, which the client
+ * will subsequently pass to JSON_Parser_Parse(), either all at once or in
+ * consecutive chunks. The offsets in the index are relative to the start
+ * of the document. The index is only used if the parser's input encoding
+ * is, or is detected to be, JSON_UTF8. Building the index does not
+ * validate the document; an index that does not match the input that is
+ * subsequently parsed makes parsing slower, but not incorrect.
+ *
+ * The index is discarded when the parser is reset.
+ *
+ * This function returns failure if the parser parameter is null, if
+ * pBytes is null and length is not 0, if the parser has already started
+ * parsing, or if there is not enough memory to build the index.
+ */
+JSON_API(JSON_Status) JSON_Parser_BuildStructuralIndex(JSON_Parser parser, const char* pBytes, size_t length);
+
+/* Get the structural index that was built for a parser instance by
+ * JSON_Parser_BuildStructuralIndex(), if any.
+ *
+ * This function returns a pointer to the array of offsets, and sets the
+ * value pointed to by pLength, if it is not null, to the number of offsets
+ * in the array. If the parser has no structural index, this function
+ * returns null and sets the value pointed to by pLength to 0. The array is
+ * owned by the parser and is only valid until the parser is reset or freed.
+ */
+JSON_API(const size_t*) JSON_Parser_GetStructuralIndex(JSON_Parser parser, size_t* pLength);
+
+/* Add a path filter to a parser instance.
+ *
+ * A parser instance that has one or more path filters only reports events
+ * for the values that match a filter and for everything inside them. The
+ * object member event that precedes a matching member value and the array
+ * item event that precedes a matching array item are reported as well.
+ * This applies to events passed to handlers, pulled events, and batched
+ * events alike. Values that cannot contain a matching value are skipped as
+ * though a handler had returned JSON_Parser_SkipValue, so they are parsed
+ * quickly and are not fully validated.
+ *
+ * The pPath parameter is a null-terminated JSON Pointer (RFC 6901) encoded
+ * in UTF-8, such as "/meta/ts". The empty string matches the entire
+ * document. Each reference token matches the object member with the same
+ * name (in which "~1" stands for "/" and "~0" stands for "~") and, if it is
+ * a decimal array index without leading zeros, the array item with that
+ * index. As an extension, a reference token that consists of a single
+ * asterisk matches every object member and every array item.
+ *
+ * Filters are discarded when the parser is reset.
+ *
+ * This function returns failure if the parser parameter is null, if pPath
+ * is null or is not a valid JSON Pointer, if the parser has already
+ * started parsing, or if there is not enough memory to add the filter.
+ */
+JSON_API(JSON_Status) JSON_Parser_AddPathFilter(JSON_Parser parser, const char* pPath);
+
+/* Set the names of the object members that a parser instance should
+ * recognize.
+ *
+ * The ppKeys parameter points to keyCount null-terminated member names
+ * encoded in UTF-8. The parser compiles them into a minimal perfect hash,
+ * so that it can identify the name of each object member with at most two
+ * hashes and a single comparison, and reports the index of the matching
+ * key in ppKeys along with every object member event. The client can then
+ * dispatch on the index rather than comparing names. The parser makes its
+ * own copy of the names, so the client does not need to keep them.
+ *
+ * Calling this function replaces any previous key dictionary, and calling
+ * it with keyCount set to 0 removes the key dictionary. The key dictionary
+ * is discarded when the parser is reset.
+ *
+ * This function returns failure if the parser parameter is null, if ppKeys
+ * is null and keyCount is not 0, if any of the names is null or is not
+ * valid UTF-8, if two of the names are the same, if the parser has started
+ * parsing, or if memory cannot be allocated. If it fails because memory
+ * cannot be allocated, the parser is left without a key dictionary.
+ */
+JSON_API(JSON_Status) JSON_Parser_SetKeyDictionary(JSON_Parser parser, const char* const* ppKeys, size_t keyCount);
+
+/* Get the index in a parser instance's key dictionary of the name of the
+ * object member that is currently being handled by its object member
+ * handler.
+ *
+ * If the parser is inside its object member handler, this function sets
+ * the value pointed to by pIndex and returns success. Otherwise, it leaves
+ * the value unchanged and returns failure. The value is the index of the
+ * member's name in the array of names passed to
+ * JSON_Parser_SetKeyDictionary(), or the number of names in the array if
+ * the member's name is not one of them (which is always 0 if the parser
+ * does not have a key dictionary).
+ */
+JSON_API(JSON_Status) JSON_Parser_GetMemberKeyIndex(JSON_Parser parser, size_t* pIndex);
+
+/* As an alternative to parse handlers, a client can pull events from a
+ * parser instance one at a time by supplying input with
+ * JSON_Parser_SetInput() and then calling JSON_Parser_NextEvent()
+ * repeatedly. The input is decoded, lexed and checked against the grammar
+ * exactly as it is by JSON_Parser_Parse(), and the same errors are
+ * reported, but no parse handlers (other than the encoding detected
+ * handler) are called. A parser instance that has started parsing with
+ * JSON_Parser_Parse() cannot be used to pull events, and vice versa.
+ */
+
+/* Types of events returned by JSON_Parser_NextEvent(). */
+typedef enum tag_JSON_EventType
+{
+    JSON_NeedMoreInputEvent = 0,
+    JSON_EndOfDocumentEvent = 1,
+    JSON_NullEvent          = 2,
+    JSON_BooleanEvent       = 3,
+    JSON_StringEvent        = 4,
+    JSON_NumberEvent        = 5,
+    JSON_SpecialNumberEvent = 6,
+    JSON_StartObjectEvent   = 7,
+    JSON_EndObjectEvent     = 8,
+    JSON_ObjectMemberEvent  = 9,
+    JSON_StartArrayEvent    = 10,
+    JSON_EndArrayEvent      = 11
+} JSON_EventType;
+
+/* An event returned by JSON_Parser_NextEvent().
+ *
+ * For string, object member and number events, pValue, length and
+ * attributes are the same values that would have been passed to the
+ * string, object member and number handlers, respectively (attributes is
+ * a JSON_StringAttributes or JSON_NumberAttributes value). The value is
+ * only valid until the next call to JSON_Parser_NextEvent() or
+ * JSON_Parser_SetInput(), or, if the attributes include
+ * JSON_PointsIntoInput, until the input that it points into is no longer
+ * valid, whichever is sooner.
+ *
+ * For boolean events, booleanValue is the value of the literal, and for
+ * special number events, specialNumberValue is the value of the literal.
+ *
+ * For object member events, keyIndex is the value that
+ * JSON_Parser_GetMemberKeyIndex() would have returned.
+ *
+ * Members that do not apply to the type of the event are set to 0.
+ */
+typedef struct tag_JSON_Event
+{
+    JSON_EventType     type;
+    char*              pValue;
+    size_t             length;
+    unsigned int       attributes;
+    JSON_Boolean       booleanValue;
+    JSON_SpecialNumber specialNumberValue;
+    size_t             keyIndex;
+} JSON_Event;
+
+/* Supply a chunk of input to a parser instance that is used to pull events.
+ *
+ * The pBytes, length and isFinal parameters have the same meaning as they
+ * do for JSON_Parser_Parse(). Unlike JSON_Parser_Parse(), this function
+ * does not parse the input; it is parsed incrementally by subsequent calls
+ * to JSON_Parser_NextEvent(), so the client must keep the buffer valid and
+ * unchanged until JSON_Parser_NextEvent() returns a JSON_NeedMoreInputEvent
+ * event (or the parser instance is reset or freed).
+ *
+ * This function returns failure if the parser parameter is null, if
+ * pBytes is null and length is not 0, if the function was called from
+ * inside a handler, if the parser instance has started parsing with
+ * JSON_Parser_Parse(), if previous input has been supplied with isFinal
+ * set to JSON_True, or if JSON_Parser_NextEvent() has not yet returned a
+ * JSON_NeedMoreInputEvent event for the previous input.
+ */
+JSON_API(JSON_Status) JSON_Parser_SetInput(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal);
+
+/* Pull the next event from a parser instance.
+ *
+ * This function parses the input that was supplied by JSON_Parser_SetInput()
+ * only as far as is necessary to produce the next event, and sets the
+ * members of the structure pointed to by pEvent to describe it.
+ *
+ * When all of the input has been consumed without producing another event,
+ * the event type is JSON_NeedMoreInputEvent, and the client should supply
+ * the next chunk of input. Once the final input has been consumed and the
+ * document is complete, the event type is JSON_EndOfDocumentEvent, and
+ * every subsequent call returns the same event.
+ *
+ * Events are produced for the same tokens, and in the same order, as the
+ * corresponding parse handlers would be called; there is no event that
+ * corresponds to the array item handler. If the parser encounters an
+ * error, any events that precede the error are returned first, and then
+ * this function returns failure, and JSON_Parser_GetError() and
+ * JSON_Parser_GetErrorLocation() can be used to get the details.
+ *
+ * This function returns failure if the parser parameter or the pEvent
+ * parameter is null, if the function was called from inside a handler,
+ * if the parser instance has started parsing with JSON_Parser_Parse(), or
+ * if the parser instance has encountered an error.
+ */
+JSON_API(JSON_Status) JSON_Parser_NextEvent(JSON_Parser parser, JSON_Event* pEvent);
+
+/* As another alternative to individual parse handlers, a client can have a
+ * parser instance record events in an array that the client supplies, and
+ * pass them to a single event batch handler when the array is full and
+ * before JSON_Parser_Parse() returns. This replaces one handler call per
+ * token with one call per batch, so that a client can process the events
+ * for documents that consist of many small tokens, such as large arrays of
+ * numbers, in a tight loop.
+ */
+
+/* An event recorded by a parser instance that is delivering event batches.
+ *
+ * The type member is one of the types of event returned by
+ * JSON_Parser_NextEvent(), other than JSON_NeedMoreInputEvent and
+ * JSON_EndOfDocumentEvent.
+ *
+ * The depth member is the number of objects and arrays that enclose the
+ * token that caused the event. The start and end of a container are not
+ * enclosed by the container itself, so for the input [1] the depth of the
+ * start and end array events is 0 and the depth of the number event is 1.
+ *
+ * For string, object member and number events, offset and length specify
+ * the location of the value, in bytes, relative to the start of the string
+ * bytes passed to the event batch handler. Each value is followed by a
+ * null terminator. The attributes member is the same value that would
+ * have been passed to the string, object member or number handler,
+ * respectively, except that JSON_PointsIntoInput is never set, since the
+ * value is always copied.
+ *
+ * For boolean events, attributes is the JSON_Boolean value of the literal,
+ * and for special number events, it is the JSON_SpecialNumber value of the
+ * literal.
+ *
+ * For object member events, keyIndex is the value that
+ * JSON_Parser_GetMemberKeyIndex() would have returned.
+ *
+ * Members that do not apply to the type of the event are set to 0.
+ */
+typedef struct tag_JSON_BatchedEvent
+{
+    JSON_EventType type;
+    unsigned int   attributes;
+    size_t         depth;
+    size_t         offset;
+    size_t         length;
+    size_t         keyIndex;
+} JSON_BatchedEvent;
+
+/* Get and set the handler that is called when a parser instance delivers a
+ * batch of events.
+ *
+ * The pEvents parameter points to eventCount events, in the order in which
+ * they occurred in the input, and the pStringBytes parameter points to the
+ * bytes of the values that they refer to. Both are only valid until the
+ * handler returns. The handler is never called with an empty batch.
+ *
+ * If the handler returns JSON_Parser_Abort, the parser aborts the parse as
+ * described above for other parse handlers, except that the error location
+ * is the location in the input that the parser had reached when it
+ * delivered the batch.
+ */
+typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_Parser_EventBatchHandler)(JSON_Parser parser, const JSON_BatchedEvent* pEvents, size_t eventCount, const char* pStringBytes);
+JSON_API(JSON_Parser_EventBatchHandler) JSON_Parser_GetEventBatchHandler(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetEventBatchHandler(JSON_Parser parser, JSON_Parser_EventBatchHandler handler);
+
+/* Get and set the array in which a parser instance records events for the
+ * event batch handler.
+ *
+ * By default a parser has no event batch buffer and calls the individual
+ * parse handlers for each token. When an event batch buffer is set, the
+ * parser instead records an event for each token in the buffer, and calls
+ * no parse handlers other than the encoding detected handler and the event
+ * batch handler. Events are recorded for the same tokens, and in the same
+ * order, as the corresponding parse handlers would be called; there is no
+ * event that corresponds to the array item handler.
+ *
+ * The parser passes the recorded events to the event batch handler as soon
+ * as the buffer is full, and before JSON_Parser_Parse() returns, if any
+ * events have been recorded. If the parser encounters an error, the events
+ * that precede the error are delivered before JSON_Parser_Parse() returns
+ * failure.
+ *
+ * The pEvents parameter points to an array of size events, which must
+ * remain valid until the parser is freed or reset. If size is zero, the
+ * parser stops recording events.
+ *
+ * The event batch buffer is not used by a parser instance that is used to
+ * pull events with JSON_Parser_NextEvent().
+ *
+ * The default value of this setting is no buffer (a size of zero).
+ *
+ * This setting cannot be changed once the parser has started parsing.
+ */
+JSON_API(size_t) JSON_Parser_GetEventBatchBufferSize(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetEventBatchBuffer(JSON_Parser parser, JSON_BatchedEvent* pEvents, size_t size);
+
+/******************** JSON Parallel Lines ********************/
+
+/* A parallel lines instance parses a buffer of newline-delimited JSON
+ * documents (NDJSON, also known as JSON Lines) on several threads at once.
+ *
+ * The input is divided into batches of whole lines, which are parsed
+ * independently on a pool of worker threads. Each worker thread parses
+ * the batches that it claims with its own parser instance, which is reset
+ * before each batch, so the parser's buffers are allocated once per
+ * thread rather than once per batch. The client configures the parser for
+ * each batch in the batch start handler (typically by setting the same
+ * parse handlers for every batch), and receives the finished batches, in
+ * input order, in the batch end handler. A parallel lines instance can
+ * also parse the elements of a single large array in parallel; refer to
+ * JSON_ParallelLines_ParseArray() for details.
+ *
+ * Before the batch start handler is called, the parser's input encoding
+ * is set to JSON_UTF8, and it is set to allow multiple documents and to
+ * skip invalid documents, so that an invalid line in a batch does not
+ * prevent the rest of the batch from being parsed; refer to
+ * JSON_Parser_SetAllowMultipleDocuments() and
+ * JSON_Parser_SetSkipInvalidDocuments() for details. (When the elements
+ * of an array are parsed, invalid documents are not skipped.) The input
+ * must be encoded in UTF-8, since it is divided at U+000A (LINE FEED)
+ * bytes.
+ *
+ * The parse handlers for different batches are called concurrently on
+ * different threads, so they must not modify shared data without
+ * synchronizing access to it. The usual approach is for the batch start
+ * handler to set the parser's user data to a structure that collects the
+ * results for the batch, and for the batch end handler to merge those
+ * results in order. Likewise, the memory suite of a parallel lines
+ * instance, which is also used by the parser instances that it creates,
+ * must be safe to call from multiple threads at once.
+ *
+ * If the library is built with JSON_NO_THREADS defined, all batches are
+ * parsed on the thread that calls JSON_ParallelLines_Parse() or
+ * JSON_ParallelLines_ParseArray().
+ */
+struct JSON_ParallelLines_Data; /* opaque data */
+typedef struct JSON_ParallelLines_Data* JSON_ParallelLines;
+
+/* Create a parallel lines instance.
+ *
+ * The pMemorySuite parameter has the same meaning as it does for
+ * JSON_Parser_Create().
+ */
+JSON_API(JSON_ParallelLines) JSON_ParallelLines_Create(const JSON_MemorySuite* pMemorySuite);
+
+/* Free a parallel lines instance.
+ *
+ * This function returns failure if the lines parameter is null or if the
+ * function was called reentrantly from inside a handler.
+ */
+JSON_API(JSON_Status) JSON_ParallelLines_Free(JSON_ParallelLines lines);
+
+/* Get and set the user data value associated with a parallel lines
+ * instance.
+ *
+ * The default value of this setting is null.
+ *
+ * This setting can be changed at any time, even inside handlers.
+ */
+JSON_API(void*) JSON_ParallelLines_GetUserData(JSON_ParallelLines lines);
+JSON_API(JSON_Status) JSON_ParallelLines_SetUserData(JSON_ParallelLines lines, void* userData);
+
+/* Get and set the number of threads that a parallel lines instance uses
+ * to parse batches, including the thread that calls
+ * JSON_ParallelLines_Parse().
+ *
+ * If this setting is 0, the instance uses one thread for each processor
+ * that is online when parsing starts. If fewer threads can be started than
+ * requested, the batches are shared among the threads that were started.
+ *
+ * The default value of this setting is 0.
+ *
+ * This setting cannot be changed inside handlers.
+ */
+JSON_API(size_t) JSON_ParallelLines_GetThreadCount(JSON_ParallelLines lines);
+JSON_API(JSON_Status) JSON_ParallelLines_SetThreadCount(JSON_ParallelLines lines, size_t threadCount);
+
+/* Get and set the approximate size of the batches into which a parallel
+ * lines instance divides its input, in bytes.
+ *
+ * Each batch ends at the first line break at or after this many bytes
+ * from its start, or at the end of the input. Batches that are much
+ * smaller than the input keep all of the threads busy until the end,
+ * while batches that are too small spend a larger fraction of their time
+ * in the handlers and in thread synchronization.
+ *
+ * The default value of this setting is 1048576 (1 MiB).
+ *
+ * This setting cannot be set to 0, and it cannot be changed inside
+ * handlers.
+ */
+JSON_API(size_t) JSON_ParallelLines_GetBatchSize(JSON_ParallelLines lines);
+JSON_API(JSON_Status) JSON_ParallelLines_SetBatchSize(JSON_ParallelLines lines, size_t batchSize);
+
+/* Information about a batch of lines.
+ *
+ * The index member is the zero-based position of the batch in the input,
+ * and pBytes and length specify the bytes of the batch. The byte member
+ * is the offset of the batch from the start of the input, and the line
+ * member is the zero-based line number of its first line; since the line
+ * number depends on the batches that precede the batch, it is only set
+ * when the batch is passed to the batch end handler, and is 0 before
+ * then. Token and error locations reported by the batch's parser are
+ * relative to the start of the batch, so these members can be added to
+ * them to get locations in the input.
+ *
+ * When the elements of an array are parsed with
+ * JSON_ParallelLines_ParseArray(), the element member is the zero-based
+ * index in the array of the batch's first element; like the line member,
+ * it is only set when the batch is passed to the batch end handler.
+ * Otherwise it is 0.
+ *
+ * The userData member is the batch parser's user data when parsing of the
+ * batch finished.
+ *
+ * The error member is JSON_Error_None if the whole batch was parsed, even
+ * if invalid documents were skipped along the way. Otherwise it is the
+ * error that stopped the batch parser (for example, JSON_Error_OutOfMemory,
+ * or JSON_Error_AbortedByHandler if a parse handler or the batch start
+ * handler aborted), and errorLocation is its location relative to the
+ * start of the batch. When the elements of an array are parsed, the
+ * errorElement member is the index in the array of the element in which
+ * the error occurred; like the element member, it is only set when the
+ * batch is passed to the batch end handler.
+ */
+typedef struct tag_JSON_LineBatch
+{
+    size_t        index;
+    const char*   pBytes;
+    size_t        length;
+    size_t        byte;
+    size_t        line;
+    size_t        element;
+    void*         userData;
+    JSON_Error    error;
+    JSON_Location errorLocation;
+    size_t        errorElement;
+} JSON_LineBatch;
+
+/* Get and set the handler that is called before a batch is parsed.
+ *
+ * The handler is called on the worker thread that parses the batch, with
+ * the parser instance that will parse it. The handler should set the
+ * parser's handlers and any other settings that the client requires; it
+ * can also change the settings described above, though the input encoding
+ * must remain JSON_UTF8. The parser's user data is null when the handler
+ * is called.
+ *
+ * If the handler returns JSON_Parser_Abort, the batch is not parsed, and
+ * its error is JSON_Error_AbortedByHandler; the other batches are not
+ * affected.
+ */
+typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_ParallelLines_BatchStartHandler)(JSON_ParallelLines lines, JSON_Parser parser, const JSON_LineBatch* pBatch);
+JSON_API(JSON_ParallelLines_BatchStartHandler) JSON_ParallelLines_GetBatchStartHandler(JSON_ParallelLines lines);
+JSON_API(JSON_Status) JSON_ParallelLines_SetBatchStartHandler(JSON_ParallelLines lines, JSON_ParallelLines_BatchStartHandler handler);
+
+/* Get and set the handler that is called after a batch is parsed.
+ *
+ * The handler is called once for each batch, in input order, and never
+ * for two batches at once, although it may be called on any of the
+ * threads that parse batches. The structure pointed to by pBatch is only
+ * valid until the handler returns.
+ *
+ * If the handler returns JSON_Parser_Abort, no further batches are parsed
+ * or passed to the handler, and JSON_ParallelLines_Parse() or
+ * JSON_ParallelLines_ParseArray() returns failure with the error
+ * JSON_Error_AbortedByHandler.
+ */
+typedef JSON_Parser_HandlerResult (JSON_CALL * JSON_ParallelLines_BatchEndHandler)(JSON_ParallelLines lines, const JSON_LineBatch* pBatch);
+JSON_API(JSON_ParallelLines_BatchEndHandler) JSON_ParallelLines_GetBatchEndHandler(JSON_ParallelLines lines);
+JSON_API(JSON_Status) JSON_ParallelLines_SetBatchEndHandler(JSON_ParallelLines lines, JSON_ParallelLines_BatchEndHandler handler);
+
+/* Get the error, if any, that caused the most recent call to
+ * JSON_ParallelLines_Parse() or JSON_ParallelLines_ParseArray() on a
+ * parallel lines instance to fail.
+ *
+ * Errors in individual batches are reported to the batch end handler and
+ * do not cause parsing to fail.
+ */
+JSON_API(JSON_Error) JSON_ParallelLines_GetError(JSON_ParallelLines lines);
+
+/* Get the location in the input at which the most recent call to
+ * JSON_ParallelLines_ParseArray() on a parallel lines instance found an
+ * error in the structure of the array.
+ *
+ * If the error was found in the structure of the array, this function
+ * sets the members of the structure pointed to by pLocation to the
+ * location of the error, relative to the start of the input, and returns
+ * success. Otherwise, it leaves the members unchanged and returns failure.
+ */
+JSON_API(JSON_Status) JSON_ParallelLines_GetErrorLocation(JSON_ParallelLines lines, JSON_Location* pLocation);
+
+/* Parse a buffer of newline-delimited JSON documents.
+ *
+ * This function divides the input into batches, parses them on the worker
+ * threads, and returns when every batch has been passed to the batch end
+ * handler (or the batch end handler has aborted). The buffer must remain
+ * valid and unchanged until the function returns. A parallel lines
+ * instance can parse any number of buffers, one after another.
+ *
+ * This function returns failure if the lines parameter is null, if pBytes
+ * is null and length is not 0, if the function was called reentrantly
+ * from inside a handler, if memory for the batches could not be
+ * allocated, or if the batch end handler aborted.
+ */
+JSON_API(JSON_Status) JSON_ParallelLines_Parse(JSON_ParallelLines lines, const char* pBytes, size_t length);
+
+/* Parse a buffer containing a single JSON array, parsing its elements in
+ * parallel.
+ *
+ * This is intended for inputs that consist of one very large array of
+ * independent values. The input must be encoded in UTF-8 and must consist
+ * of the array, optionally surrounded by whitespace.
+ *
+ * The array's elements are divided into batches of whole elements, which
+ * are parsed and passed to the batch end handler in the same way as the
+ * batches of JSON_ParallelLines_Parse(). To find the boundaries between
+ * elements without scanning the array serially, the input is first
+ * divided into pieces of the batch size, which are scanned in parallel for
+ * the quotation marks, backslashes, brackets and braces that determine
+ * where strings and containers begin and end. Since a piece may begin
+ * inside a string, each piece is scanned speculatively both ways, and the
+ * results for consecutive pieces are then chained together to find the
+ * state at the start of each piece. The scan does not otherwise validate
+ * the input, which is left to the parsers of the batches; in particular,
+ * the input must not contain comments.
+ *
+ * A batch consists of one or more elements and the commas between them,
+ * but not the commas that separate it from the neighboring batches, nor
+ * the array's brackets. Each of the batch's elements is a separate
+ * document to the batch's parser, so the start and end document handlers
+ * are called once for each element, and the values that the handlers see
+ * are one level shallower than they are in the array. The parser requires
+ * exactly one value between each pair of commas. Unlike in
+ * JSON_ParallelLines_Parse(), invalid documents are not skipped: an error
+ * stops the batch's parser, and the elements of the batch that follow the
+ * element in which the error occurred are not parsed.
+ *
+ * This function returns failure for the same reasons as
+ * JSON_ParallelLines_Parse(), and also if the input does not begin with
+ * an array, if the array is not closed, or if anything other than
+ * whitespace follows the array. In those cases, JSON_ParallelLines_GetError()
+ * returns JSON_Error_UnexpectedToken or JSON_Error_ExpectedMoreTokens, no
+ * batches are parsed, and JSON_ParallelLines_GetErrorLocation() reports
+ * the location of the error.
+ */
+JSON_API(JSON_Status) JSON_ParallelLines_ParseArray(JSON_ParallelLines lines, const char* pBytes, size_t length);
+
+/******************** JSON Document ********************/
+
+/* A document instance holds a parsed JSON document in memory, as a compact
+ * alternative to building a tree of nodes from parse handlers.
+ *
+ * A client attaches a document to a parser instance with
+ * JSON_Parser_SetDocument() and then parses the input as usual. The parser
+ * records every value directly in the document instead of calling parse
+ * handlers. Values are stored in document order on a "tape" of 64-bit
+ * words, one per value, and the bytes of strings, member names and
+ * numbers are stored in a single contiguous buffer. The start of
+ * each object and array records where the container ends, so a whole
+ * container can be stepped over in constant time, and the end records how
+ * many items the container has. Building a document takes two growable
+ * buffers rather than an allocation per value, and the memory is kept
+ * when the document is reused for another parse.
+ *
+ * A value in a document is identified by a size_t handle, which is only
+ * meaningful to the document that returned it. Functions that find a
+ * value return JSON_Document_NoValue if there is no such value. Passing
+ * a handle that was not returned by the document has undefined results,
+ * except that JSON_Document_NoValue is always rejected.
+ */
+struct JSON_Document_Data; /* opaque data */
+typedef struct JSON_Document_Data* JSON_Document;
+
+#define JSON_Document_NoValue ((size_t)-1)
+
+/* Types of the values in a document. */
+typedef enum tag_JSON_ValueType
+{
+    JSON_NoValueType            = 0,
+    JSON_NullValueType          = 1,
+    JSON_BooleanValueType       = 2,
+    JSON_StringValueType        = 3,
+    JSON_NumberValueType        = 4,
+    JSON_SpecialNumberValueType = 5,
+    JSON_ObjectValueType        = 6,
+    JSON_ArrayValueType         = 7
+} JSON_ValueType;
+
+/* Create a document instance.
+ *
+ * The pMemorySuite parameter has the same meaning as it does for
+ * JSON_Parser_Create().
+ */
+JSON_API(JSON_Document) JSON_Document_Create(const JSON_MemorySuite* pMemorySuite);
+
+/* Free a document instance.
+ *
+ * A document must not be freed while it is attached to a parser instance.
+ *
+ * This function returns failure if the document parameter is null.
+ */
+JSON_API(JSON_Status) JSON_Document_Free(JSON_Document document);
+
+/* Get and set the document in which a parser instance records the values
+ * that it parses.
+ *
+ * Setting a document empties it. While a document is set, the parser
+ * calls no parse handlers other than the encoding detected handler, and
+ * does not record event batches. Strings and member names are recorded in
+ * the parser's string encoding and numbers in its number encoding, and
+ * numbers are also converted to native values as they would be for the
+ * typed number handler. If the parser allows multiple documents, each one
+ * is recorded in turn as a top-level value; invalid documents are never
+ * skipped. If the parser has path filters, each value that matches a
+ * filter is recorded as a top-level value.
+ *
+ * The document is complete, and can be read, once JSON_Parser_Parse() (or
+ * JSON_Parser_ParseFile() or JSON_Parser_ParseFd()) has returned success
+ * for the final input. If parsing fails, the document remains empty as far
+ * as the functions that read it are concerned.
+ *
+ * The document is not used by a parser instance that is used to pull
+ * events with JSON_Parser_NextEvent(). The document must remain valid
+ * until the parser is freed or reset, or another document is set.
+ *
+ * The default value of this setting is null.
+ *
+ * This setting cannot be changed once the parser has started parsing.
+ */
+JSON_API(JSON_Document) JSON_Parser_GetDocument(JSON_Parser parser);
+JSON_API(JSON_Status) JSON_Parser_SetDocument(JSON_Parser parser, JSON_Document document);
+
+/* Get the first top-level value of a complete document.
+ *
+ * If the parser allows multiple documents, the rest of the top-level
+ * values follow it and can be reached with JSON_Document_GetNextItem().
+ *
+ * This function returns JSON_Document_NoValue if the document parameter
+ * is null or if the document is empty or incomplete.
+ */
+JSON_API(size_t) JSON_Document_GetRoot(JSON_Document document);
+
+/* Get the type of a value in a document.
+ *
+ * This function returns JSON_NoValueType if the document parameter is
+ * null or if the value is JSON_Document_NoValue.
+ */
+JSON_API(JSON_ValueType) JSON_Document_GetType(JSON_Document document, size_t value);
+
+/* Get the value of a boolean value in a document.
+ *
+ * This function returns JSON_False if the value is not a boolean.
+ */
+JSON_API(JSON_Boolean) JSON_Document_GetBoolean(JSON_Document document, size_t value);
+
+/* Get the contents of a string value in a document.
+ *
+ * This function returns a pointer to the string, which is null-terminated
+ * in the string encoding of the parser that recorded it, and is valid
+ * until the document is emptied or freed. If pLength is not null, it sets
+ * the value pointed to by pLength to the length of the string in bytes
+ * (not including the null terminator). If pAttributes is not null, it sets
+ * the value pointed to by pAttributes to the attributes that would have
+ * been passed to the string handler, except that JSON_PointsIntoInput is
+ * never set.
+ *
+ * This function returns null if the value is not a string.
+ */
+JSON_API(const char*) JSON_Document_GetString(JSON_Document document, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes);
+
+/* Get a number value in a document, converted to a native type.
+ *
+ * This function sets the members of the structure pointed to by pValue,
+ * and the value pointed to by pAttributes if it is not null, to the values
+ * that would have been passed to the typed number handler.
+ *
+ * This function returns failure if pValue is null or if the value is not
+ * a number.
+ */
+JSON_API(JSON_Status) JSON_Document_GetNumber(JSON_Document document, size_t value, JSON_NumberValue* pValue, JSON_NumberAttributes* pAttributes);
+
+/* Get the text of a number value in a document.
+ *
+ * This function returns a pointer to the text of the number, which is
+ * null-terminated in the number encoding of the parser that recorded it,
+ * and sets the value pointed to by pLength, if it is not null, to its
+ * length in bytes. This is the value that would have been passed to the
+ * number handler; unlike the native value, it always represents the
+ * number exactly.
+ *
+ * This function returns null if the value is not a number.
+ */
+JSON_API(const char*) JSON_Document_GetNumberText(JSON_Document document, size_t value, size_t* pLength);
+
+/* Get the value of a special number value in a document.
+ *
+ * This function returns JSON_NaN if the value is not a special number.
+ */
+JSON_API(JSON_SpecialNumber) JSON_Document_GetSpecialNumber(JSON_Document document, size_t value);
+
+/* Get the number of items in an object or array value in a document.
+ *
+ * The items of an object are its members. This function returns 0 if the
+ * value is not an object or array.
+ */
+JSON_API(size_t) JSON_Document_GetItemCount(JSON_Document document, size_t value);
+
+/* Get the first item of an object or array value in a document.
+ *
+ * For an object, this is the value of its first member.
+ *
+ * This function returns JSON_Document_NoValue if the value is not an
+ * object or array, or if the object or array is empty.
+ */
+JSON_API(size_t) JSON_Document_GetFirstItem(JSON_Document document, size_t value);
+
+/* Get the item that follows an item of an object or array in a document,
+ * or the top-level value that follows a top-level value.
+ *
+ * If the item is an object or array, this steps over all of its contents
+ * in constant time.
+ *
+ * This function returns JSON_Document_NoValue if the item is the last one.
+ */
+JSON_API(size_t) JSON_Document_GetNextItem(JSON_Document document, size_t value);
+
+/* Get the name of the object member whose value is a value in a document.
+ *
+ * The name is returned in the same way as by JSON_Document_GetString().
+ *
+ * This function returns null if the value is not the value of an object
+ * member.
+ */
+JSON_API(const char*) JSON_Document_GetMemberName(JSON_Document document, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes);
+
+/* Find the value of an object member in a document by name.
+ *
+ * The pName parameter points to length bytes of the name, which must be
+ * encoded in the string encoding of the parser that recorded the object.
+ * If the object has more than one member with the name, the first one is
+ * found. The members are compared in order, so a client that reads many
+ * members of a large object should iterate over its items instead.
+ *
+ * This function returns JSON_Document_NoValue if the value is not an
+ * object, if pName is null and length is not 0, or if the object has no
+ * member with the name.
+ */
+JSON_API(size_t) JSON_Document_FindMember(JSON_Document document, size_t value, const char* pName, size_t length);
+
+/******************** JSON On-Demand ********************/
+
+/* An on-demand instance reads selected values from a complete UTF-8 JSON
+ * document in memory without parsing the rest of it.
+ *
+ * A client opens a document with JSON_OnDemand_Open() and then navigates
+ * it with JSON_OnDemand_GetRoot(), JSON_OnDemand_FindMember(),
+ * JSON_OnDemand_GetFirstItem() and JSON_OnDemand_GetNextItem(). To
+ * navigate, the instance builds a structural index of the document (see
+ * JSON_Parser_BuildStructuralIndex()) lazily, scanning only as far into
+ * the input as the values that have been asked for. Values are only
+ * decoded when the client reads them, and are decoded by a parser
+ * instance, so strings, member names and numbers are exactly what the
+ * parse handlers would receive, including the handling of escape
+ * sequences, surrogate pairs, invalid encoding sequences and output
+ * encodings.
+ *
+ * A value in an open document is identified by a size_t handle, which is
+ * the offset of its first byte in the input. Functions that find a value
+ * return JSON_OnDemand_NoValue if there is no such value.
+ *
+ * The parts of the document that are skipped over are not validated. A
+ * value that is read is validated as if it were parsed by itself, but a
+ * document that is malformed between the values may be navigated in ways
+ * that the parser would reject. The input must not contain comments.
+ */
+struct JSON_OnDemand_Data; /* opaque data */
+typedef struct JSON_OnDemand_Data* JSON_OnDemand;
+
+#define JSON_OnDemand_NoValue ((size_t)-1)
+
+/* Create an on-demand instance.
+ *
+ * The pMemorySuite parameter has the same meaning as it does for
+ * JSON_Parser_Create().
+ */
+JSON_API(JSON_OnDemand) JSON_OnDemand_Create(const JSON_MemorySuite* pMemorySuite);
+
+/* Free an on-demand instance.
+ *
+ * This function returns failure if the onDemand parameter is null.
+ */
+JSON_API(JSON_Status) JSON_OnDemand_Free(JSON_OnDemand onDemand);
+
+/* Get the parser instance that an on-demand instance uses to decode
+ * values.
+ *
+ * The client can change the settings of the parser, such as its string
+ * and number encodings, whether it allows special numbers or a BOM, and
+ * whether it replaces invalid encoding sequences, and can add path
+ * filters or set a key dictionary. The on-demand instance keeps all of
+ * them, and decodes each value as if it were a whole document parsed
+ * with them. The input encoding is always JSON_UTF8. The client must not
+ * set handlers on the parser, parse with it, reset it, or free it.
+ */
+JSON_API(JSON_Parser) JSON_OnDemand_GetParser(JSON_OnDemand onDemand);
+
+/* Open a document with an on-demand instance.
+ *
+ * The pBytes parameter points to length bytes of the entire document,
+ * which must remain valid and unchanged until another document is opened
+ * or the instance is freed. Opening a document does not read it; the
+ * document is read as it is navigated.
+ *
+ * This function returns failure if the onDemand parameter is null or if
+ * pBytes is null and length is not 0.
+ */
+JSON_API(JSON_Status) JSON_OnDemand_Open(JSON_OnDemand onDemand, const char* pBytes, size_t length);
+
+/* Get the error that caused an on-demand instance to fail to decode a
+ * value, or to index the document, since the document was opened.
+ *
+ * Errors in decoding a value are the errors that the parser would report
+ * for the value by itself. If the instance runs out of memory while
+ * indexing the document, the error is JSON_Error_OutOfMemory, and
+ * navigation behaves as if the document ended where indexing stopped.
+ *
+ * This function returns JSON_Error_None if no error has occurred.
+ */
+JSON_API(JSON_Error) JSON_OnDemand_GetError(JSON_OnDemand onDemand);
+
+/* Get the top-level value of an open document.
+ *
+ * This function returns JSON_OnDemand_NoValue if the onDemand parameter
+ * is null or if the document is empty. If the document begins with a BOM
+ * and the parser does not allow it, it sets the error to
+ * JSON_Error_BOMNotAllowed and returns JSON_OnDemand_NoValue.
+ */
+JSON_API(size_t) JSON_OnDemand_GetRoot(JSON_OnDemand onDemand);
+
+/* Get the type of a value in an open document.
+ *
+ * The type is determined from the first byte of the value, without
+ * decoding it.
+ *
+ * This function returns JSON_NoValueType if the onDemand parameter is
+ * null, if the value is JSON_OnDemand_NoValue, or if the value does not
+ * begin with a byte that can begin a value.
+ */
+JSON_API(JSON_ValueType) JSON_OnDemand_GetType(JSON_OnDemand onDemand, size_t value);
+
+/* Decode the value of a boolean value in an open document.
+ *
+ * This function returns JSON_False if the value is not a boolean or
+ * cannot be decoded.
+ */
+JSON_API(JSON_Boolean) JSON_OnDemand_GetBoolean(JSON_OnDemand onDemand, size_t value);
+
+/* Decode the contents of a string value in an open document.
+ *
+ * The string is returned in the same way as by JSON_Document_GetString().
+ * It is valid until another value or member name is decoded, or until
+ * another document is opened.
+ *
+ * This function returns null if the value is not a string or cannot be
+ * decoded.
+ */
+JSON_API(const char*) JSON_OnDemand_GetString(JSON_OnDemand onDemand, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes);
+
+/* Decode a number value in an open document, converted to a native type.
+ *
+ * The number is returned in the same way as by JSON_Document_GetNumber().
+ *
+ * This function returns failure if pValue is null, or if the value is
+ * not a number or cannot be decoded.
+ */
+JSON_API(JSON_Status) JSON_OnDemand_GetNumber(JSON_OnDemand onDemand, size_t value, JSON_NumberValue* pValue, JSON_NumberAttributes* pAttributes);
+
+/* Decode the text of a number value in an open document.
+ *
+ * The text is returned in the same way as by
+ * JSON_Document_GetNumberText(), and is valid for as long as a string
+ * returned by JSON_OnDemand_GetString().
+ *
+ * This function returns null if the value is not a number or cannot be
+ * decoded.
+ */
+JSON_API(const char*) JSON_OnDemand_GetNumberText(JSON_OnDemand onDemand, size_t value, size_t* pLength);
+
+/* Decode the value of a special number value in an open document.
+ *
+ * This function returns JSON_NaN if the value is not a special number or
+ * cannot be decoded.
+ */
+JSON_API(JSON_SpecialNumber) JSON_OnDemand_GetSpecialNumber(JSON_OnDemand onDemand, size_t value);
+
+/* Get the first item of an object or array value in an open document.
+ *
+ * For an object, this is the value of its first member.
+ *
+ * This function returns JSON_OnDemand_NoValue if the value is not an
+ * object or array, or if the object or array is empty.
+ */
+JSON_API(size_t) JSON_OnDemand_GetFirstItem(JSON_OnDemand onDemand, size_t value);
+
+/* Get the item that follows an item of an object or array in an open
+ * document.
+ *
+ * If the item is an object or array, this steps over its contents using
+ * the structural index, without decoding them.
+ *
+ * This function returns JSON_OnDemand_NoValue if the item is the last
+ * one, or if the value is the top-level value.
+ */
+JSON_API(size_t) JSON_OnDemand_GetNextItem(JSON_OnDemand onDemand, size_t value);
+
+/* Decode the name of the object member whose value is a value in an open
+ * document.
+ *
+ * The name is returned in the same way as by JSON_OnDemand_GetString().
+ *
+ * This function returns null if the value is not the value of an object
+ * member, or if the name cannot be decoded.
+ */
+JSON_API(const char*) JSON_OnDemand_GetMemberName(JSON_OnDemand onDemand, size_t value, size_t* pLength, JSON_StringAttributes* pAttributes);
+
+/* Find the value of an object member in an open document by name.
+ *
+ * The name is given in the same way as to JSON_Document_FindMember().
+ * Member names that contain only printable ASCII characters other than
+ * reverse solidus are compared without being decoded, when the parser's
+ * string encoding is JSON_UTF8; other names are decoded before they are
+ * compared.
+ *
+ * This function returns JSON_OnDemand_NoValue if the value is not an
+ * object, if pName is null and length is not 0, or if the object has no
+ * member with the name.
+ */
+JSON_API(size_t) JSON_OnDemand_FindMember(JSON_OnDemand onDemand, size_t value, const char* pName, size_t length);
+
 #endif /* JSON_NO_PARSER */
 
 /******************** JSON Writer ********************/
@@ -833,6 +2001,30 @@ JSON_API(JSON_Status) JSON_Writer_SetReplaceInvalidEncodingSequences(JSON_Writer
 JSON_API(JSON_Boolean) JSON_Writer_GetEscapeAllNonASCIICharacters(JSON_Writer writer);
 JSON_API(JSON_Status) JSON_Writer_SetEscapeAllNonASCIICharacters(JSON_Writer writer, JSON_Boolean escapeAllNonASCIICharacters);
 
+/* Get and set the buffer in which a writer instance accumulates output
+ * before sending it to the output handler.
+ *
+ * By default a writer has no output buffer, and every piece of output
+ * (each token, string, number and run of whitespace) is sent to the output
+ * handler as soon as it is generated. When an output buffer is set, the
+ * writer instead copies its output into the buffer and calls the output
+ * handler only when the buffer is full or when JSON_Writer_Flush() is
+ * called. Output too large to fit in an empty buffer is passed to the
+ * output handler directly.
+ *
+ * If pBuffer is non-null, the writer uses the caller's buffer, which must
+ * remain valid until the writer is freed, reset or given another buffer.
+ * If pBuffer is null and size is non-zero, the writer allocates a buffer
+ * of the specified size using its memory suite, and fails if the
+ * allocation fails. If size is zero, the writer stops buffering output.
+ *
+ * The default value of this setting is no buffer (a size of zero).
+ *
+ * This setting cannot be changed once the writer has started writing.
+ */
+JSON_API(size_t) JSON_Writer_GetOutputBufferSize(JSON_Writer writer);
+JSON_API(JSON_Status) JSON_Writer_SetOutputBuffer(JSON_Writer writer, char* pBuffer, size_t size);
+
 /* Get the type of error, if any, encountered by a writer instance.
  *
  * If the writer encountered an error while writing input, this function
@@ -851,10 +2043,12 @@ JSON_API(JSON_Error) JSON_Writer_GetError(JSON_Writer writer);
  *   2. A single call to JSON_Writer_WriteXXX() may trigger multiple calls
  *      to the output handler.
  *
- *   3. All output generated by a call to JSON_Writer_WriteXXX() is sent
- *      to the output handler before the call returns; that is, the writer
- *      does not aggregate output from multiple writes before sending it to
- *      the output handler.
+ *   3. Unless the writer has an output buffer, all output generated by a
+ *      call to JSON_Writer_WriteXXX() is sent to the output handler before
+ *      the call returns; that is, the writer does not aggregate output
+ *      from multiple writes before sending it to the output handler. If
+ *      the writer has an output buffer, output may remain in the buffer
+ *      until it fills up or JSON_Writer_Flush() is called.
  *
  *   4. A call to JSON_Writer_WriteXXX() will fail if the writer has
  *      already encountered an error.
@@ -895,6 +2089,22 @@ typedef JSON_Writer_HandlerResult (JSON_CALL * JSON_Writer_OutputHandler)(JSON_W
 JSON_API(JSON_Writer_OutputHandler) JSON_Writer_GetOutputHandler(JSON_Writer writer);
 JSON_API(JSON_Status) JSON_Writer_SetOutputHandler(JSON_Writer writer, JSON_Writer_OutputHandler handler);
 
+/* Send any output held in a writer instance's output buffer to the output
+ * handler.
+ *
+ * Output that is still buffered when the writer is freed or reset is
+ * discarded, so clients that set an output buffer should call this
+ * function once they have finished writing.
+ *
+ * This function can be called after the writer has encountered an error,
+ * in order to send the output that was generated before the error. It
+ * returns failure if the writer parameter is null, if the function was
+ * called reentrantly from inside a handler, or if the output handler
+ * returns JSON_Writer_Abort (in which case the writer sets its error to
+ * JSON_Error_AbortedByHandler).
+ */
+JSON_API(JSON_Status) JSON_Writer_Flush(JSON_Writer writer);
+
 /* Write the JSON null literal to the output. */
 JSON_API(JSON_Status) JSON_Writer_WriteNull(JSON_Writer writer);
 
@@ -976,6 +2186,34 @@ JSON_API(JSON_Status) JSON_Writer_WriteString(JSON_Writer writer, const char* pV
  */
 JSON_API(JSON_Status) JSON_Writer_WriteNumber(JSON_Writer writer, const char* pValue, size_t length, JSON_Encoding encoding);
 
+/* Write a JSON number value, formatted from a native integer, to the
+ * output.
+ *
+ * Integers are written in decimal with no exponent, fraction or leading
+ * zeros. Because the formatted text is always a valid JSON number, these
+ * functions are cheaper than formatting the value yourself and passing it
+ * to JSON_Writer_WriteNumber(), which must validate the text it is given.
+ */
+JSON_API(JSON_Status) JSON_Writer_WriteInt64(JSON_Writer writer, JSON_Int64 value);
+JSON_API(JSON_Status) JSON_Writer_WriteUInt64(JSON_Writer writer, JSON_UInt64 value);
+
+/* Write a JSON number value, formatted from a native double, to the
+ * output.
+ *
+ * The value is written with the shortest sequence of significant digits
+ * that converts back to exactly the same double. Values of magnitude 1e21
+ * or greater, or less than 1e-6, are written in exponential notation
+ * (e.g. 1e+21 is written as "1e21"). Values with no fractional part are
+ * written with a trailing ".0" (e.g. "3.0" or "-0.0") so that parsers can
+ * distinguish them from integers.
+ *
+ * JSON numbers cannot represent NaN or infinity, so if the value is NaN or
+ * infinite the function returns failure without writing anything and
+ * without setting the writer's error. Use JSON_Writer_WriteSpecialNumber()
+ * to write those values.
+ */
+JSON_API(JSON_Status) JSON_Writer_WriteDouble(JSON_Writer writer, double value);
+
 /* Write a JSON "special" number literal to the output. */
 JSON_API(JSON_Status) JSON_Writer_WriteSpecialNumber(JSON_Writer writer, JSON_SpecialNumber value);
 
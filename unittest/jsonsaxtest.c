@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <math.h>
+#include <locale.h>
 #include "jsonsax.h"
 
 static int s_failureCount = 0;
@@ -57,7 +58,8 @@ static const char* errorNames[] =
     "InvalidNumber",
     "TooLongNumber",
     "DuplicateObjectMember",
-    "StoppedAfterEmbeddedDocument"
+    "StoppedAfterEmbeddedDocument",
+    "CannotReadInput"
 };
 
 static void* JSON_CALL ReallocHandler(void* caller, void* ptr, size_t size)
@@ -293,6 +295,10 @@ static void OutputStringBytes(const unsigned char* pBytes, size_t length, JSON_S
         {
             OutputCharacter('r');
         }
+        if (attributes & JSON_PointsIntoInput)
+        {
+            OutputCharacter('p');
+        }
         if (length)
         {
             OutputCharacter(' ');
@@ -332,6 +338,48 @@ static void OutputNumber(const unsigned char* pValue, size_t length, JSON_Number
     OutputByteSequence((const unsigned char*)pValue, length, encoding);
 }
 
+static void OutputTypedNumber(const JSON_NumberValue* pValue, JSON_NumberAttributes attributes)
+{
+    /* Format 64-bit integers by hand, since C89's printf() can't. */
+    char digits[21];
+    size_t i = sizeof(digits) - 1;
+    JSON_UInt64 magnitude;
+    if (attributes & JSON_LosesPrecision)
+    {
+        OutputFormatted("l ");
+    }
+    switch (pValue->type)
+    {
+    case JSON_Int64Number:
+    case JSON_UInt64Number:
+        if (pValue->type == JSON_UInt64Number)
+        {
+            magnitude = pValue->uint64Value;
+        }
+        else if (pValue->int64Value < 0)
+        {
+            OutputCharacter('-');
+            magnitude = (JSON_UInt64)0 - (JSON_UInt64)pValue->int64Value;
+        }
+        else
+        {
+            magnitude = (JSON_UInt64)pValue->int64Value;
+        }
+        digits[i] = 0;
+        do
+        {
+            digits[--i] = (char)('0' + (int)(magnitude % 10));
+            magnitude /= 10;
+        } while (magnitude);
+        OutputFormatted("%s", &digits[i]);
+        break;
+
+    case JSON_DoubleNumber:
+        OutputFormatted("%.17g", pValue->doubleValue);
+        break;
+    }
+}
+
 static void OutputLocation(const JSON_Location* pLocation)
 {
     OutputFormatted("%d,%d,%d,%d", (int)pLocation->byte, (int)pLocation->line, (int)pLocation->column, (int)pLocation->depth);
@@ -359,6 +407,8 @@ static void ResetOutput(void)
 
 #ifndef JSON_NO_PARSER
 
+static int s_outputKeyIndexes = 0;
+
 typedef struct tag_ParserState
 {
     JSON_Error    error;
@@ -443,6 +493,9 @@ typedef struct tag_ParserSettings
     JSON_Boolean  replaceInvalidEncodingSequences;
     JSON_Boolean  trackObjectMembers;
     JSON_Boolean  stopAfterEmbeddedDocument;
+    JSON_Boolean  zeroCopyStrings;
+    JSON_Boolean  allowMultipleDocuments;
+    JSON_Boolean  skipInvalidDocuments;
 } ParserSettings;
 
 static void InitParserSettings(ParserSettings* pSettings)
@@ -461,6 +514,9 @@ static void InitParserSettings(ParserSettings* pSettings)
     pSettings->replaceInvalidEncodingSequences = JSON_False;
     pSettings->trackObjectMembers = JSON_False;
     pSettings->stopAfterEmbeddedDocument = JSON_False;
+    pSettings->zeroCopyStrings = JSON_False;
+    pSettings->allowMultipleDocuments = JSON_False;
+    pSettings->skipInvalidDocuments = JSON_False;
 }
 
 static void GetParserSettings(JSON_Parser parser, ParserSettings* pSettings)
@@ -479,6 +535,9 @@ static void GetParserSettings(JSON_Parser parser, ParserSettings* pSettings)
     pSettings->replaceInvalidEncodingSequences = JSON_Parser_GetReplaceInvalidEncodingSequences(parser);
     pSettings->trackObjectMembers = JSON_Parser_GetTrackObjectMembers(parser);
     pSettings->stopAfterEmbeddedDocument = JSON_Parser_GetStopAfterEmbeddedDocument(parser);
+    pSettings->zeroCopyStrings = JSON_Parser_GetZeroCopyStrings(parser);
+    pSettings->allowMultipleDocuments = JSON_Parser_GetAllowMultipleDocuments(parser);
+    pSettings->skipInvalidDocuments = JSON_Parser_GetSkipInvalidDocuments(parser);
 }
 
 static int ParserSettingsAreIdentical(const ParserSettings* pSettings1, const ParserSettings* pSettings2)
@@ -496,7 +555,10 @@ static int ParserSettingsAreIdentical(const ParserSettings* pSettings1, const Pa
             pSettings1->allowUnescapedControlCharacters == pSettings2->allowUnescapedControlCharacters &&
             pSettings1->replaceInvalidEncodingSequences == pSettings2->replaceInvalidEncodingSequences &&
             pSettings1->trackObjectMembers == pSettings2->trackObjectMembers &&
-            pSettings1->stopAfterEmbeddedDocument == pSettings2->stopAfterEmbeddedDocument);
+            pSettings1->stopAfterEmbeddedDocument == pSettings2->stopAfterEmbeddedDocument &&
+            pSettings1->zeroCopyStrings == pSettings2->zeroCopyStrings &&
+            pSettings1->allowMultipleDocuments == pSettings2->allowMultipleDocuments &&
+            pSettings1->skipInvalidDocuments == pSettings2->skipInvalidDocuments);
 }
 
 static int CheckParserSettings(JSON_Parser parser, const ParserSettings* pExpectedSettings)
@@ -531,6 +593,9 @@ static int CheckParserSettings(JSON_Parser parser, const ParserSettings* pExpect
                "  JSON_Parser_GetReplaceInvalidEncodingSequences() %8d   %8d\n"
                "  JSON_Parser_GetTrackObjectMembers()              %8d   %8d\n"
                "  JSON_Parser_GetStopAfterEmbeddedDocument()       %8d   %8d\n"
+               "  JSON_Parser_GetZeroCopyStrings()                 %8d   %8d\n"
+               "  JSON_Parser_GetAllowMultipleDocuments()          %8d   %8d\n"
+               "  JSON_Parser_GetSkipInvalidDocuments()            %8d   %8d\n"
                ,
                (int)pExpectedSettings->allowBOM, (int)actualSettings.allowBOM,
                (int)pExpectedSettings->allowComments, (int)actualSettings.allowComments,
@@ -539,7 +604,10 @@ static int CheckParserSettings(JSON_Parser parser, const ParserSettings* pExpect
                (int)pExpectedSettings->allowUnescapedControlCharacters, (int)actualSettings.allowUnescapedControlCharacters,
                (int)pExpectedSettings->replaceInvalidEncodingSequences, (int)actualSettings.replaceInvalidEncodingSequences,
                (int)pExpectedSettings->trackObjectMembers, (int)actualSettings.trackObjectMembers,
-               (int)pExpectedSettings->stopAfterEmbeddedDocument, (int)actualSettings.stopAfterEmbeddedDocument
+               (int)pExpectedSettings->stopAfterEmbeddedDocument, (int)actualSettings.stopAfterEmbeddedDocument,
+               (int)pExpectedSettings->zeroCopyStrings, (int)actualSettings.zeroCopyStrings,
+               (int)pExpectedSettings->allowMultipleDocuments, (int)actualSettings.allowMultipleDocuments,
+               (int)pExpectedSettings->skipInvalidDocuments, (int)actualSettings.skipInvalidDocuments
             );
     }
     return identical;
@@ -552,6 +620,7 @@ typedef struct tag_ParserHandlers
     JSON_Parser_BooleanHandler          booleanHandler;
     JSON_Parser_StringHandler           stringHandler;
     JSON_Parser_NumberHandler           numberHandler;
+    JSON_Parser_TypedNumberHandler      typedNumberHandler;
     JSON_Parser_SpecialNumberHandler    specialNumberHandler;
     JSON_Parser_StartObjectHandler      startObjectHandler;
     JSON_Parser_EndObjectHandler        endObjectHandler;
@@ -559,6 +628,9 @@ typedef struct tag_ParserHandlers
     JSON_Parser_StartArrayHandler       startArrayHandler;
     JSON_Parser_EndArrayHandler         endArrayHandler;
     JSON_Parser_ArrayItemHandler        arrayItemHandler;
+    JSON_Parser_StartDocumentHandler    startDocumentHandler;
+    JSON_Parser_EndDocumentHandler      endDocumentHandler;
+    JSON_Parser_EventBatchHandler       eventBatchHandler;
 } ParserHandlers;
 
 static void InitParserHandlers(ParserHandlers* pHandlers)
@@ -568,6 +640,7 @@ static void InitParserHandlers(ParserHandlers* pHandlers)
     pHandlers->booleanHandler = NULL;
     pHandlers->stringHandler = NULL;
     pHandlers->numberHandler = NULL;
+    pHandlers->typedNumberHandler = NULL;
     pHandlers->specialNumberHandler = NULL;
     pHandlers->startObjectHandler = NULL;
     pHandlers->endObjectHandler = NULL;
@@ -575,6 +648,9 @@ static void InitParserHandlers(ParserHandlers* pHandlers)
     pHandlers->startArrayHandler = NULL;
     pHandlers->endArrayHandler = NULL;
     pHandlers->arrayItemHandler = NULL;
+    pHandlers->startDocumentHandler = NULL;
+    pHandlers->endDocumentHandler = NULL;
+    pHandlers->eventBatchHandler = NULL;
 }
 
 static void GetParserHandlers(JSON_Parser parser, ParserHandlers* pHandlers)
@@ -584,6 +660,7 @@ static void GetParserHandlers(JSON_Parser parser, ParserHandlers* pHandlers)
     pHandlers->booleanHandler = JSON_Parser_GetBooleanHandler(parser);
     pHandlers->stringHandler = JSON_Parser_GetStringHandler(parser);
     pHandlers->numberHandler = JSON_Parser_GetNumberHandler(parser);
+    pHandlers->typedNumberHandler = JSON_Parser_GetTypedNumberHandler(parser);
     pHandlers->specialNumberHandler = JSON_Parser_GetSpecialNumberHandler(parser);
     pHandlers->startObjectHandler = JSON_Parser_GetStartObjectHandler(parser);
     pHandlers->endObjectHandler = JSON_Parser_GetEndObjectHandler(parser);
@@ -591,6 +668,9 @@ static void GetParserHandlers(JSON_Parser parser, ParserHandlers* pHandlers)
     pHandlers->startArrayHandler = JSON_Parser_GetStartArrayHandler(parser);
     pHandlers->endArrayHandler = JSON_Parser_GetEndArrayHandler(parser);
     pHandlers->arrayItemHandler = JSON_Parser_GetArrayItemHandler(parser);
+    pHandlers->startDocumentHandler = JSON_Parser_GetStartDocumentHandler(parser);
+    pHandlers->endDocumentHandler = JSON_Parser_GetEndDocumentHandler(parser);
+    pHandlers->eventBatchHandler = JSON_Parser_GetEventBatchHandler(parser);
 }
 
 static int ParserHandlersAreIdentical(const ParserHandlers* pHandlers1, const ParserHandlers* pHandlers2)
@@ -600,13 +680,17 @@ static int ParserHandlersAreIdentical(const ParserHandlers* pHandlers1, const Pa
             pHandlers1->booleanHandler == pHandlers2->booleanHandler &&
             pHandlers1->stringHandler == pHandlers2->stringHandler &&
             pHandlers1->numberHandler == pHandlers2->numberHandler &&
+            pHandlers1->typedNumberHandler == pHandlers2->typedNumberHandler &&
             pHandlers1->specialNumberHandler == pHandlers2->specialNumberHandler &&
             pHandlers1->startObjectHandler == pHandlers2->startObjectHandler &&
             pHandlers1->endObjectHandler == pHandlers2->endObjectHandler &&
             pHandlers1->objectMemberHandler == pHandlers2->objectMemberHandler &&
             pHandlers1->startArrayHandler == pHandlers2->startArrayHandler &&
             pHandlers1->endArrayHandler == pHandlers2->endArrayHandler &&
-            pHandlers1->arrayItemHandler == pHandlers2->arrayItemHandler);
+            pHandlers1->arrayItemHandler == pHandlers2->arrayItemHandler &&
+            pHandlers1->startDocumentHandler == pHandlers2->startDocumentHandler &&
+            pHandlers1->endDocumentHandler == pHandlers2->endDocumentHandler &&
+            pHandlers1->eventBatchHandler == pHandlers2->eventBatchHandler);
 }
 
 static int CheckParserHandlers(JSON_Parser parser, const ParserHandlers* pExpectedHandlers)
@@ -624,6 +708,7 @@ static int CheckParserHandlers(JSON_Parser parser, const ParserHandlers* pExpect
                "  JSON_Parser_GetBooleanHandler()          %8s   %8s\n"
                "  JSON_Parser_GetStringHandler()           %8s   %8s\n"
                "  JSON_Parser_GetNumberHandler()           %8s   %8s\n"
+               "  JSON_Parser_GetTypedNumberHandler()      %8s   %8s\n"
                "  JSON_Parser_GetSpecialNumberHandler()    %8s   %8s\n"
                ,
                HANDLER_STRING(pExpectedHandlers->encodingDetectedHandler), HANDLER_STRING(actualHandlers.encodingDetectedHandler),
@@ -631,6 +716,7 @@ static int CheckParserHandlers(JSON_Parser parser, const ParserHandlers* pExpect
                HANDLER_STRING(pExpectedHandlers->booleanHandler), HANDLER_STRING(actualHandlers.booleanHandler),
                HANDLER_STRING(pExpectedHandlers->stringHandler), HANDLER_STRING(actualHandlers.stringHandler),
                HANDLER_STRING(pExpectedHandlers->numberHandler), HANDLER_STRING(actualHandlers.numberHandler),
+               HANDLER_STRING(pExpectedHandlers->typedNumberHandler), HANDLER_STRING(actualHandlers.typedNumberHandler),
                HANDLER_STRING(pExpectedHandlers->specialNumberHandler), HANDLER_STRING(actualHandlers.specialNumberHandler)
             );
         printf("  JSON_Parser_GetStartObjectHandler()      %8s   %8s\n"
@@ -639,13 +725,19 @@ static int CheckParserHandlers(JSON_Parser parser, const ParserHandlers* pExpect
                "  JSON_Parser_GetStartArrayHandler()       %8s   %8s\n"
                "  JSON_Parser_GetEndArrayHandler()         %8s   %8s\n"
                "  JSON_Parser_GetArrayItemHandler()        %8s   %8s\n"
+               "  JSON_Parser_GetStartDocumentHandler()    %8s   %8s\n"
+               "  JSON_Parser_GetEndDocumentHandler()      %8s   %8s\n"
+               "  JSON_Parser_GetEventBatchHandler()       %8s   %8s\n"
                ,
                HANDLER_STRING(pExpectedHandlers->startObjectHandler), HANDLER_STRING(actualHandlers.startObjectHandler),
                HANDLER_STRING(pExpectedHandlers->endObjectHandler), HANDLER_STRING(actualHandlers.endObjectHandler),
                HANDLER_STRING(pExpectedHandlers->objectMemberHandler), HANDLER_STRING(actualHandlers.objectMemberHandler),
                HANDLER_STRING(pExpectedHandlers->startArrayHandler), HANDLER_STRING(actualHandlers.startArrayHandler),
                HANDLER_STRING(pExpectedHandlers->endArrayHandler), HANDLER_STRING(actualHandlers.endArrayHandler),
-               HANDLER_STRING(pExpectedHandlers->arrayItemHandler), HANDLER_STRING(actualHandlers.arrayItemHandler)
+               HANDLER_STRING(pExpectedHandlers->arrayItemHandler), HANDLER_STRING(actualHandlers.arrayItemHandler),
+               HANDLER_STRING(pExpectedHandlers->startDocumentHandler), HANDLER_STRING(actualHandlers.startDocumentHandler),
+               HANDLER_STRING(pExpectedHandlers->endDocumentHandler), HANDLER_STRING(actualHandlers.endDocumentHandler),
+               HANDLER_STRING(pExpectedHandlers->eventBatchHandler), HANDLER_STRING(actualHandlers.eventBatchHandler)
             );
     }
     return identical;
@@ -881,6 +973,36 @@ static int CheckParserSetStopAfterEmbeddedDocument(JSON_Parser parser, JSON_Bool
     return 1;
 }
 
+static int CheckParserSetZeroCopyStrings(JSON_Parser parser, JSON_Boolean zeroCopyStrings, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetZeroCopyStrings(parser, zeroCopyStrings) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetZeroCopyStrings() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetAllowMultipleDocuments(JSON_Parser parser, JSON_Boolean allowMultipleDocuments, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetAllowMultipleDocuments(parser, allowMultipleDocuments) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetAllowMultipleDocuments() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetSkipInvalidDocuments(JSON_Parser parser, JSON_Boolean skipInvalidDocuments, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetSkipInvalidDocuments(parser, skipInvalidDocuments) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetSkipInvalidDocuments() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
 static int CheckParserSetEncodingDetectedHandler(JSON_Parser parser, JSON_Parser_EncodingDetectedHandler handler, JSON_Status expectedStatus)
 {
     if (JSON_Parser_SetEncodingDetectedHandler(parser, handler) != expectedStatus)
@@ -931,6 +1053,16 @@ static int CheckParserSetNumberHandler(JSON_Parser parser, JSON_Parser_NumberHan
     return 1;
 }
 
+static int CheckParserSetTypedNumberHandler(JSON_Parser parser, JSON_Parser_TypedNumberHandler handler, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetTypedNumberHandler(parser, handler) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetTypedNumberHandler() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
 static int CheckParserSetSpecialNumberHandler(JSON_Parser parser, JSON_Parser_SpecialNumberHandler handler, JSON_Status expectedStatus)
 {
     if (JSON_Parser_SetSpecialNumberHandler(parser, handler) != expectedStatus)
@@ -1001,6 +1133,26 @@ static int CheckParserSetArrayItemHandler(JSON_Parser parser, JSON_Parser_ArrayI
     return 1;
 }
 
+static int CheckParserSetStartDocumentHandler(JSON_Parser parser, JSON_Parser_StartDocumentHandler handler, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetStartDocumentHandler(parser, handler) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetStartDocumentHandler() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetEndDocumentHandler(JSON_Parser parser, JSON_Parser_EndDocumentHandler handler, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetEndDocumentHandler(parser, handler) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetEndDocumentHandler() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
 static int CheckParserParse(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal, JSON_Status expectedStatus)
 {
     if (JSON_Parser_Parse(parser, pBytes, length, isFinal) != expectedStatus)
@@ -1011,8 +1163,164 @@ static int CheckParserParse(JSON_Parser parser, const char* pBytes, size_t lengt
     return 1;
 }
 
+static int CheckParserParseFile(JSON_Parser parser, const char* path, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_ParseFile(parser, path) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_ParseFile() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserParseFd(JSON_Parser parser, int fd, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_ParseFd(parser, fd) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_ParseFd() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetInput(JSON_Parser parser, const char* pBytes, size_t length, JSON_Boolean isFinal, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetInput(parser, pBytes, length, isFinal) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetInput() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserNextEvent(JSON_Parser parser, JSON_Event* pEvent, JSON_EventType expectedType, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_NextEvent(parser, pEvent) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_NextEvent() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    if (expectedStatus == JSON_Success && pEvent->type != expectedType)
+    {
+        printf("FAILURE: expected JSON_Parser_NextEvent() to return event type %d instead of %d\n", (int)expectedType, (int)pEvent->type);
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetEventBatchHandler(JSON_Parser parser, JSON_Parser_EventBatchHandler handler, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetEventBatchHandler(parser, handler) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetEventBatchHandler() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetEventBatchBuffer(JSON_Parser parser, JSON_BatchedEvent* pEvents, size_t size, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetEventBatchBuffer(parser, pEvents, size) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetEventBatchBuffer() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserBuildStructuralIndex(JSON_Parser parser, const char* pBytes, size_t length, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_BuildStructuralIndex(parser, pBytes, length) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_BuildStructuralIndex() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserAddPathFilter(JSON_Parser parser, const char* pPath, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_AddPathFilter(parser, pPath) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_AddPathFilter() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserAddPathFilters(JSON_Parser parser, const char* pPaths)
+{
+    /* The paths are separated by vertical bars. */
+    char path[64];
+    while (pPaths)
+    {
+        const char* pBar = strchr(pPaths, '|');
+        size_t length = pBar ? (size_t)(pBar - pPaths) : strlen(pPaths);
+        memcpy(path, pPaths, length);
+        path[length] = 0;
+        if (!CheckParserAddPathFilter(parser, path, JSON_Success))
+        {
+            return 0;
+        }
+        pPaths = pBar ? pBar + 1 : NULL;
+    }
+    return 1;
+}
+
+static int CheckParserSetKeyDictionary(JSON_Parser parser, const char* const* ppKeys, size_t keyCount, JSON_Status expectedStatus)
+{
+    if (JSON_Parser_SetKeyDictionary(parser, ppKeys, keyCount) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Parser_SetKeyDictionary() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParserSetKeys(JSON_Parser parser, const char* pKeys)
+{
+    /* The keys are separated by vertical bars. */
+    char keyBytes[256];
+    const char* keys[32];
+    size_t keyCount = 0;
+    size_t i;
+    strcpy(keyBytes, pKeys);
+    keys[keyCount++] = keyBytes;
+    for (i = 0; keyBytes[i]; i++)
+    {
+        if (keyBytes[i] == '|')
+        {
+            keyBytes[i] = 0;
+            keys[keyCount++] = &keyBytes[i + 1];
+        }
+    }
+    return CheckParserSetKeyDictionary(parser, keys, keyCount, JSON_Success);
+}
+
+static int CheckParserStructuralIndex(JSON_Parser parser, const size_t* pExpectedOffsets, size_t expectedLength)
+{
+    size_t length = 0;
+    size_t i;
+    const size_t* pOffsets = JSON_Parser_GetStructuralIndex(parser, &length);
+    if (length != expectedLength || (!pOffsets != !expectedLength))
+    {
+        printf("FAILURE: expected JSON_Parser_GetStructuralIndex() to return %d offsets instead of %d\n", (int)expectedLength, (int)length);
+        return 0;
+    }
+    for (i = 0; i < length; i++)
+    {
+        if (pOffsets[i] != pExpectedOffsets[i])
+        {
+            printf("FAILURE: expected structural index entry %d to be %d instead of %d\n", (int)i, (int)pExpectedOffsets[i], (int)pOffsets[i]);
+            return 0;
+        }
+    }
+    return 1;
+}
+
 static int TryToMisbehaveInParseHandler(JSON_Parser parser)
 {
+    JSON_Event event;
     if (!CheckParserFree(parser, JSON_Failure) ||
         !CheckParserReset(parser, JSON_Failure) ||
         !CheckParserGetTokenLocation(parser, NULL, JSON_Failure) ||
@@ -1030,7 +1338,15 @@ static int TryToMisbehaveInParseHandler(JSON_Parser parser)
         !CheckParserSetReplaceInvalidEncodingSequences(parser, JSON_True, JSON_Failure) ||
         !CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Failure) ||
         !CheckParserSetStopAfterEmbeddedDocument(parser, JSON_True, JSON_Failure) ||
-        !CheckParserParse(parser, " ", 1, JSON_False, JSON_Failure))
+        !CheckParserSetZeroCopyStrings(parser, JSON_True, JSON_Failure) ||
+        !CheckParserSetAllowMultipleDocuments(parser, JSON_True, JSON_Failure) ||
+        !CheckParserSetSkipInvalidDocuments(parser, JSON_True, JSON_Failure) ||
+        !CheckParserSetEventBatchBuffer(parser, NULL, 0, JSON_Failure) ||
+        !CheckParserBuildStructuralIndex(parser, " ", 1, JSON_Failure) ||
+        !CheckParserParse(parser, " ", 1, JSON_False, JSON_Failure) ||
+        !CheckParserParseFd(parser, 0, JSON_Failure) ||
+        !CheckParserSetInput(parser, " ", 1, JSON_False, JSON_Failure) ||
+        !CheckParserNextEvent(parser, &event, JSON_NeedMoreInputEvent, JSON_Failure))
     {
         return 1;
     }
@@ -1153,7 +1469,10 @@ static JSON_Parser_HandlerResult JSON_CALL StringHandler(JSON_Parser parser, cha
     OutputLocation(&location);
     OutputFormatted("-");
     OutputLocation(&afterLocation);
-    memset(pValue, 0, length); /* test that the buffer is really writable */
+    if (!(attributes & JSON_PointsIntoInput))
+    {
+        memset(pValue, 0, length); /* test that the buffer is really writable */
+    }
     return JSON_Parser_Continue;
 }
 
@@ -1184,6 +1503,32 @@ static JSON_Parser_HandlerResult JSON_CALL NumberHandler(JSON_Parser parser, cha
     return JSON_Parser_Continue;
 }
 
+static JSON_Parser_HandlerResult JSON_CALL TypedNumberHandler(JSON_Parser parser, const JSON_NumberValue* pValue, JSON_NumberAttributes attributes)
+{
+    JSON_Location location, afterLocation;
+    if (s_failHandler)
+    {
+        return JSON_Parser_Abort;
+    }
+    if (s_misbehaveInHandler && TryToMisbehaveInParseHandler(parser))
+    {
+        return JSON_Parser_Abort;
+    }
+    if (JSON_Parser_GetTokenLocation(parser, &location) != JSON_Success ||
+        JSON_Parser_GetAfterTokenLocation(parser, &afterLocation) != JSON_Success)
+    {
+        return JSON_Parser_Abort;
+    }
+    OutputSeparator();
+    OutputFormatted("%s(", (pValue->type == JSON_Int64Number) ? "#i" : ((pValue->type == JSON_UInt64Number) ? "#u" : "#d"));
+    OutputTypedNumber(pValue, attributes);
+    OutputFormatted("):");
+    OutputLocation(&location);
+    OutputFormatted("-");
+    OutputLocation(&afterLocation);
+    return JSON_Parser_Continue;
+}
+
 static JSON_Parser_HandlerResult JSON_CALL SpecialNumberHandler(JSON_Parser parser, JSON_SpecialNumber value)
 {
     JSON_Location location, afterLocation;
@@ -1275,6 +1620,7 @@ static JSON_Parser_HandlerResult JSON_CALL EndObjectHandler(JSON_Parser parser)
 static JSON_Parser_HandlerResult JSON_CALL ObjectMemberHandler(JSON_Parser parser, char* pValue, size_t length, JSON_StringAttributes attributes)
 {
     JSON_Location location, afterLocation;
+    int skip;
     if (s_failHandler)
     {
         return JSON_Parser_Abort;
@@ -1292,15 +1638,29 @@ static JSON_Parser_HandlerResult JSON_CALL ObjectMemberHandler(JSON_Parser parse
     {
         return JSON_Parser_Abort;
     }
+    skip = (attributes == JSON_SimpleString && !strcmp(pValue, "skip"));
     OutputSeparator();
     OutputFormatted("m(");
     OutputStringBytes((const unsigned char*)pValue, length, attributes, JSON_Parser_GetStringEncoding(parser));
-    OutputFormatted("):");
+    OutputFormatted(")");
+    if (s_outputKeyIndexes)
+    {
+        size_t keyIndex;
+        if (JSON_Parser_GetMemberKeyIndex(parser, &keyIndex) != JSON_Success)
+        {
+            return JSON_Parser_Abort;
+        }
+        OutputFormatted("=%d", (int)keyIndex);
+    }
+    OutputFormatted(":");
     OutputLocation(&location);
     OutputFormatted("-");
     OutputLocation(&afterLocation);
-    memset(pValue, 0, length); /* test that the buffer is really writable */
-    return JSON_Parser_Continue;
+    if (!(attributes & JSON_PointsIntoInput))
+    {
+        memset(pValue, 0, length); /* test that the buffer is really writable */
+    }
+    return skip ? JSON_Parser_SkipValue : JSON_Parser_Continue;
 }
 
 static JSON_Parser_HandlerResult JSON_CALL StartArrayHandler(JSON_Parser parser)
@@ -1375,6 +1735,68 @@ static JSON_Parser_HandlerResult JSON_CALL ArrayItemHandler(JSON_Parser parser)
     return JSON_Parser_Continue;
 }
 
+static JSON_Parser_HandlerResult JSON_CALL StartDocumentHandler(JSON_Parser parser)
+{
+    JSON_Location location, afterLocation;
+    if (s_failHandler)
+    {
+        return JSON_Parser_Abort;
+    }
+    if (s_misbehaveInHandler && TryToMisbehaveInParseHandler(parser))
+    {
+        return JSON_Parser_Abort;
+    }
+    OutputSeparator();
+    OutputFormatted("D");
+    if (JSON_Parser_GetTokenLocation(parser, &location) == JSON_Success &&
+        JSON_Parser_GetAfterTokenLocation(parser, &afterLocation) == JSON_Success)
+    {
+        /* An invalid document can start without a token. */
+        OutputFormatted(":");
+        OutputLocation(&location);
+        OutputFormatted("-");
+        OutputLocation(&afterLocation);
+    }
+    return JSON_Parser_Continue;
+}
+
+static JSON_Parser_HandlerResult JSON_CALL EndDocumentHandler(JSON_Parser parser)
+{
+    JSON_Location location, afterLocation;
+    if (s_failHandler)
+    {
+        return JSON_Parser_Abort;
+    }
+    if (s_misbehaveInHandler && TryToMisbehaveInParseHandler(parser))
+    {
+        return JSON_Parser_Abort;
+    }
+    OutputSeparator();
+    OutputFormatted("/D");
+    if (JSON_Parser_GetError(parser) != JSON_Error_None)
+    {
+        if (JSON_Parser_GetErrorLocation(parser, &location) != JSON_Success)
+        {
+            return JSON_Parser_Abort;
+        }
+        OutputFormatted("!(%s):", errorNames[JSON_Parser_GetError(parser)]);
+        OutputLocation(&location);
+    }
+    else
+    {
+        if (JSON_Parser_GetTokenLocation(parser, &location) != JSON_Success ||
+            JSON_Parser_GetAfterTokenLocation(parser, &afterLocation) != JSON_Success)
+        {
+            return JSON_Parser_Abort;
+        }
+        OutputFormatted(":");
+        OutputLocation(&location);
+        OutputFormatted("-");
+        OutputLocation(&afterLocation);
+    }
+    return JSON_Parser_Continue;
+}
+
 typedef enum tag_ParserParam
 {
     Standard = 0,
@@ -1415,7 +1837,15 @@ typedef enum tag_ParserParam
     AllowUnescapedControlCharacters = 1 << 16,
     ReplaceInvalidEncodingSequences = 1 << 17,
     TrackObjectMembers              = 1 << 18,
-    StopAfterEmbeddedDocument       = 1 << 19
+    StopAfterEmbeddedDocument       = 1 << 19,
+    UseStructuralIndex              = 1 << 20,
+    ZeroCopyStrings                 = 1 << 21,
+    TypedNumbers                    = 1 << 22, /* typed number handler only */
+    TypedAndTextNumbers             = 1 << 23, /* typed and text number handlers */
+    HandlersOnly                    = 1 << 24, /* result depends on the handlers, so don't pull events */
+    AllowMultipleDocuments          = 1 << 25,
+    SkipInvalidDocuments            = 1 << 26,
+    DocumentHandlers                = 1 << 27  /* set the start and end document handlers */
 } ParserParam;
 typedef unsigned int ParserParams;
 
@@ -1428,25 +1858,384 @@ typedef struct tag_ParseTest
     JSON_Boolean  isFinal;
     JSON_Encoding inputEncoding;
     const char*   pOutput;
+    const char*   pPathFilters; /* separated by vertical bars, or NULL */
+    const char*   pKeys;        /* separated by vertical bars, or NULL */
 } ParseTest;
 
-static void RunParseTest(const ParseTest* pTest)
-{
-    JSON_Parser parser = NULL;
-    ParserSettings settings;
-    ParserState state;
-    printf("Test parsing %s ... ", pTest->pName);
-
-    InitParserSettings(&settings);
-    if ((pTest->parserParams & 0xF) != DefaultIn)
-    {
-        settings.inputEncoding = (JSON_Encoding)(pTest->parserParams & 0xF);
+static int SetUpParseTestParser(const ParseTest* pTest, const ParserSettings* pSettings, JSON_Parser* pParser)
+{
+    return CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, pParser) &&
+           CheckParserSetEncodingDetectedHandler(*pParser, &EncodingDetectedHandler, JSON_Success) &&
+           CheckParserSetNullHandler(*pParser, &NullHandler, JSON_Success) &&
+           CheckParserSetBooleanHandler(*pParser, &BooleanHandler, JSON_Success) &&
+           CheckParserSetStringHandler(*pParser, &StringHandler, JSON_Success) &&
+           CheckParserSetNumberHandler(*pParser, (pTest->parserParams & TypedNumbers) ? NULL : &NumberHandler, JSON_Success) &&
+           CheckParserSetTypedNumberHandler(*pParser, (pTest->parserParams & (TypedNumbers | TypedAndTextNumbers)) ? &TypedNumberHandler : NULL, JSON_Success) &&
+           CheckParserSetSpecialNumberHandler(*pParser, &SpecialNumberHandler, JSON_Success) &&
+           CheckParserSetStartObjectHandler(*pParser, &StartObjectHandler, JSON_Success) &&
+           CheckParserSetEndObjectHandler(*pParser, &EndObjectHandler, JSON_Success) &&
+           CheckParserSetObjectMemberHandler(*pParser, &ObjectMemberHandler, JSON_Success) &&
+           CheckParserSetStartArrayHandler(*pParser, &StartArrayHandler, JSON_Success) &&
+           CheckParserSetEndArrayHandler(*pParser, &EndArrayHandler, JSON_Success) &&
+           CheckParserSetArrayItemHandler(*pParser, &ArrayItemHandler, JSON_Success) &&
+           CheckParserSetStartDocumentHandler(*pParser, (pTest->parserParams & DocumentHandlers) ? &StartDocumentHandler : NULL, JSON_Success) &&
+           CheckParserSetEndDocumentHandler(*pParser, (pTest->parserParams & DocumentHandlers) ? &EndDocumentHandler : NULL, JSON_Success) &&
+           (!pTest->pKeys || CheckParserSetKeys(*pParser, pTest->pKeys)) &&
+           CheckParserSetInputEncoding(*pParser, pSettings->inputEncoding, JSON_Success) &&
+           CheckParserSetStringEncoding(*pParser, pSettings->stringEncoding, JSON_Success) &&
+           CheckParserSetNumberEncoding(*pParser, pSettings->numberEncoding, JSON_Success) &&
+           CheckParserSetMaxStringLength(*pParser, pSettings->maxStringLength, JSON_Success) &&
+           CheckParserSetMaxNumberLength(*pParser, pSettings->maxNumberLength, JSON_Success) &&
+           CheckParserSetAllowBOM(*pParser, pSettings->allowBOM, JSON_Success) &&
+           CheckParserSetAllowComments(*pParser, pSettings->allowComments, JSON_Success) &&
+           CheckParserSetAllowSpecialNumbers(*pParser, pSettings->allowSpecialNumbers, JSON_Success) &&
+           CheckParserSetAllowHexNumbers(*pParser, pSettings->allowHexNumbers, JSON_Success) &&
+           CheckParserSetAllowUnescapedControlCharacters(*pParser, pSettings->allowUnescapedControlCharacters, JSON_Success) &&
+           CheckParserSetReplaceInvalidEncodingSequences(*pParser, pSettings->replaceInvalidEncodingSequences, JSON_Success) &&
+           CheckParserSetTrackObjectMembers(*pParser, pSettings->trackObjectMembers, JSON_Success) &&
+           CheckParserSetStopAfterEmbeddedDocument(*pParser, pSettings->stopAfterEmbeddedDocument, JSON_Success) &&
+           CheckParserSetZeroCopyStrings(*pParser, pSettings->zeroCopyStrings, JSON_Success) &&
+           CheckParserSetAllowMultipleDocuments(*pParser, pSettings->allowMultipleDocuments, JSON_Success) &&
+           CheckParserSetSkipInvalidDocuments(*pParser, pSettings->skipInvalidDocuments, JSON_Success) &&
+           (!(pTest->parserParams & UseStructuralIndex) || CheckParserBuildStructuralIndex(*pParser, pTest->pInput, pTest->length, JSON_Success)) &&
+           (!pTest->pPathFilters || CheckParserAddPathFilters(*pParser, pTest->pPathFilters));
+}
+
+static size_t MatchOutputLocation(const char* pOutput)
+{
+    size_t i = 0;
+    int part;
+    for (part = 0; part < 4; part++)
+    {
+        if (part && pOutput[i++] != ',')
+        {
+            return 0;
+        }
+        if (pOutput[i] < '0' || pOutput[i] > '9')
+        {
+            return 0;
+        }
+        while (pOutput[i] >= '0' && pOutput[i] <= '9')
+        {
+            i++;
+        }
     }
-    if ((pTest->parserParams & 0xF0) != DefaultOut)
+    return i;
+}
+
+static void StripTokenLocationsAndArrayItems(const char* pOutput, char* pStrippedOutput)
+{
+    /* Pulled events have no token locations and there are no array item
+       or document events, so remove them from the expected output of a
+       parse test. */
+    size_t i = 0;
+    size_t j = 0;
+    while (pOutput[i])
     {
-        settings.stringEncoding = settings.numberEncoding = (JSON_Encoding)((pTest->parserParams >> 4) & 0xF);
-    }
-    if ((pTest->parserParams & 0x300) != DefaultMaxStringLength)
+        size_t length1;
+        size_t length2;
+        if ((!i || pOutput[i - 1] == ' ') &&
+            ((pOutput[i] == 'i' && pOutput[i + 1] == ':') ||
+             (pOutput[i] == 'D' && (pOutput[i + 1] == ':' || pOutput[i + 1] == ' ' || !pOutput[i + 1])) ||
+             (pOutput[i] == '/' && pOutput[i + 1] == 'D')))
+        {
+            while (pOutput[i] && pOutput[i] != ' ')
+            {
+                i++;
+            }
+            if (pOutput[i])
+            {
+                i++;
+            }
+        }
+        else if (pOutput[i] == ':' &&
+                 (length1 = MatchOutputLocation(&pOutput[i + 1])) != 0 &&
+                 pOutput[i + 1 + length1] == '-' &&
+                 (length2 = MatchOutputLocation(&pOutput[i + 2 + length1])) != 0)
+        {
+            i += 2 + length1 + length2;
+        }
+        else
+        {
+            pStrippedOutput[j++] = pOutput[i++];
+        }
+    }
+    if (j && pStrippedOutput[j - 1] == ' ')
+    {
+        j--;
+    }
+    pStrippedOutput[j] = 0;
+}
+
+static void OutputEvent(JSON_Parser parser, const JSON_Event* pEvent)
+{
+    OutputSeparator();
+    switch (pEvent->type)
+    {
+    case JSON_NullEvent:
+        OutputFormatted("n");
+        break;
+    case JSON_BooleanEvent:
+        OutputFormatted("%s", (pEvent->booleanValue == JSON_True) ? "t" : "f");
+        break;
+    case JSON_StringEvent:
+    case JSON_ObjectMemberEvent:
+        OutputFormatted("%s(", (pEvent->type == JSON_StringEvent) ? "s" : "m");
+        OutputStringBytes((const unsigned char*)pEvent->pValue, pEvent->length, pEvent->attributes, JSON_Parser_GetStringEncoding(parser));
+        OutputFormatted(")");
+        if (s_outputKeyIndexes && pEvent->type == JSON_ObjectMemberEvent)
+        {
+            OutputFormatted("=%d", (int)pEvent->keyIndex);
+        }
+        break;
+    case JSON_NumberEvent:
+        OutputFormatted("#(");
+        OutputNumber((const unsigned char*)pEvent->pValue, pEvent->length, pEvent->attributes, JSON_Parser_GetNumberEncoding(parser));
+        OutputFormatted(")");
+        break;
+    case JSON_SpecialNumberEvent:
+        OutputFormatted("#(%s)", (pEvent->specialNumberValue == JSON_NaN) ? "NaN" :
+                        ((pEvent->specialNumberValue == JSON_Infinity) ? "Infinity" : "-Infinity"));
+        break;
+    case JSON_StartObjectEvent:
+        OutputFormatted("{");
+        break;
+    case JSON_EndObjectEvent:
+        OutputFormatted("}");
+        break;
+    case JSON_StartArrayEvent:
+        OutputFormatted("[");
+        break;
+    case JSON_EndArrayEvent:
+        OutputFormatted("]");
+        break;
+    default:
+        OutputFormatted("UNEXPECTED(%d)", (int)pEvent->type);
+        break;
+    }
+}
+
+static int CheckPulledEvents(const ParseTest* pTest, const ParserSettings* pSettings, size_t chunkLength)
+{
+    /* Pull the events for a parse test, supplying the input in chunks of
+       the specified length, and check that they are the same as the
+       events that were passed to the handlers. */
+    JSON_Parser parser = NULL;
+    JSON_Event event;
+    size_t used = 0;
+    int isValid = 0;
+    int supplied = 0;
+    static char expectedOutput[sizeof(s_outputBuffer)];
+    StripTokenLocationsAndArrayItems(pTest->pOutput, expectedOutput);
+    ResetOutput();
+    if (SetUpParseTestParser(pTest, pSettings, &parser))
+    {
+        while (JSON_Parser_NextEvent(parser, &event) == JSON_Success && event.type != JSON_EndOfDocumentEvent)
+        {
+            if (event.type == JSON_NeedMoreInputEvent)
+            {
+                size_t length = pTest->length - used;
+                if (supplied && !length)
+                {
+                    break;
+                }
+                if (length > chunkLength)
+                {
+                    length = chunkLength;
+                }
+                if (JSON_Parser_SetInput(parser, pTest->pInput + used, length, (pTest->isFinal && used + length == pTest->length) ? JSON_True : JSON_False) != JSON_Success)
+                {
+                    OutputFormatted("SetInput failed");
+                    break;
+                }
+                used += length;
+                supplied = 1;
+            }
+            else
+            {
+                OutputEvent(parser, &event);
+            }
+        }
+        if (JSON_Parser_GetError(parser) != JSON_Error_None)
+        {
+            JSON_Location location;
+            JSON_Parser_GetErrorLocation(parser, &location);
+            OutputSeparator();
+            OutputFormatted("!(%s):", errorNames[JSON_Parser_GetError(parser)]);
+            OutputLocation(&location);
+        }
+        isValid = !strcmp(expectedOutput, s_outputBuffer);
+        if (!isValid)
+        {
+            printf("FAILURE: pulled events do not match expected (chunk length %d)\n"
+                   "  EXPECTED %s\n"
+                   "  ACTUAL   %s\n", (int)chunkLength, expectedOutput, s_outputBuffer);
+        }
+    }
+    JSON_Parser_Free(parser);
+    ResetOutput();
+    return isValid;
+}
+
+static size_t s_batchedEventDepth = 0;
+static int s_checkBatchedEventDepth = 1; /* path filters hide the enclosing containers */
+
+static JSON_Parser_HandlerResult JSON_CALL EventBatchHandler(JSON_Parser parser, const JSON_BatchedEvent* pEvents, size_t eventCount, const char* pStringBytes)
+{
+    /* Output the batched events in the same form as pulled events, and
+       check their depths and null terminators along the way. */
+    size_t i;
+    if (!eventCount)
+    {
+        OutputSeparator();
+        OutputFormatted("EMPTY BATCH");
+    }
+    for (i = 0; i < eventCount; i++)
+    {
+        JSON_Event event;
+        event.type = pEvents[i].type;
+        event.pValue = (char*)pStringBytes + pEvents[i].offset;
+        event.length = pEvents[i].length;
+        event.attributes = pEvents[i].attributes;
+        event.booleanValue = (JSON_Boolean)pEvents[i].attributes;
+        event.specialNumberValue = (JSON_SpecialNumber)pEvents[i].attributes;
+        event.keyIndex = pEvents[i].keyIndex;
+        if (event.type == JSON_EndObjectEvent || event.type == JSON_EndArrayEvent)
+        {
+            s_batchedEventDepth--;
+        }
+        OutputEvent(parser, &event);
+        if (s_checkBatchedEventDepth && pEvents[i].depth != s_batchedEventDepth)
+        {
+            OutputFormatted(" BAD DEPTH %d", (int)pEvents[i].depth);
+        }
+        if ((event.type == JSON_StringEvent || event.type == JSON_ObjectMemberEvent || event.type == JSON_NumberEvent) &&
+            pStringBytes[pEvents[i].offset + pEvents[i].length] != 0)
+        {
+            OutputFormatted(" NOT TERMINATED");
+        }
+        if (event.type == JSON_StartObjectEvent || event.type == JSON_StartArrayEvent)
+        {
+            s_batchedEventDepth++;
+        }
+    }
+    return JSON_Parser_Continue;
+}
+
+static int CheckBatchedEvents(const ParseTest* pTest, const ParserSettings* pSettings, size_t chunkLength)
+{
+    /* Parse the input for a parse test in chunks of the specified length,
+       recording events in a small event batch buffer, and check that the
+       batched events are the same as the events that were passed to the
+       handlers. */
+    JSON_Parser parser = NULL;
+    JSON_BatchedEvent events[3];
+    int isValid = 0;
+    static char expectedOutput[sizeof(s_outputBuffer)];
+    StripTokenLocationsAndArrayItems(pTest->pOutput, expectedOutput);
+    ResetOutput();
+    s_batchedEventDepth = 0;
+    s_checkBatchedEventDepth = !pTest->pPathFilters;
+    if (SetUpParseTestParser(pTest, pSettings, &parser) &&
+        CheckParserSetEventBatchHandler(parser, &EventBatchHandler, JSON_Success) &&
+        CheckParserSetEventBatchBuffer(parser, events, sizeof(events) / sizeof(events[0]), JSON_Success))
+    {
+        size_t used = 0;
+        JSON_Status status;
+        do
+        {
+            size_t length = pTest->length - used;
+            if (length > chunkLength)
+            {
+                length = chunkLength;
+            }
+            status = JSON_Parser_Parse(parser, pTest->pInput + used, length, (pTest->isFinal && used + length == pTest->length) ? JSON_True : JSON_False);
+            used += length;
+        } while (status == JSON_Success && used < pTest->length);
+        if (JSON_Parser_GetError(parser) != JSON_Error_None)
+        {
+            JSON_Location location;
+            JSON_Parser_GetErrorLocation(parser, &location);
+            OutputSeparator();
+            OutputFormatted("!(%s):", errorNames[JSON_Parser_GetError(parser)]);
+            OutputLocation(&location);
+        }
+        isValid = !strcmp(expectedOutput, s_outputBuffer);
+        if (!isValid)
+        {
+            printf("FAILURE: batched events do not match expected (chunk length %d)\n"
+                   "  EXPECTED %s\n"
+                   "  ACTUAL   %s\n", (int)chunkLength, expectedOutput, s_outputBuffer);
+        }
+    }
+    JSON_Parser_Free(parser);
+    ResetOutput();
+    return isValid;
+}
+
+static int CheckParsedInChunks(const ParseTest* pTest, const ParserSettings* pSettings, size_t chunkLength)
+{
+    /* Parse the input for a parse test in chunks of the specified length
+       and check that the handlers see exactly the same events, with the
+       same locations, as when the input is parsed all at once. This
+       exercises the fast paths for runs of string bytes, whitespace and
+       literals at every possible chunk boundary. */
+    JSON_Parser parser = NULL;
+    int isValid = 0;
+    ResetOutput();
+    if (SetUpParseTestParser(pTest, pSettings, &parser))
+    {
+        size_t used = 0;
+        JSON_Status status;
+        do
+        {
+            size_t length = pTest->length - used;
+            if (length > chunkLength)
+            {
+                length = chunkLength;
+            }
+            status = JSON_Parser_Parse(parser, pTest->pInput + used, length, (pTest->isFinal && used + length == pTest->length) ? JSON_True : JSON_False);
+            used += length;
+        } while (status == JSON_Success && used < pTest->length);
+        if (JSON_Parser_GetError(parser) != JSON_Error_None)
+        {
+            JSON_Location location;
+            JSON_Parser_GetErrorLocation(parser, &location);
+            OutputSeparator();
+            OutputFormatted("!(%s):", errorNames[JSON_Parser_GetError(parser)]);
+            OutputLocation(&location);
+        }
+        isValid = !strcmp(pTest->pOutput, s_outputBuffer);
+        if (!isValid)
+        {
+            printf("FAILURE: output does not match expected (chunk length %d)\n"
+                   "  EXPECTED %s\n"
+                   "  ACTUAL   %s\n", (int)chunkLength, pTest->pOutput, s_outputBuffer);
+        }
+    }
+    JSON_Parser_Free(parser);
+    ResetOutput();
+    return isValid;
+}
+
+static void RunParseTest(const ParseTest* pTest)
+{
+    JSON_Parser parser = NULL;
+    ParserSettings settings;
+    ParserState state;
+    printf("Test parsing %s ... ", pTest->pName);
+    s_outputKeyIndexes = (pTest->pKeys != NULL);
+
+    InitParserSettings(&settings);
+    if ((pTest->parserParams & 0xF) != DefaultIn)
+    {
+        settings.inputEncoding = (JSON_Encoding)(pTest->parserParams & 0xF);
+    }
+    if ((pTest->parserParams & 0xF0) != DefaultOut)
+    {
+        settings.stringEncoding = settings.numberEncoding = (JSON_Encoding)((pTest->parserParams >> 4) & 0xF);
+    }
+    if ((pTest->parserParams & 0x300) != DefaultMaxStringLength)
     {
         settings.maxStringLength = (size_t)((pTest->parserParams >> 8) & 0x3) - 1;
     }
@@ -1462,37 +2251,15 @@ static void RunParseTest(const ParseTest* pTest)
     settings.replaceInvalidEncodingSequences = (JSON_Boolean)((pTest->parserParams >> 17) & 0x1);
     settings.trackObjectMembers = (JSON_Boolean)((pTest->parserParams >> 18) & 0x1);
     settings.stopAfterEmbeddedDocument = (JSON_Boolean)((pTest->parserParams >> 19) & 0x1);
+    settings.zeroCopyStrings = (JSON_Boolean)((pTest->parserParams >> 21) & 0x1);
+    settings.allowMultipleDocuments = (JSON_Boolean)((pTest->parserParams >> 25) & 0x1);
+    settings.skipInvalidDocuments = (JSON_Boolean)((pTest->parserParams >> 26) & 0x1);
 
     InitParserState(&state);
     state.inputEncoding = pTest->inputEncoding;
     ResetOutput();
 
-    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
-        CheckParserSetEncodingDetectedHandler(parser, &EncodingDetectedHandler, JSON_Success) &&
-        CheckParserSetNullHandler(parser, &NullHandler, JSON_Success) &&
-        CheckParserSetBooleanHandler(parser, &BooleanHandler, JSON_Success) &&
-        CheckParserSetStringHandler(parser, &StringHandler, JSON_Success) &&
-        CheckParserSetNumberHandler(parser, &NumberHandler, JSON_Success) &&
-        CheckParserSetSpecialNumberHandler(parser, &SpecialNumberHandler, JSON_Success) &&
-        CheckParserSetStartObjectHandler(parser, &StartObjectHandler, JSON_Success) &&
-        CheckParserSetEndObjectHandler(parser, &EndObjectHandler, JSON_Success) &&
-        CheckParserSetObjectMemberHandler(parser, &ObjectMemberHandler, JSON_Success) &&
-        CheckParserSetStartArrayHandler(parser, &StartArrayHandler, JSON_Success) &&
-        CheckParserSetEndArrayHandler(parser, &EndArrayHandler, JSON_Success) &&
-        CheckParserSetArrayItemHandler(parser, &ArrayItemHandler, JSON_Success) &&
-        CheckParserSetInputEncoding(parser, settings.inputEncoding, JSON_Success) &&
-        CheckParserSetStringEncoding(parser, settings.stringEncoding, JSON_Success) &&
-        CheckParserSetNumberEncoding(parser, settings.numberEncoding, JSON_Success) &&
-        CheckParserSetMaxStringLength(parser, settings.maxStringLength, JSON_Success) &&
-        CheckParserSetMaxNumberLength(parser, settings.maxNumberLength, JSON_Success) &&
-        CheckParserSetAllowBOM(parser, settings.allowBOM, JSON_Success) &&
-        CheckParserSetAllowComments(parser, settings.allowComments, JSON_Success) &&
-        CheckParserSetAllowSpecialNumbers(parser, settings.allowSpecialNumbers, JSON_Success) &&
-        CheckParserSetAllowHexNumbers(parser, settings.allowHexNumbers, JSON_Success) &&
-        CheckParserSetAllowUnescapedControlCharacters(parser, settings.allowUnescapedControlCharacters, JSON_Success) &&
-        CheckParserSetReplaceInvalidEncodingSequences(parser, settings.replaceInvalidEncodingSequences, JSON_Success) &&
-        CheckParserSetTrackObjectMembers(parser, settings.trackObjectMembers, JSON_Success) &&
-        CheckParserSetStopAfterEmbeddedDocument(parser, settings.stopAfterEmbeddedDocument, JSON_Success))
+    if (SetUpParseTestParser(pTest, &settings, &parser))
     {
         JSON_Parser_Parse(parser, pTest->pInput, pTest->length, pTest->isFinal);
         state.error = JSON_Parser_GetError(parser);
@@ -1503,7 +2270,14 @@ static void RunParseTest(const ParseTest* pTest)
             OutputFormatted("!(%s):", errorNames[state.error]);
             OutputLocation(&state.errorLocation);
         }
-        if (CheckParserState(parser, &state) && CheckOutput(pTest->pOutput))
+        if (CheckParserState(parser, &state) && CheckOutput(pTest->pOutput) &&
+            ((pTest->parserParams & ZeroCopyStrings) || CheckParsedInChunks(pTest, &settings, 1)) &&
+            ((pTest->parserParams & (TypedNumbers | TypedAndTextNumbers | HandlersOnly)) ||
+             (CheckPulledEvents(pTest, &settings, pTest->length) &&
+              ((pTest->parserParams & ZeroCopyStrings) ||
+               (CheckPulledEvents(pTest, &settings, 1) &&
+                CheckBatchedEvents(pTest, &settings, pTest->length) &&
+                CheckBatchedEvents(pTest, &settings, 1))))))
         {
             printf("OK\n");
         }
@@ -1592,6 +2366,9 @@ static void TestParserSetSettings(void)
     settings.replaceInvalidEncodingSequences = JSON_True;
     settings.trackObjectMembers = JSON_True;
     settings.stopAfterEmbeddedDocument = JSON_True;
+    settings.zeroCopyStrings = JSON_True;
+    settings.allowMultipleDocuments = JSON_True;
+    settings.skipInvalidDocuments = JSON_True;
     if (CheckParserCreate(NULL, JSON_Success, &parser) &&
         CheckParserSetUserData(parser, settings.userData, JSON_Success) &&
         CheckParserSetInputEncoding(parser, settings.inputEncoding, JSON_Success) &&
@@ -1607,6 +2384,9 @@ static void TestParserSetSettings(void)
         CheckParserSetReplaceInvalidEncodingSequences(parser, settings.replaceInvalidEncodingSequences, JSON_Success) &&
         CheckParserSetTrackObjectMembers(parser, settings.trackObjectMembers, JSON_Success) &&
         CheckParserSetStopAfterEmbeddedDocument(parser, settings.stopAfterEmbeddedDocument, JSON_Success) &&
+        CheckParserSetZeroCopyStrings(parser, settings.zeroCopyStrings, JSON_Success) &&
+        CheckParserSetAllowMultipleDocuments(parser, settings.allowMultipleDocuments, JSON_Success) &&
+        CheckParserSetSkipInvalidDocuments(parser, settings.skipInvalidDocuments, JSON_Success) &&
         CheckParserSettings(parser, &settings))
     {
         printf("OK\n");
@@ -1653,6 +2433,7 @@ static void TestParserSetHandlers(void)
     handlers.booleanHandler = &BooleanHandler;
     handlers.stringHandler = &StringHandler;
     handlers.numberHandler = &NumberHandler;
+    handlers.typedNumberHandler = &TypedNumberHandler;
     handlers.specialNumberHandler = &SpecialNumberHandler;
     handlers.startObjectHandler = &StartObjectHandler;
     handlers.endObjectHandler = &EndObjectHandler;
@@ -1660,12 +2441,16 @@ static void TestParserSetHandlers(void)
     handlers.startArrayHandler = &StartArrayHandler;
     handlers.endArrayHandler = &EndArrayHandler;
     handlers.arrayItemHandler = &ArrayItemHandler;
+    handlers.startDocumentHandler = &StartDocumentHandler;
+    handlers.endDocumentHandler = &EndDocumentHandler;
+    handlers.eventBatchHandler = &EventBatchHandler;
     if (CheckParserCreate(NULL, JSON_Success, &parser) &&
         CheckParserSetEncodingDetectedHandler(parser, handlers.encodingDetectedHandler, JSON_Success) &&
         CheckParserSetNullHandler(parser, handlers.nullHandler, JSON_Success) &&
         CheckParserSetBooleanHandler(parser, handlers.booleanHandler, JSON_Success) &&
         CheckParserSetStringHandler(parser, handlers.stringHandler, JSON_Success) &&
         CheckParserSetNumberHandler(parser, handlers.numberHandler, JSON_Success) &&
+        CheckParserSetTypedNumberHandler(parser, handlers.typedNumberHandler, JSON_Success) &&
         CheckParserSetSpecialNumberHandler(parser, handlers.specialNumberHandler, JSON_Success) &&
         CheckParserSetStartObjectHandler(parser, handlers.startObjectHandler, JSON_Success) &&
         CheckParserSetEndObjectHandler(parser, handlers.endObjectHandler, JSON_Success) &&
@@ -1673,6 +2458,9 @@ static void TestParserSetHandlers(void)
         CheckParserSetStartArrayHandler(parser, handlers.startArrayHandler, JSON_Success) &&
         CheckParserSetEndArrayHandler(parser, handlers.endArrayHandler, JSON_Success) &&
         CheckParserSetArrayItemHandler(parser, handlers.arrayItemHandler, JSON_Success) &&
+        CheckParserSetStartDocumentHandler(parser, handlers.startDocumentHandler, JSON_Success) &&
+        CheckParserSetEndDocumentHandler(parser, handlers.endDocumentHandler, JSON_Success) &&
+        CheckParserSetEventBatchHandler(parser, handlers.eventBatchHandler, JSON_Success) &&
         CheckParserHandlers(parser, &handlers))
     {
         printf("OK\n");
@@ -1709,11 +2497,15 @@ static void TestParserReset(void)
         CheckParserSetAllowUnescapedControlCharacters(parser, JSON_True, JSON_Success) &&
         CheckParserSetReplaceInvalidEncodingSequences(parser, JSON_True, JSON_Success) &&
         CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Success) &&
+        CheckParserSetZeroCopyStrings(parser, JSON_True, JSON_Success) &&
+        CheckParserSetAllowMultipleDocuments(parser, JSON_True, JSON_Success) &&
+        CheckParserSetSkipInvalidDocuments(parser, JSON_True, JSON_Success) &&
         CheckParserSetEncodingDetectedHandler(parser, &EncodingDetectedHandler, JSON_Success) &&
         CheckParserSetNullHandler(parser, &NullHandler, JSON_Success) &&
         CheckParserSetBooleanHandler(parser, &BooleanHandler, JSON_Success) &&
         CheckParserSetStringHandler(parser, &StringHandler, JSON_Success) &&
         CheckParserSetNumberHandler(parser, &NumberHandler, JSON_Success) &&
+        CheckParserSetTypedNumberHandler(parser, &TypedNumberHandler, JSON_Success) &&
         CheckParserSetSpecialNumberHandler(parser, &SpecialNumberHandler, JSON_Success) &&
         CheckParserSetStartObjectHandler(parser, &StartObjectHandler, JSON_Success) &&
         CheckParserSetEndObjectHandler(parser, &EndObjectHandler, JSON_Success) &&
@@ -1721,6 +2513,8 @@ static void TestParserReset(void)
         CheckParserSetStartArrayHandler(parser, &StartArrayHandler, JSON_Success) &&
         CheckParserSetEndArrayHandler(parser, &EndArrayHandler, JSON_Success) &&
         CheckParserSetArrayItemHandler(parser, &ArrayItemHandler, JSON_Success) &&
+        CheckParserSetStartDocumentHandler(parser, &StartDocumentHandler, JSON_Success) &&
+        CheckParserSetEndDocumentHandler(parser, &EndDocumentHandler, JSON_Success) &&
         CheckParserParse(parser, input, sizeof(input) - 1, JSON_False, JSON_Success) &&
         CheckParserReset(parser, JSON_Success) &&
         CheckParserState(parser, &state) &&
@@ -1761,6 +2555,10 @@ static void TestParserMisbehaveInCallbacks(void)
         CheckParserSetNumberHandler(parser, &NumberHandler, JSON_Success) &&
         CheckParserParse(parser, "7", 1, JSON_True, JSON_Success) &&
 
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetTypedNumberHandler(parser, &TypedNumberHandler, JSON_Success) &&
+        CheckParserParse(parser, "7", 1, JSON_True, JSON_Success) &&
+
         CheckParserReset(parser, JSON_Success) &&
         CheckParserSetAllowSpecialNumbers(parser, JSON_True, JSON_Success) &&
         CheckParserSetSpecialNumberHandler(parser, &SpecialNumberHandler, JSON_Success) &&
@@ -1788,7 +2586,15 @@ static void TestParserMisbehaveInCallbacks(void)
 
         CheckParserReset(parser, JSON_Success) &&
         CheckParserSetArrayItemHandler(parser, &ArrayItemHandler, JSON_Success) &&
-        CheckParserParse(parser, "[0]", 3, JSON_True, JSON_Success))
+        CheckParserParse(parser, "[0]", 3, JSON_True, JSON_Success) &&
+
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetStartDocumentHandler(parser, &StartDocumentHandler, JSON_Success) &&
+        CheckParserParse(parser, "null", 4, JSON_True, JSON_Success) &&
+
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetEndDocumentHandler(parser, &EndDocumentHandler, JSON_Success) &&
+        CheckParserParse(parser, "null", 4, JSON_True, JSON_Success))
     {
         printf("OK\n");
     }
@@ -1846,6 +2652,11 @@ static void TestParserAbortInCallbacks(void)
         CheckParserParse(parser, " 7", 2, JSON_True, JSON_Failure) &&
         CheckParserState(parser, &state) &&
 
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetTypedNumberHandler(parser, &TypedNumberHandler, JSON_Success) &&
+        CheckParserParse(parser, " 7", 2, JSON_True, JSON_Failure) &&
+        CheckParserState(parser, &state) &&
+
         CheckParserReset(parser, JSON_Success) &&
         CheckParserSetAllowSpecialNumbers(parser, JSON_True, JSON_Success) &&
         CheckParserSetSpecialNumberHandler(parser, &SpecialNumberHandler, JSON_Success) &&
@@ -1872,6 +2683,16 @@ static void TestParserAbortInCallbacks(void)
         CheckParserParse(parser, "[]", 2, JSON_True, JSON_Failure) &&
         CheckParserState(parser, &state) &&
 
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetStartDocumentHandler(parser, &StartDocumentHandler, JSON_Success) &&
+        CheckParserParse(parser, " null", 5, JSON_True, JSON_Failure) &&
+        CheckParserState(parser, &state) &&
+
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetEndDocumentHandler(parser, &EndDocumentHandler, JSON_Success) &&
+        CheckParserParse(parser, " null", 5, JSON_True, JSON_Failure) &&
+        CheckParserState(parser, &state) &&
+
         !!(state.errorLocation.depth = 1) && /* hacky! */
 
         CheckParserReset(parser, JSON_Success) &&
@@ -2059,22 +2880,2119 @@ static void TestParserDuplicateMemberTrackingMallocFailure(void)
         CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Success))
     {
         s_failMalloc = 1;
-        if (CheckParserParse(parser, "{\"a\":0}", 7, JSON_True, JSON_Failure) &&
-            CheckParserState(parser, &state))
+        if (CheckParserParse(parser, "{\"a\":0}", 7, JSON_True, JSON_Failure) &&
+            CheckParserState(parser, &state))
+        {
+            succeeded = 1;
+        }
+        s_failMalloc = 0;
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserDuplicateMemberTrackingReusesMemory(void)
+{
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    ParserState state;
+    int i;
+    printf("Test parser duplicate member tracking reuses memory ... ");
+    InitParserState(&state);
+    state.inputEncoding = JSON_UTF8;
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Success) &&
+        CheckParserParse(parser, "[{\"a\":{\"b\":0,\"c\":1}}", 20, JSON_False, JSON_Success))
+    {
+        /* Once the first object has been parsed, objects of the same shape
+           should not require any more memory. */
+        s_failMalloc = 1;
+        s_failRealloc = 1;
+        for (i = 0; i < 1000; i++)
+        {
+            if (!CheckParserParse(parser, ",{\"a\":{\"b\":0,\"c\":1}}", 20, JSON_False, JSON_Success))
+            {
+                break;
+            }
+        }
+        if (i == 1000 &&
+            CheckParserParse(parser, "]", 1, JSON_True, JSON_Success) &&
+            CheckParserState(parser, &state))
+        {
+            succeeded = 1;
+        }
+        s_failMalloc = 0;
+        s_failRealloc = 0;
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserDuplicateMemberTrackingWithManyLongNames(void)
+{
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    ParserState state;
+    char name[3000];
+    char member[16];
+    int i;
+    printf("Test parser duplicate member tracking with many long names ... ");
+    InitParserState(&state);
+    state.error = JSON_Error_DuplicateObjectMember;
+    state.errorLocation.byte = 13418;
+    state.errorLocation.column = 13418;
+    state.errorLocation.depth = 1;
+    state.inputEncoding = JSON_UTF8;
+    memset(name, 'x', sizeof(name));
+    name[0] = '"';
+    name[sizeof(name) - 1] = '"';
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Success) &&
+        CheckParserParse(parser, "{\"a\":{", 6, JSON_False, JSON_Success))
+    {
+        succeeded = 1;
+        for (i = 0; succeeded && i < 500; i++)
+        {
+            sprintf(member, "\"m%d\":0,", i);
+            succeeded = CheckParserParse(parser, member, strlen(member), JSON_False, JSON_Success);
+        }
+        succeeded = succeeded &&
+            CheckParserParse(parser, name, sizeof(name), JSON_False, JSON_Success) &&
+            CheckParserParse(parser, ":0},\"b\":{", 9, JSON_False, JSON_Success) &&
+            CheckParserParse(parser, name, sizeof(name), JSON_False, JSON_Success) &&
+            CheckParserParse(parser, ":0,\"a\":1},", 10, JSON_False, JSON_Success) &&
+            CheckParserParse(parser, name, sizeof(name), JSON_False, JSON_Success) &&
+            CheckParserParse(parser, ":0,\"a\":2}", 9, JSON_True, JSON_Failure) &&
+            CheckParserState(parser, &state);
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserDuplicateMemberTrackingInWideObjects(void)
+{
+    static const int s_memberCounts[] = { 15, 16, 17, 33, 1000, 20000 };
+    int failures = 0;
+    size_t t;
+    printf("Test parser duplicate member tracking in wide objects ... ");
+    for (t = 0; t < sizeof(s_memberCounts) / sizeof(s_memberCounts[0]); t++)
+    {
+        /* Each member count is tested with a duplicate of the first, middle,
+           and last member, and with no duplicate at all. */
+        int d;
+        for (d = 0; d < 4; d++)
+        {
+            int succeeded = 0;
+            JSON_Parser parser = NULL;
+            ParserState state;
+            char member[32];
+            size_t byte = 1;
+            int count = s_memberCounts[t];
+            int duplicate = (d == 0) ? 0 : (d == 1) ? count / 2 : (d == 2) ? count - 1 : -1;
+            int i;
+            InitParserState(&state);
+            state.inputEncoding = JSON_UTF8;
+            if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+                CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Success) &&
+                CheckParserParse(parser, "{", 1, JSON_False, JSON_Success))
+            {
+                succeeded = 1;
+                for (i = 0; succeeded && i < count; i++)
+                {
+                    sprintf(member, "\"member%d\":0,", i);
+                    succeeded = CheckParserParse(parser, member, strlen(member), JSON_False, JSON_Success);
+                    byte += strlen(member);
+                }
+                if (succeeded)
+                {
+                    if (duplicate < 0)
+                    {
+                        succeeded = CheckParserParse(parser, "\"last\":0}", 9, JSON_True, JSON_Success);
+                    }
+                    else
+                    {
+                        state.error = JSON_Error_DuplicateObjectMember;
+                        state.errorLocation.byte = byte;
+                        state.errorLocation.column = byte;
+                        state.errorLocation.depth = 1;
+                        sprintf(member, "\"member%d\":0}", duplicate);
+                        succeeded = CheckParserParse(parser, member, strlen(member), JSON_True, JSON_Failure);
+                    }
+                    succeeded = succeeded && CheckParserState(parser, &state);
+                }
+            }
+            if (!succeeded)
+            {
+                printf("  (%d members, duplicate %d)\n", count, duplicate);
+                failures++;
+            }
+            JSON_Parser_Free(parser);
+        }
+    }
+    if (!failures)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+}
+
+static void TestParserDuplicateMemberTrackingGrowthMallocFailure(void)
+{
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    ParserState state;
+    char name[3000];
+    printf("Test parser duplicate member tracking growth malloc failure ... ");
+    InitParserState(&state);
+    state.error = JSON_Error_OutOfMemory;
+    state.errorLocation.byte = 6003;
+    state.errorLocation.column = 6003;
+    state.errorLocation.depth = 2;
+    state.inputEncoding = JSON_UTF8;
+    memset(name, 'x', sizeof(name));
+    name[0] = '"';
+    name[sizeof(name) - 1] = '"';
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        CheckParserSetTrackObjectMembers(parser, JSON_True, JSON_Success) &&
+        CheckParserParse(parser, "[", 1, JSON_False, JSON_Success) &&
+        CheckParserParse(parser, name, sizeof(name), JSON_False, JSON_Success) &&
+        CheckParserParse(parser, ",{", 2, JSON_False, JSON_Success))
+    {
+        /* The token buffer is already big enough for the name, so the only
+           allocation is the arena chunk needed to hold it. */
+        s_failMalloc = 1;
+        if (CheckParserParse(parser, name, sizeof(name), JSON_False, JSON_Failure) &&
+            CheckParserState(parser, &state))
+        {
+            succeeded = 1;
+        }
+        s_failMalloc = 0;
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserPullEvents(void)
+{
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    JSON_Event event;
+    ParserState state;
+    printf("Test pulling events ... ");
+    InitParserState(&state);
+    state.error = JSON_Error_UnexpectedToken;
+    state.errorLocation.byte = 3;
+    state.errorLocation.column = 3;
+    state.errorLocation.depth = 1;
+    state.inputEncoding = JSON_UTF8;
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserNextEvent(NULL, &event, JSON_NeedMoreInputEvent, JSON_Failure) &&
+        CheckParserNextEvent(parser, NULL, JSON_NeedMoreInputEvent, JSON_Failure) &&
+        CheckParserSetInput(NULL, "1", 1, JSON_True, JSON_Failure) &&
+        CheckParserSetInput(parser, NULL, 1, JSON_True, JSON_Failure) &&
+        CheckParserNextEvent(parser, &event, JSON_NeedMoreInputEvent, JSON_Success) &&
+        CheckParserSetAllowComments(parser, JSON_True, JSON_Failure) &&
+        CheckParserSetInput(parser, "[1", 2, JSON_False, JSON_Success) &&
+        CheckParserSetInput(parser, "]", 1, JSON_True, JSON_Failure) &&
+        CheckParserParse(parser, "]", 1, JSON_True, JSON_Failure) &&
+        CheckParserNextEvent(parser, &event, JSON_NeedMoreInputEvent, JSON_Success) && /* still detecting the encoding */
+        CheckParserSetInput(parser, "]", 1, JSON_True, JSON_Success) &&
+        CheckParserSetInput(parser, " ", 1, JSON_True, JSON_Failure) &&
+        CheckParserNextEvent(parser, &event, JSON_StartArrayEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_NumberEvent, JSON_Success) &&
+        event.length == 1 && !strcmp(event.pValue, "1") && event.attributes == JSON_SimpleNumber &&
+        CheckParserNextEvent(parser, &event, JSON_EndArrayEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_EndOfDocumentEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_EndOfDocumentEvent, JSON_Success) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserParse(parser, "[", 1, JSON_False, JSON_Success) &&
+        CheckParserSetInput(parser, "]", 1, JSON_True, JSON_Failure) &&
+        CheckParserNextEvent(parser, &event, JSON_NeedMoreInputEvent, JSON_Failure) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetInput(parser, "[1 2]", 5, JSON_True, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_StartArrayEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_NumberEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_NeedMoreInputEvent, JSON_Failure) &&
+        CheckParserNextEvent(parser, &event, JSON_NeedMoreInputEvent, JSON_Failure) &&
+        CheckParserState(parser, &state))
+    {
+        succeeded = 1;
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static JSON_Parser_HandlerResult JSON_CALL AbortingEventBatchHandler(JSON_Parser parser, const JSON_BatchedEvent* pEvents, size_t eventCount, const char* pStringBytes)
+{
+    /* Only abort if the parser behaves as expected, so that the test
+       detects any misbehavior. */
+    if (TryToMisbehaveInParseHandler(parser) || !eventCount || eventCount > 2 ||
+        pEvents[0].type != JSON_StartArrayEvent || pEvents[0].depth != 0 ||
+        (eventCount == 2 &&
+         (pEvents[1].type != JSON_NumberEvent || pEvents[1].depth != 1 ||
+          pEvents[1].length != 1 || strcmp(pStringBytes + pEvents[1].offset, "1"))))
+    {
+        return JSON_Parser_Continue;
+    }
+    return JSON_Parser_Abort;
+}
+
+static void TestParserEventBatches(void)
+{
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    JSON_BatchedEvent events[2];
+    ParserState state;
+    printf("Test delivering event batches ... ");
+    InitParserState(&state);
+    state.error = JSON_Error_AbortedByHandler;
+    state.errorLocation.byte = 2;
+    state.errorLocation.column = 2;
+    state.errorLocation.depth = 1;
+    state.inputEncoding = JSON_UTF8;
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetEventBatchBuffer(parser, NULL, 2, JSON_Failure) &&
+        CheckParserSetEventBatchBuffer(parser, events, 2, JSON_Success) &&
+        JSON_Parser_GetEventBatchBufferSize(parser) == 2 &&
+        CheckParserParse(parser, "[1,2,3]", 7, JSON_True, JSON_Success) && /* no handler */
+        CheckParserSetEventBatchBuffer(parser, events, 1, JSON_Failure) &&
+        CheckParserReset(parser, JSON_Success) &&
+        JSON_Parser_GetEventBatchBufferSize(parser) == 0 &&
+        CheckParserSetEventBatchBuffer(parser, events, 2, JSON_Success) &&
+        CheckParserSetEventBatchHandler(parser, &AbortingEventBatchHandler, JSON_Success) &&
+        CheckParserParse(parser, "[1,2,3]", 7, JSON_True, JSON_Failure) &&
+        CheckParserState(parser, &state) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetEventBatchBuffer(parser, events, 2, JSON_Success) &&
+        CheckParserSetEventBatchHandler(parser, &AbortingEventBatchHandler, JSON_Success) &&
+        CheckParserParse(parser, "[}", 2, JSON_True, JSON_Failure)) /* the input error takes precedence */
+    {
+        state.error = JSON_Error_UnexpectedToken;
+        state.errorLocation.byte = 1;
+        state.errorLocation.column = 1;
+        if (CheckParserState(parser, &state))
+        {
+            succeeded = 1;
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserEventBatchMallocFailure(void)
+{
+    JSON_Parser parser = NULL;
+    JSON_BatchedEvent events[2];
+    ParserState state;
+    printf("Test parser event batch malloc failure ... ");
+    InitParserState(&state);
+    state.error = JSON_Error_OutOfMemory;
+    state.errorLocation.byte = 4;
+    state.errorLocation.column = 4;
+    state.errorLocation.depth = 1;
+    state.inputEncoding = JSON_UTF8;
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        CheckParserSetEventBatchBuffer(parser, events, 2, JSON_Success))
+    {
+        s_failMalloc = 1;
+        if (CheckParserParse(parser, "[\"a\"]", 5, JSON_True, JSON_Failure) &&
+            CheckParserState(parser, &state))
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failMalloc = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static JSON_Parser_HandlerResult JSON_CALL SkippingStartArrayHandler(JSON_Parser parser)
+{
+    if (TryToMisbehaveInParseHandler(parser))
+    {
+        return JSON_Parser_Abort;
+    }
+    OutputSeparator();
+    OutputFormatted("[");
+    return JSON_Parser_SkipValue;
+}
+
+static JSON_Parser_HandlerResult JSON_CALL SkippingArrayItemHandler(JSON_Parser parser)
+{
+    if (TryToMisbehaveInParseHandler(parser))
+    {
+        return JSON_Parser_Abort;
+    }
+    OutputSeparator();
+    OutputFormatted("i");
+    return JSON_Parser_SkipValue;
+}
+
+static JSON_Parser_HandlerResult JSON_CALL SkippingNullHandler(JSON_Parser parser)
+{
+    if (TryToMisbehaveInParseHandler(parser))
+    {
+        return JSON_Parser_Abort;
+    }
+    return JSON_Parser_SkipValue;
+}
+
+static int CheckSkippedValues(JSON_Parser parser, const char* pInput, int skipArrays, JSON_Boolean stopAfterEmbeddedDocument, const char* pExpectedOutput)
+{
+    /* Skip either every array or every array item. The input is parsed one
+       byte at a time, so that the skipped values are scanned one codepoint
+       at a time rather than a word at a time, and then all at once. */
+    int pass;
+    size_t length = strlen(pInput);
+    for (pass = 0; pass < 2; pass++)
+    {
+        size_t used = 0;
+        JSON_Status status;
+        ResetOutput();
+        if (!CheckParserReset(parser, JSON_Success) ||
+            !CheckParserSetStopAfterEmbeddedDocument(parser, stopAfterEmbeddedDocument, JSON_Success) ||
+            !CheckParserSetStartObjectHandler(parser, &StartObjectHandler, JSON_Success) ||
+            !CheckParserSetEndObjectHandler(parser, &EndObjectHandler, JSON_Success) ||
+            !CheckParserSetObjectMemberHandler(parser, &ObjectMemberHandler, JSON_Success) ||
+            !CheckParserSetEndArrayHandler(parser, &EndArrayHandler, JSON_Success) ||
+            !CheckParserSetNumberHandler(parser, &NumberHandler, JSON_Success) ||
+            !CheckParserSetStringHandler(parser, &StringHandler, JSON_Success) ||
+            !CheckParserSetNullHandler(parser, &SkippingNullHandler, JSON_Success) ||
+            !CheckParserSetStartArrayHandler(parser, skipArrays ? &SkippingStartArrayHandler : &StartArrayHandler, JSON_Success) ||
+            !CheckParserSetArrayItemHandler(parser, skipArrays ? NULL : &SkippingArrayItemHandler, JSON_Success))
+        {
+            return 0;
+        }
+        do
+        {
+            size_t chunkLength = pass ? length : 1;
+            status = JSON_Parser_Parse(parser, pInput + used, chunkLength, (used + chunkLength == length) ? JSON_True : JSON_False);
+            used += chunkLength;
+        } while (status == JSON_Success && used < length);
+        if (JSON_Parser_GetError(parser) != JSON_Error_None)
+        {
+            JSON_Location location;
+            JSON_Parser_GetErrorLocation(parser, &location);
+            OutputSeparator();
+            OutputFormatted("!(%s):", errorNames[JSON_Parser_GetError(parser)]);
+            OutputLocation(&location);
+        }
+        if (!CheckOutput(pExpectedOutput))
+        {
+            return 0;
+        }
+    }
+    ResetOutput();
+    return 1;
+}
+
+static int CheckTypedNumberWithManyZeros(JSON_Parser parser, const char* pBefore, const char* pAfter, const char* pExpectedOutput)
+{
+    char zeros[100];
+    int succeeded;
+    int i;
+    memset(zeros, '0', sizeof(zeros));
+    ResetOutput();
+    succeeded = CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetTypedNumberHandler(parser, &TypedNumberHandler, JSON_Success) &&
+        CheckParserParse(parser, pBefore, strlen(pBefore), JSON_False, JSON_Success);
+    for (i = 0; succeeded && i < 1000; i++)
+    {
+        succeeded = CheckParserParse(parser, zeros, sizeof(zeros), JSON_False, JSON_Success);
+    }
+    return succeeded &&
+        CheckParserParse(parser, pAfter, strlen(pAfter), JSON_True, JSON_Success) &&
+        CheckOutput(pExpectedOutput);
+}
+
+static void TestParserTypedNumbersWithManyZeros(void)
+{
+    JSON_Parser parser = NULL;
+    printf("Test parsing typed numbers with many zeros ... ");
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckTypedNumberWithManyZeros(parser, "0.", "1e100005", "#d(10000):0,0,0,0-100010,0,100010,0") &&
+        CheckTypedNumberWithManyZeros(parser, "0.", "123456789012345678901e100020", "#d(l 1.2345678901234567e+19):0,0,0,0-100030,0,100030,0") &&
+        CheckTypedNumberWithManyZeros(parser, "1", "00000e-100005", "#d(1):0,0,0,0-100014,0,100014,0") &&
+        CheckTypedNumberWithManyZeros(parser, "1", "e-100000", "#d(1):0,0,0,0-100009,0,100009,0"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserTypedNumbersInCommaLocale(void)
+{
+    /* The input needs the slow path and its value is formatted without a
+       decimal point, so the output does not depend on the locale. */
+    static const char* const localeNames[] = { "de_DE.UTF-8", "de_DE", "fr_FR.UTF-8", "fr_FR" };
+    static const char input[] = "1000000000000000000000.00000000000000000001e-5";
+    JSON_Parser parser = NULL;
+    char savedLocale[64];
+    const char* pLocale = setlocale(LC_NUMERIC, NULL);
+    size_t i;
+    printf("Test parsing typed numbers in a locale with a decimal comma ... ");
+    savedLocale[0] = 0;
+    if (pLocale && strlen(pLocale) < sizeof(savedLocale))
+    {
+        strcpy(savedLocale, pLocale);
+    }
+    for (i = 0; i < sizeof(localeNames) / sizeof(localeNames[0]) && !setlocale(LC_NUMERIC, localeNames[i]); i++)
+    {
+    }
+    ResetOutput();
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetTypedNumberHandler(parser, &TypedNumberHandler, JSON_Success) &&
+        CheckParserParse(parser, input, sizeof(input) - 1, JSON_True, JSON_Success) &&
+        CheckOutput("#d(l 10000000000000000):0,0,0,0-46,0,46,0"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+    setlocale(LC_NUMERIC, savedLocale[0] ? savedLocale : "C");
+}
+
+static void TestParserSkipValue(void)
+{
+    JSON_Parser parser = NULL;
+    printf("Test skipping values ... ");
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckSkippedValues(parser, "[1,[2,\"]\"],{}]", 0, JSON_False, "[:0,0,0,0-1,0,1,0 i i i ]:13,0,13,0-14,0,14,0") &&
+        CheckSkippedValues(parser, "{\"a\":[1,[2,\"]\"]],\"b\":{\"c\":[]}}", 1, JSON_False, "{:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 [ m(b):17,0,17,1-20,0,20,1 {:21,0,21,1-22,0,22,1 m(c):22,0,22,2-25,0,25,2 [ }:28,0,28,1-29,0,29,1 }:29,0,29,0-30,0,30,0") &&
+        CheckSkippedValues(parser, "[1, 2] 3", 1, JSON_True, "[ !(StoppedAfterEmbeddedDocument):6,0,6,0") &&
+        CheckSkippedValues(parser, "{\"a\":[1,{\"b\":[]},\"x\",[null],null]}", 0, JSON_False, "{:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 [:5,0,5,1-6,0,6,1 i i i i i ]:32,0,32,1-33,0,33,1 }:33,0,33,0-34,0,34,0") &&
+        CheckSkippedValues(parser, "{\"a\":null}", 0, JSON_False, "{:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 !(AbortedByHandler):5,0,5,1"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserSettingsAfterReset(void)
+{
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    ParserState state;
+    printf("Test parser settings after reset ... ");
+    InitParserState(&state);
+    state.error = JSON_Error_UnknownToken;
+    state.errorLocation.byte = 2;
+    state.errorLocation.column = 2;
+    state.errorLocation.depth = 1;
+    state.inputEncoding = JSON_UTF8;
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetAllowComments(parser, JSON_True, JSON_Success) &&
+        CheckParserSetAllowSpecialNumbers(parser, JSON_True, JSON_Success) &&
+        CheckParserSetAllowHexNumbers(parser, JSON_True, JSON_Success) &&
+        CheckParserParse(parser, "[/*c*/0x1F,NaN,-Infinity]", 25, JSON_True, JSON_Success) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserParse(parser, "[0x1F]", 6, JSON_True, JSON_Failure) &&
+        CheckParserState(parser, &state) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetAllowComments(parser, JSON_True, JSON_Success) &&
+        CheckParserParse(parser, "[/*c*/-Infinity]", 16, JSON_True, JSON_Failure))
+    {
+        state.errorLocation.byte = 6;
+        state.errorLocation.column = 6;
+        if (CheckParserState(parser, &state))
+        {
+            succeeded = 1;
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserStructuralIndex(void)
+{
+    static const char input[] = "{\"a\\\"[\":[1,\"x\"],\n \"b\" : {}}";
+    static const size_t offsets[] = { 0, 1, 6, 7, 8, 10, 11, 13, 14, 15, 18, 20, 22, 24, 25, 26 };
+    JSON_Parser parser = NULL;
+    printf("Test parser structural index ... ");
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        CheckParserStructuralIndex(parser, NULL, 0) &&
+        CheckParserBuildStructuralIndex(parser, NULL, 1, JSON_Failure) &&
+        CheckParserBuildStructuralIndex(parser, NULL, 0, JSON_Success) &&
+        CheckParserStructuralIndex(parser, NULL, 0) &&
+        CheckParserBuildStructuralIndex(parser, input, sizeof(input) - 1, JSON_Success) &&
+        CheckParserStructuralIndex(parser, offsets, sizeof(offsets) / sizeof(offsets[0])) &&
+        CheckParserParse(parser, input, sizeof(input) - 1, JSON_True, JSON_Success) &&
+        CheckParserBuildStructuralIndex(parser, input, sizeof(input) - 1, JSON_Failure) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserStructuralIndex(parser, NULL, 0))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserStructuralIndexMallocFailure(void)
+{
+    JSON_Parser parser = NULL;
+    printf("Test parser structural index malloc failure ... ");
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser))
+    {
+        s_failMalloc = 1;
+        if (CheckParserBuildStructuralIndex(parser, "[]", 2, JSON_Failure) &&
+            CheckParserStructuralIndex(parser, NULL, 0))
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failMalloc = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserAddPathFilter(void)
+{
+    JSON_Parser parser = NULL;
+    printf("Test parser add path filter ... ");
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserAddPathFilter(parser, NULL, JSON_Failure) &&
+        CheckParserAddPathFilter(parser, "a", JSON_Failure) &&
+        CheckParserAddPathFilter(parser, "/a~", JSON_Failure) &&
+        CheckParserAddPathFilter(parser, "/a~2", JSON_Failure) &&
+        CheckParserAddPathFilter(parser, "/\xC0\x80", JSON_Failure) &&
+        CheckParserAddPathFilter(parser, "/\xE0", JSON_Failure) &&
+        CheckParserAddPathFilter(parser, "", JSON_Success) &&
+        CheckParserAddPathFilter(parser, "/a/~0~1/*/0", JSON_Success) &&
+        CheckParserAddPathFilter(parser, "/a/~0~1/*/0", JSON_Success) &&
+        CheckParserAddPathFilter(parser, "/\xE2\x82\xAC//", JSON_Success) &&
+        CheckParserParse(parser, "{\"a\":", 5, JSON_False, JSON_Success) &&
+        CheckParserAddPathFilter(parser, "/b", JSON_Failure) &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserAddPathFilter(parser, "/b", JSON_Success))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserAddPathFilterMallocFailure(void)
+{
+    JSON_Parser parser = NULL;
+    printf("Test parser add path filter malloc failure ... ");
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser))
+    {
+        s_failMalloc = 1;
+        if (CheckParserAddPathFilter(parser, "/a", JSON_Failure))
+        {
+            s_failMalloc = 0;
+            if (CheckParserAddPathFilter(parser, "/a", JSON_Success) &&
+                CheckParserParse(parser, "{\"a\":[1]}", 9, JSON_True, JSON_Success))
+            {
+                printf("OK\n");
+            }
+            else
+            {
+                s_failureCount++;
+            }
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failMalloc = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserKeyDictionary(void)
+{
+    static const char* const keys[] = { "a", "bc", "\xC3\xA9" };
+    static const char* const nullKey[] = { "a", NULL };
+    static const char* const invalidKey[] = { "a", "\xC3" };
+    static const char* const duplicateKeys[] = { "a", "b", "a" };
+    JSON_Parser parser = NULL;
+    JSON_Event event;
+    size_t keyIndex = 7;
+    printf("Test parser key dictionary ... ");
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetKeyDictionary(parser, NULL, 1, JSON_Failure) &&
+        CheckParserSetKeyDictionary(parser, nullKey, 2, JSON_Failure) &&
+        CheckParserSetKeyDictionary(parser, invalidKey, 2, JSON_Failure) &&
+        CheckParserSetKeyDictionary(parser, duplicateKeys, 3, JSON_Failure) &&
+        CheckParserSetKeyDictionary(parser, duplicateKeys, 2, JSON_Success) &&
+        CheckParserSetKeyDictionary(parser, NULL, 0, JSON_Success) &&
+        CheckParserSetKeyDictionary(parser, keys, 3, JSON_Success) &&
+        JSON_Parser_GetMemberKeyIndex(NULL, &keyIndex) == JSON_Failure &&
+        JSON_Parser_GetMemberKeyIndex(parser, NULL) == JSON_Failure &&
+        JSON_Parser_GetMemberKeyIndex(parser, &keyIndex) == JSON_Failure && keyIndex == 7 &&
+        CheckParserSetInput(parser, "{\"\xC3\xA9\":1,\"b\":2,\"bc\":3}", 22, JSON_True, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_StartObjectEvent, JSON_Success) && event.keyIndex == 0 &&
+        CheckParserNextEvent(parser, &event, JSON_ObjectMemberEvent, JSON_Success) && event.keyIndex == 2 &&
+        CheckParserNextEvent(parser, &event, JSON_NumberEvent, JSON_Success) && event.keyIndex == 0 &&
+        CheckParserNextEvent(parser, &event, JSON_ObjectMemberEvent, JSON_Success) && event.keyIndex == 3 &&
+        CheckParserSetKeyDictionary(parser, keys, 3, JSON_Failure) &&
+        CheckParserNextEvent(parser, &event, JSON_NumberEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_ObjectMemberEvent, JSON_Success) && event.keyIndex == 1 &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserSetInput(parser, "{\"a\":1}", 7, JSON_True, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_StartObjectEvent, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_ObjectMemberEvent, JSON_Success) && event.keyIndex == 0)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserLargeKeyDictionary(void)
+{
+    /* Every key must be found in its own slot, and names that are close to
+       the keys must not be. */
+    static char keyBytes[500][8];
+    static const char* keys[500];
+    static char input[500 * 20 + 2];
+    size_t inputLength = 0;
+    size_t i;
+    int succeeded = 1;
+    JSON_Parser parser = NULL;
+    JSON_Event event;
+    printf("Test parser large key dictionary ... ");
+    for (i = 0; i < 500; i++)
+    {
+        sprintf(keyBytes[i], "k%d", (int)i);
+        keys[i] = keyBytes[i];
+    }
+    input[inputLength++] = '{';
+    for (i = 0; i < 500; i++)
+    {
+        /* Each key is followed by a near miss. */
+        inputLength += (size_t)sprintf(input + inputLength, "%s\"k%d\":0,\"k%dx\":0", i ? "," : "", (int)(499 - i), (int)(499 - i));
+    }
+    input[inputLength++] = '}';
+    if (CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetKeyDictionary(parser, keys, 500, JSON_Success) &&
+        CheckParserSetInput(parser, input, inputLength, JSON_True, JSON_Success) &&
+        CheckParserNextEvent(parser, &event, JSON_StartObjectEvent, JSON_Success))
+    {
+        for (i = 0; i < 500 && succeeded; i++)
+        {
+            succeeded = CheckParserNextEvent(parser, &event, JSON_ObjectMemberEvent, JSON_Success) && event.keyIndex == 499 - i &&
+                        CheckParserNextEvent(parser, &event, JSON_NumberEvent, JSON_Success) &&
+                        CheckParserNextEvent(parser, &event, JSON_ObjectMemberEvent, JSON_Success) && event.keyIndex == 500 &&
+                        CheckParserNextEvent(parser, &event, JSON_NumberEvent, JSON_Success);
+        }
+        succeeded = succeeded &&
+                    CheckParserNextEvent(parser, &event, JSON_EndObjectEvent, JSON_Success) &&
+                    CheckParserNextEvent(parser, &event, JSON_EndOfDocumentEvent, JSON_Success);
+    }
+    else
+    {
+        succeeded = 0;
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE: wrong key index\n");
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static void TestParserKeyDictionaryMallocFailure(void)
+{
+    static const char* const keys[] = { "a", "b", "c" };
+    JSON_Parser parser = NULL;
+    printf("Test parser key dictionary malloc failure ... ");
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser))
+    {
+        s_failMalloc = 1;
+        if (CheckParserSetKeyDictionary(parser, keys, 3, JSON_Failure) &&
+            CheckParserSetKeyDictionary(parser, keys, 0, JSON_Success))
+        {
+            s_failMalloc = 0;
+            if (CheckParserSetKeyDictionary(parser, keys, 3, JSON_Success) &&
+                CheckParserSetStringEncoding(parser, JSON_UTF16BE, JSON_Success))
+            {
+                s_failMalloc = 1;
+                if (CheckParserParse(parser, "{\"a\":1}", 7, JSON_True, JSON_Failure) &&
+                    JSON_Parser_GetError(parser) == JSON_Error_OutOfMemory)
+                {
+                    printf("OK\n");
+                }
+                else
+                {
+                    s_failureCount++;
+                }
+            }
+            else
+            {
+                s_failureCount++;
+            }
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failMalloc = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+}
+
+static int WriteTestFile(const char* path, const char* pContents)
+{
+    int succeeded = 0;
+    FILE* f = fopen(path, "wb");
+    if (f)
+    {
+        succeeded = fwrite(pContents, 1, strlen(pContents), f) == strlen(pContents);
+        succeeded = (fclose(f) == 0) && succeeded;
+    }
+    if (!succeeded)
+    {
+        printf("FAILURE: could not write test file \"%s\"\n", path);
+    }
+    return succeeded;
+}
+
+static void TestParserParseFile(void)
+{
+    static const char path[] = "jsonsaxtest.tmp";
+    int succeeded = 0;
+    JSON_Parser parser = NULL;
+    ParserState state;
+    printf("Test parser parse file ... ");
+    InitParserState(&state);
+    state.inputEncoding = JSON_UTF8;
+    ResetOutput();
+    if (CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        CheckParserSetStartArrayHandler(parser, &StartArrayHandler, JSON_Success) &&
+        CheckParserSetNumberHandler(parser, &NumberHandler, JSON_Success) &&
+        CheckParserSetStringHandler(parser, &StringHandler, JSON_Success) &&
+        CheckParserParseFile(parser, NULL, JSON_Failure) &&
+        WriteTestFile(path, "[1,\n\"ab\"]") &&
+        CheckParserParseFile(parser, path, JSON_Success) &&
+        CheckOutput("[:0,0,0,0-1,0,1,0 #(1):1,0,1,1-2,0,2,1 s(ab):4,1,0,1-8,1,4,1") &&
+        CheckParserState(parser, &state) &&
+        CheckParserParseFile(parser, path, JSON_Failure) &&
+        CheckParserReset(parser, JSON_Success) &&
+        WriteTestFile(path, "[1,]") &&
+        CheckParserParseFile(parser, path, JSON_Failure))
+    {
+        state.error = JSON_Error_UnexpectedToken;
+        state.errorLocation.byte = 3;
+        state.errorLocation.column = 3;
+        state.errorLocation.depth = 1;
+        if (CheckParserState(parser, &state) &&
+            CheckParserReset(parser, JSON_Success) &&
+            CheckParserParseFile(parser, "jsonsaxtest.missing", JSON_Failure))
+        {
+            InitParserState(&state);
+            state.error = JSON_Error_CannotReadInput;
+            if (CheckParserState(parser, &state) &&
+                CheckParserReset(parser, JSON_Success) &&
+                CheckParserParseFd(parser, -1, JSON_Failure) &&
+                CheckParserState(parser, &state))
+            {
+                succeeded = 1;
+            }
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    remove(path);
+    ResetOutput();
+    JSON_Parser_Free(parser);
+}
+
+/* The parallel lines tests collect the results of each batch in its own
+   slot, since batches are parsed concurrently, and check them in the batch
+   end handler, which is never called concurrently. */
+#define MAX_LINE_BATCHES 256
+
+typedef struct tag_LineBatchResult
+{
+    size_t documents;
+    size_t invalidDocuments;
+    size_t invalidLines[4];
+} LineBatchResult;
+
+typedef struct tag_ParallelLinesState
+{
+    LineBatchResult results[MAX_LINE_BATCHES];
+    size_t          abortStartAtBatch;
+    size_t          abortEndAtBatch;
+    size_t          batchesDelivered;
+    size_t          nextByte;
+    size_t          nextLine;
+    size_t          nextElement; /* (size_t)-1 after a batch fails */
+    size_t          documents;
+    int             isArray;
+    int             misbehaved;
+    int             succeeded;
+    char            invalidLines[128];
+} ParallelLinesState;
+
+static JSON_Parser_HandlerResult JSON_CALL LineDocumentEndHandler(JSON_Parser parser)
+{
+    LineBatchResult* pResult = (LineBatchResult*)JSON_Parser_GetUserData(parser);
+    pResult->documents++;
+    if (JSON_Parser_GetError(parser) != JSON_Error_None)
+    {
+        JSON_Location location;
+        JSON_Parser_GetErrorLocation(parser, &location);
+        if (pResult->invalidDocuments < 4)
+        {
+            pResult->invalidLines[pResult->invalidDocuments++] = location.line;
+        }
+    }
+    return JSON_Parser_Continue;
+}
+
+static JSON_Parser_HandlerResult JSON_CALL LineBatchStartHandler(JSON_ParallelLines lines, JSON_Parser parser, const JSON_LineBatch* pBatch)
+{
+    ParallelLinesState* pState = (ParallelLinesState*)JSON_ParallelLines_GetUserData(lines);
+    LineBatchResult* pResult;
+    if (pBatch->index >= MAX_LINE_BATCHES || pBatch->index == pState->abortStartAtBatch)
+    {
+        return JSON_Parser_Abort;
+    }
+    pResult = &pState->results[pBatch->index];
+    pResult->documents = 0;
+    pResult->invalidDocuments = 0;
+    JSON_Parser_SetUserData(parser, pResult);
+    JSON_Parser_SetEndDocumentHandler(parser, &LineDocumentEndHandler);
+    return JSON_Parser_Continue;
+}
+
+static JSON_Parser_HandlerResult JSON_CALL LineBatchEndHandler(JSON_ParallelLines lines, const JSON_LineBatch* pBatch)
+{
+    ParallelLinesState* pState = (ParallelLinesState*)JSON_ParallelLines_GetUserData(lines);
+    const LineBatchResult* pResult = (const LineBatchResult*)pBatch->userData;
+    size_t i;
+    if (JSON_ParallelLines_SetThreadCount(lines, 1) != JSON_Failure ||
+        JSON_ParallelLines_SetBatchSize(lines, 1) != JSON_Failure ||
+        JSON_ParallelLines_Parse(lines, "1", 1) != JSON_Failure ||
+        JSON_ParallelLines_ParseArray(lines, "[1]", 3) != JSON_Failure ||
+        JSON_ParallelLines_Free(lines) != JSON_Failure)
+    {
+        pState->misbehaved = 1;
+    }
+    if (pBatch->index != pState->batchesDelivered ||
+        pBatch->byte != pState->nextByte ||
+        pBatch->line != pState->nextLine ||
+        (pState->isArray ? (pState->nextElement != (size_t)-1 && pBatch->element != pState->nextElement) : (pBatch->element != 0)) ||
+        (pBatch->error == JSON_Error_None && pResult != &pState->results[pBatch->index]))
+    {
+        pState->succeeded = 0;
+    }
+    pState->batchesDelivered++;
+
+    /* The elements of an array are separated by commas, which are not part
+       of any batch. */
+    pState->nextByte += pBatch->length + (pState->isArray ? 1 : 0);
+    for (i = 0; i < pBatch->length; i++)
+    {
+        if (pBatch->pBytes[i] == '\r' || (pBatch->pBytes[i] == '\n' && (!i || pBatch->pBytes[i - 1] != '\r')))
+        {
+            pState->nextLine++;
+        }
+    }
+    if (pBatch->error != JSON_Error_None && pState->isArray)
+    {
+        sprintf(pState->invalidLines + strlen(pState->invalidLines), "%d(%s) ", (int)pBatch->errorElement, errorNames[pBatch->error]);
+        pState->nextElement = (size_t)-1;
+    }
+    else if (pBatch->error != JSON_Error_None)
+    {
+        sprintf(pState->invalidLines + strlen(pState->invalidLines), "#%d(%s) ", (int)pBatch->index, errorNames[pBatch->error]);
+    }
+    else
+    {
+        pState->documents += pResult->documents;
+        if (pState->nextElement != (size_t)-1)
+        {
+            pState->nextElement += pResult->documents;
+        }
+        for (i = 0; i < pResult->invalidDocuments; i++)
+        {
+            sprintf(pState->invalidLines + strlen(pState->invalidLines), "%d ", (int)(pBatch->line + pResult->invalidLines[i]));
+        }
+    }
+    return (pBatch->index == pState->abortEndAtBatch) ? JSON_Parser_Abort : JSON_Parser_Continue;
+}
+
+static void InitParallelLinesState(ParallelLinesState* pState)
+{
+    pState->abortStartAtBatch = (size_t)-1;
+    pState->abortEndAtBatch = (size_t)-1;
+    pState->batchesDelivered = 0;
+    pState->nextByte = 0;
+    pState->nextLine = 0;
+    pState->nextElement = 0;
+    pState->documents = 0;
+    pState->isArray = 0;
+    pState->misbehaved = 0;
+    pState->succeeded = 1;
+    pState->invalidLines[0] = 0;
+}
+
+static size_t MakeLines(char* pBytes, size_t lineCount)
+{
+    /* Lines 57 and 123 are invalid, and lines of different lengths keep
+       the batches from lining up with any particular thread. */
+    size_t length = 0;
+    size_t i;
+    for (i = 0; i < lineCount; i++)
+    {
+        if (i == 57 || i == 123)
+        {
+            length += (size_t)sprintf(pBytes + length, "{\"n\":}\n");
+        }
+        else
+        {
+            length += (size_t)sprintf(pBytes + length, "{\"n\":%d,\"s\":\"%.*s\"}\n", (int)i, (int)(i % 7), "abcdefg");
+        }
+    }
+    return length;
+}
+
+static int CheckParallelLinesParse(JSON_ParallelLines lines, const char* pBytes, size_t length, JSON_Status expectedStatus, JSON_Error expectedError)
+{
+    if (JSON_ParallelLines_Parse(lines, pBytes, length) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_ParallelLines_Parse() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    if (JSON_ParallelLines_GetError(lines) != expectedError)
+    {
+        printf("FAILURE: expected JSON_ParallelLines_GetError() to return %s\n", errorNames[expectedError]);
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParallelLinesParseArray(JSON_ParallelLines lines, const char* pBytes, size_t length, JSON_Status expectedStatus, JSON_Error expectedError)
+{
+    if (JSON_ParallelLines_ParseArray(lines, pBytes, length) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_ParallelLines_ParseArray() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    if (JSON_ParallelLines_GetError(lines) != expectedError)
+    {
+        printf("FAILURE: expected JSON_ParallelLines_GetError() to return %s\n", errorNames[expectedError]);
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckParallelLinesState(const ParallelLinesState* pState, size_t expectedBatches, size_t expectedDocuments, const char* pExpectedInvalidLines)
+{
+    if (!pState->succeeded || pState->misbehaved)
+    {
+        printf("FAILURE: batches were delivered out of order or handlers misbehaved\n");
+        return 0;
+    }
+    if (pState->batchesDelivered != expectedBatches || pState->documents != expectedDocuments || strcmp(pState->invalidLines, pExpectedInvalidLines))
+    {
+        printf("FAILURE: expected %d batches, %d documents and invalid lines \"%s\"; actual %d, %d and \"%s\"\n",
+               (int)expectedBatches, (int)expectedDocuments, pExpectedInvalidLines,
+               (int)pState->batchesDelivered, (int)pState->documents, pState->invalidLines);
+        return 0;
+    }
+    return 1;
+}
+
+static void TestParallelLinesCreate(void)
+{
+    JSON_MemorySuite memorySuite = { NULL, NULL, NULL };
+    JSON_ParallelLines lines = NULL;
+    int value = 0;
+    printf("Test creating parallel lines instance ... ");
+    memorySuite.realloc = &ReallocHandler;
+    if (JSON_ParallelLines_Create(&memorySuite) == NULL &&
+        (lines = JSON_ParallelLines_Create(NULL)) != NULL &&
+        JSON_ParallelLines_GetUserData(lines) == NULL &&
+        JSON_ParallelLines_GetThreadCount(lines) == 0 &&
+        JSON_ParallelLines_GetBatchSize(lines) == 1048576 &&
+        JSON_ParallelLines_GetBatchStartHandler(lines) == NULL &&
+        JSON_ParallelLines_GetBatchEndHandler(lines) == NULL &&
+        JSON_ParallelLines_GetError(lines) == JSON_Error_None &&
+        JSON_ParallelLines_SetUserData(lines, &value) == JSON_Success &&
+        JSON_ParallelLines_GetUserData(lines) == &value &&
+        JSON_ParallelLines_SetThreadCount(lines, 3) == JSON_Success &&
+        JSON_ParallelLines_GetThreadCount(lines) == 3 &&
+        JSON_ParallelLines_SetBatchSize(lines, 0) == JSON_Failure &&
+        JSON_ParallelLines_SetBatchSize(lines, 100) == JSON_Success &&
+        JSON_ParallelLines_GetBatchSize(lines) == 100 &&
+        JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler) == JSON_Success &&
+        JSON_ParallelLines_GetBatchStartHandler(lines) == &LineBatchStartHandler &&
+        JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler) == JSON_Success &&
+        JSON_ParallelLines_GetBatchEndHandler(lines) == &LineBatchEndHandler &&
+        JSON_ParallelLines_Parse(lines, NULL, 1) == JSON_Failure &&
+        JSON_ParallelLines_ParseArray(lines, NULL, 1) == JSON_Failure &&
+        CheckParallelLinesParse(lines, NULL, 0, JSON_Success, JSON_Error_None))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_ParallelLines_Free(lines);
+}
+
+static void TestParallelLinesMissing(void)
+{
+    JSON_Location location;
+    printf("Test NULL parallel lines instance ... ");
+    if (JSON_ParallelLines_Free(NULL) == JSON_Failure &&
+        JSON_ParallelLines_GetUserData(NULL) == NULL &&
+        JSON_ParallelLines_SetUserData(NULL, NULL) == JSON_Failure &&
+        JSON_ParallelLines_GetThreadCount(NULL) == 0 &&
+        JSON_ParallelLines_SetThreadCount(NULL, 1) == JSON_Failure &&
+        JSON_ParallelLines_GetBatchSize(NULL) == 0 &&
+        JSON_ParallelLines_SetBatchSize(NULL, 1) == JSON_Failure &&
+        JSON_ParallelLines_GetBatchStartHandler(NULL) == NULL &&
+        JSON_ParallelLines_SetBatchStartHandler(NULL, NULL) == JSON_Failure &&
+        JSON_ParallelLines_GetBatchEndHandler(NULL) == NULL &&
+        JSON_ParallelLines_SetBatchEndHandler(NULL, NULL) == JSON_Failure &&
+        JSON_ParallelLines_GetError(NULL) == JSON_Error_None &&
+        JSON_ParallelLines_GetErrorLocation(NULL, &location) == JSON_Failure &&
+        JSON_ParallelLines_Parse(NULL, "1", 1) == JSON_Failure &&
+        JSON_ParallelLines_ParseArray(NULL, "[1]", 3) == JSON_Failure)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+}
+
+static void TestParallelLinesParse(void)
+{
+    static char input[200 * 32];
+    static ParallelLinesState state;
+    size_t length = MakeLines(input, 200);
+    size_t threadCounts[] = { 1, 4, 0 };
+    size_t batchSizes[] = { 1, 64, 1000, 1048576 };
+    size_t expectedBatches[] = { 200, 0, 0, 1 };
+    size_t i, j;
+    int succeeded = 1;
+    JSON_ParallelLines lines = JSON_ParallelLines_Create(NULL);
+    printf("Test parallel lines parse ... ");
+    JSON_ParallelLines_SetUserData(lines, &state);
+    JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler);
+    JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler);
+    for (i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]) && succeeded; i++)
+    {
+        for (j = 0; j < sizeof(batchSizes) / sizeof(batchSizes[0]) && succeeded; j++)
+        {
+            InitParallelLinesState(&state);
+            JSON_ParallelLines_SetThreadCount(lines, threadCounts[i]);
+            JSON_ParallelLines_SetBatchSize(lines, batchSizes[j]);
+            succeeded = CheckParallelLinesParse(lines, input, length, JSON_Success, JSON_Error_None) &&
+                        CheckParallelLinesState(&state, expectedBatches[j] ? expectedBatches[j] : state.batchesDelivered, 200, "57 123 ") &&
+                        state.nextByte == length && state.nextLine == 200;
+        }
+    }
+
+    /* A line that is not terminated by a line break is still a line, and a
+       document cannot continue into the next batch, so the unterminated
+       array is reported at the end of its batch. */
+    if (succeeded)
+    {
+        InitParallelLinesState(&state);
+        JSON_ParallelLines_SetThreadCount(lines, 4);
+        JSON_ParallelLines_SetBatchSize(lines, 1);
+        succeeded = CheckParallelLinesParse(lines, "1\n[\n2", 5, JSON_Success, JSON_Error_None) &&
+                    CheckParallelLinesState(&state, 3, 3, "2 ");
+    }
+
+    /* Batches also end at CR line breaks, but never between the CR and LF
+       of a CRLF line break. */
+    if (succeeded)
+    {
+        InitParallelLinesState(&state);
+        succeeded = CheckParallelLinesParse(lines, "1\r[\r2", 5, JSON_Success, JSON_Error_None) &&
+                    CheckParallelLinesState(&state, 3, 3, "2 ") &&
+                    state.nextByte == 5 && state.nextLine == 2;
+    }
+    if (succeeded)
+    {
+        InitParallelLinesState(&state);
+        succeeded = CheckParallelLinesParse(lines, "1\r\n[\r\n2", 7, JSON_Success, JSON_Error_None) &&
+                    CheckParallelLinesState(&state, 3, 3, "2 ") &&
+                    state.nextByte == 7 && state.nextLine == 2;
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_ParallelLines_Free(lines);
+}
+
+static void TestParallelLinesAbortInHandlers(void)
+{
+    static char input[200 * 32];
+    static ParallelLinesState state;
+    size_t length = MakeLines(input, 200);
+    JSON_ParallelLines lines = JSON_ParallelLines_Create(NULL);
+    printf("Test parallel lines abort in handlers ... ");
+    JSON_ParallelLines_SetUserData(lines, &state);
+    JSON_ParallelLines_SetThreadCount(lines, 4);
+    JSON_ParallelLines_SetBatchSize(lines, 1000);
+    JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler);
+    JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler);
+    InitParallelLinesState(&state);
+    state.abortStartAtBatch = 1;
+    if (CheckParallelLinesParse(lines, input, length, JSON_Success, JSON_Error_None) &&
+        !strncmp(state.invalidLines, "#1(AbortedByHandler) ", 21))
+    {
+        InitParallelLinesState(&state);
+        state.abortEndAtBatch = 2;
+        if (CheckParallelLinesParse(lines, input, length, JSON_Failure, JSON_Error_AbortedByHandler) &&
+            CheckParallelLinesState(&state, 3, state.documents, state.invalidLines))
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+    }
+    else
+    {
+        printf("FAILURE: expected batch 1 to be aborted; actual \"%s\"\n", state.invalidLines);
+        s_failureCount++;
+    }
+    JSON_ParallelLines_Free(lines);
+}
+
+static size_t MakeArray(char* pBytes, size_t elementCount, size_t invalidElement)
+{
+    /* The strings contain the characters that the scan for element
+       boundaries looks for, including escaped quotation marks and
+       backslashes, so that the pieces of the scan start in all sorts of
+       places. */
+    size_t length = 0;
+    size_t i;
+    length += (size_t)sprintf(pBytes + length, " [\n");
+    for (i = 0; i < elementCount; i++)
+    {
+        if (i == invalidElement)
+        {
+            length += (size_t)sprintf(pBytes + length, "{\"n\":}");
+        }
+        else if (i % 3 == 0)
+        {
+            length += (size_t)sprintf(pBytes + length, "{\"n\":%d,\"s\":\"a,]}\\\"\\\\\",\"a\":[[%d],{}]}", (int)i, (int)i);
+        }
+        else if (i % 3 == 1)
+        {
+            length += (size_t)sprintf(pBytes + length, "\"\\\\\\\"[,{%.*s\"", (int)(i % 7), "abcdefg");
+        }
+        else
+        {
+            length += (size_t)sprintf(pBytes + length, "%d", (int)i);
+        }
+        if (i + 1 < elementCount)
+        {
+            length += (size_t)sprintf(pBytes + length, (i % 2) ? ",\n" : " , ");
+        }
+    }
+    length += (size_t)sprintf(pBytes + length, "\n]\n");
+    return length;
+}
+
+static void TestParallelLinesParseArray(void)
+{
+    static char input[200 * 48];
+    static ParallelLinesState state;
+    size_t length = MakeArray(input, 200, (size_t)-1);
+    size_t threadCounts[] = { 1, 4, 0 };
+    size_t batchSizes[] = { 1, 2, 3, 7, 64, 1000, 1048576 };
+    size_t i, j;
+    int succeeded = 1;
+    JSON_ParallelLines lines = JSON_ParallelLines_Create(NULL);
+    printf("Test parallel lines parse array ... ");
+    JSON_ParallelLines_SetUserData(lines, &state);
+    JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler);
+    JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler);
+    for (i = 0; i < sizeof(threadCounts) / sizeof(threadCounts[0]) && succeeded; i++)
+    {
+        for (j = 0; j < sizeof(batchSizes) / sizeof(batchSizes[0]) && succeeded; j++)
+        {
+            InitParallelLinesState(&state);
+            state.isArray = 1;
+            state.nextByte = 2;
+            JSON_ParallelLines_SetThreadCount(lines, threadCounts[i]);
+            JSON_ParallelLines_SetBatchSize(lines, batchSizes[j]);
+            succeeded = CheckParallelLinesParseArray(lines, input, length, JSON_Success, JSON_Error_None) &&
+                        CheckParallelLinesState(&state, (batchSizes[j] == 1048576) ? 1 : state.batchesDelivered, 200, "") &&
+                        state.nextElement == 200;
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE: thread count %d, batch size %d\n", (int)threadCounts[i - 1], (int)batchSizes[j - 1]);
+        s_failureCount++;
+    }
+    JSON_ParallelLines_Free(lines);
+}
+
+typedef struct tag_ParseArrayTest
+{
+    const char* pInput;
+    size_t      batchSize;
+    JSON_Status expectedStatus;
+    JSON_Error  expectedError;
+    size_t      expectedErrorByte;
+    size_t      expectedErrorLine;
+    size_t      expectedErrorColumn;
+    size_t      expectedBatches;
+    size_t      expectedDocuments;
+    const char* pExpectedErrors;
+} ParseArrayTest;
+
+static void TestParallelLinesParseArrayErrors(void)
+{
+    static const ParseArrayTest tests[] =
+    {
+        { "",              1, JSON_Failure, JSON_Error_ExpectedMoreTokens, 0, 0, 0, 0, 0, "" },
+        { " \n ",          1, JSON_Failure, JSON_Error_ExpectedMoreTokens, 3, 1, 1, 0, 0, "" },
+        { "  {}",          1, JSON_Failure, JSON_Error_UnexpectedToken,    2, 0, 2, 0, 0, "" },
+        { "[1,2",          1, JSON_Failure, JSON_Error_ExpectedMoreTokens, 4, 0, 4, 0, 0, "" },
+        { "[\"]\"",        1, JSON_Failure, JSON_Error_ExpectedMoreTokens, 4, 0, 4, 0, 0, "" },
+        { "[1,2}",         1, JSON_Failure, JSON_Error_UnexpectedToken,    4, 0, 4, 0, 0, "" },
+        { "[1,2]\n\xC3\xA9 x", 1, JSON_Failure, JSON_Error_UnexpectedToken, 6, 1, 0, 0, 0, "" },
+        { "[1,2]]",        1, JSON_Failure, JSON_Error_UnexpectedToken,    5, 0, 5, 0, 0, "" },
+        { "[]",            1, JSON_Success, JSON_Error_None,               0, 0, 0, 0, 0, "" },
+        { " [ \r\n ] \n",  1, JSON_Success, JSON_Error_None,               0, 0, 0, 0, 0, "" },
+        { "[[]]",          1, JSON_Success, JSON_Error_None,               0, 0, 0, 1, 1, "" },
+        { "[1,,2]",        1, JSON_Success, JSON_Error_None,               0, 0, 0, 3, 2, "1(ExpectedMoreTokens) " },
+        { "[1,,2]",      100, JSON_Success, JSON_Error_None,               0, 0, 0, 1, 0, "1(UnexpectedToken) " },
+        { "[1,]",          1, JSON_Success, JSON_Error_None,               0, 0, 0, 2, 1, "1(ExpectedMoreTokens) " },
+        { "[,1]",          1, JSON_Success, JSON_Error_None,               0, 0, 0, 1, 0, "0(UnexpectedToken) " },
+        { "[1 2,3]",     100, JSON_Success, JSON_Error_None,               0, 0, 0, 1, 0, "0(UnexpectedToken) " },
+        { "[0,1,2 3,4]",   3, JSON_Success, JSON_Error_None,               0, 0, 0, 3, 3, "2(UnexpectedToken) " },
+        { "[0,1,2,3 4]", 100, JSON_Success, JSON_Error_None,               0, 0, 0, 1, 0, "3(UnexpectedToken) " }
+    };
+    static ParallelLinesState state;
+    size_t i;
+    int succeeded = 1;
+    JSON_ParallelLines lines = JSON_ParallelLines_Create(NULL);
+    JSON_Location location = { 0, 0, 0, 0 };
+    printf("Test parallel lines parse array errors ... ");
+    JSON_ParallelLines_SetUserData(lines, &state);
+    JSON_ParallelLines_SetThreadCount(lines, 2);
+    JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler);
+    JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler);
+    succeeded = JSON_ParallelLines_GetErrorLocation(lines, &location) == JSON_Failure;
+    for (i = 0; i < sizeof(tests) / sizeof(tests[0]) && succeeded; i++)
+    {
+        const ParseArrayTest* pTest = &tests[i];
+        InitParallelLinesState(&state);
+        state.isArray = 1;
+        state.nextByte = 1;
+        JSON_ParallelLines_SetBatchSize(lines, pTest->batchSize);
+        succeeded = CheckParallelLinesParseArray(lines, pTest->pInput, strlen(pTest->pInput), pTest->expectedStatus, pTest->expectedError) &&
+                    CheckParallelLinesState(&state, pTest->expectedBatches, pTest->expectedDocuments, pTest->pExpectedErrors);
+        if (succeeded && pTest->expectedStatus == JSON_Failure)
+        {
+            succeeded = JSON_ParallelLines_GetErrorLocation(lines, NULL) == JSON_Failure &&
+                        JSON_ParallelLines_GetErrorLocation(lines, &location) == JSON_Success &&
+                        location.byte == pTest->expectedErrorByte &&
+                        location.line == pTest->expectedErrorLine &&
+                        location.column == pTest->expectedErrorColumn;
+        }
+        else if (succeeded)
+        {
+            succeeded = JSON_ParallelLines_GetErrorLocation(lines, &location) == JSON_Failure;
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE: test %d; error location %d:%d,%d\n", (int)(i - 1), (int)location.byte, (int)location.line, (int)location.column);
+        s_failureCount++;
+    }
+    JSON_ParallelLines_Free(lines);
+}
+
+static void TestParallelLinesParseArrayWithInvalidElement(void)
+{
+    static char input[200 * 48];
+    static ParallelLinesState state;
+    size_t length = MakeArray(input, 200, 57);
+    JSON_ParallelLines lines = JSON_ParallelLines_Create(NULL);
+    printf("Test parallel lines parse array with invalid element ... ");
+    JSON_ParallelLines_SetUserData(lines, &state);
+    JSON_ParallelLines_SetThreadCount(lines, 4);
+    JSON_ParallelLines_SetBatchSize(lines, 1);
+    JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler);
+    JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler);
+    InitParallelLinesState(&state);
+    state.isArray = 1;
+    state.nextByte = 2;
+    if (CheckParallelLinesParseArray(lines, input, length, JSON_Success, JSON_Error_None) &&
+        CheckParallelLinesState(&state, 200, 199, "57(UnexpectedToken) "))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_ParallelLines_Free(lines);
+}
+
+static void TestParallelLinesMallocFailure(void)
+{
+    /* The test memory suite is not thread-safe, so this test uses a single
+       thread. */
+    static ParallelLinesState state;
+    JSON_MemorySuite memorySuite = { NULL, NULL, NULL };
+    JSON_ParallelLines lines;
+    JSON_Location location;
+    printf("Test parallel lines malloc failure ... ");
+    memorySuite.realloc = &ReallocHandler;
+    memorySuite.free = &FreeHandler;
+    s_failMalloc = 1;
+    lines = JSON_ParallelLines_Create(&memorySuite);
+    s_failMalloc = 0;
+    if (lines)
+    {
+        printf("FAILURE: expected JSON_ParallelLines_Create() to fail\n");
+        s_failureCount++;
+        JSON_ParallelLines_Free(lines);
+        return;
+    }
+    lines = JSON_ParallelLines_Create(&memorySuite);
+    JSON_ParallelLines_SetUserData(lines, &state);
+    JSON_ParallelLines_SetThreadCount(lines, 1);
+    JSON_ParallelLines_SetBatchSize(lines, 1);
+    JSON_ParallelLines_SetBatchStartHandler(lines, &LineBatchStartHandler);
+    JSON_ParallelLines_SetBatchEndHandler(lines, &LineBatchEndHandler);
+    InitParallelLinesState(&state);
+    s_failMalloc = 1;
+    if (CheckParallelLinesParse(lines, "1\n2\n", 4, JSON_Failure, JSON_Error_OutOfMemory) &&
+        CheckParallelLinesState(&state, 0, 0, ""))
+    {
+        /* The batches are reused, but the batch parser cannot be created. */
+        s_failMalloc = 0;
+        if (CheckParallelLinesParse(lines, "1\n2\n", 4, JSON_Success, JSON_Error_None) &&
+            CheckParallelLinesState(&state, 2, 2, ""))
+        {
+            InitParallelLinesState(&state);
+            s_failMalloc = 1;
+            if (CheckParallelLinesParse(lines, "1\n2\n", 4, JSON_Success, JSON_Error_None) &&
+                CheckParallelLinesState(&state, 2, 0, "#0(OutOfMemory) #1(OutOfMemory) ") &&
+                CheckParallelLinesParseArray(lines, "[1,2]", 5, JSON_Failure, JSON_Error_OutOfMemory) &&
+                JSON_ParallelLines_GetErrorLocation(lines, &location) == JSON_Failure)
+            {
+                printf("OK\n");
+            }
+            else
+            {
+                s_failureCount++;
+            }
+        }
+        else
+        {
+            s_failureCount++;
+        }
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    s_failMalloc = 0;
+    JSON_ParallelLines_Free(lines);
+}
+
+static void OutputDocumentValue(JSON_Document document, size_t value)
+{
+    size_t item;
+    size_t length;
+    JSON_NumberValue number;
+    switch (JSON_Document_GetType(document, value))
+    {
+    case JSON_NullValueType:
+        OutputFormatted("null");
+        break;
+
+    case JSON_BooleanValueType:
+        OutputFormatted(JSON_Document_GetBoolean(document, value) ? "true" : "false");
+        break;
+
+    case JSON_StringValueType:
+        OutputFormatted("s(%s)", JSON_Document_GetString(document, value, &length, NULL));
+        break;
+
+    case JSON_NumberValueType:
+        JSON_Document_GetNumber(document, value, &number, NULL);
+        OutputFormatted("#(%s)", JSON_Document_GetNumberText(document, value, &length));
+        if (number.type == JSON_Int64Number)
+        {
+            OutputFormatted("i%d", (int)number.int64Value);
+        }
+        else if (number.type == JSON_UInt64Number)
+        {
+            OutputFormatted("u%d", (int)(number.uint64Value % 1000));
+        }
+        else
+        {
+            OutputFormatted("d%g", number.doubleValue);
+        }
+        break;
+
+    case JSON_SpecialNumberValueType:
+        OutputFormatted("special(%d)", (int)JSON_Document_GetSpecialNumber(document, value));
+        break;
+
+    case JSON_ObjectValueType:
+    case JSON_ArrayValueType:
+        OutputFormatted((JSON_Document_GetType(document, value) == JSON_ObjectValueType) ? "{%d:" : "[%d:", (int)JSON_Document_GetItemCount(document, value));
+        for (item = JSON_Document_GetFirstItem(document, value); item != JSON_Document_NoValue; item = JSON_Document_GetNextItem(document, item))
+        {
+            const char* pName = JSON_Document_GetMemberName(document, item, &length, NULL);
+            OutputSeparator();
+            if (pName)
+            {
+                OutputFormatted("%s=", pName);
+            }
+            OutputDocumentValue(document, item);
+        }
+        OutputFormatted((JSON_Document_GetType(document, value) == JSON_ObjectValueType) ? "}" : "]");
+        break;
+
+    default:
+        OutputFormatted("?");
+        break;
+    }
+}
+
+static int CheckDocument(JSON_Document document, const char* pExpectedOutput)
+{
+    size_t value;
+    ResetOutput();
+    for (value = JSON_Document_GetRoot(document); value != JSON_Document_NoValue; value = JSON_Document_GetNextItem(document, value))
+    {
+        OutputSeparator();
+        OutputDocumentValue(document, value);
+    }
+    return CheckOutput(pExpectedOutput);
+}
+
+static void TestDocumentCreate(void)
+{
+    JSON_MemorySuite memorySuite = { NULL, NULL, NULL };
+    JSON_Document document = NULL;
+    JSON_Parser parser = NULL;
+    JSON_NumberValue number;
+    printf("Test creating document instance ... ");
+    memorySuite.realloc = &ReallocHandler;
+    if (JSON_Document_Create(&memorySuite) == NULL &&
+        (document = JSON_Document_Create(NULL)) != NULL &&
+        JSON_Document_GetRoot(document) == JSON_Document_NoValue &&
+        JSON_Document_GetType(document, 0) == JSON_NoValueType &&
+        CheckParserCreate(NULL, JSON_Success, &parser) &&
+        JSON_Parser_GetDocument(parser) == NULL &&
+        JSON_Parser_SetDocument(parser, document) == JSON_Success &&
+        JSON_Parser_GetDocument(parser) == document &&
+        CheckParserParse(parser, "[", 1, JSON_False, JSON_Success) &&
+        JSON_Document_GetRoot(document) == JSON_Document_NoValue && /* incomplete */
+        JSON_Parser_SetDocument(parser, NULL) == JSON_Failure &&
+        CheckParserParse(parser, "]", 1, JSON_True, JSON_Success) &&
+        CheckDocument(document, "[0:]") &&
+        JSON_Document_GetFirstItem(document, JSON_Document_GetRoot(document)) == JSON_Document_NoValue &&
+        JSON_Document_GetNextItem(document, JSON_Document_GetRoot(document)) == JSON_Document_NoValue &&
+        JSON_Document_GetString(document, JSON_Document_GetRoot(document), NULL, NULL) == NULL &&
+        JSON_Document_GetNumber(document, JSON_Document_GetRoot(document), &number, NULL) == JSON_Failure &&
+        JSON_Document_FindMember(document, JSON_Document_GetRoot(document), "", 0) == JSON_Document_NoValue &&
+        JSON_Document_GetType(document, JSON_Document_NoValue) == JSON_NoValueType &&
+        CheckParserReset(parser, JSON_Success) &&
+        JSON_Parser_GetDocument(parser) == NULL &&
+        JSON_Parser_SetDocument(parser, document) == JSON_Success &&
+        JSON_Document_GetRoot(document) == JSON_Document_NoValue && /* emptied */
+        CheckParserParse(parser, "[1,}", 4, JSON_True, JSON_Failure) &&
+        JSON_Document_GetRoot(document) == JSON_Document_NoValue)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+    JSON_Document_Free(document);
+}
+
+static void TestDocumentMissing(void)
+{
+    JSON_NumberValue number;
+    printf("Test NULL document instance ... ");
+    if (JSON_Document_Free(NULL) == JSON_Failure &&
+        JSON_Parser_GetDocument(NULL) == NULL &&
+        JSON_Parser_SetDocument(NULL, NULL) == JSON_Failure &&
+        JSON_Document_GetRoot(NULL) == JSON_Document_NoValue &&
+        JSON_Document_GetType(NULL, 0) == JSON_NoValueType &&
+        JSON_Document_GetBoolean(NULL, 0) == JSON_False &&
+        JSON_Document_GetString(NULL, 0, NULL, NULL) == NULL &&
+        JSON_Document_GetNumber(NULL, 0, &number, NULL) == JSON_Failure &&
+        JSON_Document_GetNumberText(NULL, 0, NULL) == NULL &&
+        JSON_Document_GetSpecialNumber(NULL, 0) == JSON_NaN &&
+        JSON_Document_GetItemCount(NULL, 0) == 0 &&
+        JSON_Document_GetFirstItem(NULL, 0) == JSON_Document_NoValue &&
+        JSON_Document_GetNextItem(NULL, 0) == JSON_Document_NoValue &&
+        JSON_Document_GetMemberName(NULL, 0, NULL, NULL) == NULL &&
+        JSON_Document_FindMember(NULL, 0, "a", 1) == JSON_Document_NoValue)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+}
+
+static void TestDocument(void)
+{
+    static const char input[] = "{\"a\":[1,-2,18446744073709551615,0.5,1e400,true,false,null],\"b\":{},\"c\":\"x\\ty\",\"d\":{\"e\":[[]]}}";
+    JSON_Document document = NULL;
+    JSON_Parser parser = NULL;
+    size_t root;
+    size_t value;
+    size_t length;
+    JSON_StringAttributes attributes;
+    JSON_NumberValue number;
+    JSON_NumberAttributes numberAttributes;
+    size_t i;
+    int succeeded = 0;
+    printf("Test recording a document ... ");
+    if ((document = JSON_Document_Create(NULL)) != NULL &&
+        CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetStringHandler(parser, &StringHandler, JSON_Success) && /* not called */
+        JSON_Parser_SetDocument(parser, document) == JSON_Success)
+    {
+        /* Parse the input one byte at a time, so that tokens span calls. */
+        for (i = 0; i < sizeof(input) - 1; i++)
+        {
+            if (!CheckParserParse(parser, &input[i], 1, JSON_False, JSON_Success))
+            {
+                break;
+            }
+        }
+        ResetOutput();
+        if (i == sizeof(input) - 1 &&
+            CheckParserParse(parser, NULL, 0, JSON_True, JSON_Success) &&
+            CheckDocument(document, "{4: a=[8: #(1)i1 #(-2)i-2 #(18446744073709551615)u615 #(0.5)d0.5 #(1e400)dinf true false null] b={0:} c=s(x\ty) d={1: e=[1: [0:]]}}"))
+        {
+            root = JSON_Document_GetRoot(document);
+            value = JSON_Document_FindMember(document, root, "a", 1);
+            if (JSON_Document_GetType(document, value) == JSON_ArrayValueType &&
+                JSON_Document_GetType(document, JSON_Document_GetNextItem(document, value)) == JSON_ObjectValueType &&
+                JSON_Document_GetNumber(document, JSON_Document_GetNextItem(document, JSON_Document_GetFirstItem(document, value)), &number, &numberAttributes) == JSON_Success &&
+                number.type == JSON_Int64Number && number.int64Value == -2 && numberAttributes == JSON_IsNegative &&
+                JSON_Document_GetMemberName(document, value, &length, &attributes) != NULL && length == 1 && attributes == JSON_SimpleString &&
+                JSON_Document_GetMemberName(document, root, NULL, NULL) == NULL &&
+                JSON_Document_GetMemberName(document, JSON_Document_GetFirstItem(document, value), NULL, NULL) == NULL &&
+                (value = JSON_Document_FindMember(document, root, "c", 1)) != JSON_Document_NoValue &&
+                JSON_Document_GetString(document, value, &length, &attributes) != NULL && length == 3 && attributes == JSON_ContainsControlCharacter &&
+                JSON_Document_GetNextItem(document, JSON_Document_FindMember(document, root, "d", 1)) == JSON_Document_NoValue &&
+                JSON_Document_FindMember(document, root, "e", 1) == JSON_Document_NoValue &&
+                JSON_Document_FindMember(document, root, NULL, 1) == JSON_Document_NoValue)
+            {
+                succeeded = 1;
+            }
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+    JSON_Document_Free(document);
+}
+
+static void TestDocumentWithMultipleDocumentsAndFilters(void)
+{
+    JSON_Document document = NULL;
+    JSON_Parser parser = NULL;
+    printf("Test recording multiple documents and filtered values ... ");
+    if ((document = JSON_Document_Create(NULL)) != NULL &&
+        CheckParserCreate(NULL, JSON_Success, &parser) &&
+        CheckParserSetAllowMultipleDocuments(parser, JSON_True, JSON_Success) &&
+        CheckParserSetAllowSpecialNumbers(parser, JSON_True, JSON_Success) &&
+        JSON_Parser_SetDocument(parser, document) == JSON_Success &&
+        CheckParserParse(parser, "1 {\"a\":NaN} -Infinity [\"\"]", 26, JSON_True, JSON_Success) &&
+        CheckDocument(document, "#(1)i1 {1: a=special(0)} special(2) [1: s()]") &&
+        CheckParserReset(parser, JSON_Success) &&
+        CheckParserAddPathFilter(parser, "/a", JSON_Success) &&
+        JSON_Parser_SetDocument(parser, document) == JSON_Success &&
+        CheckParserParse(parser, "{\"b\":{\"a\":2},\"a\":[3,{\"a\":4}]}", 29, JSON_True, JSON_Success) &&
+        CheckDocument(document, "[2: #(3)i3 {1: a=#(4)i4}]"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+    JSON_Document_Free(document);
+}
+
+static void TestDocumentMallocFailure(void)
+{
+    JSON_MemorySuite memorySuite = { NULL, NULL, NULL };
+    JSON_Document document = NULL;
+    JSON_Parser parser = NULL;
+    ParserState state;
+    printf("Test document malloc failure ... ");
+    memorySuite.realloc = &ReallocHandler;
+    memorySuite.free = &FreeHandler;
+    InitParserState(&state);
+    state.error = JSON_Error_OutOfMemory;
+    state.errorLocation.byte = 1;
+    state.errorLocation.column = 1;
+    state.inputEncoding = JSON_UTF8;
+    s_failMalloc = 1;
+    document = JSON_Document_Create(&memorySuite);
+    s_failMalloc = 0;
+    if (document)
+    {
+        printf("FAILURE: expected JSON_Document_Create() to fail\n");
+        s_failureCount++;
+        JSON_Document_Free(document);
+        return;
+    }
+    if ((document = JSON_Document_Create(&memorySuite)) != NULL &&
+        CheckParserCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &parser) &&
+        JSON_Parser_SetDocument(parser, document) == JSON_Success)
+    {
+        s_failMalloc = 1;
+        if (CheckParserParse(parser, "7", 1, JSON_True, JSON_Failure) &&
+            CheckParserState(parser, &state) &&
+            JSON_Document_GetRoot(document) == JSON_Document_NoValue)
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failMalloc = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Parser_Free(parser);
+    JSON_Document_Free(document);
+}
+
+static void OutputOnDemandValue(JSON_OnDemand onDemand, size_t value)
+{
+    size_t item;
+    size_t length;
+    const char* pString;
+    JSON_NumberValue number;
+    switch (JSON_OnDemand_GetType(onDemand, value))
+    {
+    case JSON_NullValueType:
+        OutputFormatted("null");
+        break;
+
+    case JSON_BooleanValueType:
+        OutputFormatted(JSON_OnDemand_GetBoolean(onDemand, value) ? "true" : "false");
+        break;
+
+    case JSON_StringValueType:
+        pString = JSON_OnDemand_GetString(onDemand, value, &length, NULL);
+        OutputFormatted(pString ? "s(%s)" : "s!", pString);
+        break;
+
+    case JSON_NumberValueType:
+        JSON_OnDemand_GetNumber(onDemand, value, &number, NULL);
+        OutputFormatted("#(%s)", JSON_OnDemand_GetNumberText(onDemand, value, &length));
+        if (number.type == JSON_Int64Number)
+        {
+            OutputFormatted("i%d", (int)number.int64Value);
+        }
+        else
+        {
+            OutputFormatted("d%g", number.doubleValue);
+        }
+        break;
+
+    case JSON_SpecialNumberValueType:
+        OutputFormatted("special(%d)", (int)JSON_OnDemand_GetSpecialNumber(onDemand, value));
+        break;
+
+    case JSON_ObjectValueType:
+    case JSON_ArrayValueType:
+        OutputFormatted((JSON_OnDemand_GetType(onDemand, value) == JSON_ObjectValueType) ? "{" : "[");
+        for (item = JSON_OnDemand_GetFirstItem(onDemand, value); item != JSON_OnDemand_NoValue; item = JSON_OnDemand_GetNextItem(onDemand, item))
+        {
+            const char* pName = JSON_OnDemand_GetMemberName(onDemand, item, &length, NULL);
+            OutputSeparator();
+            if (pName)
+            {
+                OutputFormatted("%s=", pName);
+            }
+            OutputOnDemandValue(onDemand, item);
+        }
+        OutputFormatted((JSON_OnDemand_GetType(onDemand, value) == JSON_ObjectValueType) ? "}" : "]");
+        break;
+
+    default:
+        OutputFormatted("?");
+        break;
+    }
+}
+
+static int CheckOnDemand(JSON_OnDemand onDemand, const char* pInput, const char* pExpectedOutput)
+{
+    if (JSON_OnDemand_Open(onDemand, pInput, strlen(pInput)) != JSON_Success)
+    {
+        printf("FAILURE: expected JSON_OnDemand_Open() to return JSON_Success\n");
+        return 0;
+    }
+    ResetOutput();
+    OutputOnDemandValue(onDemand, JSON_OnDemand_GetRoot(onDemand));
+    return CheckOutput(pExpectedOutput);
+}
+
+static void TestOnDemandCreate(void)
+{
+    JSON_MemorySuite memorySuite = { NULL, NULL, NULL };
+    JSON_OnDemand onDemand = NULL;
+    printf("Test creating on-demand instance ... ");
+    memorySuite.realloc = &ReallocHandler;
+    if (JSON_OnDemand_Create(&memorySuite) == NULL &&
+        (onDemand = JSON_OnDemand_Create(NULL)) != NULL &&
+        JSON_OnDemand_GetParser(onDemand) != NULL &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_None &&
+        JSON_OnDemand_GetRoot(onDemand) == JSON_OnDemand_NoValue && /* nothing open */
+        JSON_OnDemand_Open(onDemand, NULL, 1) == JSON_Failure &&
+        JSON_OnDemand_Open(onDemand, NULL, 0) == JSON_Success &&
+        JSON_OnDemand_GetRoot(onDemand) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_Open(onDemand, " \r\n\t", 4) == JSON_Success &&
+        JSON_OnDemand_GetRoot(onDemand) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_Open(onDemand, " 7 ", 3) == JSON_Success &&
+        JSON_OnDemand_GetRoot(onDemand) == 1 &&
+        JSON_OnDemand_GetNextItem(onDemand, 1) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetFirstItem(onDemand, 1) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetMemberName(onDemand, 1, NULL, NULL) == NULL &&
+        JSON_OnDemand_FindMember(onDemand, 1, "a", 1) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetString(onDemand, 1, NULL, NULL) == NULL &&
+        JSON_OnDemand_GetType(onDemand, 3) == JSON_NoValueType &&
+        JSON_OnDemand_GetType(onDemand, JSON_OnDemand_NoValue) == JSON_NoValueType)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_OnDemand_Free(onDemand);
+}
+
+static void TestOnDemandMissing(void)
+{
+    JSON_NumberValue number;
+    printf("Test NULL on-demand instance ... ");
+    if (JSON_OnDemand_Free(NULL) == JSON_Failure &&
+        JSON_OnDemand_GetParser(NULL) == NULL &&
+        JSON_OnDemand_Open(NULL, "7", 1) == JSON_Failure &&
+        JSON_OnDemand_GetError(NULL) == JSON_Error_None &&
+        JSON_OnDemand_GetRoot(NULL) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetType(NULL, 0) == JSON_NoValueType &&
+        JSON_OnDemand_GetBoolean(NULL, 0) == JSON_False &&
+        JSON_OnDemand_GetString(NULL, 0, NULL, NULL) == NULL &&
+        JSON_OnDemand_GetNumber(NULL, 0, &number, NULL) == JSON_Failure &&
+        JSON_OnDemand_GetNumberText(NULL, 0, NULL) == NULL &&
+        JSON_OnDemand_GetSpecialNumber(NULL, 0) == JSON_NaN &&
+        JSON_OnDemand_GetFirstItem(NULL, 0) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetNextItem(NULL, 0) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetMemberName(NULL, 0, NULL, NULL) == NULL &&
+        JSON_OnDemand_FindMember(NULL, 0, "a", 1) == JSON_OnDemand_NoValue)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+}
+
+static void TestOnDemand(void)
+{
+    static const char input[] = "{ \"id\" : 17, \"tags\": [ \"x\", [], {}, [1, [2]], null ], \"a\\u0062\": \"\\uD834\\uDD1E\\t\", \"n\": -2.5e1, \"t\": true, \"\": false }";
+    JSON_OnDemand onDemand = NULL;
+    size_t root;
+    size_t value;
+    size_t length;
+    JSON_StringAttributes attributes;
+    JSON_NumberValue number;
+    JSON_NumberAttributes numberAttributes;
+    int succeeded = 0;
+    printf("Test reading values on demand ... ");
+    if ((onDemand = JSON_OnDemand_Create(NULL)) != NULL &&
+        CheckOnDemand(onDemand, input, "{ id=#(17)i17 tags=[ s(x) [] {} [ #(1)i1 [ #(2)i2]] null] ab=s(\xF0\x9D\x84\x9E\t) n=#(-2.5e1)d-25 t=true =false}") &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_None)
+    {
+        root = JSON_OnDemand_GetRoot(onDemand);
+        value = JSON_OnDemand_FindMember(onDemand, root, "ab", 2); /* decoded name */
+        if (value != JSON_OnDemand_NoValue &&
+            JSON_OnDemand_GetString(onDemand, value, &length, &attributes) != NULL && length == 5 &&
+            attributes == (JSON_ContainsNonASCIICharacter | JSON_ContainsNonBMPCharacter | JSON_ContainsControlCharacter) &&
+            JSON_OnDemand_GetMemberName(onDemand, value, &length, &attributes) != NULL && length == 2 && attributes == JSON_SimpleString &&
+            (value = JSON_OnDemand_FindMember(onDemand, root, "n", 1)) != JSON_OnDemand_NoValue &&
+            JSON_OnDemand_GetNumber(onDemand, value, &number, &numberAttributes) == JSON_Success &&
+            number.type == JSON_DoubleNumber && number.doubleValue == -25.0 &&
+            numberAttributes == (JSON_IsNegative | JSON_ContainsDecimalPoint | JSON_ContainsExponent) &&
+            JSON_OnDemand_GetNumber(onDemand, value, NULL, NULL) == JSON_Failure &&
+            JSON_OnDemand_GetString(onDemand, value, NULL, NULL) == NULL &&
+            JSON_OnDemand_GetType(onDemand, JSON_OnDemand_FindMember(onDemand, root, "", 0)) == JSON_BooleanValueType &&
+            JSON_OnDemand_FindMember(onDemand, root, "a", 1) == JSON_OnDemand_NoValue &&
+            JSON_OnDemand_FindMember(onDemand, root, NULL, 1) == JSON_OnDemand_NoValue &&
+            JSON_OnDemand_GetNextItem(onDemand, JSON_OnDemand_GetFirstItem(onDemand, JSON_OnDemand_FindMember(onDemand, root, "tags", 4))) == 28 &&
+            JSON_OnDemand_GetError(onDemand) == JSON_Error_None)
+        {
+            succeeded = 1;
+        }
+    }
+    if (succeeded)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_OnDemand_Free(onDemand);
+}
+
+static void TestOnDemandSettingsAndErrors(void)
+{
+    JSON_OnDemand onDemand = NULL;
+    JSON_Parser parser;
+    size_t value;
+    size_t length;
+    const char* pString;
+    printf("Test reading values on demand with parser settings and errors ... ");
+    if ((onDemand = JSON_OnDemand_Create(NULL)) != NULL &&
+        (parser = JSON_OnDemand_GetParser(onDemand)) != NULL &&
+        /* Values that are not read are not validated. */
+        CheckOnDemand(onDemand, "{\"a\": 1, \"b\": [\"\\q\"}", "{ a=#(1)i1 b=[ s!]}") &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_InvalidEscapeSequence &&
+        JSON_OnDemand_Open(onDemand, "{\"a\": \"x\", \"b\": [}}", 19) == JSON_Success &&
+        JSON_OnDemand_GetType(onDemand, JSON_OnDemand_FindMember(onDemand, JSON_OnDemand_GetRoot(onDemand), "a", 1)) == JSON_StringValueType &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_None &&
+        CheckOnDemand(onDemand, "[tru, NaN, -Infinity]", "[ false special(0) special(0)]") &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_UnknownToken &&
+        CheckParserSetAllowSpecialNumbers(parser, JSON_True, JSON_Success) &&
+        CheckOnDemand(onDemand, "[NaN, -Infinity]", "[ special(0) special(2)]") &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_None &&
+        JSON_OnDemand_Open(onDemand, "\xEF\xBB\xBF 7", 5) == JSON_Success &&
+        JSON_OnDemand_GetRoot(onDemand) == JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetError(onDemand) == JSON_Error_BOMNotAllowed &&
+        CheckParserSetAllowBOM(parser, JSON_True, JSON_Success) &&
+        JSON_OnDemand_Open(onDemand, "\xEF\xBB\xBF 7", 5) == JSON_Success &&
+        JSON_OnDemand_GetRoot(onDemand) == 4 &&
+        CheckParserSetStringEncoding(parser, JSON_UTF16LE, JSON_Success) &&
+        JSON_OnDemand_Open(onDemand, "{\"k\":\"\\u00E9\",\"\\u00E9\":1}", 25) == JSON_Success &&
+        (value = JSON_OnDemand_FindMember(onDemand, JSON_OnDemand_GetRoot(onDemand), "\xE9\0", 2)) != JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetType(onDemand, value) == JSON_NumberValueType &&
+        JSON_OnDemand_FindMember(onDemand, JSON_OnDemand_GetRoot(onDemand), "k", 1) == JSON_OnDemand_NoValue &&
+        (pString = JSON_OnDemand_GetString(onDemand, JSON_OnDemand_FindMember(onDemand, JSON_OnDemand_GetRoot(onDemand), "k\0", 2), &length, NULL)) != NULL &&
+        length == 2 && pString[0] == '\xE9' && pString[1] == 0 &&
+        /* Path filters apply to each value as if it were a whole document,
+           and are kept from one value to the next. */
+        CheckParserAddPathFilter(parser, "/a", JSON_Success) &&
+        JSON_OnDemand_Open(onDemand, "[\"x\",\"y\"]", 9) == JSON_Success &&
+        (value = JSON_OnDemand_GetFirstItem(onDemand, JSON_OnDemand_GetRoot(onDemand))) != JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetType(onDemand, value) == JSON_StringValueType &&
+        JSON_OnDemand_GetString(onDemand, value, NULL, NULL) == NULL &&
+        (value = JSON_OnDemand_GetNextItem(onDemand, value)) != JSON_OnDemand_NoValue &&
+        JSON_OnDemand_GetType(onDemand, value) == JSON_StringValueType &&
+        JSON_OnDemand_GetString(onDemand, value, NULL, NULL) == NULL)
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        printf("FAILURE\n");
+        s_failureCount++;
+    }
+    JSON_OnDemand_Free(onDemand);
+}
+
+static void TestOnDemandMallocFailure(void)
+{
+    JSON_MemorySuite memorySuite = { NULL, NULL, NULL };
+    JSON_OnDemand onDemand = NULL;
+    printf("Test on-demand malloc failure ... ");
+    memorySuite.realloc = &ReallocHandler;
+    memorySuite.free = &FreeHandler;
+    s_failMalloc = 1;
+    onDemand = JSON_OnDemand_Create(&memorySuite);
+    s_failMalloc = 0;
+    if (onDemand)
+    {
+        printf("FAILURE: expected JSON_OnDemand_Create() to fail\n");
+        s_failureCount++;
+        JSON_OnDemand_Free(onDemand);
+        return;
+    }
+    onDemand = JSON_OnDemand_Create(&memorySuite);
+    if (onDemand && JSON_OnDemand_Open(onDemand, "{\"a\":1}", 7) == JSON_Success)
+    {
+        s_failMalloc = 1;
+        if (JSON_OnDemand_GetFirstItem(onDemand, 0) == JSON_OnDemand_NoValue &&
+            JSON_OnDemand_GetError(onDemand) == JSON_Error_OutOfMemory)
         {
-            succeeded = 1;
+            printf("OK\n");
+        }
+        else
+        {
+            printf("FAILURE\n");
+            s_failureCount++;
         }
         s_failMalloc = 0;
     }
-    if (succeeded)
-    {
-        printf("OK\n");
-    }
     else
     {
         s_failureCount++;
     }
-    JSON_Parser_Free(parser);
+    JSON_OnDemand_Free(onDemand);
 }
 
 static void TestParserMissing(void)
@@ -2104,6 +5022,7 @@ static void TestParserMissing(void)
         CheckParserSetBooleanHandler(NULL, &BooleanHandler, JSON_Failure) &&
         CheckParserSetStringHandler(NULL, &StringHandler, JSON_Failure) &&
         CheckParserSetNumberHandler(NULL, &NumberHandler, JSON_Failure) &&
+        CheckParserSetTypedNumberHandler(NULL, &TypedNumberHandler, JSON_Failure) &&
         CheckParserSetSpecialNumberHandler(NULL, &SpecialNumberHandler, JSON_Failure) &&
         CheckParserSetStartObjectHandler(NULL, &StartObjectHandler, JSON_Failure) &&
         CheckParserSetEndObjectHandler(NULL, &EndObjectHandler, JSON_Failure) &&
@@ -2111,7 +5030,19 @@ static void TestParserMissing(void)
         CheckParserSetStartArrayHandler(NULL, &StartArrayHandler, JSON_Failure) &&
         CheckParserSetEndArrayHandler(NULL, &EndArrayHandler, JSON_Failure) &&
         CheckParserSetArrayItemHandler(NULL, &ArrayItemHandler, JSON_Failure) &&
-        CheckParserParse(NULL, "7", 1, JSON_True, JSON_Failure))
+        CheckParserSetStartDocumentHandler(NULL, &StartDocumentHandler, JSON_Failure) &&
+        CheckParserSetEndDocumentHandler(NULL, &EndDocumentHandler, JSON_Failure) &&
+        CheckParserSetAllowMultipleDocuments(NULL, JSON_True, JSON_Failure) &&
+        CheckParserSetSkipInvalidDocuments(NULL, JSON_True, JSON_Failure) &&
+        CheckParserSetEventBatchHandler(NULL, &EventBatchHandler, JSON_Failure) &&
+        CheckParserSetEventBatchBuffer(NULL, NULL, 0, JSON_Failure) &&
+        CheckParserBuildStructuralIndex(NULL, "7", 1, JSON_Failure) &&
+        CheckParserStructuralIndex(NULL, NULL, 0) &&
+        CheckParserAddPathFilter(NULL, "/a", JSON_Failure) &&
+        CheckParserSetKeyDictionary(NULL, NULL, 0, JSON_Failure) &&
+        CheckParserParse(NULL, "7", 1, JSON_True, JSON_Failure) &&
+        CheckParserParseFile(NULL, "missing.json", JSON_Failure) &&
+        CheckParserParseFd(NULL, 0, JSON_Failure))
     {
         printf("OK\n");
     }
@@ -2216,7 +5147,9 @@ static void TestParserGetAfterTokenLocationOutsideHandler(void)
     JSON_Parser_Free(parser);
 }
 
-#define PARSE_TEST(name, params, input, final, enc, output) { name, params, input, sizeof(input) - 1, final, JSON_##enc, output },
+#define PARSE_TEST(name, params, input, final, enc, output) { name, params, input, sizeof(input) - 1, final, JSON_##enc, output, NULL, NULL },
+#define PATH_FILTER_TEST(name, params, filters, input, final, enc, output) { name, params, input, sizeof(input) - 1, final, JSON_##enc, output, filters, NULL },
+#define KEY_DICTIONARY_TEST(name, params, keys, input, final, enc, output) { name, params, input, sizeof(input) - 1, final, JSON_##enc, output, NULL, keys },
 
 #define FINAL   JSON_True
 #define PARTIAL JSON_False
@@ -2447,6 +5380,15 @@ PARSE_TEST("all whitespace (1)", Standard, " ", FINAL, UTF8, "u(8) !(ExpectedMor
 PARSE_TEST("all whitespace (2)", Standard, "\t", FINAL, UTF8, "u(8) !(ExpectedMoreTokens):1,0,1,0")
 PARSE_TEST("all whitespace (3)", Standard, "\r\n", FINAL, UTF8, "u(8) !(ExpectedMoreTokens):2,1,0,0")
 PARSE_TEST("all whitespace (4)", Standard, "\r\n\n\r ", FINAL, UTF8, "u(8) !(ExpectedMoreTokens):5,3,1,0")
+PARSE_TEST("all whitespace (5)", Standard, "                \t\t\t\t\t\t\t\t\r\n  \r\r\n\t        \n", FINAL, UTF8, "u(8) !(ExpectedMoreTokens):41,4,0,0")
+PARSE_TEST("indented tokens", Standard, "{\r\n    \"a\" :\t[\r\n        1,\n\t\t\t\t\t\t\t\t\t2\r    ]\n}\r\n", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a):7,1,4,1-10,1,7,1 [:13,1,10,1-14,1,11,1 i:24,2,8,2-25,2,9,2 #(1):24,2,8,2-25,2,9,2 i:36,3,9,2-37,3,10,2 #(2):36,3,9,2-37,3,10,2 ]:42,4,4,1-43,4,5,1 }:44,5,0,0-45,5,1,0")
+PARSE_TEST("whitespace cut off at end of input (1)", Standard, "[                \r", PARTIAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0")
+PARSE_TEST("whitespace cut off at end of input (2)", Standard, "[                \r", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(ExpectedMoreTokens):18,1,0,1")
+PARSE_TEST("whitespace with line breaks at word boundaries", Standard, "[      \r\n       \r\r       \n\r       \n1]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:35,6,0,1-36,6,1,1 #(1):35,6,0,1-36,6,1,1 ]:36,6,1,0-37,6,2,0")
+PARSE_TEST("whitespace followed by invalid encoding sequence at word boundary (1)", Standard, "[      \xFF]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):7,0,7,1")
+PARSE_TEST("whitespace followed by invalid encoding sequence at word boundary (2)", Standard, "[       \xFF]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):8,0,8,1")
+PARSE_TEST("whitespace followed by non-ASCII character", Standard, "[\r\n      \xC2\xA0]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(UnknownToken):9,1,6,1")
+PARSE_TEST("whitespace after multi-byte characters", Standard, "[\"\xC2\xA9\xE2\x82\xAC\xF0\x9F\x80\x84\"                ,\t\t\t\t\t\t\t\t1]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-12,0,6,1 s(ab <C2><A9><E2><82><AC><F0><9F><80><84>):1,0,1,1-12,0,6,1 i:37,0,31,1-38,0,32,1 #(1):37,0,31,1-38,0,32,1 ]:38,0,32,0-39,0,33,0")
 PARSE_TEST("trailing garbage (1)", Standard, "7 !", FINAL, UTF8, "u(8) #(7):0,0,0,0-1,0,1,0 !(UnknownToken):2,0,2,0")
 PARSE_TEST("trailing garbage (2)", Standard, "7 {", FINAL, UTF8, "u(8) #(7):0,0,0,0-1,0,1,0 !(UnexpectedToken):2,0,2,0")
 PARSE_TEST("trailing garbage (3)", Standard, "7 \xC0", FINAL, UTF8, "u(8) #(7):0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):2,0,2,0")
@@ -2547,6 +5489,23 @@ PARSE_TEST("Infinity truncated after Infini", AllowSpecialNumbers, "Infini", FIN
 PARSE_TEST("Infinity truncated after Infinit", AllowSpecialNumbers, "Infinit", FINAL, UTF8, "u(8) !(UnknownToken):0,0,0,0")
 PARSE_TEST("Infinity not allowed", Standard, "Infinity", FINAL, UTF8, "u(8) !(UnknownToken):0,0,0,0")
 
+/* literal sequences */
+
+PARSE_TEST("literals in array", Standard, "[true,false,null]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-5,0,5,1 t:1,0,1,1-5,0,5,1 i:6,0,6,1-11,0,11,1 f:6,0,6,1-11,0,11,1 i:12,0,12,1-16,0,16,1 n:12,0,12,1-16,0,16,1 ]:16,0,16,0-17,0,17,0")
+PARSE_TEST("literals on separate lines", Standard, "[\r\ntrue,\r\nfalse\r\n,null\n]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:3,1,0,1-7,1,4,1 t:3,1,0,1-7,1,4,1 i:10,2,0,1-15,2,5,1 f:10,2,0,1-15,2,5,1 i:18,3,1,1-22,3,5,1 n:18,3,1,1-22,3,5,1 ]:23,4,0,0-24,4,1,0")
+PARSE_TEST("special number literals in array", AllowSpecialNumbers, "[NaN,Infinity,-Infinity]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-4,0,4,1 #(NaN):1,0,1,1-4,0,4,1 i:5,0,5,1-13,0,13,1 #(Infinity):5,0,5,1-13,0,13,1 i:14,0,14,1-23,0,23,1 #(-Infinity):14,0,14,1-23,0,23,1 ]:23,0,23,0-24,0,24,0")
+PARSE_TEST("literal followed by non-ASCII character", Standard, "[null\xC2\xA0]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-5,0,5,1 n:1,0,1,1-5,0,5,1 !(UnknownToken):5,0,5,1")
+PARSE_TEST("literal cut off at end of input (1)", Standard, "[tru", PARTIAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0")
+PARSE_TEST("literal cut off at end of input (2)", Standard, "[tru", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(UnknownToken):1,0,1,1")
+PARSE_TEST("literal cut off at end of input (3)", Standard, "[null", PARTIAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0")
+PARSE_TEST("literal cut off at end of input (4)", AllowSpecialNumbers, "[-Infinit", PARTIAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0")
+PARSE_TEST("literal at end of input", Standard, "false", FINAL, UTF8, "u(8) f:0,0,0,0-5,0,5,0")
+PARSE_TEST("literal followed by letter", Standard, "[truex]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(UnknownToken):1,0,1,1")
+PARSE_TEST("literal followed by invalid encoding sequence (1)", Standard, "[null\xFF]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):5,0,5,1")
+PARSE_TEST("literal followed by invalid encoding sequence (2)", Standard, "[fals\xFF]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):5,0,5,1")
+PARSE_TEST("literal followed by invalid encoding sequence (3)", AllowSpecialNumbers, "[Infinity\xE2\x82]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):9,0,9,1")
+PARSE_TEST("literals after multi-byte characters", AllowSpecialNumbers, "[\"\xC2\xA9\xE2\x82\xAC\xF0\x9F\x80\x84\",true,NaN,\r\n\"\xF0\x9F\x80\x84\",-Infinity]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-12,0,6,1 s(ab <C2><A9><E2><82><AC><F0><9F><80><84>):1,0,1,1-12,0,6,1 i:13,0,7,1-17,0,11,1 t:13,0,7,1-17,0,11,1 i:18,0,12,1-21,0,15,1 #(NaN):18,0,12,1-21,0,15,1 i:24,1,0,1-30,1,3,1 s(ab <F0><9F><80><84>):24,1,0,1-30,1,3,1 i:31,1,4,1-40,1,13,1 #(-Infinity):31,1,4,1-40,1,13,1 ]:40,1,13,0-41,1,14,0")
+
 /* -Infinity */
 
 PARSE_TEST("-Infinity (1)", AllowSpecialNumbers, "-Infinity", FINAL, UTF8, "u(8) #(-Infinity):0,0,0,0-9,0,9,0")
@@ -2719,6 +5678,46 @@ PARSE_TEST("long string", Standard, "\""
                    "0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF"
                    "0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF"
                    "\"", FINAL, UTF8, "u(8) s(0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF):0,0,0,0-130,0,130,0")
+PARSE_TEST("long string with escape sequences and non-ASCII characters", Standard, "\""
+                   "0123456789ABCDEF0123456789ABCDEF\\u0041\\n0123456789ABCDEF0123456789ABCDEF"
+                   "\xC2\xA9" "0123456789ABCDEF0123456789ABCDEF\xF0\x9F\x80\x84" "0123456789ABCDEF"
+                   "\"", FINAL, UTF8, "u(8) s(cab 0123456789ABCDEF0123456789ABCDEFA<0A>0123456789ABCDEF0123456789ABCDEF<C2><A9>0123456789ABCDEF0123456789ABCDEF<F0><9F><80><84>0123456789ABCDEF):0,0,0,0-128,0,124,0")
+PARSE_TEST("long string cut off at end of input (1)", Standard, "\"0123456789ABCDEF0123456789", PARTIAL, UTF8, "u(8)")
+PARSE_TEST("long string cut off at end of input (2)", Standard, "\"0123456789ABCDEF0123456789", FINAL, UTF8, "u(8) !(IncompleteToken):0,0,0,0")
+PARSE_TEST("long string cut off inside multi-byte character (1)", Standard, "\"0123456789ABCDEF\xE2\x82", PARTIAL, UTF8, "u(8)")
+PARSE_TEST("long string cut off inside multi-byte character (2)", Standard, "\"0123456789ABCDEF\xE2\x82", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):17,0,17,0")
+PARSE_TEST("long string with invalid encoding sequence at word boundary (1)", Standard, "\"0123456\xFF" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):8,0,8,0")
+PARSE_TEST("long string with invalid encoding sequence at word boundary (2)", Standard, "\"01234567\xFF" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):9,0,9,0")
+PARSE_TEST("long string with invalid encoding sequence at word boundary (3)", Standard, "\"0123456\xE2\x82" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):8,0,8,0")
+PARSE_TEST("long string with invalid encoding sequence at word boundary (4)", ReplaceInvalidEncodingSequences, "\"01234567\xFF" "0123456\xE2\x82" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) s(ar 01234567<EF><BF><BD>0123456<EF><BF><BD>0123456789ABCDEF):0,0,0,0-36,0,35,0")
+PARSE_TEST("long string with multi-byte characters followed by tokens", Standard, "[\"0123456789ABCDEF\xC2\xA9\xE2\x82\xAC\xF0\x9F\x80\x84" "0123456789ABCDEF\",1]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-44,0,38,1 s(ab 0123456789ABCDEF<C2><A9><E2><82><AC><F0><9F><80><84>0123456789ABCDEF):1,0,1,1-44,0,38,1 i:45,0,39,1-46,0,40,1 #(1):45,0,39,1-46,0,40,1 ]:46,0,40,0-47,0,41,0")
+PARSE_TEST("long string with boundary non-ASCII characters", Standard, "\"0123456789ABCDEF" "\xC2\x80\xDF\xBF\xE0\xA0\x80\xED\x9F\xBF\xEE\x80\x80\xEF\xBF\xBF\xF0\x90\x80\x80\xF4\x8F\xBF\xBF" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) s(ab 0123456789ABCDEF<C2><80><DF><BF><E0><A0><80><ED><9F><BF><EE><80><80><EF><BF><BF><F0><90><80><80><F4><8F><BF><BF>0123456789ABCDEF):0,0,0,0-58,0,42,0")
+PARSE_TEST("long string with overlong 3-byte sequence", Standard, "\"0123456789ABCDEF" "\xE0\x9F\xBF" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):17,0,17,0")
+PARSE_TEST("long string with encoded surrogate", Standard, "\"0123456789ABCDEF" "\xED\xA0\x80" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):17,0,17,0")
+PARSE_TEST("long string with overlong 4-byte sequence", Standard, "\"0123456789ABCDEF" "\xF0\x8F\xBF\xBF" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):17,0,17,0")
+PARSE_TEST("long string with encoded out-of-range codepoint", Standard, "\"0123456789ABCDEF" "\xF4\x90\x80\x80" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):17,0,17,0")
+PARSE_TEST("long string with overlong 2-byte sequence", Standard, "\"0123456789ABCDEF" "\xC1\xBF" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):17,0,17,0")
+PARSE_TEST("long string with invalid leading byte", Standard, "\"0123456789ABCDEF\xC2\xA9" "\xF5\x80" "0123456789ABCDEF\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):19,0,18,0")
+PARSE_TEST("long string with truncated sequence", Standard, "\"0123456789ABCDEF\xC2\xA9" "\xE2\x82" "\"", FINAL, UTF8, "u(8) !(InvalidEncodingSequence):19,0,18,0")
+PARSE_TEST("long string with replaced invalid sequences", ReplaceInvalidEncodingSequences, "\"0123456789ABCDEF" "\xE2\x82\xAC\xE2\x82" "0123456789ABCDEF" "\xED\xA0\x80\xC2\xA9\"", FINAL, UTF8, "u(8) s(ar 0123456789ABCDEF<E2><82><AC><EF><BF><BD>0123456789ABCDEF<EF><BF><BD><EF><BF><BD><EF><BF><BD><C2><A9>):0,0,0,0-44,0,40,0")
+PARSE_TEST("long UTF-16LE string -> UTF-8", UTF16LEIn | UTF8Out, "\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\xA9\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x3C\xD8\x04\xDC\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"\x00", FINAL, UTF16LE, "s(ab 0123456789ABCDEF0123456789ABCDEF<C2><A9>0123456789ABCDEF<F0><9F><80><84>0123456789ABCDEF):0,0,0,0-138,0,68,0")
+PARSE_TEST("long UTF-16BE string -> UTF-8", UTF16BEIn | UTF8Out, "\x00\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\xA9\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\xD8\x3C\xDC\x04\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"", FINAL, UTF16BE, "s(ab 0123456789ABCDEF0123456789ABCDEF<C2><A9>0123456789ABCDEF<F0><9F><80><84>0123456789ABCDEF):0,0,0,0-138,0,68,0")
+PARSE_TEST("long UTF-32LE string -> UTF-8", UTF32LEIn | UTF8Out, "\"\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\xA9\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\x04\xF0\x01\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\"\x00\x00\x00", FINAL, UTF32LE, "s(ab 0123456789ABCDEF0123456789ABCDEF<C2><A9>0123456789ABCDEF<F0><9F><80><84>0123456789ABCDEF):0,0,0,0-272,0,68,0")
+PARSE_TEST("long UTF-32BE string -> UTF-8", UTF32BEIn | UTF8Out, "\x00\x00\x00\"\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\xA9\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x01\xF0\x04\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\"", FINAL, UTF32BE, "s(ab 0123456789ABCDEF0123456789ABCDEF<C2><A9>0123456789ABCDEF<F0><9F><80><84>0123456789ABCDEF):0,0,0,0-272,0,68,0")
+PARSE_TEST("long UTF-16LE string with standalone leading surrogate", UTF16LEIn | UTF8Out, "\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x00\xD8\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"\x00", FINAL, UTF16LE, "!(InvalidEncodingSequence):34,0,17,0")
+PARSE_TEST("long UTF-16LE string with standalone trailing surrogate", UTF16LEIn | UTF8Out, "\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x00\xDC\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"\x00", FINAL, UTF16LE, "!(InvalidEncodingSequence):34,0,17,0")
+PARSE_TEST("long UTF-16BE string with standalone leading surrogate", UTF16BEIn | UTF8Out, "\x00\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\xD8\x00\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"", FINAL, UTF16BE, "!(InvalidEncodingSequence):34,0,17,0")
+PARSE_TEST("long UTF-16BE string with standalone trailing surrogate", UTF16BEIn | UTF8Out, "\x00\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\xDC\x00\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"", FINAL, UTF16BE, "!(InvalidEncodingSequence):34,0,17,0")
+PARSE_TEST("long UTF-16LE string with replaced standalone surrogate", UTF16LEIn | UTF8Out | ReplaceInvalidEncodingSequences, "\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x00\xD8\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"\x00", FINAL, UTF16LE, "s(ar 0123456789ABCDEF<EF><BF><BD>0123456789ABCDEF):0,0,0,0-70,0,35,0")
+PARSE_TEST("long UTF-32LE string with out-of-range codepoint", UTF32LEIn | UTF8Out, "\"\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\x00\x00\x11\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\"\x00\x00\x00", FINAL, UTF32LE, "!(InvalidEncodingSequence):68,0,17,0")
+PARSE_TEST("long UTF-32BE string with out-of-range codepoint", UTF32BEIn | UTF8Out, "\x00\x00\x00\"\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x11\x00\x00\x00\x00\x00\x30\x00\x00\x00\x31\x00\x00\x00\x32\x00\x00\x00\x33\x00\x00\x00\x34\x00\x00\x00\x35\x00\x00\x00\x36\x00\x00\x00\x37\x00\x00\x00\x38\x00\x00\x00\x39\x00\x00\x00\x41\x00\x00\x00\x42\x00\x00\x00\x43\x00\x00\x00\x44\x00\x00\x00\x45\x00\x00\x00\x46\x00\x00\x00\"", FINAL, UTF32BE, "!(InvalidEncodingSequence):68,0,17,0")
+PARSE_TEST("long UTF-16LE string with escape sequences", UTF16LEIn | UTF8Out, "\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\\\x00\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\\\x00\x75\x00\x30\x00\x30\x00\x41\x00\x39\x00\"\x00", FINAL, UTF16LE, "s(a 0123456789ABCDEF\"0123456789ABCDEF<C2><A9>):0,0,0,0-84,0,42,0")
+PARSE_TEST("long UTF-16LE string cannot contain unescaped control character", UTF16LEIn | UTF8Out, "\"\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\x09\x00\x30\x00\x31\x00\x32\x00\x33\x00\x34\x00\x35\x00\x36\x00\x37\x00\x38\x00\x39\x00\x41\x00\x42\x00\x43\x00\x44\x00\x45\x00\x46\x00\"\x00", FINAL, UTF16LE, "!(UnescapedControlCharacter):34,0,17,0")
+PARSE_TEST("long UTF-8 string -> UTF-16LE", UTF8In | UTF16LEOut, "\"0123456789ABCDEF\xC2\xA9\xF0\x9F\x80\x84" "0123456789ABCDEF\"", FINAL, UTF8, "s(ab 0_1_2_3_4_5_6_7_8_9_A_B_C_D_E_F_<A9 00><3C D8><04 DC>0_1_2_3_4_5_6_7_8_9_A_B_C_D_E_F_):0,0,0,0-40,0,36,0")
+PARSE_TEST("long UTF-8 string -> UTF-16BE", UTF8In | UTF16BEOut, "\"0123456789ABCDEF\xC2\xA9\xF0\x9F\x80\x84" "0123456789ABCDEF\"", FINAL, UTF8, "s(ab _0_1_2_3_4_5_6_7_8_9_A_B_C_D_E_F<00 A9><D8 3C><DC 04>_0_1_2_3_4_5_6_7_8_9_A_B_C_D_E_F):0,0,0,0-40,0,36,0")
+PARSE_TEST("max length 2 UTF-16LE string -> UTF-8 (1)", UTF16LEIn | UTF8Out | MaxStringLength2, "\"\x00\x61\x00\x62\x00\"\x00", FINAL, UTF16LE, "s(ab):0,0,0,0-8,0,4,0")
+PARSE_TEST("max length 2 UTF-16LE string -> UTF-8 (2)", UTF16LEIn | UTF8Out | MaxStringLength2, "\"\x00\x61\x00\x62\x00\x63\x00\"\x00", FINAL, UTF16LE, "!(TooLongString):0,0,0,0")
+PARSE_TEST("max length 2 UTF-16LE string -> UTF-8 (3)", UTF16LEIn | UTF8Out | MaxStringLength2, "\"\x00\x61\x00\xA9\x00\"\x00", FINAL, UTF16LE, "!(TooLongString):0,0,0,0")
 PARSE_TEST("unterminated string (1)", Standard, "\"", FINAL, UTF8, "u(8) !(IncompleteToken):0,0,0,0")
 PARSE_TEST("unterminated string (2)", Standard, "\"abc", FINAL, UTF8, "u(8) !(IncompleteToken):0,0,0,0")
 PARSE_TEST("string cannot contain unescaped control character (1)", Standard, "\"abc\x00\"", FINAL, UTF8, "u(8) !(UnescapedControlCharacter):4,0,4,0")
@@ -2726,11 +5725,13 @@ PARSE_TEST("string cannot contain unescaped control character (2)", Standard, "\
 PARSE_TEST("string cannot contain unescaped control character (3)", Standard, "\"abc\x0A\"", FINAL, UTF8, "u(8) !(UnescapedControlCharacter):4,0,4,0")
 PARSE_TEST("string cannot contain unescaped control character (4)", Standard, "\"abc\x0D\"", FINAL, UTF8, "u(8) !(UnescapedControlCharacter):4,0,4,0")
 PARSE_TEST("string cannot contain unescaped control character (5)", Standard, "\"abc\x1F\"", FINAL, UTF8, "u(8) !(UnescapedControlCharacter):4,0,4,0")
+PARSE_TEST("string cannot contain unescaped control character (6)", Standard, "\"abcdefghijklmnopqrstuvwxyz\x01\"", FINAL, UTF8, "u(8) !(UnescapedControlCharacter):27,0,27,0")
 PARSE_TEST("unescaped control character (1)", AllowUnescapedControlCharacters, "\"abc\x00\"", FINAL, UTF8, "u(8) s(zc abc<00>):0,0,0,0-6,0,6,0")
 PARSE_TEST("unescaped control character (2)", AllowUnescapedControlCharacters, "\"abc\x09\"", FINAL, UTF8, "u(8) s(c abc<09>):0,0,0,0-6,0,6,0")
 PARSE_TEST("unescaped control character (3)", AllowUnescapedControlCharacters, "\"abc\x0A\"", FINAL, UTF8, "u(8) s(c abc<0A>):0,0,0,0-6,1,1,0")
 PARSE_TEST("unescaped control character (4)", AllowUnescapedControlCharacters, "\"abc\x0D\"", FINAL, UTF8, "u(8) s(c abc<0D>):0,0,0,0-6,1,1,0")
 PARSE_TEST("unescaped control character (5)", AllowUnescapedControlCharacters, "\"abc\x1F\"", FINAL, UTF8, "u(8) s(c abc<1F>):0,0,0,0-6,0,6,0")
+PARSE_TEST("unescaped control character (6)", AllowUnescapedControlCharacters, "\"abcdefgh\x0D\x0A" "ijklmnopqrstuvwxyz\x0D" "abcdefgh\"", FINAL, UTF8, "u(8) s(c abcdefgh<0D><0A>ijklmnopqrstuvwxyz<0D>abcdefgh):0,0,0,0-39,2,9,0")
 PARSE_TEST("unescaped newlines in string", AllowUnescapedControlCharacters, "\"\x0D\x0A \x0D \x0A\"!", FINAL, UTF8, "u(8) s(c <0D><0A><20><0D><20><0A>):0,0,0,0-8,3,1,0 !(UnknownToken):8,3,1,0")
 PARSE_TEST("string cannot contain invalid escape sequence (1)", Standard, "\"\\v\"", FINAL, UTF8, "u(8) !(InvalidEscapeSequence):1,0,1,0")
 PARSE_TEST("string cannot contain invalid escape sequence (2)", Standard, "\"\\x0020\"", FINAL, UTF8, "u(8) !(InvalidEscapeSequence):1,0,1,0")
@@ -2813,7 +5814,23 @@ PARSE_TEST("allow duplicate object members (2)", Standard, "{\"x\":1,\"y\":2,\"x
 PARSE_TEST("allow duplicate object members (3)", Standard, "{\"x\":1,\"y\":{\"TRUE\":true,\"FALSE\":false},\"x\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(x):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 m(y):7,0,7,1-10,0,10,1 {:11,0,11,1-12,0,12,1 m(TRUE):12,0,12,2-18,0,18,2 t:19,0,19,2-23,0,23,2 m(FALSE):24,0,24,2-31,0,31,2 f:32,0,32,2-37,0,37,2 }:37,0,37,1-38,0,38,1 m(x):39,0,39,1-42,0,42,1 #(3):43,0,43,1-44,0,44,1 }:44,0,44,0-45,0,45,0")
 PARSE_TEST("allow duplicate object members (4)", Standard, "{\"x\":1,\"y\":{\"TRUE\":true,\"TRUE\":true},\"z\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(x):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 m(y):7,0,7,1-10,0,10,1 {:11,0,11,1-12,0,12,1 m(TRUE):12,0,12,2-18,0,18,2 t:19,0,19,2-23,0,23,2 m(TRUE):24,0,24,2-30,0,30,2 t:31,0,31,2-35,0,35,2 }:35,0,35,1-36,0,36,1 m(z):37,0,37,1-40,0,40,1 #(3):41,0,41,1-42,0,42,1 }:42,0,42,0-43,0,43,0")
 PARSE_TEST("allow duplicate object members (5)", Standard, "{\"x\":1,\"y\":2,\"y\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(x):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 m(y):7,0,7,1-10,0,10,1 #(2):11,0,11,1-12,0,12,1 m(y):13,0,13,1-16,0,16,1 #(3):17,0,17,1-18,0,18,1 }:18,0,18,0-19,0,19,0")
-PARSE_TEST("detect duplicate object member in callback", Standard, "{\"duplicate\":0}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 !(DuplicateObjectMember):1,0,1,1")
+PARSE_TEST("detect duplicate object member in callback", HandlersOnly, "{\"duplicate\":0}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 !(DuplicateObjectMember):1,0,1,1")
+PARSE_TEST("skip object member value (1)", HandlersOnly, "{\"skip\":{\"a\":[1,\"]}\\\"\",{}],\"b\":null},\"c\":1}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(c):37,0,37,1-40,0,40,1 #(1):41,0,41,1-42,0,42,1 }:42,0,42,0-43,0,43,0")
+PARSE_TEST("skip object member value (2)", HandlersOnly, "{\"skip\":\"x\",\"skip\":[],\"skip\":true,\"c\":1}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(skip):12,0,12,1-18,0,18,1 m(skip):22,0,22,1-28,0,28,1 m(c):34,0,34,1-37,0,37,1 #(1):38,0,38,1-39,0,39,1 }:39,0,39,0-40,0,40,0")
+PARSE_TEST("skip object member value (3)", HandlersOnly, "{\"skip\":[\n\"\xC3\xA9\\\\\",\r\n{}\r],\"c\":0}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(c):24,3,2,1-27,3,5,1 #(0):28,3,6,1-29,3,7,1 }:29,3,7,0-30,3,8,0")
+PARSE_TEST("skip object member value (4)", HandlersOnly | UTF16LEIn, "{\0\"\0s\0k\0i\0p\0\"\0:\0[\0\"\0]\0\\\0\"\0\"\0]\0,\0\"\0c\0\"\0:\0\x32\0}\0", FINAL, UTF16LE, "{:0,0,0,0-2,0,1,0 m(skip):2,0,1,1-14,0,7,1 m(c):32,0,16,1-38,0,19,1 #(2):40,0,20,1-42,0,21,1 }:42,0,21,0-44,0,22,0")
+PARSE_TEST("skip object member value (5)", HandlersOnly | UseStructuralIndex, "{\"skip\":{\"a\":[1,2],\"b\":\"}\"},\"c\":[1]}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(c):28,0,28,1-31,0,31,1 [:32,0,32,1-33,0,33,1 i:33,0,33,2-34,0,34,2 #(1):33,0,33,2-34,0,34,2 ]:34,0,34,1-35,0,35,1 }:35,0,35,0-36,0,36,0")
+PARSE_TEST("skip object member value (6)", HandlersOnly | TrackObjectMembers, "{\"skip\":{\"a\":1,\"a\":2},\"c\":1}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(c):22,0,22,1-25,0,25,1 #(1):26,0,26,1-27,0,27,1 }:27,0,27,0-28,0,28,0")
+PARSE_TEST("skip object member value (7)", HandlersOnly, "{\"skip\":[1/2,{\"x\" \"y\"}],\"c\":1}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(c):24,0,24,1-27,0,27,1 #(1):28,0,28,1-29,0,29,1 }:29,0,29,0-30,0,30,0")
+PARSE_TEST("skip object member value (8)", HandlersOnly, "[{\"skip\":{\"a\":\"abcdefghijklmnopqrstuvwxyz0123456789\",\"b\":[[[[]]]],\"c\":\"\xE2\x82\xAC\xF0\x9D\x84\x9E\"}},2]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 {:1,0,1,1-2,0,2,1 m(skip):2,0,2,2-8,0,8,2 }:80,0,75,1-81,0,76,1 i:82,0,77,1-83,0,78,1 #(2):82,0,77,1-83,0,78,1 ]:83,0,78,0-84,0,79,0")
+PARSE_TEST("skip object member value with comments", HandlersOnly | AllowComments, "{\"skip\":[/*]*/ // ]\r1 /**/, /***/ ],\"c\":0}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 m(c):36,1,16,1-39,1,19,1 #(0):40,1,20,1-41,1,21,1 }:41,1,21,0-42,1,22,0")
+PARSE_TEST("skip object member value with mismatched bracket", HandlersOnly, "{\"skip\":[}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 !(UnexpectedToken):9,0,9,2")
+PARSE_TEST("skip object member value at end of input (1)", HandlersOnly, "{\"skip\":[1,", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 !(ExpectedMoreTokens):11,0,11,2")
+PARSE_TEST("skip object member value at end of input (2)", HandlersOnly, "{\"skip\":[\"]", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 !(ExpectedMoreTokens):11,0,11,2")
+PARSE_TEST("skip object member value at end of input (3)", HandlersOnly, "{\"skip\":[1,", PARTIAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1")
+PARSE_TEST("skip object member value with invalid encoding sequence (1)", HandlersOnly, "{\"skip\":[\"\xFF\"]}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 !(InvalidEncodingSequence):10,0,10,2")
+PARSE_TEST("skip object member value with invalid encoding sequence (2)", HandlersOnly | ReplaceInvalidEncodingSequences, "{\"skip\":[\"\xFF\"]}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 }:13,0,13,0-14,0,14,0")
+PARSE_TEST("skip object member value with invalid encoding sequence (3)", HandlersOnly | ReplaceInvalidEncodingSequences, "{\"skip\":[\xFF]}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(skip):1,0,1,1-7,0,7,1 !(InvalidEncodingSequence):9,0,9,2")
 PARSE_TEST("empty string object member name (1)", Standard, "{\"\":0}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m():1,0,1,1-3,0,3,1 #(0):4,0,4,1-5,0,5,1 }:5,0,5,0-6,0,6,0")
 PARSE_TEST("empty string object member name (2)", TrackObjectMembers, "{\"\":0}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m():1,0,1,1-3,0,3,1 #(0):4,0,4,1-5,0,5,1 }:5,0,5,0-6,0,6,0")
 PARSE_TEST("empty string object member name (3)", TrackObjectMembers, "{\"\":0,\"x\":1}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m():1,0,1,1-3,0,3,1 #(0):4,0,4,1-5,0,5,1 m(x):6,0,6,1-9,0,9,1 #(1):10,0,10,1-11,0,11,1 }:11,0,11,0-12,0,12,0")
@@ -2897,6 +5914,14 @@ PARSE_TEST("random /", Standard, "/", FINAL, UTF8, "u(8) !(UnknownToken):0,0,0,0
 /* multi-line input */
 
 PARSE_TEST("multi-line input", Standard, "[\r 1,\n  2,\r\n\r\n   3]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:3,1,1,1-4,1,2,1 #(1):3,1,1,1-4,1,2,1 i:8,2,2,1-9,2,3,1 #(2):8,2,2,1-9,2,3,1 i:17,4,3,1-18,4,4,1 #(3):17,4,3,1-18,4,4,1 ]:18,4,4,0-19,4,5,0")
+PARSE_TEST("multi-line input with multi-byte characters (1)", Standard, "[\"\xC3\xA9\xE2\x82\xAC\",\r\n\"\xF0\x9F\x98\x80\", 1]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-8,0,5,1 s(a <C3><A9><E2><82><AC>):1,0,1,1-8,0,5,1 i:11,1,0,1-17,1,3,1 s(ab <F0><9F><98><80>):11,1,0,1-17,1,3,1 i:19,1,5,1-20,1,6,1 #(1):19,1,5,1-20,1,6,1 ]:20,1,6,0-21,1,7,0")
+PARSE_TEST("multi-line input with multi-byte characters (2)", Standard, "[\0\"\0\xE9\0\xAC\x20\"\0,\0\n\0\"\0\x3D\xD8\x00\xDE\"\0,\0\r\0 \0\x31\0]\0", FINAL, UTF16LE, "u(16LE) [:0,0,0,0-2,0,1,0 i:2,0,1,1-10,0,5,1 s(a <C3><A9><E2><82><AC>):2,0,1,1-10,0,5,1 i:14,1,0,1-22,1,3,1 s(ab <F0><9F><98><80>):14,1,0,1-22,1,3,1 i:28,2,1,1-30,2,2,1 #(1):28,2,1,1-30,2,2,1 ]:30,2,2,0-32,2,3,0")
+PARSE_TEST("multi-line input with multi-byte characters (3)", Standard, "[\"\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\",\r\"\xE2\x82\xAC\xE2\x82\xAC\", x]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-12,0,6,1 s(ab <C3><A9><E2><82><AC><F0><9F><98><80>):1,0,1,1-12,0,6,1 i:14,1,0,1-22,1,4,1 s(a <E2><82><AC><E2><82><AC>):14,1,0,1-22,1,4,1 !(UnknownToken):24,1,6,1")
+PARSE_TEST("multi-line input with multi-byte characters (4)", Standard, "[\"\xF0\x9F\x98\x80\",\n\"\xC3\xA9\x01\"]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-7,0,4,1 s(ab <F0><9F><98><80>):1,0,1,1-7,0,4,1 !(UnescapedControlCharacter):12,1,2,1")
+PARSE_TEST("multi-line input with multi-byte characters (5)", Standard, "[\"\xF0\x9F\x98\x80\",\r\n\"\xC3\xA9\xE2\x82", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-7,0,4,1 s(ab <F0><9F><98><80>):1,0,1,1-7,0,4,1 !(InvalidEncodingSequence):13,1,2,1")
+PARSE_TEST("multi-line input with multi-byte characters (6)", AllowUnescapedControlCharacters, "\"\xC3\xA9\r\xE2\x82\xAC\r\n\xF0\x9F\x98\x80\n\xC3\xA9\" x", FINAL, UTF8, "u(8) s(cab <C3><A9><0D><E2><82><AC><0D><0A><F0><9F><98><80><0A><C3><A9>):0,0,0,0-17,3,2,0 !(UnknownToken):18,3,3,0")
+PARSE_TEST("multi-line input with replaced invalid encoding sequences", ReplaceInvalidEncodingSequences, "[\"\xE2\x82\xFF\xF0\x9F\x98\",\n\"\xC3\xA9\xFF\", 1]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-9,0,6,1 s(ar <EF><BF><BD><EF><BF><BD><EF><BF><BD>):1,0,1,1-9,0,6,1 i:11,1,0,1-16,1,4,1 s(ar <C3><A9><EF><BF><BD>):11,1,0,1-16,1,4,1 i:18,1,6,1-19,1,7,1 #(1):18,1,6,1-19,1,7,1 ]:19,1,7,0-20,1,8,0")
+PARSE_TEST("multi-line input with multi-byte characters (7)", Standard, "[\0\"\0\x3D\xD8\x00\xDE\x3D\xD8\x00\xDE\"\0,\0\r\0\"\0\xE9\0\"\0,\0 \0x\0]\0", FINAL, UTF16LE, "u(16LE) [:0,0,0,0-2,0,1,0 i:2,0,1,1-14,0,5,1 s(ab <F0><9F><98><80><F0><9F><98><80>):2,0,1,1-14,0,5,1 i:18,1,0,1-24,1,3,1 s(a <C3><A9>):18,1,0,1-24,1,3,1 !(UnknownToken):28,1,5,1")
 PARSE_TEST("multi-line input error (1)", Standard, "[\r1", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:2,1,0,1-3,1,1,1 #(1):2,1,0,1-3,1,1,1 !(ExpectedMoreTokens):3,1,1,1")
 PARSE_TEST("multi-line input error (2)", Standard, "[\n1", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:2,1,0,1-3,1,1,1 #(1):2,1,0,1-3,1,1,1 !(ExpectedMoreTokens):3,1,1,1")
 PARSE_TEST("multi-line input error (3)", Standard, "[\r\n1", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:3,1,0,1-4,1,1,1 #(1):3,1,0,1-4,1,1,1 !(ExpectedMoreTokens):4,1,1,1")
@@ -3152,6 +6177,160 @@ PARSE_TEST("embedded unclosed object (1)", StopAfterEmbeddedDocument, "{", FINAL
 PARSE_TEST("embedded unclosed object (2)", StopAfterEmbeddedDocument, "{!", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 !(UnknownToken):1,0,1,1")
 PARSE_TEST("embedded unclosed object (2)", StopAfterEmbeddedDocument, "{\xFF", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 !(InvalidEncodingSequence):1,0,1,1")
 
+/* structural index */
+
+PARSE_TEST("structural index (1)", UseStructuralIndex, "{ \"a\" : [ 1, \"{}[]:,\\\"\", true ], \"b\\\\\" : { \"c\" : null }, \"d\" : [] }", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a):2,0,2,1-5,0,5,1 [:8,0,8,1-9,0,9,1 i:10,0,10,2-11,0,11,2 #(1):10,0,10,2-11,0,11,2 i:13,0,13,2-23,0,23,2 s({}[]:,\"):13,0,13,2-23,0,23,2 i:25,0,25,2-29,0,29,2 t:25,0,25,2-29,0,29,2 ]:30,0,30,1-31,0,31,1 m(b\\):33,0,33,1-38,0,38,1 {:41,0,41,1-42,0,42,1 m(c):43,0,43,2-46,0,46,2 n:49,0,49,2-53,0,53,2 }:54,0,54,1-55,0,55,1 m(d):57,0,57,1-60,0,60,1 [:63,0,63,1-64,0,64,1 ]:64,0,64,1-65,0,65,1 }:66,0,66,0-67,0,67,0")
+PARSE_TEST("structural index (2)", UseStructuralIndex, "[\r\n    {\r\n        \"a\": \"xyz\"\r\n    },\r\n    [\r\n        -1.5e3\r\n    ]\r\n]\r\n", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:7,1,4,1-8,1,5,1 {:7,1,4,1-8,1,5,1 m(a):18,2,8,2-21,2,11,2 s(xyz):23,2,13,2-28,2,18,2 }:34,3,4,1-35,3,5,1 i:42,4,4,1-43,4,5,1 [:42,4,4,1-43,4,5,1 i:53,5,8,2-59,5,14,2 #(-.e -1.5e3):53,5,8,2-59,5,14,2 ]:65,6,4,1-66,6,5,1 ]:68,7,0,0-69,7,1,0")
+PARSE_TEST("structural index (3)", UseStructuralIndex | AllowBOM, "\xEF\xBB\xBF[0]", FINAL, UTF8, "u(8) [:3,0,1,0-4,0,2,0 i:4,0,2,1-5,0,3,1 #(0):4,0,2,1-5,0,3,1 ]:5,0,3,0-6,0,4,0")
+PARSE_TEST("structural index (4)", UseStructuralIndex | AllowComments, "[/* \" */ 1, // \"\n 2]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:9,0,9,1-10,0,10,1 #(1):9,0,9,1-10,0,10,1 i:18,1,1,1-19,1,2,1 #(2):18,1,1,1-19,1,2,1 ]:19,1,2,0-20,1,3,0")
+PARSE_TEST("structural index (5)", UseStructuralIndex | UTF16LEIn, "[\x00]\x00", FINAL, UTF16LE, "[:0,0,0,0-2,0,1,0 ]:2,0,1,0-4,0,2,0")
+PARSE_TEST("structural index (6)", UseStructuralIndex | StopAfterEmbeddedDocument, "{} {}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 }:1,0,1,0-2,0,2,0 !(StoppedAfterEmbeddedDocument):2,0,2,0")
+PARSE_TEST("structural index (7)", UseStructuralIndex, "[1,]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #(1):1,0,1,1-2,0,2,1 !(UnexpectedToken):3,0,3,1")
+PARSE_TEST("structural index (8)", UseStructuralIndex, "{\"a\" 1}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 !(UnexpectedToken):5,0,5,1")
+PARSE_TEST("structural index (9)", UseStructuralIndex, "[\"abc", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 !(IncompleteToken):1,0,1,1")
+
+/* zero-copy strings */
+
+PARSE_TEST("zero-copy string (1)", ZeroCopyStrings, "\"abc\"", FINAL, UTF8, "u(8) s(abc):0,0,0,0-5,0,5,0")
+PARSE_TEST("zero-copy string (2)", ZeroCopyStrings, "\"\"", FINAL, UTF8, "u(8) s():0,0,0,0-2,0,2,0")
+PARSE_TEST("zero-copy string (3)", ZeroCopyStrings, "{\"a\":\"0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF\"}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(p a):1,0,1,1-4,0,4,1 s(p 0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF0123456789ABCDEF):5,0,5,1-71,0,71,1 }:71,0,71,0-72,0,72,0")
+PARSE_TEST("zero-copy string (4)", ZeroCopyStrings | TrackObjectMembers, "{\"abc\":0,\"abd\":1,\"abc\":2}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(abc):1,0,1,1-6,0,6,1 #(0):7,0,7,1-8,0,8,1 m(p abd):9,0,9,1-14,0,14,1 #(1):15,0,15,1-16,0,16,1 !(DuplicateObjectMember):17,0,17,1")
+PARSE_TEST("zero-copy string (5)", ZeroCopyStrings | UseStructuralIndex, "[\"abc\",\"def\"]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-6,0,6,1 s(abc):1,0,1,1-6,0,6,1 i:7,0,7,1-12,0,12,1 s(p def):7,0,7,1-12,0,12,1 ]:12,0,12,0-13,0,13,0")
+PARSE_TEST("zero-copy string with escape sequence (1)", ZeroCopyStrings, "\"abc\\ndef\"", FINAL, UTF8, "u(8) s(c abc<0A>def):0,0,0,0-10,0,10,0")
+PARSE_TEST("zero-copy string with escape sequence (2)", ZeroCopyStrings, "\"\\nabcdef\"", FINAL, UTF8, "u(8) s(c <0A>abcdef):0,0,0,0-10,0,10,0")
+PARSE_TEST("zero-copy string with non-ASCII character", ZeroCopyStrings, "\"abc\xC2\xA9\"", FINAL, UTF8, "u(8) s(a abc<C2><A9>):0,0,0,0-7,0,6,0")
+PARSE_TEST("zero-copy string with non-ASCII characters", ZeroCopyStrings, "[    \"abc\xC2\xA9\xE2\x82\xAC\xF0\x9F\x80\x84\"]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:5,0,5,1-19,0,13,1 s(abp abc<C2><A9><E2><82><AC><F0><9F><80><84>):5,0,5,1-19,0,13,1 ]:19,0,13,0-20,0,14,0")
+PARSE_TEST("zero-copy string with UTF-16 output", ZeroCopyStrings | UTF16LEOut, "\"abc\"", FINAL, UTF8, "u(8) s(a_b_c_):0,0,0,0-5,0,5,0")
+PARSE_TEST("zero-copy string too long", ZeroCopyStrings | MaxStringLength2, "\"abc\"", FINAL, UTF8, "u(8) !(TooLongString):0,0,0,0")
+PARSE_TEST("zero-copy string unterminated", ZeroCopyStrings, "\"abc", FINAL, UTF8, "u(8) !(IncompleteToken):0,0,0,0")
+
+/* multiple documents */
+
+PARSE_TEST("multiple documents (1)", AllowMultipleDocuments | DocumentHandlers, "1 2", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,0,2,0-3,0,3,0 #(2):2,0,2,0-3,0,3,0 /D:2,0,2,0-3,0,3,0")
+PARSE_TEST("multiple documents (2)", AllowMultipleDocuments | DocumentHandlers, "{}[]\"a\"", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 {:0,0,0,0-1,0,1,0 }:1,0,1,0-2,0,2,0 /D:1,0,1,0-2,0,2,0 D:2,0,2,0-3,0,3,0 [:2,0,2,0-3,0,3,0 ]:3,0,3,0-4,0,4,0 /D:3,0,3,0-4,0,4,0 D:4,0,4,0-7,0,7,0 s(a):4,0,4,0-7,0,7,0 /D:4,0,4,0-7,0,7,0")
+PARSE_TEST("multiple documents (3)", AllowMultipleDocuments | DocumentHandlers, "{\"a\":1}\n[true,null]\r\n\"x\"\n", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 }:6,0,6,0-7,0,7,0 /D:6,0,6,0-7,0,7,0 D:8,1,0,0-9,1,1,0 [:8,1,0,0-9,1,1,0 i:9,1,1,1-13,1,5,1 t:9,1,1,1-13,1,5,1 i:14,1,6,1-18,1,10,1 n:14,1,6,1-18,1,10,1 ]:18,1,10,0-19,1,11,0 /D:18,1,10,0-19,1,11,0 D:21,2,0,0-24,2,3,0 s(x):21,2,0,0-24,2,3,0 /D:21,2,0,0-24,2,3,0")
+PARSE_TEST("multiple documents (4)", AllowMultipleDocuments, "1 [2] {\"a\":[]} null", FINAL, UTF8, "u(8) #(1):0,0,0,0-1,0,1,0 [:2,0,2,0-3,0,3,0 i:3,0,3,1-4,0,4,1 #(2):3,0,3,1-4,0,4,1 ]:4,0,4,0-5,0,5,0 {:6,0,6,0-7,0,7,0 m(a):7,0,7,1-10,0,10,1 [:11,0,11,1-12,0,12,1 ]:12,0,12,1-13,0,13,1 }:13,0,13,0-14,0,14,0 n:15,0,15,0-19,0,19,0")
+PARSE_TEST("multiple documents (5)", AllowMultipleDocuments | UseStructuralIndex, "[1]\n[2]\n", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #(1):1,0,1,1-2,0,2,1 ]:2,0,2,0-3,0,3,0 [:4,1,0,0-5,1,1,0 i:5,1,1,1-6,1,2,1 #(2):5,1,1,1-6,1,2,1 ]:6,1,2,0-7,1,3,0")
+PARSE_TEST("multiple documents (6)", AllowMultipleDocuments | UTF16LEIn, "1\x00\n\x00\x32\x00", FINAL, UTF16LE, "#(1):0,0,0,0-2,0,1,0 #(2):4,1,0,0-6,1,1,0")
+PARSE_TEST("multiple documents (7)", AllowMultipleDocuments | TrackObjectMembers, "{\"a\":1}\n{\"a\":2}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 }:6,0,6,0-7,0,7,0 {:8,1,0,0-9,1,1,0 m(a):9,1,1,1-12,1,4,1 #(2):13,1,5,1-14,1,6,1 }:14,1,6,0-15,1,7,0")
+PARSE_TEST("multiple documents empty", AllowMultipleDocuments | DocumentHandlers, "", FINAL, UnknownEncoding, "")
+PARSE_TEST("multiple documents whitespace only", AllowMultipleDocuments | DocumentHandlers, " \n \n", FINAL, UTF8, "u(8)")
+PARSE_TEST("multiple documents partial", AllowMultipleDocuments | DocumentHandlers, "1\n[2,", PARTIAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,1,0,0-3,1,1,0 [:2,1,0,0-3,1,1,0 i:3,1,1,1-4,1,2,1 #(2):3,1,1,1-4,1,2,1")
+PARSE_TEST("multiple documents incomplete", AllowMultipleDocuments | DocumentHandlers, "1\n{", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,1,0,0-3,1,1,0 {:2,1,0,0-3,1,1,0 !(ExpectedMoreTokens):3,1,1,1")
+PARSE_TEST("multiple documents invalid", AllowMultipleDocuments | DocumentHandlers, "1\n}\n2", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,1,0,0-3,1,1,0 !(UnexpectedToken):2,1,0,0")
+PARSE_TEST("multiple documents not allowed", DocumentHandlers, "1 2", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 !(UnexpectedToken):2,0,2,0")
+PARSE_TEST("multiple documents stop after embedded document", AllowMultipleDocuments | StopAfterEmbeddedDocument | DocumentHandlers, "1 2", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 !(StoppedAfterEmbeddedDocument):1,0,1,0")
+PARSE_TEST("skip invalid documents (1)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "1\n}\n2\n", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,1,0,0-3,1,1,0 /D!(UnexpectedToken):2,1,0,0 D:4,2,0,0-5,2,1,0 #(2):4,2,0,0-5,2,1,0 /D:4,2,0,0-5,2,1,0")
+PARSE_TEST("skip invalid documents (2)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "{\"a\":x} [1]\n[2]", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 /D!(UnknownToken):5,0,5,1 D:12,1,0,0-13,1,1,0 [:12,1,0,0-13,1,1,0 i:13,1,1,1-14,1,2,1 #(2):13,1,1,1-14,1,2,1 ]:14,1,2,0-15,1,3,0 /D:14,1,2,0-15,1,3,0")
+PARSE_TEST("skip invalid documents (3)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "{\"a\" true}\n2", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 /D!(UnexpectedToken):5,0,5,1 D:11,1,0,0-12,1,1,0 #(2):11,1,0,0-12,1,1,0 /D:11,1,0,0-12,1,1,0")
+PARSE_TEST("skip invalid documents (4)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "\"a\nb\"\n3", FINAL, UTF8, "u(8) D /D!(UnescapedControlCharacter):2,0,2,0 D /D!(UnknownToken):3,1,0,0 D:6,2,0,0-7,2,1,0 #(3):6,2,0,0-7,2,1,0 /D:6,2,0,0-7,2,1,0")
+PARSE_TEST("skip invalid documents (5)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "x\r\n1\rx\r2", FINAL, UTF8, "u(8) D /D!(UnknownToken):0,0,0,0 D:3,1,0,0-4,1,1,0 #(1):3,1,0,0-4,1,1,0 /D:3,1,0,0-4,1,1,0 D /D!(UnknownToken):5,2,0,0 D:7,3,0,0-8,3,1,0 #(2):7,3,0,0-8,3,1,0 /D:7,3,0,0-8,3,1,0")
+PARSE_TEST("skip invalid documents (6)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers | TrackObjectMembers, "{\"a\":1,\"a\":2}\n{\"a\":3}", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 /D!(DuplicateObjectMember):7,0,7,1 D:14,1,0,0-15,1,1,0 {:14,1,0,0-15,1,1,0 m(a):15,1,1,1-18,1,4,1 #(3):19,1,5,1-20,1,6,1 }:20,1,6,0-21,1,7,0 /D:20,1,6,0-21,1,7,0")
+PARSE_TEST("skip invalid documents (7)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers | UseStructuralIndex, "[1}]]\n[2]", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #(1):1,0,1,1-2,0,2,1 /D!(UnexpectedToken):2,0,2,1 D:6,1,0,0-7,1,1,0 [:6,1,0,0-7,1,1,0 i:7,1,1,1-8,1,2,1 #(2):7,1,1,1-8,1,2,1 ]:8,1,2,0-9,1,3,0 /D:8,1,2,0-9,1,3,0")
+PARSE_TEST("skip invalid documents (8)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers | UTF16LEIn, "x\x00\xE9\x00\n\x00\x31\x00", FINAL, UTF16LE, "D /D!(UnknownToken):0,0,0,0 D:6,1,0,0-8,1,1,0 #(1):6,1,0,0-8,1,1,0 /D:6,1,0,0-8,1,1,0")
+PARSE_TEST("skip invalid documents with long line", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "[1,2 3,\"abcdefghijklmnopqrstuvwxyz\xC3\xA9\"]\n4", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #(1):1,0,1,1-2,0,2,1 i:3,0,3,1-4,0,4,1 #(2):3,0,3,1-4,0,4,1 /D!(UnexpectedToken):5,0,5,1 D:39,1,0,0-40,1,1,0 #(4):39,1,0,0-40,1,1,0 /D:39,1,0,0-40,1,1,0")
+PARSE_TEST("skip invalid documents with invalid encoding sequence (1)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "\"\xFF\"\n1", FINAL, UTF8, "u(8) D /D!(InvalidEncodingSequence):1,0,1,0 D:4,1,0,0-5,1,1,0 #(1):4,1,0,0-5,1,1,0 /D:4,1,0,0-5,1,1,0")
+PARSE_TEST("skip invalid documents with invalid encoding sequence (2)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "x \xFF\n1 \xE0", FINAL, UTF8, "u(8) D /D!(UnknownToken):0,0,0,0 D:4,1,0,0-5,1,1,0 #(1):4,1,0,0-5,1,1,0 /D:4,1,0,0-5,1,1,0 D /D!(InvalidEncodingSequence):6,1,2,0")
+PARSE_TEST("skip invalid documents at end of input (1)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "1\n[1,", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,1,0,0-3,1,1,0 [:2,1,0,0-3,1,1,0 i:3,1,1,1-4,1,2,1 #(1):3,1,1,1-4,1,2,1 /D!(ExpectedMoreTokens):5,1,3,1")
+PARSE_TEST("skip invalid documents at end of input (2)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "1\n[1 2]", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D:2,1,0,0-3,1,1,0 [:2,1,0,0-3,1,1,0 i:3,1,1,1-4,1,2,1 #(1):3,1,1,1-4,1,2,1 /D!(UnexpectedToken):5,1,3,1")
+PARSE_TEST("skip invalid documents at end of input (3)", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments | DocumentHandlers, "1\n\"abc", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 #(1):0,0,0,0-1,0,1,0 /D:0,0,0,0-1,0,1,0 D /D!(IncompleteToken):2,1,0,0")
+PARSE_TEST("skip invalid documents without multiple documents", HandlersOnly | SkipInvalidDocuments | DocumentHandlers, "}\n1", FINAL, UTF8, "u(8) D:0,0,0,0-1,0,1,0 !(UnexpectedToken):0,0,0,0")
+PARSE_TEST("skip invalid documents without document handlers", HandlersOnly | AllowMultipleDocuments | SkipInvalidDocuments, "[1 2]\n[3]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #(1):1,0,1,1-2,0,2,1 [:6,1,0,0-7,1,1,0 i:7,1,1,1-8,1,2,1 #(3):7,1,1,1-8,1,2,1 ]:8,1,2,0-9,1,3,0")
+
+/* path filters */
+
+PATH_FILTER_TEST("path filter root", Standard, "", "{\"a\":[1]}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 [:5,0,5,1-6,0,6,1 i:6,0,6,2-7,0,7,2 #(1):6,0,6,2-7,0,7,2 ]:7,0,7,1-8,0,8,1 }:8,0,8,0-9,0,9,0")
+PATH_FILTER_TEST("path filter member (1)", Standard, "/a", "{\"a\":1,\"b\":2}", FINAL, UTF8, "u(8) m(a):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1")
+PATH_FILTER_TEST("path filter member (2)", Standard, "/b", "{\"a\":{\"b\":1},\"b\":{\"c\":[true]},\"c\":\"b\"}", FINAL, UTF8, "u(8) m(b):13,0,13,1-16,0,16,1 {:17,0,17,1-18,0,18,1 m(c):18,0,18,2-21,0,21,2 [:22,0,22,2-23,0,23,2 i:23,0,23,3-27,0,27,3 t:23,0,23,3-27,0,27,3 ]:27,0,27,2-28,0,28,2 }:28,0,28,1-29,0,29,1")
+PATH_FILTER_TEST("path filter member (3)", Standard, "/meta/ts", "{\"data\":[1,2,3],\"meta\":{\"id\":7,\"ts\":\"now\",\"x\":{}}}", FINAL, UTF8, "u(8) m(ts):31,0,31,2-35,0,35,2 s(now):36,0,36,2-41,0,41,2")
+PATH_FILTER_TEST("path filter member with escapes", Standard, "/a~1b/~0", "{\"a/b\":{\"~\":1,\"~0\":2},\"a~1b\":{\"~\":3}}", FINAL, UTF8, "u(8) m(~):8,0,8,2-11,0,11,2 #(1):12,0,12,2-13,0,13,2")
+PATH_FILTER_TEST("path filter empty member name", Standard, "/", "{\"\":1,\"x\":2}", FINAL, UTF8, "u(8) m():1,0,1,1-3,0,3,1 #(1):4,0,4,1-5,0,5,1")
+PATH_FILTER_TEST("path filter array index (1)", Standard, "/1", "[1,[2],3]", FINAL, UTF8, "u(8) i:3,0,3,1-4,0,4,1 [:3,0,3,1-4,0,4,1 i:4,0,4,2-5,0,5,2 #(2):4,0,4,2-5,0,5,2 ]:5,0,5,1-6,0,6,1")
+PATH_FILTER_TEST("path filter array index (2)", Standard, "/items/1/id|/items/0", "{\"items\":[{\"id\":1},{\"id\":2,\"n\":0},{\"id\":3}]}", FINAL, UTF8, "u(8) i:10,0,10,2-11,0,11,2 {:10,0,10,2-11,0,11,2 m(id):11,0,11,3-15,0,15,3 #(1):16,0,16,3-17,0,17,3 }:17,0,17,2-18,0,18,2 m(id):20,0,20,3-24,0,24,3 #(2):25,0,25,3-26,0,26,3")
+PATH_FILTER_TEST("path filter array index (3)", Standard, "/01|/1", "{\"01\":1,\"1\":2}", FINAL, UTF8, "u(8) m(01):1,0,1,1-5,0,5,1 #(1):6,0,6,1-7,0,7,1 m(1):8,0,8,1-11,0,11,1 #(2):12,0,12,1-13,0,13,1")
+PATH_FILTER_TEST("path filter array index (4)", Standard, "/01", "[0,1]", FINAL, UTF8, "u(8)")
+PATH_FILTER_TEST("path filter wildcard (1)", Standard, "/items/*/id", "{\"items\":[{\"id\":1,\"n\":\"x\"},{\"n\":\"y\"},{\"id\":[3]}],\"id\":4}", FINAL, UTF8, "u(8) m(id):11,0,11,3-15,0,15,3 #(1):16,0,16,3-17,0,17,3 m(id):38,0,38,3-42,0,42,3 [:43,0,43,3-44,0,44,3 i:44,0,44,4-45,0,45,4 #(3):44,0,44,4-45,0,45,4 ]:45,0,45,3-46,0,46,3")
+PATH_FILTER_TEST("path filter wildcard (2)", Standard, "/*/x|/a/y", "{\"a\":{\"x\":1,\"y\":2,\"z\":3},\"b\":{\"x\":4,\"y\":5}}", FINAL, UTF8, "u(8) m(x):6,0,6,2-9,0,9,2 #(1):10,0,10,2-11,0,11,2 m(y):12,0,12,2-15,0,15,2 #(2):16,0,16,2-17,0,17,2 m(x):30,0,30,2-33,0,33,2 #(4):34,0,34,2-35,0,35,2")
+PATH_FILTER_TEST("path filter wildcard (3)", Standard, "/*", "[1,{\"a\":2}]", FINAL, UTF8, "u(8) i:1,0,1,1-2,0,2,1 #(1):1,0,1,1-2,0,2,1 i:3,0,3,1-4,0,4,1 {:3,0,3,1-4,0,4,1 m(a):4,0,4,2-7,0,7,2 #(2):8,0,8,2-9,0,9,2 }:9,0,9,1-10,0,10,1")
+PATH_FILTER_TEST("path filter nested matches", Standard, "/a|/a/b", "{\"a\":{\"b\":1},\"b\":2}", FINAL, UTF8, "u(8) m(a):1,0,1,1-4,0,4,1 {:5,0,5,1-6,0,6,1 m(b):6,0,6,2-9,0,9,2 #(1):10,0,10,2-11,0,11,2 }:11,0,11,1-12,0,12,1")
+PATH_FILTER_TEST("path filter no match", Standard, "/x", "{\"a\":[1,{\"x\":2}],\"b\":\"x\"}", FINAL, UTF8, "u(8)")
+PATH_FILTER_TEST("path filter scalar root", Standard, "/a", "1", FINAL, UTF8, "u(8)")
+PATH_FILTER_TEST("path filter UTF-16 member names", UTF16LEOut, "/\xC3\xA9", "{\"\xC3\xA9\":1,\"e\":2}", FINAL, UTF8, "u(8) m(a <E9 00>):1,0,1,1-5,0,4,1 #(1_):6,0,5,1-7,0,6,1")
+PATH_FILTER_TEST("path filter with structural index", UseStructuralIndex, "/b/*", "{\"a\":[1,2],\"b\":[{\"c\":3},4]}", FINAL, UTF8, "u(8) i:16,0,16,2-17,0,17,2 {:16,0,16,2-17,0,17,2 m(c):17,0,17,3-20,0,20,3 #(3):21,0,21,3-22,0,22,3 }:22,0,22,2-23,0,23,2 i:24,0,24,2-25,0,25,2 #(4):24,0,24,2-25,0,25,2")
+PATH_FILTER_TEST("path filter with duplicate member tracking", TrackObjectMembers, "/a", "{\"b\":1,\"a\":2,\"b\":3}", FINAL, UTF8, "u(8) m(a):7,0,7,1-10,0,10,1 #(2):11,0,11,1-12,0,12,1 !(DuplicateObjectMember):13,0,13,1")
+PATH_FILTER_TEST("path filter with embedded document", StopAfterEmbeddedDocument, "/a", "{\"a\":1} x", FINAL, UTF8, "u(8) m(a):1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 !(StoppedAfterEmbeddedDocument):7,0,7,0")
+PATH_FILTER_TEST("path filter does not validate skipped value", Standard, "/a", "{\"b\":[1 2],\"a\":1}", FINAL, UTF8, "u(8) m(a):11,0,11,1-14,0,14,1 #(1):15,0,15,1-16,0,16,1")
+PATH_FILTER_TEST("path filter syntax error in unmatched value", Standard, "/a/b", "{\"a\":{\"c\" 1}}", FINAL, UTF8, "u(8) !(UnexpectedToken):10,0,10,2")
+PATH_FILTER_TEST("path filter incomplete input", Standard, "/a", "{\"b\":[1,", FINAL, UTF8, "u(8) !(ExpectedMoreTokens):8,0,8,2")
+PATH_FILTER_TEST("path filter with skipped member", HandlersOnly, "/a", "{\"a\":{\"skip\":[1],\"b\":2},\"c\":3}", FINAL, UTF8, "u(8) m(a):1,0,1,1-4,0,4,1 {:5,0,5,1-6,0,6,1 m(skip):6,0,6,2-12,0,12,2 m(b):17,0,17,2-20,0,20,2 #(2):21,0,21,2-22,0,22,2 }:22,0,22,1-23,0,23,1")
+
+/* key dictionaries */
+
+KEY_DICTIONARY_TEST("key dictionary (1)", Standard, "a", "{\"a\":1,\"b\":2,\"\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a)=0:1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 m(b)=1:7,0,7,1-10,0,10,1 #(2):11,0,11,1-12,0,12,1 m()=1:13,0,13,1-15,0,15,1 #(3):16,0,16,1-17,0,17,1 }:17,0,17,0-18,0,18,0")
+KEY_DICTIONARY_TEST("key dictionary (2)", Standard, "id|name|tags|x|y|z|created|updated|owner|size|type|kind|version|a|b|c|d", "{\"name\":\"n\",\"id\":1,\"z\":{\"x\":0,\"w\":0},\"tags\":[{\"kind\":\"k\",\"d\":[]}],\"ID\":2,\"version\":3,\"versions\":4,\"\":5}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(name)=1:1,0,1,1-7,0,7,1 s(n):8,0,8,1-11,0,11,1 m(id)=0:12,0,12,1-16,0,16,1 #(1):17,0,17,1-18,0,18,1 m(z)=5:19,0,19,1-22,0,22,1 {:23,0,23,1-24,0,24,1 m(x)=3:24,0,24,2-27,0,27,2 #(0):28,0,28,2-29,0,29,2 m(w)=17:30,0,30,2-33,0,33,2 #(0):34,0,34,2-35,0,35,2 }:35,0,35,1-36,0,36,1 m(tags)=2:37,0,37,1-43,0,43,1 [:44,0,44,1-45,0,45,1 i:45,0,45,2-46,0,46,2 {:45,0,45,2-46,0,46,2 m(kind)=11:46,0,46,3-52,0,52,3 s(k):53,0,53,3-56,0,56,3 m(d)=16:57,0,57,3-60,0,60,3 [:61,0,61,3-62,0,62,3 ]:62,0,62,3-63,0,63,3 }:63,0,63,2-64,0,64,2 ]:64,0,64,1-65,0,65,1 m(ID)=17:66,0,66,1-70,0,70,1 #(2):71,0,71,1-72,0,72,1 m(version)=12:73,0,73,1-82,0,82,1 #(3):83,0,83,1-84,0,84,1 m(versions)=17:85,0,85,1-95,0,95,1 #(4):96,0,96,1-97,0,97,1 m()=17:98,0,98,1-100,0,100,1 #(5):101,0,101,1-102,0,102,1 }:102,0,102,0-103,0,103,0")
+KEY_DICTIONARY_TEST("key dictionary empty key", Standard, "a||b", "{\"\":1,\"b\":2,\"c\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m()=1:1,0,1,1-3,0,3,1 #(1):4,0,4,1-5,0,5,1 m(b)=2:6,0,6,1-9,0,9,1 #(2):10,0,10,1-11,0,11,1 m(c)=3:12,0,12,1-15,0,15,1 #(3):16,0,16,1-17,0,17,1 }:17,0,17,0-18,0,18,0")
+KEY_DICTIONARY_TEST("key dictionary non-ASCII keys", Standard, "\xC3\xA9|\xF0\x9F\x98\x80|e", "{\"\\u00E9\":1,\"\\uD83D\\uDE00\":2,\"e\\u0301\":3,\"e\":4}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a <C3><A9>)=0:1,0,1,1-9,0,9,1 #(1):10,0,10,1-11,0,11,1 m(ab <F0><9F><98><80>)=1:12,0,12,1-26,0,26,1 #(2):27,0,27,1-28,0,28,1 m(a e<CC><81>)=3:29,0,29,1-38,0,38,1 #(3):39,0,39,1-40,0,40,1 m(e)=2:41,0,41,1-44,0,44,1 #(4):45,0,45,1-46,0,46,1 }:46,0,46,0-47,0,47,0")
+KEY_DICTIONARY_TEST("key dictionary UTF-16LE strings", UTF16LEOut, "\xC3\xA9|ab", "{\"ab\":1,\"\xC3\xA9\":2,\"a\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a_b_)=1:1,0,1,1-5,0,5,1 #(1_):6,0,6,1-7,0,7,1 m(a <E9 00>)=0:8,0,8,1-12,0,11,1 #(2_):13,0,12,1-14,0,13,1 m(a_)=2:15,0,14,1-18,0,17,1 #(3_):19,0,18,1-20,0,19,1 }:20,0,19,0-21,0,20,0")
+KEY_DICTIONARY_TEST("key dictionary UTF-32BE strings", UTF32BEOut, "\xC3\xA9|ab", "{\"ab\":1,\"\xC3\xA9\":2,\"a\":3}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(___a___b)=1:1,0,1,1-5,0,5,1 #(___1):6,0,6,1-7,0,7,1 m(a <00 00 00 E9>)=0:8,0,8,1-12,0,11,1 #(___2):13,0,12,1-14,0,13,1 m(___a)=2:15,0,14,1-18,0,17,1 #(___3):19,0,18,1-20,0,19,1 }:20,0,19,0-21,0,20,0")
+KEY_DICTIONARY_TEST("key dictionary with embedded null", Standard, "a", "{\"a\\u0000\":1,\"a\":2}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(zc a<00>)=1:1,0,1,1-10,0,10,1 #(1):11,0,11,1-12,0,12,1 m(a)=0:13,0,13,1-16,0,16,1 #(2):17,0,17,1-18,0,18,1 }:18,0,18,0-19,0,19,0")
+KEY_DICTIONARY_TEST("key dictionary with zero-copy strings", ZeroCopyStrings, "a|b", "{\"b\":1,\"a\":2}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(p b)=1:1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 m(p a)=0:7,0,7,1-10,0,10,1 #(2):11,0,11,1-12,0,12,1 }:12,0,12,0-13,0,13,0")
+KEY_DICTIONARY_TEST("key dictionary with duplicate member tracking", TrackObjectMembers, "a", "{\"a\":1,\"a\":2}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a)=0:1,0,1,1-4,0,4,1 #(1):5,0,5,1-6,0,6,1 !(DuplicateObjectMember):7,0,7,1")
+KEY_DICTIONARY_TEST("key dictionary nested objects", Standard, "b", "{\"a\":{\"b\":1},\"b\":2}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a)=1:1,0,1,1-4,0,4,1 {:5,0,5,1-6,0,6,1 m(b)=0:6,0,6,2-9,0,9,2 #(1):10,0,10,2-11,0,11,2 }:11,0,11,1-12,0,12,1 m(b)=0:13,0,13,1-16,0,16,1 #(2):17,0,17,1-18,0,18,1 }:18,0,18,0-19,0,19,0")
+
+/* typed numbers */
+
+PARSE_TEST("typed number (1)", TypedNumbers, "0", FINAL, UTF8, "u(8) #i(0):0,0,0,0-1,0,1,0")
+PARSE_TEST("typed number (2)", TypedNumbers, "-0", FINAL, UTF8, "u(8) #d(-0):0,0,0,0-2,0,2,0")
+PARSE_TEST("typed number (3)", TypedNumbers, "123", FINAL, UTF8, "u(8) #i(123):0,0,0,0-3,0,3,0")
+PARSE_TEST("typed number (4)", TypedNumbers, "-123", FINAL, UTF8, "u(8) #i(-123):0,0,0,0-4,0,4,0")
+PARSE_TEST("typed number (5)", TypedNumbers, "9223372036854775807", FINAL, UTF8, "u(8) #i(9223372036854775807):0,0,0,0-19,0,19,0")
+PARSE_TEST("typed number (6)", TypedNumbers, "9223372036854775808", FINAL, UTF8, "u(8) #u(9223372036854775808):0,0,0,0-19,0,19,0")
+PARSE_TEST("typed number (7)", TypedNumbers, "-9223372036854775808", FINAL, UTF8, "u(8) #i(-9223372036854775808):0,0,0,0-20,0,20,0")
+PARSE_TEST("typed number (8)", TypedNumbers, "-9223372036854775809", FINAL, UTF8, "u(8) #d(l -9.2233720368547758e+18):0,0,0,0-20,0,20,0")
+PARSE_TEST("typed number (9)", TypedNumbers, "18446744073709551615", FINAL, UTF8, "u(8) #u(18446744073709551615):0,0,0,0-20,0,20,0")
+PARSE_TEST("typed number (10)", TypedNumbers, "18446744073709551616", FINAL, UTF8, "u(8) #d(l 1.8446744073709552e+19):0,0,0,0-20,0,20,0")
+PARSE_TEST("typed number (11)", TypedNumbers, "1000000000000000000000", FINAL, UTF8, "u(8) #d(1e+21):0,0,0,0-22,0,22,0")
+PARSE_TEST("typed number (12)", TypedNumbers, "1.000000000000000000000000", FINAL, UTF8, "u(8) #d(1):0,0,0,0-26,0,26,0")
+PARSE_TEST("typed number (13)", TypedNumbers, "1.5", FINAL, UTF8, "u(8) #d(1.5):0,0,0,0-3,0,3,0")
+PARSE_TEST("typed number (14)", TypedNumbers, "-2.25e3", FINAL, UTF8, "u(8) #d(-2250):0,0,0,0-7,0,7,0")
+PARSE_TEST("typed number (15)", TypedNumbers, "0.1", FINAL, UTF8, "u(8) #d(0.10000000000000001):0,0,0,0-3,0,3,0")
+PARSE_TEST("typed number (16)", TypedNumbers, "1e22", FINAL, UTF8, "u(8) #d(1e+22):0,0,0,0-4,0,4,0")
+PARSE_TEST("typed number (17)", TypedNumbers, "123e25", FINAL, UTF8, "u(8) #d(1.23e+27):0,0,0,0-6,0,6,0")
+PARSE_TEST("typed number (18)", TypedNumbers, "1E-22", FINAL, UTF8, "u(8) #d(1e-22):0,0,0,0-5,0,5,0")
+PARSE_TEST("typed number (19)", TypedNumbers, "-0.0", FINAL, UTF8, "u(8) #d(-0):0,0,0,0-4,0,4,0")
+PARSE_TEST("typed number (20)", TypedNumbers, "0e999999999999999999", FINAL, UTF8, "u(8) #d(0):0,0,0,0-20,0,20,0")
+PARSE_TEST("typed number (21)", TypedNumbers, "1e-30", FINAL, UTF8, "u(8) #d(1.0000000000000001e-30):0,0,0,0-5,0,5,0")
+PARSE_TEST("typed number (22)", TypedNumbers, "9007199254740993", FINAL, UTF8, "u(8) #i(9007199254740993):0,0,0,0-16,0,16,0")
+PARSE_TEST("typed number (23)", TypedNumbers, "9007199254740993.0", FINAL, UTF8, "u(8) #d(l 9007199254740992):0,0,0,0-18,0,18,0")
+PARSE_TEST("typed number (24)", TypedNumbers, "0.30000000000000004", FINAL, UTF8, "u(8) #d(l 0.30000000000000004):0,0,0,0-19,0,19,0")
+PARSE_TEST("typed number (25)", TypedNumbers, "12345678901234567890123", FINAL, UTF8, "u(8) #d(l 1.2345678901234568e+22):0,0,0,0-23,0,23,0")
+PARSE_TEST("typed number (26)", TypedNumbers, "1e400", FINAL, UTF8, "u(8) #d(l inf):0,0,0,0-5,0,5,0")
+PARSE_TEST("typed number (27)", TypedNumbers, "-1e400", FINAL, UTF8, "u(8) #d(l -inf):0,0,0,0-6,0,6,0")
+PARSE_TEST("typed number (28)", TypedNumbers, "1e-400", FINAL, UTF8, "u(8) #d(l 0):0,0,0,0-6,0,6,0")
+PARSE_TEST("typed number (29)", TypedNumbers, "2.2250738585072011e-308", FINAL, UTF8, "u(8) #d(l 2.2250738585072009e-308):0,0,0,0-23,0,23,0")
+PARSE_TEST("typed number (30)", TypedNumbers, "1.0000000000000000000000000000000000000000000000000000000000000000000000000001", FINAL, UTF8, "u(8) #d(l 1):0,0,0,0-78,0,78,0")
+PARSE_TEST("typed number (31)", TypedNumbers, "0.0000000000000000000000000000000000000000000000000000000000000000000000000001", FINAL, UTF8, "u(8) #d(9.9999999999999993e-77):0,0,0,0-78,0,78,0")
+PARSE_TEST("typed number (32)", TypedNumbers, "[1,-2.5,3e2]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #i(1):1,0,1,1-2,0,2,1 i:3,0,3,1-7,0,7,1 #d(-2.5):3,0,3,1-7,0,7,1 i:8,0,8,1-11,0,11,1 #d(300):8,0,8,1-11,0,11,1 ]:11,0,11,0-12,0,12,0")
+PARSE_TEST("typed hex number (1)", TypedNumbers | AllowHexNumbers, "0x1F", FINAL, UTF8, "u(8) #i(31):0,0,0,0-4,0,4,0")
+PARSE_TEST("typed hex number (2)", TypedNumbers | AllowHexNumbers, "0xffffffffffffffff", FINAL, UTF8, "u(8) #u(18446744073709551615):0,0,0,0-18,0,18,0")
+PARSE_TEST("typed hex number (3)", TypedNumbers | AllowHexNumbers, "0x10000000000000000", FINAL, UTF8, "u(8) #d(1.8446744073709552e+19):0,0,0,0-19,0,19,0")
+PARSE_TEST("typed hex number (4)", TypedNumbers | AllowHexNumbers, "0x80000000000004001", FINAL, UTF8, "u(8) #d(l 1.4757395258967645e+20):0,0,0,0-19,0,19,0")
+PARSE_TEST("typed hex number (5)", TypedNumbers | AllowHexNumbers, "0x80000000000004000", FINAL, UTF8, "u(8) #d(1.4757395258967641e+20):0,0,0,0-19,0,19,0")
+PARSE_TEST("typed number slow path (1)", TypedNumbers, "0.00000000000000000000123456789012345678e5", FINAL, UTF8, "u(8) #d(l 1.2345678901234568e-16):0,0,0,0-42,0,42,0")
+PARSE_TEST("typed number slow path (2)", TypedNumbers, "123456789012345678901234567890.123e-10", FINAL, UTF8, "u(8) #d(l 1.2345678901234567e+19):0,0,0,0-38,0,38,0")
+PARSE_TEST("typed number slow path (3)", TypedNumbers, "-1.7976931348623157e308", FINAL, UTF8, "u(8) #d(l -1.7976931348623157e+308):0,0,0,0-23,0,23,0")
+PARSE_TEST("typed number slow path (4)", TypedNumbers, "4.9406564584124654e-324", FINAL, UTF8, "u(8) #d(l 4.9406564584124654e-324):0,0,0,0-23,0,23,0")
+PARSE_TEST("typed number slow path (5)", TypedNumbers, "2.47032822920623272e-324", FINAL, UTF8, "u(8) #d(l 0):0,0,0,0-24,0,24,0")
+PARSE_TEST("typed number slow path (6)", TypedNumbers, "1.00000000000000000000000000000000000000000000000000000001e-100000000000", FINAL, UTF8, "u(8) #d(l 0):0,0,0,0-72,0,72,0")
+PARSE_TEST("typed number slow path (7)", TypedNumbers, "100.000000000000000000000000000000001e99999999999999999", FINAL, UTF8, "u(8) #d(l inf):0,0,0,0-55,0,55,0")
+PARSE_TEST("typed number slow path (8)", TypedNumbers, "0.0000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000000001e-200", FINAL, UTF8, "u(8) #d(l 9.9999874849559983e-319):0,0,0,0-125,0,125,0")
+PARSE_TEST("typed number with UTF-16 output (1)", TypedNumbers | UTF16BEOut, "[1e-30,-0.5e-30]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-6,0,6,1 #d(1.0000000000000001e-30):1,0,1,1-6,0,6,1 i:7,0,7,1-15,0,15,1 #d(-5.0000000000000004e-31):7,0,7,1-15,0,15,1 ]:15,0,15,0-16,0,16,0")
+PARSE_TEST("typed number with UTF-16 output (2)", TypedNumbers | UTF16BEOut, "123456789012345678901234567890.123e-10", FINAL, UTF8, "u(8) #d(l 1.2345678901234567e+19):0,0,0,0-38,0,38,0")
+PARSE_TEST("typed number with text fallback (1)", TypedAndTextNumbers, "[1,0.5,0.30000000000000004,1e400]", FINAL, UTF8, "u(8) [:0,0,0,0-1,0,1,0 i:1,0,1,1-2,0,2,1 #i(1):1,0,1,1-2,0,2,1 i:3,0,3,1-6,0,6,1 #d(0.5):3,0,3,1-6,0,6,1 i:7,0,7,1-26,0,26,1 #(. 0.30000000000000004):7,0,7,1-26,0,26,1 i:27,0,27,1-32,0,32,1 #(e 1e400):27,0,27,1-32,0,32,1 ]:32,0,32,0-33,0,33,0")
+PARSE_TEST("typed number with text fallback (2)", TypedAndTextNumbers, "{\"a\":18446744073709551615,\"b\":18446744073709551616}", FINAL, UTF8, "u(8) {:0,0,0,0-1,0,1,0 m(a):1,0,1,1-4,0,4,1 #u(18446744073709551615):5,0,5,1-25,0,25,1 m(b):26,0,26,1-29,0,29,1 #(18446744073709551616):30,0,30,1-50,0,50,1 }:50,0,50,0-51,0,51,0")
+PARSE_TEST("typed number invalid", TypedNumbers, "1.", FINAL, UTF8, "u(8) !(IncompleteToken):0,0,0,0")
+PARSE_TEST("typed number too long", TypedNumbers | MaxNumberLength2, "123", FINAL, UTF8, "u(8) !(TooLongNumber):0,0,0,0")
+
 };
 
 static void TestParserParse(void)
@@ -3212,6 +6391,7 @@ typedef struct tag_WriterSettings
     JSON_Boolean  useCRLF;
     JSON_Boolean  replaceInvalidEncodingSequences;
     JSON_Boolean  escapeAllNonASCIICharacters;
+    size_t        outputBufferSize;
 } WriterSettings;
 
 static void InitWriterSettings(WriterSettings* pSettings)
@@ -3221,6 +6401,7 @@ static void InitWriterSettings(WriterSettings* pSettings)
     pSettings->useCRLF = JSON_False;
     pSettings->replaceInvalidEncodingSequences = JSON_False;
     pSettings->escapeAllNonASCIICharacters = JSON_False;
+    pSettings->outputBufferSize = 0;
 }
 
 static void GetWriterSettings(JSON_Writer writer, WriterSettings* pSettings)
@@ -3230,6 +6411,7 @@ static void GetWriterSettings(JSON_Writer writer, WriterSettings* pSettings)
     pSettings->useCRLF = JSON_Writer_GetUseCRLF(writer);
     pSettings->replaceInvalidEncodingSequences = JSON_Writer_GetReplaceInvalidEncodingSequences(writer);
     pSettings->escapeAllNonASCIICharacters = JSON_Writer_GetEscapeAllNonASCIICharacters(writer);
+    pSettings->outputBufferSize = JSON_Writer_GetOutputBufferSize(writer);
 }
 
 static int WriterSettingsAreIdentical(const WriterSettings* pSettings1, const WriterSettings* pSettings2)
@@ -3238,7 +6420,8 @@ static int WriterSettingsAreIdentical(const WriterSettings* pSettings1, const Wr
             pSettings1->outputEncoding == pSettings2->outputEncoding &&
             pSettings1->useCRLF == pSettings2->useCRLF &&
             pSettings1->replaceInvalidEncodingSequences == pSettings2->replaceInvalidEncodingSequences &&
-            pSettings1->escapeAllNonASCIICharacters == pSettings2->escapeAllNonASCIICharacters);
+            pSettings1->escapeAllNonASCIICharacters == pSettings2->escapeAllNonASCIICharacters &&
+            pSettings1->outputBufferSize == pSettings2->outputBufferSize);
 }
 
 static int CheckWriterSettings(JSON_Writer writer, const WriterSettings* pExpectedSettings)
@@ -3256,12 +6439,14 @@ static int CheckWriterSettings(JSON_Writer writer, const WriterSettings* pExpect
                "  JSON_Writer_GetUseCRLF()                         %8d   %8d\n"
                "  JSON_Writer_GetReplaceInvalidEncodingSequences() %8d   %8d\n"
                "  JSON_Writer_GetEscapeAllNonASCIICharacters()     %8d   %8d\n"
+               "  JSON_Writer_GetOutputBufferSize()                %8d   %8d\n"
                ,
                pExpectedSettings->userData, actualSettings.userData,
                (int)pExpectedSettings->outputEncoding, (int)actualSettings.outputEncoding,
                (int)pExpectedSettings->useCRLF, (int)actualSettings.useCRLF,
                (int)pExpectedSettings->replaceInvalidEncodingSequences, (int)actualSettings.replaceInvalidEncodingSequences,
-               (int)pExpectedSettings->escapeAllNonASCIICharacters, (int)actualSettings.escapeAllNonASCIICharacters
+               (int)pExpectedSettings->escapeAllNonASCIICharacters, (int)actualSettings.escapeAllNonASCIICharacters,
+               (int)pExpectedSettings->outputBufferSize, (int)actualSettings.outputBufferSize
             );
     }
     return identical;
@@ -3415,6 +6600,26 @@ static int CheckWriterSetEscapeAllNonASCIICharacters(JSON_Writer writer, JSON_Bo
     return 1;
 }
 
+static int CheckWriterSetOutputBuffer(JSON_Writer writer, char* pBuffer, size_t size, JSON_Status expectedStatus)
+{
+    if (JSON_Writer_SetOutputBuffer(writer, pBuffer, size) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Writer_SetOutputBuffer() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckWriterFlush(JSON_Writer writer, JSON_Status expectedStatus)
+{
+    if (JSON_Writer_Flush(writer) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Writer_Flush() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
 static int CheckWriterSetOutputHandler(JSON_Writer writer, JSON_Writer_OutputHandler handler, JSON_Status expectedStatus)
 {
     if (JSON_Writer_SetOutputHandler(writer, handler) != expectedStatus)
@@ -3475,6 +6680,36 @@ static int CheckWriterWriteSpecialNumber(JSON_Writer writer, JSON_SpecialNumber
     return 1;
 }
 
+static int CheckWriterWriteInt64(JSON_Writer writer, JSON_Int64 value, JSON_Status expectedStatus)
+{
+    if (JSON_Writer_WriteInt64(writer, value) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Writer_WriteInt64() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckWriterWriteUInt64(JSON_Writer writer, JSON_UInt64 value, JSON_Status expectedStatus)
+{
+    if (JSON_Writer_WriteUInt64(writer, value) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Writer_WriteUInt64() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
+static int CheckWriterWriteDouble(JSON_Writer writer, double value, JSON_Status expectedStatus)
+{
+    if (JSON_Writer_WriteDouble(writer, value) != expectedStatus)
+    {
+        printf("FAILURE: expected JSON_Writer_WriteDouble() to return %s\n", (expectedStatus == JSON_Success) ? "JSON_Success" : "JSON_Failure");
+        return 0;
+    }
+    return 1;
+}
+
 static int CheckWriterWriteStartObject(JSON_Writer writer, JSON_Status expectedStatus)
 {
     if (JSON_Writer_WriteStartObject(writer) != expectedStatus)
@@ -3563,11 +6798,16 @@ static int TryToMisbehaveInWriteHandler(JSON_Writer writer)
         !CheckWriterSetUseCRLF(writer, JSON_True, JSON_Failure) ||
         !CheckWriterSetReplaceInvalidEncodingSequences(writer, JSON_True, JSON_Failure) ||
         !CheckWriterSetEscapeAllNonASCIICharacters(writer, JSON_True, JSON_Failure) ||
+        !CheckWriterSetOutputBuffer(writer, NULL, 16, JSON_Failure) ||
+        !CheckWriterFlush(writer, JSON_Failure) ||
         !CheckWriterWriteNull(writer, JSON_Failure) ||
         !CheckWriterWriteBoolean(writer, JSON_True, JSON_Failure) ||
         !CheckWriterWriteString(writer, "abc", 3, JSON_UTF8, JSON_Failure) ||
         !CheckWriterWriteNumber(writer, "0", 1, JSON_UTF8, JSON_Failure) ||
         !CheckWriterWriteSpecialNumber(writer, JSON_NaN, JSON_Failure) ||
+        !CheckWriterWriteInt64(writer, -1, JSON_Failure) ||
+        !CheckWriterWriteUInt64(writer, 1, JSON_Failure) ||
+        !CheckWriterWriteDouble(writer, 1.5, JSON_Failure) ||
         !CheckWriterWriteStartObject(writer, JSON_Failure) ||
         !CheckWriterWriteEndObject(writer, JSON_Failure) ||
         !CheckWriterWriteStartArray(writer, JSON_Failure) ||
@@ -3665,11 +6905,16 @@ static void TestWriterMissing(void)
         CheckWriterSetUserData(NULL, (void*)1, JSON_Failure) &&
         CheckWriterSetOutputEncoding(NULL, JSON_UTF16LE, JSON_Failure) &&
         CheckWriterSetOutputHandler(NULL, &OutputHandler, JSON_Failure) &&
+        CheckWriterSetOutputBuffer(NULL, NULL, 16, JSON_Failure) &&
+        CheckWriterFlush(NULL, JSON_Failure) &&
         CheckWriterWriteNull(NULL, JSON_Failure) &&
         CheckWriterWriteBoolean(NULL, JSON_True, JSON_Failure) &&
         CheckWriterWriteString(NULL, "abc", 3, JSON_UTF8, JSON_Failure) &&
         CheckWriterWriteNumber(NULL, "0", 1, JSON_UTF8, JSON_Failure) &&
         CheckWriterWriteSpecialNumber(NULL, JSON_NaN, JSON_Failure) &&
+        CheckWriterWriteInt64(NULL, -1, JSON_Failure) &&
+        CheckWriterWriteUInt64(NULL, 1, JSON_Failure) &&
+        CheckWriterWriteDouble(NULL, 1.5, JSON_Failure) &&
         CheckWriterWriteStartObject(NULL, JSON_Failure) &&
         CheckWriterWriteEndObject(NULL, JSON_Failure) &&
         CheckWriterWriteStartArray(NULL, JSON_Failure) &&
@@ -3696,12 +6941,14 @@ static void TestWriterSetSettings(void)
     settings.userData = (void*)1;
     settings.outputEncoding = JSON_UTF16LE;
     settings.replaceInvalidEncodingSequences = JSON_True;
+    settings.outputBufferSize = 64;
     if (CheckWriterCreate(NULL, JSON_Success, &writer) &&
         CheckWriterSetUserData(writer, settings.userData, JSON_Success) &&
         CheckWriterSetOutputEncoding(writer, settings.outputEncoding, JSON_Success) &&
         CheckWriterSetUseCRLF(writer, settings.useCRLF, JSON_Success) &&
         CheckWriterSetReplaceInvalidEncodingSequences(writer, settings.replaceInvalidEncodingSequences, JSON_Success) &&
         CheckWriterSetEscapeAllNonASCIICharacters(writer, settings.escapeAllNonASCIICharacters, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, NULL, settings.outputBufferSize, JSON_Success) &&
         CheckWriterSettings(writer, &settings))
     {
         printf("OK\n");
@@ -3775,6 +7022,7 @@ static void TestWriterReset(void)
         CheckWriterSetUseCRLF(writer, JSON_True, JSON_Success) &&
         CheckWriterSetReplaceInvalidEncodingSequences(writer, JSON_True, JSON_Success) &&
         CheckWriterSetEscapeAllNonASCIICharacters(writer, JSON_True, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, NULL, 64, JSON_Success) &&
         CheckWriterSetOutputHandler(writer, &OutputHandler, JSON_Success) &&
         CheckWriterWriteNull(writer, JSON_Success) &&
         CheckWriterReset(writer, JSON_Success) &&
@@ -4599,6 +7847,170 @@ static void TestWriterWriteSpecialNumber(void)
     }
 }
 
+typedef struct tag_WriteNativeNumberTest
+{
+    const char*      pName;
+    JSON_Encoding    outputEncoding;
+    JSON_NumberValue value;
+    const char*      pOutput;
+} WriteNativeNumberTest;
+
+#define TEST_INT64_MAX  (((JSON_Int64)0x7FFFFFFF << 32) | (JSON_Int64)0xFFFFFFFF)
+#define TEST_INT64_MIN  (-TEST_INT64_MAX - 1)
+#define TEST_UINT64_MAX (~(JSON_UInt64)0)
+
+#define WRITE_INT64_TEST(name, out_enc, input, output) { name, JSON_##out_enc, { JSON_Int64Number, input, 0, 0.0 }, output },
+#define WRITE_UINT64_TEST(name, out_enc, input, output) { name, JSON_##out_enc, { JSON_UInt64Number, 0, input, 0.0 }, output },
+#define WRITE_DOUBLE_TEST(name, out_enc, input, output) { name, JSON_##out_enc, { JSON_DoubleNumber, 0, 0, input }, output },
+
+static void RunWriteNativeNumberTest(const WriteNativeNumberTest* pTest)
+{
+    JSON_Writer writer = NULL;
+    WriterState state;
+    JSON_Status status;
+    printf("Test writing native number %s ... ", pTest->pName);
+
+    InitWriterState(&state);
+    ResetOutput();
+
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputHandler(writer, &OutputHandler, JSON_Success) &&
+        CheckWriterSetOutputEncoding(writer, pTest->outputEncoding, JSON_Success))
+    {
+        switch (pTest->value.type)
+        {
+        case JSON_Int64Number:
+            status = JSON_Writer_WriteInt64(writer, pTest->value.int64Value);
+            break;
+        case JSON_UInt64Number:
+            status = JSON_Writer_WriteUInt64(writer, pTest->value.uint64Value);
+            break;
+        default:
+            status = JSON_Writer_WriteDouble(writer, pTest->value.doubleValue);
+            break;
+        }
+        if (status != JSON_Success)
+        {
+            state.error = JSON_Writer_GetError(writer);
+            if (state.error != JSON_Error_None)
+            {
+                OutputSeparator();
+                OutputFormatted("!(%s)", errorNames[state.error]);
+            }
+        }
+        if (CheckWriterState(writer, &state) && CheckOutput(pTest->pOutput))
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+    ResetOutput();
+}
+
+static const WriteNativeNumberTest s_writeNativeNumberTests[] =
+{
+
+WRITE_INT64_TEST("int64 0",                    UTF8, 0, "0")
+WRITE_INT64_TEST("int64 1",                    UTF8, 1, "1")
+WRITE_INT64_TEST("int64 -1",                   UTF8, -1, "-1")
+WRITE_INT64_TEST("int64 9",                    UTF8, 9, "9")
+WRITE_INT64_TEST("int64 10",                   UTF8, 10, "10")
+WRITE_INT64_TEST("int64 99",                   UTF8, 99, "99")
+WRITE_INT64_TEST("int64 100",                  UTF8, 100, "100")
+WRITE_INT64_TEST("int64 -100",                 UTF8, -100, "-100")
+WRITE_INT64_TEST("int64 1234567890",           UTF8, 1234567890, "1234567890")
+WRITE_INT64_TEST("int64 4294967296",           UTF8, (JSON_Int64)1 << 32, "4294967296")
+WRITE_INT64_TEST("int64 -4294967296",          UTF8, -((JSON_Int64)1 << 32), "-4294967296")
+WRITE_INT64_TEST("int64 max",                  UTF8, TEST_INT64_MAX, "9223372036854775807")
+WRITE_INT64_TEST("int64 min",                  UTF8, TEST_INT64_MIN, "-9223372036854775808")
+WRITE_INT64_TEST("int64 -12 -> UTF-16LE",      UTF16LE, -12, "-_1_2_")
+WRITE_INT64_TEST("int64 -12 -> UTF-16BE",      UTF16BE, -12, "_-_1_2")
+WRITE_INT64_TEST("int64 -12 -> UTF-32LE",      UTF32LE, -12, "-___1___2___")
+WRITE_INT64_TEST("int64 -12 -> UTF-32BE",      UTF32BE, -12, "___-___1___2")
+
+WRITE_UINT64_TEST("uint64 0",                  UTF8, 0, "0")
+WRITE_UINT64_TEST("uint64 7",                  UTF8, 7, "7")
+WRITE_UINT64_TEST("uint64 4294967295",         UTF8, 0xFFFFFFFFUL, "4294967295")
+WRITE_UINT64_TEST("uint64 4294967296",         UTF8, (JSON_UInt64)1 << 32, "4294967296")
+WRITE_UINT64_TEST("uint64 10000000000000000000", UTF8, (JSON_UInt64)1000000000 * 1000000000 * 10, "10000000000000000000")
+WRITE_UINT64_TEST("uint64 max",                UTF8, TEST_UINT64_MAX, "18446744073709551615")
+WRITE_UINT64_TEST("uint64 12 -> UTF-16LE",     UTF16LE, 12, "1_2_")
+WRITE_UINT64_TEST("uint64 12 -> UTF-32BE",     UTF32BE, 12, "___1___2")
+
+WRITE_DOUBLE_TEST("double 0",                  UTF8, 0.0, "0.0")
+WRITE_DOUBLE_TEST("double -0",                 UTF8, -0.0, "-0.0")
+WRITE_DOUBLE_TEST("double 1",                  UTF8, 1.0, "1.0")
+WRITE_DOUBLE_TEST("double -1.5",               UTF8, -1.5, "-1.5")
+WRITE_DOUBLE_TEST("double 0.1",                UTF8, 0.1, "0.1")
+WRITE_DOUBLE_TEST("double 0.3",                UTF8, 0.3, "0.3")
+WRITE_DOUBLE_TEST("double 123.456",            UTF8, 123.456, "123.456")
+WRITE_DOUBLE_TEST("double 1/3",                UTF8, 1.0 / 3.0, "0.3333333333333333")
+WRITE_DOUBLE_TEST("double 2/3",                UTF8, 2.0 / 3.0, "0.6666666666666666")
+WRITE_DOUBLE_TEST("double 2^53",               UTF8, 9007199254740992.0, "9007199254740992.0")
+WRITE_DOUBLE_TEST("double 2^53 + 1",           UTF8, 9007199254740993.0, "9007199254740992.0")
+WRITE_DOUBLE_TEST("double 1e20",               UTF8, 1e20, "100000000000000000000.0")
+WRITE_DOUBLE_TEST("double 1.2345678901234568e20", UTF8, 1.2345678901234568e20, "123456789012345680000.0")
+WRITE_DOUBLE_TEST("double 1e21",               UTF8, 1e21, "1e21")
+WRITE_DOUBLE_TEST("double 5e22",               UTF8, 5e22, "5e22")
+WRITE_DOUBLE_TEST("double 1.5e300",            UTF8, 1.5e300, "1.5e300")
+WRITE_DOUBLE_TEST("double 1e-6",               UTF8, 1e-6, "0.000001")
+WRITE_DOUBLE_TEST("double 1.25e-6",            UTF8, 1.25e-6, "0.00000125")
+WRITE_DOUBLE_TEST("double 1e-7",               UTF8, 1e-7, "1e-7")
+WRITE_DOUBLE_TEST("double -1.5e-7",            UTF8, -1.5e-7, "-1.5e-7")
+WRITE_DOUBLE_TEST("double 1.2345e-100",        UTF8, 1.2345e-100, "1.2345e-100")
+WRITE_DOUBLE_TEST("double max",                UTF8, 1.7976931348623157e308, "1.7976931348623157e308")
+WRITE_DOUBLE_TEST("double min normal",         UTF8, 2.2250738585072014e-308, "2.2250738585072014e-308")
+WRITE_DOUBLE_TEST("double max subnormal",      UTF8, 2.225073858507201e-308, "2.225073858507201e-308")
+WRITE_DOUBLE_TEST("double min subnormal",      UTF8, 4.9406564584124654e-324, "5e-324")
+WRITE_DOUBLE_TEST("double -0.5 -> UTF-16LE",   UTF16LE, -0.5, "-_0_._5_")
+WRITE_DOUBLE_TEST("double -0.5 -> UTF-16BE",   UTF16BE, -0.5, "_-_0_._5")
+WRITE_DOUBLE_TEST("double 1e-7 -> UTF-32LE",   UTF32LE, 1e-7, "1___e___-___7___")
+WRITE_DOUBLE_TEST("double 1e-7 -> UTF-32BE",   UTF32BE, 1e-7, "___1___e___-___7")
+
+};
+
+static void TestWriterWriteNativeNumber(void)
+{
+    size_t i;
+    for  (i = 0; i < sizeof(s_writeNativeNumberTests)/sizeof(s_writeNativeNumberTests[0]); i++)
+    {
+        RunWriteNativeNumberTest(&s_writeNativeNumberTests[i]);
+    }
+}
+
+static void TestWriterWriteDoubleWithInvalidParameters(void)
+{
+    JSON_Writer writer = NULL;
+    WriterState state;
+    double infinity = HUGE_VAL;
+    printf("Test writing double with invalid parameters ... ");
+
+    InitWriterState(&state);
+
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterWriteDouble(writer, infinity, JSON_Failure) &&
+        CheckWriterWriteDouble(writer, -infinity, JSON_Failure) &&
+        CheckWriterWriteDouble(writer, infinity - infinity, JSON_Failure) &&
+        CheckWriterState(writer, &state) &&
+        CheckWriterSetOutputEncoding(writer, JSON_UTF16LE, JSON_Success))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+}
+
 #define WRITE_ARRAY_TEST(name, out_enc, output) { name, JSON_UnknownEncoding, JSON_##out_enc, NO_REPLACE, NO_ESCAPE_ALL, NULL, 0, output },
 
 static void RunWriteArrayTest(const WriteTest* pTest)
@@ -4903,6 +8315,194 @@ static void TestWriterWriteNewLine(void)
     }
 }
 
+static JSON_Writer_HandlerResult JSON_CALL ChunkOutputHandler(JSON_Writer writer, const char* pBytes, size_t length)
+{
+    if (s_failHandler)
+    {
+        return JSON_Writer_Abort;
+    }
+    OutputStringBytes((const unsigned char*)pBytes, length, JSON_SimpleString, JSON_Writer_GetOutputEncoding(writer));
+    OutputCharacter('|');
+    return JSON_Writer_Continue;
+}
+
+static void TestWriterOutputBuffer(void)
+{
+    JSON_Writer writer = NULL;
+    char buffer[8];
+    printf("Test writer output buffer ... ");
+    ResetOutput();
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputHandler(writer, &ChunkOutputHandler, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, buffer, sizeof(buffer), JSON_Success) &&
+        CheckWriterWriteStartArray(writer, JSON_Success) &&
+        CheckWriterWriteNull(writer, JSON_Success) &&
+        CheckWriterWriteComma(writer, JSON_Success) &&
+        CheckOutput("") &&
+        CheckWriterWriteBoolean(writer, JSON_True, JSON_Success) &&
+        CheckWriterWriteComma(writer, JSON_Success) &&
+        CheckWriterWriteString(writer, "abc", 3, JSON_UTF8, JSON_Success) &&
+        CheckWriterWriteComma(writer, JSON_Success) &&
+        CheckWriterWriteDouble(writer, 1.5, JSON_Success) &&
+        CheckWriterWriteEndArray(writer, JSON_Success) &&
+        CheckOutput("[null,tr|ue,\"abc\"|") &&
+        CheckWriterSetOutputBuffer(writer, NULL, 16, JSON_Failure) &&
+        CheckWriterFlush(writer, JSON_Success) &&
+        CheckOutput("[null,tr|ue,\"abc\"|,1.5]|") &&
+        CheckWriterFlush(writer, JSON_Success) &&
+        CheckOutput("[null,tr|ue,\"abc\"|,1.5]|"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+    ResetOutput();
+}
+
+static void TestWriterOutputBufferWithLargeOutput(void)
+{
+    JSON_Writer writer = NULL;
+    printf("Test writer output buffer with output larger than the buffer ... ");
+    ResetOutput();
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputHandler(writer, &ChunkOutputHandler, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, NULL, 4, JSON_Success) &&
+        CheckWriterWriteStartArray(writer, JSON_Success) &&
+        CheckWriterWriteString(writer, "abcdefgh", 8, JSON_UTF8, JSON_Success) &&
+        CheckOutput("[\"ab|cdefgh\"|") &&
+        CheckWriterWriteEndArray(writer, JSON_Success) &&
+        CheckWriterFlush(writer, JSON_Success) &&
+        CheckOutput("[\"ab|cdefgh\"|]|"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+    ResetOutput();
+}
+
+static void TestWriterOutputBufferWithEncoding(void)
+{
+    JSON_Writer writer = NULL;
+    printf("Test writer output buffer with UTF-16LE output ... ");
+    ResetOutput();
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputHandler(writer, &ChunkOutputHandler, JSON_Success) &&
+        CheckWriterSetOutputEncoding(writer, JSON_UTF16LE, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, NULL, 6, JSON_Success) &&
+        CheckWriterWriteStartArray(writer, JSON_Success) &&
+        CheckWriterWriteInt64(writer, -12, JSON_Success) &&
+        CheckWriterWriteEndArray(writer, JSON_Success) &&
+        CheckWriterFlush(writer, JSON_Success) &&
+        CheckOutput("[_-_1_|2_]_|"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+    ResetOutput();
+}
+
+static void TestWriterOutputBufferMallocFailure(void)
+{
+    JSON_Writer writer = NULL;
+    WriterSettings settings;
+    printf("Test writer output buffer malloc failure ... ");
+    InitWriterSettings(&settings);
+    settings.outputBufferSize = 16;
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputBuffer(writer, NULL, 16, JSON_Success))
+    {
+        s_failMalloc = 1;
+        if (CheckWriterSetOutputBuffer(writer, NULL, 32, JSON_Failure) &&
+            CheckWriterSettings(writer, &settings))
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failMalloc = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+}
+
+static void TestWriterOutputBufferAbortInFlush(void)
+{
+    JSON_Writer writer = NULL;
+    WriterState state;
+    printf("Test writer output buffer aborting in flush ... ");
+    InitWriterState(&state);
+    state.error = JSON_Error_AbortedByHandler;
+    ResetOutput();
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputHandler(writer, &ChunkOutputHandler, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, NULL, 16, JSON_Success) &&
+        CheckWriterWriteNull(writer, JSON_Success))
+    {
+        s_failHandler = 1;
+        if (CheckWriterFlush(writer, JSON_Failure) &&
+            CheckWriterState(writer, &state) &&
+            CheckOutput(""))
+        {
+            printf("OK\n");
+        }
+        else
+        {
+            s_failureCount++;
+        }
+        s_failHandler = 0;
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+    ResetOutput();
+}
+
+static void TestWriterOutputBufferFlushAfterError(void)
+{
+    JSON_Writer writer = NULL;
+    WriterState state;
+    printf("Test writer output buffer flushing after error ... ");
+    InitWriterState(&state);
+    state.error = JSON_Error_InvalidNumber;
+    ResetOutput();
+    if (CheckWriterCreateWithCustomMemorySuite(&ReallocHandler, &FreeHandler, JSON_Success, &writer) &&
+        CheckWriterSetOutputHandler(writer, &ChunkOutputHandler, JSON_Success) &&
+        CheckWriterSetOutputBuffer(writer, NULL, 16, JSON_Success) &&
+        CheckWriterWriteNumber(writer, "1x", 2, JSON_UTF8, JSON_Failure) &&
+        CheckWriterState(writer, &state) &&
+        CheckOutput("") &&
+        CheckWriterFlush(writer, JSON_Success) &&
+        CheckWriterState(writer, &state) &&
+        CheckOutput("1|"))
+    {
+        printf("OK\n");
+    }
+    else
+    {
+        s_failureCount++;
+    }
+    JSON_Writer_Free(writer);
+    ResetOutput();
+}
+
 #endif /* JSON_NO_WRITER */
 
 static void TestLibraryVersion(void)
@@ -4959,8 +8559,9 @@ static void TestErrorStrings(void)
         { JSON_Error_TooLongNumber, "the input contains a number that is too long" },
         { JSON_Error_DuplicateObjectMember, "the input contains an object with duplicate members" },
         { JSON_Error_StoppedAfterEmbeddedDocument, "the end of the embedded document was reached"},
+        { JSON_Error_CannotReadInput, "the input could not be read"},
 
-        { JSON_Error_StoppedAfterEmbeddedDocument + 1, "" },
+        { JSON_Error_CannotReadInput + 1, "" },
         { 1000, "" }
     };
 
@@ -5048,6 +8649,43 @@ int main(int argc, char* argv[])
     TestParserStackMallocFailure();
     TestParserStackReallocFailure();
     TestParserDuplicateMemberTrackingMallocFailure();
+    TestParserDuplicateMemberTrackingReusesMemory();
+    TestParserDuplicateMemberTrackingWithManyLongNames();
+    TestParserDuplicateMemberTrackingInWideObjects();
+    TestParserDuplicateMemberTrackingGrowthMallocFailure();
+    TestParserSettingsAfterReset();
+    TestParserPullEvents();
+    TestParserEventBatches();
+    TestParserEventBatchMallocFailure();
+    TestParserTypedNumbersWithManyZeros();
+    TestParserTypedNumbersInCommaLocale();
+    TestParserSkipValue();
+    TestParserStructuralIndex();
+    TestParserStructuralIndexMallocFailure();
+    TestParserAddPathFilter();
+    TestParserAddPathFilterMallocFailure();
+    TestParserKeyDictionary();
+    TestParserLargeKeyDictionary();
+    TestParserKeyDictionaryMallocFailure();
+    TestParserParseFile();
+    TestParallelLinesCreate();
+    TestParallelLinesMissing();
+    TestParallelLinesParse();
+    TestParallelLinesAbortInHandlers();
+    TestParallelLinesParseArray();
+    TestParallelLinesParseArrayErrors();
+    TestParallelLinesParseArrayWithInvalidElement();
+    TestParallelLinesMallocFailure();
+    TestDocumentCreate();
+    TestDocumentMissing();
+    TestDocument();
+    TestDocumentWithMultipleDocumentsAndFilters();
+    TestDocumentMallocFailure();
+    TestOnDemandCreate();
+    TestOnDemandMissing();
+    TestOnDemand();
+    TestOnDemandSettingsAndErrors();
+    TestOnDemandMallocFailure();
     TestParserParse();
 #endif
 
@@ -5071,10 +8709,18 @@ int main(int argc, char* argv[])
     TestWriterWriteNumber();
     TestWriterWriteNumberWithInvalidParameters();
     TestWriterWriteSpecialNumber();
+    TestWriterWriteNativeNumber();
+    TestWriterWriteDoubleWithInvalidParameters();
     TestWriterWriteArray();
     TestWriterWriteObject();
     TestWriterWriteSpace();
     TestWriterWriteNewLine();
+    TestWriterOutputBuffer();
+    TestWriterOutputBufferWithLargeOutput();
+    TestWriterOutputBufferWithEncoding();
+    TestWriterOutputBufferMallocFailure();
+    TestWriterOutputBufferAbortInFlush();
+    TestWriterOutputBufferFlushAfterError();
 #endif
 
     TestLibraryVersion();